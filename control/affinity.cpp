@@ -13,6 +13,9 @@
 #include "affinity.h"
 
 #include <stdio.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
 
 affinity_set::affinity_set()
 {
@@ -45,6 +48,56 @@ int affinity_set::set_affinity()
 }
 
 
+// Returns number of cpus in set.
+int affinity_set::get_count()
+{
+    int cnt = 0;
+    for (int icpu=0; icpu < CPU_SETSIZE; ++icpu) {
+        if ( CPU_ISSET( icpu, &set ))
+            ++cnt;
+    }
+    return cnt;
+}
+
+
+// Returns i-th cpu in set (0-based), or -1 if set has fewer than i+1 cpus.
+int affinity_set::get_cpu(int i)
+{
+    for (int icpu=0; icpu < CPU_SETSIZE; ++icpu) {
+        if ( CPU_ISSET( icpu, &set )) {
+            if (i == 0)
+                return icpu;
+            --i;
+        }
+    }
+    return -1;
+}
+
+
+// Returns NUMA node of cpu, read from sysfs (/sys/devices/system/cpu/cpuN/nodeM).
+// Returns 0 if it cannot be determined, e.g., on non-NUMA kernels.
+int magma_get_cpu_numa_node(int cpu)
+{
+    char path[64];
+    snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu );
+    DIR* dir = opendir( path );
+    if (dir == NULL)
+        return 0;
+
+    int node = 0;
+    struct dirent* entry;
+    while ((entry = readdir( dir )) != NULL) {
+        if (strncmp( entry->d_name, "node", 4 ) == 0
+            && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi( &entry->d_name[4] );
+            break;
+        }
+    }
+    closedir( dir );
+    return node;
+}
+
+
 void affinity_set::print_affinity(int id, const char* s)
 {
     if (get_affinity() == 0)
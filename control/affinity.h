@@ -35,6 +35,10 @@ public:
 
     int set_affinity();
 
+    int get_count();
+
+    int get_cpu(int i);
+
     void print_affinity(int id, const char* s);
 
     void print_set(int id, const char* s);
@@ -44,6 +48,8 @@ private:
     cpu_set_t set;
 };
 
+int magma_get_cpu_numa_node(int cpu);
+
 #else
 #error "Affinity requires Linux glibc version >= 2.3.3, which isn't available. Please add -DMAGMA_NOAFFINITY to the CFLAGS in make.inc."
 #endif
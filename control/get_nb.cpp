@@ -12,6 +12,23 @@
 
 #include "magma_internal.h"
 
+// Returns from the enclosing magma_get_* function the value of name in the
+// tuning table, if it has one; see magma_tune_get.
+#define MAGMA_TUNED( name, n, nthread )                         \
+    do {                                                        \
+        magma_int_t tuned_;                                     \
+        if ( magma_tune_get( name, n, nthread, &tuned_ ))       \
+            return tuned_;                                      \
+    } while (0)
+
+// Same, but at most max_.
+#define MAGMA_TUNED_MAX( name, n, nthread, max_ )               \
+    do {                                                        \
+        magma_int_t tuned_;                                     \
+        if ( magma_tune_get( name, n, nthread, &tuned_ ))       \
+            return min( tuned_, max_ );                         \
+    } while (0)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -25,6 +42,8 @@ extern "C" {
 /// Optimal block sizes vary with GPU and, to a lesser extent, CPU.
 /// Kepler tuning was on K20c   705 MHz with SandyBridge 2.6 GHz host (bunsen).
 /// Fermi  tuning was on S2050 1147 MHz with AMD Opteron 2.4 GHz host (romulus).
+/// Values in the tuning table of the machine, loaded from $MAGMA_TUNE by
+/// magma_init (see magma_tune_get and testing_ztune), override these.
 /// @{
 
 
@@ -32,6 +51,7 @@ extern "C" {
 /// @return nb for spotrf based on n
 magma_int_t magma_get_spotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "spotrf_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -53,6 +73,7 @@ magma_int_t magma_get_spotrf_nb( magma_int_t n )
 /// @return nb for dpotrf based on n
 magma_int_t magma_get_dpotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dpotrf_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -74,6 +95,7 @@ magma_int_t magma_get_dpotrf_nb( magma_int_t n )
 /// @return nb for cpotrf based on n
 magma_int_t magma_get_cpotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "cpotrf_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -92,6 +114,7 @@ magma_int_t magma_get_cpotrf_nb( magma_int_t n )
 /// @return nb for zpotrf based on n
 magma_int_t magma_get_zpotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zpotrf_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -112,24 +135,28 @@ magma_int_t magma_get_zpotrf_nb( magma_int_t n )
 /// @return nb for zpotrf_right based on n
 magma_int_t magma_get_zpotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zpotrf_right_nb", n, 0 );
     return 128;
 }
 
 /// @return nb for cpotrf_right based on n
 magma_int_t magma_get_cpotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "cpotrf_right_nb", n, 0 );
     return 128;
 }
 
 /// @return nb for dpotrf_right based on n
 magma_int_t magma_get_dpotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dpotrf_right_nb", n, 0 );
     return 320;
 }
 
 /// @return nb for spotrf_right based on n
 magma_int_t magma_get_spotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "spotrf_right_nb", n, 0 );
     return 128;
 }
 
@@ -138,24 +165,28 @@ magma_int_t magma_get_spotrf_right_nb( magma_int_t n )
 /// @return nb for sgeqp3 based on m, n
 magma_int_t magma_get_sgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgeqp3_nb", min( m, n ), 0 );
     return 32;
 }
 
 /// @return nb for dgeqp3 based on m, n
 magma_int_t magma_get_dgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgeqp3_nb", min( m, n ), 0 );
     return 32;
 }
 
 /// @return nb for cgeqp3 based on m, n
 magma_int_t magma_get_cgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgeqp3_nb", min( m, n ), 0 );
     return 32;
 }
 
 /// @return nb for zgeqp3 based on m, n
 magma_int_t magma_get_zgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgeqp3_nb", min( m, n ), 0 );
     return 32;
 }
 
@@ -164,6 +195,7 @@ magma_int_t magma_get_zgeqp3_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgeqrf based on m, n
 magma_int_t magma_get_sgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgeqrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -189,6 +221,7 @@ magma_int_t magma_get_sgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for dgeqrf based on m, n
 magma_int_t magma_get_dgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgeqrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -208,6 +241,7 @@ magma_int_t magma_get_dgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgeqrf based on m, n
 magma_int_t magma_get_cgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgeqrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -226,6 +260,7 @@ magma_int_t magma_get_cgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgeqrf based on m, n
 magma_int_t magma_get_zgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgeqrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -250,6 +285,7 @@ magma_int_t magma_get_zgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgeqlf based on m, n
 magma_int_t magma_get_sgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgeqlf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -267,6 +303,7 @@ magma_int_t magma_get_sgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for dgeqlf based on m, n
 magma_int_t magma_get_dgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgeqlf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -284,6 +321,7 @@ magma_int_t magma_get_dgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgeqlf based on m, n
 magma_int_t magma_get_cgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgeqlf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  2048) nb = 32;
@@ -295,6 +333,7 @@ magma_int_t magma_get_cgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgeqlf based on m, n
 magma_int_t magma_get_zgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgeqlf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  1024) nb = 64;
@@ -307,12 +346,14 @@ magma_int_t magma_get_zgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgelqf based on m, n
 magma_int_t magma_get_sgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgelqf_nb", min( m, n ), 0 );
     return magma_get_sgeqrf_nb( m, n );
 }
 
 /// @return nb for dgelqf based on m, n
 magma_int_t magma_get_dgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgelqf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -330,6 +371,7 @@ magma_int_t magma_get_dgelqf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgelqf based on m, n
 magma_int_t magma_get_cgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgelqf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  2048) nb = 32;
@@ -341,6 +383,7 @@ magma_int_t magma_get_cgelqf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgelqf based on m, n
 magma_int_t magma_get_zgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgelqf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  1024) nb = 64;
@@ -630,6 +673,7 @@ magma_int_t magma_get_hgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgetrf based on m, n
 magma_int_t magma_get_sgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgetrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -653,6 +697,7 @@ magma_int_t magma_get_sgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for dgetrf based on m, n
 magma_int_t magma_get_dgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgetrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -677,6 +722,7 @@ magma_int_t magma_get_dgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgetrf based on m, n
 magma_int_t magma_get_cgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgetrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -699,6 +745,7 @@ magma_int_t magma_get_cgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgetrf based on m, n
 magma_int_t magma_get_zgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgetrf_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -722,6 +769,7 @@ magma_int_t magma_get_zgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native sgetrf based on m, n
 magma_int_t magma_get_sgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgetrf_native_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -746,6 +794,7 @@ magma_int_t magma_get_sgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native dgetrf based on m, n
 magma_int_t magma_get_dgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgetrf_native_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -770,6 +819,7 @@ magma_int_t magma_get_dgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native cgetrf based on m, n
 magma_int_t magma_get_cgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgetrf_native_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -792,6 +842,7 @@ magma_int_t magma_get_cgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native zgetrf based on m, n
 magma_int_t magma_get_zgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgetrf_native_nb", min( m, n ), 0 );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -817,6 +868,7 @@ magma_int_t magma_get_zgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgehrd based on n
 magma_int_t magma_get_sgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "sgehrd_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 200 ) {       // 2.x Fermi
@@ -833,6 +885,7 @@ magma_int_t magma_get_sgehrd_nb( magma_int_t n )
 /// @return nb for dgehrd based on n
 magma_int_t magma_get_dgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dgehrd_nb", n, 0 );
     magma_int_t nb;
     if      (n <  2048) nb = 32;
     else                nb = 64;
@@ -842,6 +895,7 @@ magma_int_t magma_get_dgehrd_nb( magma_int_t n )
 /// @return nb for cgehrd based on n
 magma_int_t magma_get_cgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "cgehrd_nb", n, 0 );
     magma_int_t nb;
     if      (n <  1024) nb = 32;
     else                nb = 64;
@@ -851,6 +905,7 @@ magma_int_t magma_get_cgehrd_nb( magma_int_t n )
 /// @return nb for zgehrd based on n
 magma_int_t magma_get_zgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zgehrd_nb", n, 0 );
     magma_int_t nb;
     if      (n <  2048) nb = 32;
     else                nb = 64;
@@ -890,24 +945,28 @@ magma_int_t magma_get_zhetrd_nb( magma_int_t n )
 /// @return nb for zhetrf based on n
 magma_int_t magma_get_zhetrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zhetrf_nb", n, 0 );
     return 256;
 }
 
 /// @return nb for chetrf based on n
 magma_int_t magma_get_chetrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "chetrf_nb", n, 0 );
     return 256;
 }
 
 /// @return nb for dsytrf based on n
 magma_int_t magma_get_dsytrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dsytrf_nb", n, 0 );
     return 96;
 }
 
 /// @return nb for ssytrf based on n
 magma_int_t magma_get_ssytrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "ssytrf_nb", n, 0 );
     return 256;
 }
 
@@ -916,24 +975,28 @@ magma_int_t magma_get_ssytrf_nb( magma_int_t n )
 /// @return nb for zhetrf_aasen based on n
 magma_int_t magma_get_zhetrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zhetrf_aasen_nb", n, 0 );
     return 256;
 }
 
 /// @return nb for chetrf_aasen based on n
 magma_int_t magma_get_chetrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "chetrf_aasen_nb", n, 0 );
     return 256;
 }
 
 /// @return nb for dsytrf_aasen based on n
 magma_int_t magma_get_dsytrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dsytrf_aasen_nb", n, 0 );
     return 256;
 }
 
 /// @return nb for ssytrf_aasen based on n
 magma_int_t magma_get_ssytrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "ssytrf_aasen_nb", n, 0 );
     return 256;
 }
 
@@ -942,24 +1005,28 @@ magma_int_t magma_get_ssytrf_aasen_nb( magma_int_t n )
 /// @return nb for zhetrf_nopiv based on n
 magma_int_t magma_get_zhetrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zhetrf_nopiv_nb", n, 0 );
     return 320;
 }
 
 /// @return nb for chetrf_nopiv based on n
 magma_int_t magma_get_chetrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "chetrf_nopiv_nb", n, 0 );
     return 320;
 }
 
 /// @return nb for dsytrf_nopiv based on n
 magma_int_t magma_get_dsytrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dsytrf_nopiv_nb", n, 0 );
     return 320;
 }
 
 /// @return nb for ssytrf_nopiv based on n
 magma_int_t magma_get_ssytrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "ssytrf_nopiv_nb", n, 0 );
     return 320;
 }
 
@@ -968,24 +1035,28 @@ magma_int_t magma_get_ssytrf_nopiv_nb( magma_int_t n )
 /// @return nb for sgebrd based on m, n
 magma_int_t magma_get_sgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgebrd_nb", min( m, n ), 0 );
     return 32;
 }
 
 /// @return nb for dgebrd based on m, n
 magma_int_t magma_get_dgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgebrd_nb", min( m, n ), 0 );
     return 32;
 }
 
 /// @return nb for cgebrd based on m, n
 magma_int_t magma_get_cgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgebrd_nb", min( m, n ), 0 );
     return 32;
 }
 
 /// @return nb for zgebrd based on m, n
 magma_int_t magma_get_zgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgebrd_nb", min( m, n ), 0 );
     return 32;
 }
 
@@ -994,6 +1065,7 @@ magma_int_t magma_get_zgebrd_nb( magma_int_t m, magma_int_t n )
 /// @return nb for ssygst based on n
 magma_int_t magma_get_ssygst_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "ssygst_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1013,6 +1085,7 @@ magma_int_t magma_get_ssygst_nb( magma_int_t n )
 /// @return nb for dsygst based on n
 magma_int_t magma_get_dsygst_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dsygst_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1031,6 +1104,7 @@ magma_int_t magma_get_dsygst_nb( magma_int_t n )
 /// @return nb for chegst based on n
 magma_int_t magma_get_chegst_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "chegst_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1049,6 +1123,7 @@ magma_int_t magma_get_chegst_nb( magma_int_t n )
 /// @return nb for zhegst based on n
 magma_int_t magma_get_zhegst_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zhegst_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1068,24 +1143,28 @@ magma_int_t magma_get_zhegst_nb( magma_int_t n )
 /// @return nb for sgetri based on n
 magma_int_t magma_get_sgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "sgetri_nb", n, 0 );
     return 64;
 }
 
 /// @return nb for dgetri based on n
 magma_int_t magma_get_dgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dgetri_nb", n, 0 );
     return 64;
 }
 
 /// @return nb for cgetri based on n
 magma_int_t magma_get_cgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "cgetri_nb", n, 0 );
     return 64;
 }
 
 /// @return nb for zgetri based on n
 magma_int_t magma_get_zgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zgetri_nb", n, 0 );
     return 64;
 }
 
@@ -1094,24 +1173,28 @@ magma_int_t magma_get_zgetri_nb( magma_int_t n )
 /// @return nb for sgesvd based on m, n
 magma_int_t magma_get_sgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "sgesvd_nb", min( m, n ), 0 );
     return magma_get_sgebrd_nb( m, n );
 }
 
 /// @return nb for dgesvd based on m, n
 magma_int_t magma_get_dgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "dgesvd_nb", min( m, n ), 0 );
     return magma_get_dgebrd_nb( m, n );
 }
 
 /// @return nb for cgesvd based on m, n
 magma_int_t magma_get_cgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "cgesvd_nb", min( m, n ), 0 );
     return magma_get_cgebrd_nb( m, n );
 }
 
 /// @return nb for zgesvd based on m, n
 magma_int_t magma_get_zgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED( "zgesvd_nb", min( m, n ), 0 );
     return magma_get_zgebrd_nb( m, n );
 }
 
@@ -1120,6 +1203,7 @@ magma_int_t magma_get_zgesvd_nb( magma_int_t m, magma_int_t n )
 /// @return nb for ssygst_m based on n
 magma_int_t magma_get_ssygst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "ssygst_m_nb", n, 0 );
     return 256; //to be updated
 
     /*
@@ -1143,6 +1227,7 @@ magma_int_t magma_get_ssygst_m_nb( magma_int_t n )
 /// @return nb for dsygst_m based on n
 magma_int_t magma_get_dsygst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dsygst_m_nb", n, 0 );
     return 256; //to be updated
 
     /*
@@ -1165,6 +1250,7 @@ magma_int_t magma_get_dsygst_m_nb( magma_int_t n )
 /// @return nb for chegst_m based on n
 magma_int_t magma_get_chegst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "chegst_m_nb", n, 0 );
     return 256; //to be updated
 
     /*
@@ -1187,6 +1273,7 @@ magma_int_t magma_get_chegst_m_nb( magma_int_t n )
 /// @return nb for zhegst_m based on n
 magma_int_t magma_get_zhegst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zhegst_m_nb", n, 0 );
     return 256; //to be updated
 
     /*
@@ -1213,6 +1300,7 @@ magma_int_t magma_get_zhegst_m_nb( magma_int_t n )
 /// @return gpu over cpu performance for 2 stage TRD
 magma_int_t magma_get_sbulge_gcperf( )
 {
+    MAGMA_TUNED( "sbulge_gcperf", 0, 0 );
     magma_int_t perf;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1230,6 +1318,7 @@ magma_int_t magma_get_sbulge_gcperf( )
 /// @return gpu over cpu performance for 2 stage TRD
 magma_int_t magma_get_dbulge_gcperf( )
 {
+    MAGMA_TUNED( "dbulge_gcperf", 0, 0 );
     magma_int_t perf;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1247,6 +1336,7 @@ magma_int_t magma_get_dbulge_gcperf( )
 /// @return gpu over cpu performance for 2 stage TRD
 magma_int_t magma_get_cbulge_gcperf( )
 {
+    MAGMA_TUNED( "cbulge_gcperf", 0, 0 );
     magma_int_t perf;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1264,6 +1354,7 @@ magma_int_t magma_get_cbulge_gcperf( )
 /// @return gpu over cpu performance for 2 stage TRD
 magma_int_t magma_get_zbulge_gcperf( )
 {
+    MAGMA_TUNED( "zbulge_gcperf", 0, 0 );
     magma_int_t perf;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1283,6 +1374,7 @@ magma_int_t magma_get_zbulge_gcperf( )
 /// @return smlsiz for the divide and conquewr routine dlaex0 dstedx zstedx
 magma_int_t magma_get_smlsize_divideconquer()
 {
+    MAGMA_TUNED( "smlsize_divideconquer", 0, 0 );
     return 128;
 }
 
@@ -1292,6 +1384,7 @@ magma_int_t magma_get_smlsize_divideconquer()
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_sbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED( "sbulge_nb", n, nbthreads );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1309,6 +1402,7 @@ magma_int_t magma_get_sbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_dbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED( "dbulge_nb", n, nbthreads );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1326,6 +1420,7 @@ magma_int_t magma_get_dbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_cbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED( "cbulge_nb", n, nbthreads );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1346,6 +1441,7 @@ magma_int_t magma_get_cbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_zbulge_nb( magma_int_t n, magma_int_t nbthreads )
 {
+    MAGMA_TUNED( "zbulge_nb", n, nbthreads );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1368,6 +1464,7 @@ magma_int_t magma_get_zbulge_nb( magma_int_t n, magma_int_t nbthreads )
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_sbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED_MAX( "sbulge_vblksiz", n, nbthreads, nb );
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1382,6 +1479,7 @@ magma_int_t magma_get_sbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_dbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED_MAX( "dbulge_vblksiz", n, nbthreads, nb );
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1396,6 +1494,7 @@ magma_int_t magma_get_dbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_cbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads )
 {
+    MAGMA_TUNED_MAX( "cbulge_vblksiz", n, nbthreads, nb );
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1413,6 +1512,7 @@ magma_int_t magma_get_cbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_zbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads )
 {
+    MAGMA_TUNED_MAX( "zbulge_vblksiz", n, nbthreads, nb );
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1432,6 +1532,7 @@ magma_int_t magma_get_zbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_sbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "sbulge_mgpu_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1449,6 +1550,7 @@ magma_int_t magma_get_sbulge_mgpu_nb( magma_int_t n )
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_dbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "dbulge_mgpu_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1466,6 +1568,7 @@ magma_int_t magma_get_dbulge_mgpu_nb( magma_int_t n )
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_cbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "cbulge_mgpu_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1483,6 +1586,7 @@ magma_int_t magma_get_cbulge_mgpu_nb( magma_int_t n )
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_zbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED( "zbulge_mgpu_nb", n, 0 );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
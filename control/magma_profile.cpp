@@ -0,0 +1,635 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "magma_internal.h"
+#include "magma_timer.h"
+
+// max number of perf_event counters
+static const int max_counters = 8;
+
+// durations are binned by octaves of nanoseconds, each split into nsub
+// buckets of equal width, up to 2^(nbucket/nsub) ns
+static const int nsub    = 8;
+static const int nbucket = 48*nsub;
+
+
+/******************************************************************************/
+// Region of one thread; children are regions started inside it.
+struct profile_node
+{
+    const char* name;
+    profile_node* parent;
+    std::vector< profile_node* > children;
+
+    int64_t  count;
+    double   total, tmin, tmax;  // seconds
+    uint32_t hist[ nbucket ];
+    int64_t  counters[ max_counters ];
+
+    // while open
+    int64_t  start;              // nanoseconds
+    int64_t  start_counters[ max_counters ];
+
+    profile_node( const char* name_, profile_node* parent_ ):
+        name( name_ ), parent( parent_ ),
+        count( 0 ), total( 0 ), tmin( 0 ), tmax( 0 ), start( 0 )
+    {
+        memset( hist, 0, sizeof(hist) );
+        memset( counters, 0, sizeof(counters) );
+        memset( start_counters, 0, sizeof(start_counters) );
+    }
+
+    ~profile_node()
+    {
+        for( size_t i = 0; i < children.size(); ++i ) {
+            delete children[i];
+        }
+    }
+
+    // Returns child with name, adding it if needed.
+    profile_node* child( const char* name_ )
+    {
+        for( size_t i = 0; i < children.size(); ++i ) {
+            if ( children[i]->name == name_ || strcmp( children[i]->name, name_ ) == 0 ) {
+                return children[i];
+            }
+        }
+        children.push_back( new profile_node( name_, this ));
+        return children.back();
+    }
+};
+
+
+/******************************************************************************/
+// Regions and counters of one thread. Only the owner thread modifies it,
+// until the report.
+struct profile_thread
+{
+    profile_node  root;
+    profile_node* current;
+    int           perf_fd;       // group leader, or -1
+
+    profile_thread():
+        root( "", NULL ), current( &root ), perf_fd( -1 )
+    {}
+};
+
+
+/******************************************************************************/
+// Global state, created on first use and never destroyed, so it is still
+// valid in the atexit report.
+struct profile_state
+{
+    bool        enabled;
+    bool        reported;        // an explicit report was written
+    std::string output;
+    bool        counters_fixed;  // counter set decided by the first thread
+    int         ncounter;
+    std::string counter_names[ max_counters ];
+    uint32_t    counter_type  [ max_counters ];
+    uint64_t    counter_config[ max_counters ];
+
+    std::mutex  mutex;           // protects threads
+    std::vector< profile_thread* > threads;
+
+    profile_state();
+};
+
+static void profile_atexit();
+
+profile_state::profile_state():
+    enabled( false ),
+    reported( false ),
+    counters_fixed( false ),
+    ncounter( 0 )
+{
+    const char* str = getenv( "MAGMA_PROFILE" );
+    if ( str == NULL || str[0] == '\0' || strcmp( str, "0" ) == 0 ) {
+        return;
+    }
+    enabled = true;
+    output = str;
+
+    #if defined(__linux__)
+    std::string events;
+    const char* env = getenv( "MAGMA_PROFILE_EVENTS" );
+    if ( env != NULL ) {
+        events = std::string( env ) + ",";
+    }
+    size_t pos = 0;
+    while( pos < events.size() ) {
+        size_t end = events.find( ',', pos );
+        std::string event = events.substr( pos, end - pos );
+        pos = end + 1;
+
+        uint32_t type = PERF_TYPE_HARDWARE;
+        uint64_t config;
+        if ( event == "" ) {
+            continue;
+        }
+        else if ( event == "default" ) {
+            events.insert( pos, "cycles,instructions,llc-misses," );
+            continue;
+        }
+        else if ( event == "cycles" ) {
+            config = PERF_COUNT_HW_CPU_CYCLES;
+        }
+        else if ( event == "instructions" ) {
+            config = PERF_COUNT_HW_INSTRUCTIONS;
+        }
+        else if ( event == "llc-misses" ) {
+            config = PERF_COUNT_HW_CACHE_MISSES;
+        }
+        else if ( event == "branch-misses" ) {
+            config = PERF_COUNT_HW_BRANCH_MISSES;
+        }
+        else if ( event.size() > 1 && event[0] == 'r' ) {
+            type   = PERF_TYPE_RAW;
+            config = strtoull( event.c_str() + 1, NULL, 16 );
+        }
+        else {
+            fprintf( stderr, "MAGMA_PROFILE_EVENTS: unknown event '%s'; skipped.\n", event.c_str() );
+            continue;
+        }
+        if ( ncounter == max_counters ) {
+            fprintf( stderr, "MAGMA_PROFILE_EVENTS: more than %d events; '%s' skipped.\n",
+                     max_counters, event.c_str() );
+            continue;
+        }
+        counter_names [ ncounter ] = event;
+        counter_type  [ ncounter ] = type;
+        counter_config[ ncounter ] = config;
+        ncounter += 1;
+    }
+    #endif
+
+    atexit( profile_atexit );
+}
+
+static profile_state& profile()
+{
+    static profile_state* state = new profile_state();
+    return *state;
+}
+
+// region data of the calling thread, created on its first region
+static thread_local profile_thread* thread_profile = NULL;
+
+
+/******************************************************************************/
+static inline int64_t profile_now()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+/******************************************************************************/
+#if defined(__linux__)
+// Opens the counters as one group on the calling thread, user space only.
+// The first thread decides the counter set: counters that fail on it are
+// removed from the state. The report has one column per counter, so a later
+// thread on which any counter fails counts nothing, rather than shifting
+// the columns.
+static void profile_open_counters( profile_state& state, profile_thread* thread )
+{
+    std::lock_guard< std::mutex > lock( state.mutex );
+    int fds[ max_counters ];
+    int nfd = 0;
+    int i = 0;
+    while( i < state.ncounter ) {
+        struct perf_event_attr attr;
+        memset( &attr, 0, sizeof(attr) );
+        attr.size           = sizeof(attr);
+        attr.type           = state.counter_type[i];
+        attr.config         = state.counter_config[i];
+        attr.read_format    = PERF_FORMAT_GROUP;
+        attr.disabled       = (thread->perf_fd == -1);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        int fd = (int) syscall( __NR_perf_event_open, &attr, 0, -1, thread->perf_fd, 0 );
+        if ( fd == -1 && state.counters_fixed ) {
+            fprintf( stderr, "MAGMA_PROFILE_EVENTS: cannot open '%s' on a new thread: %s;"
+                     " no counters on this thread.\n",
+                     state.counter_names[i].c_str(), strerror( errno ));
+            for( int j = 0; j < nfd; ++j ) {
+                close( fds[j] );
+            }
+            thread->perf_fd = -1;
+            return;
+        }
+        if ( fd == -1 ) {
+            fprintf( stderr, "MAGMA_PROFILE_EVENTS: cannot open '%s': %s; skipped.\n",
+                     state.counter_names[i].c_str(), strerror( errno ));
+            for( int j = i; j < state.ncounter-1; ++j ) {
+                state.counter_names [j] = state.counter_names [j+1];
+                state.counter_type  [j] = state.counter_type  [j+1];
+                state.counter_config[j] = state.counter_config[j+1];
+            }
+            state.ncounter -= 1;
+            continue;
+        }
+        if ( thread->perf_fd == -1 ) {
+            thread->perf_fd = fd;
+        }
+        fds[ nfd++ ] = fd;
+        i += 1;
+    }
+    state.counters_fixed = true;
+    if ( thread->perf_fd != -1 ) {
+        ioctl( thread->perf_fd, PERF_EVENT_IOC_RESET,  PERF_IOC_FLAG_GROUP );
+        ioctl( thread->perf_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+    }
+}
+
+// Reads the group of counters into values.
+static inline void profile_read_counters( profile_thread* thread, int64_t* values )
+{
+    uint64_t buf[ 1 + max_counters ];
+    if ( read( thread->perf_fd, buf, sizeof(buf) ) > 0 ) {
+        for( uint64_t i = 0; i < buf[0] && i < (uint64_t) max_counters; ++i ) {
+            values[i] = (int64_t) buf[ i+1 ];
+        }
+    }
+}
+#endif
+
+
+/******************************************************************************/
+static profile_thread* profile_thread_get( profile_state& state )
+{
+    if ( thread_profile == NULL ) {
+        profile_thread* thread = new profile_thread;
+        #if defined(__linux__)
+        profile_open_counters( state, thread );
+        #endif
+        std::lock_guard< std::mutex > lock( state.mutex );
+        state.threads.push_back( thread );
+        thread_profile = thread;
+    }
+    return thread_profile;
+}
+
+
+/******************************************************************************/
+void timer_region_start( const char* name )
+{
+    profile_state& state = profile();
+    if ( ! state.enabled ) {
+        return;
+    }
+    profile_thread* thread = profile_thread_get( state );
+    profile_node* node = thread->current->child( name );
+    thread->current = node;
+    #if defined(__linux__)
+    if ( thread->perf_fd != -1 ) {
+        profile_read_counters( thread, node->start_counters );
+    }
+    #endif
+    node->start = profile_now();
+}
+
+
+/******************************************************************************/
+void timer_region_stop()
+{
+    profile_state& state = profile();
+    if ( ! state.enabled ) {
+        return;
+    }
+    int64_t end = profile_now();
+    profile_thread* thread = profile_thread_get( state );
+    profile_node* node = thread->current;
+    if ( node == &thread->root ) {
+        fprintf( stderr, "Error in %s: no region started.\n", __func__ );
+        return;
+    }
+    #if defined(__linux__)
+    if ( thread->perf_fd != -1 ) {
+        int64_t values[ max_counters ] = { 0 };
+        profile_read_counters( thread, values );
+        for( int i = 0; i < state.ncounter; ++i ) {
+            node->counters[i] += values[i] - node->start_counters[i];
+        }
+    }
+    #endif
+
+    int64_t ns = max( end - node->start, (int64_t) 1 );
+    double time = ns * 1e-9;
+    if ( node->count == 0 ) {
+        node->tmin = time;
+        node->tmax = time;
+    }
+    else {
+        node->tmin = min( node->tmin, time );
+        node->tmax = max( node->tmax, time );
+    }
+    node->count += 1;
+    node->total += time;
+
+    // bucket floor( nsub*log2( ns ) ), from the exponent and mantissa
+    int e;
+    double m = frexp( (double) ns, &e );  // ns = m * 2^e, 0.5 <= m < 1
+    int bucket = (e - 1)*nsub + (int)( (2*m - 1)*nsub );
+    node->hist[ min( bucket, nbucket-1 ) ] += 1;
+
+    thread->current = node->parent;
+}
+
+
+/******************************************************************************/
+// Region merged over threads, by path.
+struct profile_merged
+{
+    const char* name;
+    std::vector< profile_merged* > children;
+    int      nthread;
+    int64_t  count;
+    double   total, tmin, tmax, thread_max;
+    uint64_t hist[ nbucket ];
+    int64_t  counters[ max_counters ];
+
+    explicit profile_merged( const char* name_ ):
+        name( name_ ), nthread( 0 ), count( 0 ),
+        total( 0 ), tmin( 0 ), tmax( 0 ), thread_max( 0 )
+    {
+        memset( hist, 0, sizeof(hist) );
+        memset( counters, 0, sizeof(counters) );
+    }
+
+    ~profile_merged()
+    {
+        for( size_t i = 0; i < children.size(); ++i ) {
+            delete children[i];
+        }
+    }
+
+    void merge( const profile_node* node )
+    {
+        if ( node->count > 0 ) {
+            tmin = (count == 0 ? node->tmin : min( tmin, node->tmin ));
+            tmax = (count == 0 ? node->tmax : max( tmax, node->tmax ));
+            nthread    += 1;
+            count      += node->count;
+            total      += node->total;
+            thread_max  = max( thread_max, node->total );
+            for( int i = 0; i < nbucket; ++i ) {
+                hist[i] += node->hist[i];
+            }
+            for( int i = 0; i < max_counters; ++i ) {
+                counters[i] += node->counters[i];
+            }
+        }
+        for( size_t c = 0; c < node->children.size(); ++c ) {
+            profile_merged* child = NULL;
+            for( size_t i = 0; i < children.size(); ++i ) {
+                if ( strcmp( children[i]->name, node->children[c]->name ) == 0 ) {
+                    child = children[i];
+                    break;
+                }
+            }
+            if ( child == NULL ) {
+                child = new profile_merged( node->children[c]->name );
+                children.push_back( child );
+            }
+            child->merge( node->children[c] );
+        }
+    }
+
+    // Returns the p-th percentile, as the middle of its bucket, within the
+    // range of the durations.
+    // Bucket i covers 2^e (1 + j/nsub) to 2^e (1 + (j+1)/nsub) ns,
+    // with e = i / nsub and j = i % nsub.
+    double percentile( double p ) const
+    {
+        int64_t rank = (int64_t) ceil( p * count );
+        int64_t sum = 0;
+        for( int i = 0; i < nbucket; ++i ) {
+            sum += hist[i];
+            if ( sum >= rank && sum > 0 ) {
+                double t = ldexp( 1 + (i % nsub + 0.5) / nsub, i / nsub ) * 1e-9;
+                return min( max( t, tmin ), tmax );
+            }
+        }
+        return tmax;
+    }
+
+    // Returns whether no region in this subtree has been stopped.
+    bool empty() const
+    {
+        if ( count > 0 ) {
+            return false;
+        }
+        for( size_t i = 0; i < children.size(); ++i ) {
+            if ( ! children[i]->empty() ) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+
+/******************************************************************************/
+// Returns str as a JSON string, with quotes, escaping quotes, backslashes,
+// and control characters.
+static std::string profile_json_string( const std::string& str )
+{
+    std::string out( 1, '"' );
+    for( size_t i = 0; i < str.size(); ++i ) {
+        unsigned char c = str[i];
+        if ( c == '"' || c == '\\' ) {
+            out += '\\';
+            out += c;
+        }
+        else if ( c < 0x20 ) {
+            char buf[ 8 ];
+            snprintf( buf, sizeof(buf), "\\u%04x", c );
+            out += buf;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+// Returns str as a CSV field, quoted if it contains a comma, quote, or
+// line break, with quotes doubled.
+static std::string profile_csv_string( const std::string& str )
+{
+    if ( str.find_first_of( ",\"\r\n" ) == std::string::npos ) {
+        return str;
+    }
+    std::string out( 1, '"' );
+    for( size_t i = 0; i < str.size(); ++i ) {
+        if ( str[i] == '"' ) {
+            out += '"';
+        }
+        out += str[i];
+    }
+    out += '"';
+    return out;
+}
+
+
+/******************************************************************************/
+static void profile_write( FILE* file, bool json, const profile_state& state,
+                           const profile_merged* node, const std::string& parent,
+                           int depth, bool& first )
+{
+    std::string path = (depth == 0 ? std::string() :
+                        depth == 1 ? std::string( node->name ) :
+                        parent + "/" + node->name);
+    if ( depth > 0 && node->count > 0 ) {
+        double self = node->total;
+        for( size_t i = 0; i < node->children.size(); ++i ) {
+            self -= node->children[i]->total;
+        }
+        if ( json ) {
+            fprintf( file, "%s\n    {\"path\": %s, \"depth\": %d, \"threads\": %d, \"count\": %lld,"
+                     " \"total\": %.9g, \"self\": %.9g, \"thread_max\": %.9g,"
+                     " \"min\": %.9g, \"mean\": %.9g, \"max\": %.9g,"
+                     " \"p50\": %.3g, \"p90\": %.3g, \"p99\": %.3g",
+                     (first ? "" : ","), profile_json_string( path ).c_str(),
+                     depth, node->nthread, (long long) node->count,
+                     node->total, self, node->thread_max,
+                     node->tmin, node->total / node->count, node->tmax,
+                     node->percentile( 0.50 ), node->percentile( 0.90 ), node->percentile( 0.99 ));
+            if ( state.ncounter > 0 ) {
+                fprintf( file, ", \"counters\": {" );
+                for( int i = 0; i < state.ncounter; ++i ) {
+                    fprintf( file, "%s%s: %lld", (i == 0 ? "" : ", "),
+                             profile_json_string( state.counter_names[i] ).c_str(),
+                             (long long) node->counters[i] );
+                }
+                fprintf( file, "}" );
+            }
+            fprintf( file, "}" );
+        }
+        else {
+            fprintf( file, "%s,%d,%d,%lld,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.3g,%.3g,%.3g",
+                     profile_csv_string( path ).c_str(), depth, node->nthread, (long long) node->count,
+                     node->total, self, node->thread_max,
+                     node->tmin, node->total / node->count, node->tmax,
+                     node->percentile( 0.50 ), node->percentile( 0.90 ), node->percentile( 0.99 ));
+            for( int i = 0; i < state.ncounter; ++i ) {
+                fprintf( file, ",%lld", (long long) node->counters[i] );
+            }
+            fprintf( file, "\n" );
+        }
+        first = false;
+    }
+    for( size_t i = 0; i < node->children.size(); ++i ) {
+        profile_write( file, json, state, node->children[i], path, depth+1, first );
+    }
+}
+
+
+/******************************************************************************/
+// Writes the report and resets all regions. At exit, the report is skipped
+// if an explicit report was written, so it is not overwritten, or if no
+// region was recorded.
+static void profile_report( bool at_exit )
+{
+    profile_state& state = profile();
+    if ( ! state.enabled ) {
+        return;
+    }
+    std::lock_guard< std::mutex > lock( state.mutex );
+
+    profile_merged root( "" );
+    for( size_t t = 0; t < state.threads.size(); ++t ) {
+        root.merge( &state.threads[t]->root );
+    }
+    if ( at_exit && (state.reported || root.empty()) ) {
+        return;
+    }
+
+    FILE* file = stderr;
+    bool json = false;
+    if ( state.output != "1" && state.output != "stderr" ) {
+        file = fopen( state.output.c_str(), "w" );
+        if ( file == NULL ) {
+            fprintf( stderr, "Can't open file '%s': %s (%d)\n",
+                     state.output.c_str(), strerror( errno ), errno );
+            return;
+        }
+        size_t len = state.output.size();
+        json = (len >= 5 && state.output.compare( len - 5, 5, ".json" ) == 0);
+    }
+
+    bool first = true;
+    if ( json ) {
+        fprintf( file, "{\"regions\": [" );
+        profile_write( file, json, state, &root, "", 0, first );
+        fprintf( file, "\n]}\n" );
+    }
+    else {
+        fprintf( file, "path,depth,threads,count,total,self,thread_max,min,mean,max,p50,p90,p99" );
+        for( int i = 0; i < state.ncounter; ++i ) {
+            fprintf( file, ",%s", profile_csv_string( state.counter_names[i] ).c_str() );
+        }
+        fprintf( file, "\n" );
+        profile_write( file, json, state, &root, "", 0, first );
+    }
+    if ( file != stderr ) {
+        fclose( file );
+    }
+    if ( ! at_exit ) {
+        state.reported = true;
+    }
+
+    // reset; open regions are kept
+    for( size_t t = 0; t < state.threads.size(); ++t ) {
+        profile_thread* thread = state.threads[t];
+        std::vector< profile_node* > stack( 1, &thread->root );
+        while( ! stack.empty() ) {
+            profile_node* node = stack.back();
+            stack.pop_back();
+            node->count = 0;
+            node->total = node->tmin = node->tmax = 0;
+            memset( node->hist, 0, sizeof(node->hist) );
+            memset( node->counters, 0, sizeof(node->counters) );
+            stack.insert( stack.end(), node->children.begin(), node->children.end() );
+        }
+    }
+}
+
+
+/******************************************************************************/
+void timer_region_report()
+{
+    profile_report( false );
+}
+
+
+/******************************************************************************/
+static void profile_atexit()
+{
+    profile_report( true );
+}
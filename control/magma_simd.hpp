@@ -0,0 +1,465 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#ifndef MAGMA_SIMD_HPP
+#define MAGMA_SIMD_HPP
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#endif
+
+#include "magma_internal.h"
+
+/*
+    Vectorized level 1 operations on short vectors, for CPU kernels that
+    work on tiles small enough that BLAS call overhead dominates, such as
+    the bulge chasing kernels magma_zhbtype{1,2,3}cb.
+
+    Templates cover all four precisions: magma_simd_traits<T> gives the real
+    type and number of components of T, and the operations process complex
+    vectors as interleaved real vectors. magma_simd<R> wraps the SIMD
+    register of real type R for the target instruction set, chosen at
+    compile time: AVX-512, else AVX2 with FMA, else none, in which case
+    MAGMA_SIMD is undefined and only the scalar loops are compiled. Without
+    vector fused multiply-add, optimized BLAS usually does better, so
+    callers should keep a BLAS path for builds where MAGMA_SIMD is undefined.
+*/
+
+
+/******************************************************************************/
+// Real type and number of components (1 real, 2 complex) of T.
+template< typename T > struct magma_simd_traits;
+
+template<> struct magma_simd_traits< float >
+{
+    typedef float real_t;
+    enum { ncomponent = 1 };
+    static inline float make( float re, float im ) { return re; }
+};
+
+template<> struct magma_simd_traits< double >
+{
+    typedef double real_t;
+    enum { ncomponent = 1 };
+    static inline double make( double re, double im ) { return re; }
+};
+
+template<> struct magma_simd_traits< magmaFloatComplex >
+{
+    typedef float real_t;
+    enum { ncomponent = 2 };
+    static inline magmaFloatComplex make( float re, float im ) { return MAGMA_C_MAKE( re, im ); }
+};
+
+template<> struct magma_simd_traits< magmaDoubleComplex >
+{
+    typedef double real_t;
+    enum { ncomponent = 2 };
+    static inline magmaDoubleComplex make( double re, double im ) { return MAGMA_Z_MAKE( re, im ); }
+};
+
+
+/******************************************************************************/
+// SIMD register of real type R, with width lanes.
+// swap exchanges adjacent lanes, i.e., real and imaginary parts;
+// pair( even, odd ) sets lanes to [even, odd, even, odd, ...].
+template< typename R > struct magma_simd;
+
+#if defined(__AVX512F__)
+#define MAGMA_SIMD 512
+
+template<> struct magma_simd< double >
+{
+    typedef __m512d type;
+    enum { width = 8 };
+    static inline type load ( const double* x )         { return _mm512_loadu_pd( x ); }
+    static inline void store( double* x, type a )       { _mm512_storeu_pd( x, a ); }
+    static inline type set1 ( double a )                { return _mm512_set1_pd( a ); }
+    static inline type zero ()                          { return _mm512_setzero_pd(); }
+    static inline type fmadd( type a, type b, type c )  { return _mm512_fmadd_pd( a, b, c ); }
+    static inline type swap ( type a )                  { return _mm512_permute_pd( a, 0x55 ); }
+    static inline type pair ( double e, double o )      { return _mm512_setr_pd( e, o, e, o, e, o, e, o ); }
+};
+
+template<> struct magma_simd< float >
+{
+    typedef __m512 type;
+    enum { width = 16 };
+    static inline type load ( const float* x )          { return _mm512_loadu_ps( x ); }
+    static inline void store( float* x, type a )        { _mm512_storeu_ps( x, a ); }
+    static inline type set1 ( float a )                 { return _mm512_set1_ps( a ); }
+    static inline type zero ()                          { return _mm512_setzero_ps(); }
+    static inline type fmadd( type a, type b, type c )  { return _mm512_fmadd_ps( a, b, c ); }
+    static inline type swap ( type a )                  { return _mm512_permute_ps( a, 0xB1 ); }
+    static inline type pair ( float e, float o )        { return _mm512_setr_ps( e, o, e, o, e, o, e, o,
+                                                                                  e, o, e, o, e, o, e, o ); }
+};
+
+#elif defined(__AVX2__) && defined(__FMA__)
+#define MAGMA_SIMD 256
+
+template<> struct magma_simd< double >
+{
+    typedef __m256d type;
+    enum { width = 4 };
+    static inline type load ( const double* x )         { return _mm256_loadu_pd( x ); }
+    static inline void store( double* x, type a )       { _mm256_storeu_pd( x, a ); }
+    static inline type set1 ( double a )                { return _mm256_set1_pd( a ); }
+    static inline type zero ()                          { return _mm256_setzero_pd(); }
+    static inline type fmadd( type a, type b, type c )  { return _mm256_fmadd_pd( a, b, c ); }
+    static inline type swap ( type a )                  { return _mm256_permute_pd( a, 0x5 ); }
+    static inline type pair ( double e, double o )      { return _mm256_setr_pd( e, o, e, o ); }
+};
+
+template<> struct magma_simd< float >
+{
+    typedef __m256 type;
+    enum { width = 8 };
+    static inline type load ( const float* x )          { return _mm256_loadu_ps( x ); }
+    static inline void store( float* x, type a )        { _mm256_storeu_ps( x, a ); }
+    static inline type set1 ( float a )                 { return _mm256_set1_ps( a ); }
+    static inline type zero ()                          { return _mm256_setzero_ps(); }
+    static inline type fmadd( type a, type b, type c )  { return _mm256_fmadd_ps( a, b, c ); }
+    static inline type swap ( type a )                  { return _mm256_permute_ps( a, 0xB1 ); }
+    static inline type pair ( float e, float o )        { return _mm256_setr_ps( e, o, e, o, e, o, e, o ); }
+};
+
+#endif
+
+
+#ifdef MAGMA_SIMD
+/******************************************************************************/
+// Sums of the even and odd lanes of a.
+template< typename R >
+static inline void
+magma_simd_sum_pair( typename magma_simd<R>::type a, R* even, R* odd )
+{
+    typedef magma_simd<R> V;
+    R buf[ V::width ];
+    V::store( buf, a );
+    *even = 0;
+    *odd  = 0;
+    for (int i = 0; i < V::width; i += 2) {
+        *even += buf[i];
+        *odd  += buf[i+1];
+    }
+}
+
+
+/******************************************************************************/
+// In the vector loops below, x, y are real views of length nc*n of the
+// vectors, and vector alpha*x is computed as
+//     alpha_re * x + [-alpha_im, alpha_im, ...] * swap(x)
+// for complex, and conj(x)*y summed as
+//     re = sum( x * y ),  im = sum over pairs of (even - odd) lanes of x * swap(y).
+
+// y += alpha*x for the leading lanes; returns the number of elements done.
+template< typename T >
+static inline magma_int_t
+magma_simd_axpy_vec(
+    magma_int_t n, T alpha, const T* x, T* y )
+{
+    typedef typename magma_simd_traits<T>::real_t R;
+    typedef magma_simd<R> V;
+    typedef typename V::type vec;
+    const int nc = magma_simd_traits<T>::ncomponent;
+
+    const R* xr = (const R*) x;
+    R*       yr = (R*) y;
+    magma_int_t len = nc*n, i = 0;
+    vec a_re = V::set1( real( alpha ));
+    vec a_im = V::pair( -imag( alpha ), imag( alpha ));
+    for (; i + V::width <= len; i += V::width) {
+        vec vx = V::load( xr + i );
+        vec vy = V::fmadd( a_re, vx, V::load( yr + i ));
+        if (nc == 2) {
+            vy = V::fmadd( a_im, V::swap( vx ), vy );
+        }
+        V::store( yr + i, vy );
+    }
+    return i / nc;
+}
+#endif  // MAGMA_SIMD
+
+
+/***************************************************************************//**
+    y := y + alpha*x, for vectors of length n.
+*******************************************************************************/
+template< typename T >
+static inline void
+magma_simd_axpy(
+    magma_int_t n, T alpha, const T* x, T* y )
+{
+    magma_int_t i = 0;
+    #ifdef MAGMA_SIMD
+    i = magma_simd_axpy_vec( n, alpha, x, y );
+    #endif
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+
+/***************************************************************************//**
+    @return sum_i conj( x[i] ) * y[i], for vectors of length n.
+*******************************************************************************/
+template< typename T >
+static inline T
+magma_simd_dotc(
+    magma_int_t n, const T* x, const T* y )
+{
+    typedef typename magma_simd_traits<T>::real_t R;
+    R s_re = 0, s_im = 0;
+    magma_int_t i = 0;
+
+    #ifdef MAGMA_SIMD
+    typedef magma_simd<R> V;
+    typedef typename V::type vec;
+    const int nc = magma_simd_traits<T>::ncomponent;
+    const R* xr = (const R*) x;
+    const R* yr = (const R*) y;
+    magma_int_t len = nc*n;
+    vec acc1 = V::zero(), acc2 = V::zero();
+    for (; i + V::width <= len; i += V::width) {
+        vec vx = V::load( xr + i );
+        vec vy = V::load( yr + i );
+        acc1 = V::fmadd( vx, vy, acc1 );
+        if (nc == 2) {
+            acc2 = V::fmadd( vx, V::swap( vy ), acc2 );
+        }
+    }
+    R even, odd;
+    magma_simd_sum_pair<R>( acc1, &even, &odd );
+    s_re = even + odd;
+    magma_simd_sum_pair<R>( acc2, &even, &odd );
+    s_im = even - odd;
+    i /= nc;
+    #endif
+
+    T s = magma_simd_traits<T>::make( s_re, s_im );
+    for (; i < n; ++i) {
+        s += conj( x[i] ) * y[i];
+    }
+    return s;
+}
+
+
+/***************************************************************************//**
+    Column of a Hermitian matrix-vector product, reading column a once:
+    y := y + alpha*a, and
+    @return sum_i conj( a[i] ) * v[i], for vectors of length n.
+*******************************************************************************/
+template< typename T >
+static inline T
+magma_simd_hemv_col(
+    magma_int_t n, T alpha, const T* a, const T* v, T* y )
+{
+    typedef typename magma_simd_traits<T>::real_t R;
+    R s_re = 0, s_im = 0;
+    magma_int_t i = 0;
+
+    #ifdef MAGMA_SIMD
+    typedef magma_simd<R> V;
+    typedef typename V::type vec;
+    const int nc = magma_simd_traits<T>::ncomponent;
+    const R* ar = (const R*) a;
+    const R* vr = (const R*) v;
+    R*       yr = (R*) y;
+    magma_int_t len = nc*n;
+    vec a_re = V::set1( real( alpha ));
+    vec a_im = V::pair( -imag( alpha ), imag( alpha ));
+    vec acc1 = V::zero(), acc2 = V::zero();
+    for (; i + V::width <= len; i += V::width) {
+        vec va = V::load( ar + i );
+        vec vv = V::load( vr + i );
+        vec vy = V::fmadd( a_re, va, V::load( yr + i ));
+        acc1 = V::fmadd( va, vv, acc1 );
+        if (nc == 2) {
+            vy   = V::fmadd( a_im, V::swap( va ), vy );
+            acc2 = V::fmadd( va, V::swap( vv ), acc2 );
+        }
+        V::store( yr + i, vy );
+    }
+    R even, odd;
+    magma_simd_sum_pair<R>( acc1, &even, &odd );
+    s_re = even + odd;
+    magma_simd_sum_pair<R>( acc2, &even, &odd );
+    s_im = even - odd;
+    i /= nc;
+    #endif
+
+    T s = magma_simd_traits<T>::make( s_re, s_im );
+    for (; i < n; ++i) {
+        y[i] += alpha * a[i];
+        s += conj( a[i] ) * v[i];
+    }
+    return s;
+}
+
+
+/***************************************************************************//**
+    y := y + alpha*x, then
+    @return sum_i conj( u[i] ) * y[i] of the updated y, for vectors of length n.
+    Fuses a rank-1 update of a column with the dot product of the next
+    reflector applied to it.
+*******************************************************************************/
+template< typename T >
+static inline T
+magma_simd_axpy_dotc(
+    magma_int_t n, T alpha, const T* x, T* y, const T* u )
+{
+    typedef typename magma_simd_traits<T>::real_t R;
+    R s_re = 0, s_im = 0;
+    magma_int_t i = 0;
+
+    #ifdef MAGMA_SIMD
+    typedef magma_simd<R> V;
+    typedef typename V::type vec;
+    const int nc = magma_simd_traits<T>::ncomponent;
+    const R* xr = (const R*) x;
+    const R* ur = (const R*) u;
+    R*       yr = (R*) y;
+    magma_int_t len = nc*n;
+    vec a_re = V::set1( real( alpha ));
+    vec a_im = V::pair( -imag( alpha ), imag( alpha ));
+    vec acc1 = V::zero(), acc2 = V::zero();
+    for (; i + V::width <= len; i += V::width) {
+        vec vx = V::load( xr + i );
+        vec vu = V::load( ur + i );
+        vec vy = V::fmadd( a_re, vx, V::load( yr + i ));
+        if (nc == 2) {
+            vy   = V::fmadd( a_im, V::swap( vx ), vy );
+            acc2 = V::fmadd( vu, V::swap( vy ), acc2 );
+        }
+        acc1 = V::fmadd( vu, vy, acc1 );
+        V::store( yr + i, vy );
+    }
+    R even, odd;
+    magma_simd_sum_pair<R>( acc1, &even, &odd );
+    s_re = even + odd;
+    magma_simd_sum_pair<R>( acc2, &even, &odd );
+    s_im = even - odd;
+    i /= nc;
+    #endif
+
+    T s = magma_simd_traits<T>::make( s_re, s_im );
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+        s += conj( u[i] ) * y[i];
+    }
+    return s;
+}
+
+
+/***************************************************************************//**
+    Column of a Hermitian rank-2 update, reading and writing column a once:
+    a := a + alpha*x + beta*y, for vectors of length n.
+*******************************************************************************/
+template< typename T >
+static inline void
+magma_simd_axpy2(
+    magma_int_t n, T alpha, const T* x, T beta, const T* y, T* a )
+{
+    magma_int_t i = 0;
+
+    #ifdef MAGMA_SIMD
+    typedef typename magma_simd_traits<T>::real_t R;
+    typedef magma_simd<R> V;
+    typedef typename V::type vec;
+    const int nc = magma_simd_traits<T>::ncomponent;
+    const R* xr = (const R*) x;
+    const R* yr = (const R*) y;
+    R*       ar = (R*) a;
+    magma_int_t len = nc*n;
+    vec a_re = V::set1( real( alpha ));
+    vec a_im = V::pair( -imag( alpha ), imag( alpha ));
+    vec b_re = V::set1( real( beta ));
+    vec b_im = V::pair( -imag( beta ), imag( beta ));
+    for (; i + V::width <= len; i += V::width) {
+        vec vx = V::load( xr + i );
+        vec vy = V::load( yr + i );
+        vec va = V::load( ar + i );
+        va = V::fmadd( a_re, vx, va );
+        va = V::fmadd( b_re, vy, va );
+        if (nc == 2) {
+            va = V::fmadd( a_im, V::swap( vx ), va );
+            va = V::fmadd( b_im, V::swap( vy ), va );
+        }
+        V::store( ar + i, va );
+    }
+    i /= nc;
+    #endif
+
+    for (; i < n; ++i) {
+        a[i] += alpha * x[i] + beta * y[i];
+    }
+}
+
+
+/***************************************************************************//**
+    y := y + A*x, for m-by-n matrix A with leading dimension lda.
+    Four columns are applied per pass over y, to keep y in registers.
+*******************************************************************************/
+template< typename T >
+static inline void
+magma_simd_gemv(
+    magma_int_t m, magma_int_t n, const T* A, magma_int_t lda,
+    const T* x, T* y )
+{
+    magma_int_t j = 0;
+
+    #ifdef MAGMA_SIMD
+    typedef typename magma_simd_traits<T>::real_t R;
+    typedef magma_simd<R> V;
+    typedef typename V::type vec;
+    const int nc = magma_simd_traits<T>::ncomponent;
+    R* yr = (R*) y;
+    magma_int_t len = nc*m;
+    for (; j + 4 <= n; j += 4) {
+        const R* a0 = (const R*) (A + (j  )*lda);
+        const R* a1 = (const R*) (A + (j+1)*lda);
+        const R* a2 = (const R*) (A + (j+2)*lda);
+        const R* a3 = (const R*) (A + (j+3)*lda);
+        vec x0_re = V::set1( real( x[j  ] )),  x0_im = V::pair( -imag( x[j  ] ), imag( x[j  ] ));
+        vec x1_re = V::set1( real( x[j+1] )),  x1_im = V::pair( -imag( x[j+1] ), imag( x[j+1] ));
+        vec x2_re = V::set1( real( x[j+2] )),  x2_im = V::pair( -imag( x[j+2] ), imag( x[j+2] ));
+        vec x3_re = V::set1( real( x[j+3] )),  x3_im = V::pair( -imag( x[j+3] ), imag( x[j+3] ));
+        magma_int_t i = 0;
+        for (; i + V::width <= len; i += V::width) {
+            vec va0 = V::load( a0 + i );
+            vec va1 = V::load( a1 + i );
+            vec va2 = V::load( a2 + i );
+            vec va3 = V::load( a3 + i );
+            vec vy  = V::load( yr + i );
+            vy = V::fmadd( x0_re, va0, vy );
+            vy = V::fmadd( x1_re, va1, vy );
+            vy = V::fmadd( x2_re, va2, vy );
+            vy = V::fmadd( x3_re, va3, vy );
+            if (nc == 2) {
+                vy = V::fmadd( x0_im, V::swap( va0 ), vy );
+                vy = V::fmadd( x1_im, V::swap( va1 ), vy );
+                vy = V::fmadd( x2_im, V::swap( va2 ), vy );
+                vy = V::fmadd( x3_im, V::swap( va3 ), vy );
+            }
+            V::store( yr + i, vy );
+        }
+        for (i /= nc; i < m; ++i) {
+            y[i] += A[i + (j  )*lda] * x[j  ]
+                 +  A[i + (j+1)*lda] * x[j+1]
+                 +  A[i + (j+2)*lda] * x[j+2]
+                 +  A[i + (j+3)*lda] * x[j+3];
+        }
+    }
+    #endif
+
+    for (; j < n; ++j) {
+        magma_simd_axpy( m, x[j], A + j*lda, y );
+    }
+}
+
+#endif  // MAGMA_SIMD_HPP
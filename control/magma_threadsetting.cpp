@@ -245,3 +245,109 @@ void magma_set_omp_numthreads(magma_int_t threads)
     omp_set_num_threads( threads );
 #endif
 }
+
+
+/******************************************************************************/
+// settings of the bulge chasing in magma_*hetrd_hb2st; 0 threads means use
+// magma_get_parallel_numthreads
+static magma_int_t            g_bulge_numthreads = 0;
+static magma_bulge_schedule_t g_bulge_schedule   = MagmaBulgeDynamic;
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    @return Number of threads used by the bulge chasing (band to tridiagonal
+    reduction, magma_zhetrd_hb2st) of the 2-stage eigensolvers.
+    Unless set by magma_set_bulge_numthreads, this is "bulge_numthreads"
+    in the tuning table for n and magma_get_parallel_numthreads threads,
+    if any, else magma_get_parallel_numthreads.
+
+    Arguments
+    ---------
+    @param[in]
+    n       INTEGER
+            Order of the matrix.
+
+    @sa magma_set_bulge_numthreads
+    @sa magma_tune_get
+    @sa magma_get_parallel_numthreads
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_int_t magma_get_bulge_numthreads( magma_int_t n )
+{
+    if ( g_bulge_numthreads > 0 ) {
+        return g_bulge_numthreads;
+    }
+    magma_int_t threads = magma_get_parallel_numthreads();
+    magma_int_t tuned;
+    if ( magma_tune_get( "bulge_numthreads", n, threads, &tuned )) {
+        threads = max( 1, min( tuned, threads ));
+    }
+    return threads;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Sets the number of threads used by the bulge chasing of the 2-stage
+    eigensolvers.
+
+    Arguments
+    ---------
+    @param[in]
+    threads INTEGER
+            Number of threads to use. threads >= 1.
+            If threads < 1, the default magma_get_parallel_numthreads is
+            restored.
+
+    @sa magma_get_bulge_numthreads
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+void magma_set_bulge_numthreads(magma_int_t threads)
+{
+    g_bulge_numthreads = max( 0, threads );
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    @return Schedule used by the bulge chasing of the 2-stage eigensolvers,
+    MagmaBulgeDynamic by default.
+
+    @sa magma_set_bulge_schedule
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_bulge_schedule_t magma_get_bulge_schedule()
+{
+    return g_bulge_schedule;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Sets the schedule used by the bulge chasing of the 2-stage eigensolvers.
+
+    Arguments
+    ---------
+    @param[in]
+    schedule magma_bulge_schedule_t
+      -     = MagmaBulgeStatic:  each thread owns fixed columns of the band and
+                                 spins until the tasks it depends on are done.
+      -     = MagmaBulgeDynamic: threads take groups of consecutive sweeps on
+                                 demand and sleep while waiting.
+
+    @sa magma_get_bulge_schedule
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+void magma_set_bulge_schedule(magma_bulge_schedule_t schedule)
+{
+    g_bulge_schedule = schedule;
+}
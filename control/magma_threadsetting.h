@@ -18,12 +18,23 @@ extern "C" {
 // =============================================================================
 // Internal routines
 
+// schedule of the bulge chasing in magma_*hetrd_hb2st
+typedef enum {
+    MagmaBulgeStatic  = 0,
+    MagmaBulgeDynamic = 1
+} magma_bulge_schedule_t;
+
 void magma_set_omp_numthreads(magma_int_t numthreads);
 void magma_set_lapack_numthreads(magma_int_t numthreads);
 magma_int_t magma_get_lapack_numthreads();
 magma_int_t magma_get_parallel_numthreads();
 magma_int_t magma_get_omp_numthreads();
 
+magma_int_t magma_get_bulge_numthreads( magma_int_t n );
+void magma_set_bulge_numthreads(magma_int_t numthreads);
+magma_bulge_schedule_t magma_get_bulge_schedule();
+void magma_set_bulge_schedule(magma_bulge_schedule_t schedule);
+
 #ifdef __cplusplus
 }
 #endif
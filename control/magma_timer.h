@@ -244,4 +244,77 @@ static inline int timer_snprintf( char* str, size_t size, const char* format, ..
     return len;
 }
 
+
+/***************************************************************************//**
+    Profiling regions.
+
+    Unlike the timers above, regions are compiled in and enabled at runtime
+    by setting $MAGMA_PROFILE:
+      -     = 1 or stderr:  CSV report on stderr at exit;
+      -     = file.json:    JSON report in file.json at exit;
+      -     = file:         CSV report in file at exit;
+      -     unset or 0:     disabled; each call only checks a flag.
+
+    Regions nest: a region started inside another is reported as its child,
+    with path "parent/child". Each thread aggregates its own regions without
+    locking; the report merges threads by path, with count, total and self
+    time (total minus children), min, mean, max, and approximate 50th, 90th,
+    and 99th percentiles (within 6.25%). Region and counter names are
+    escaped in the JSON report and quoted in the CSV report as needed.
+
+    On Linux, $MAGMA_PROFILE_EVENTS adds perf_event hardware counters per
+    region, as a comma-separated list of
+    cycles, instructions, llc-misses, branch-misses, or raw events rNNNN
+    as in perf(1), e.g., r01c7 for scalar double FP ops on Intel,
+    or "default" for cycles,instructions,llc-misses. Counters that cannot
+    be opened, e.g., due to /proc/sys/kernel/perf_event_paranoid, are
+    reported and skipped.
+
+    @param[in]
+    name    Region name. Must outlive the program, e.g., a string literal.
+
+    @ingroup magma_timer
+*******************************************************************************/
+void timer_region_start( const char* name );
+
+/// Ends the region started last on this thread.
+/// @ingroup magma_timer
+void timer_region_stop();
+
+/// Writes the report now and resets all regions. Once called, no report is
+/// written at exit, so regions recorded afterwards need another call.
+/// Each call replaces the report file. No other thread may be in a region.
+/// @ingroup magma_timer
+void timer_region_report();
+
+
+/***************************************************************************//**
+    Profiling region from construction to destruction of the object:
+
+        {
+            timer_region region( "zhetrd_hb2st" );
+            ...
+        }
+
+    @ingroup magma_timer
+*******************************************************************************/
+class timer_region
+{
+public:
+    explicit timer_region( const char* name )
+    {
+        timer_region_start( name );
+    }
+
+    ~timer_region()
+    {
+        timer_region_stop();
+    }
+
+private:
+    // not copyable
+    timer_region( const timer_region& );
+    timer_region& operator = ( const timer_region& );
+};
+
 #endif        //  #ifndef MAGMA_TIMER_H
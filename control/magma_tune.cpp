@@ -0,0 +1,453 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "magma_internal.h"
+
+// sizes are binned exactly below nsub, then in 1/nsub octaves, up to 2^62
+static const int nsub    = 8;
+static const int nbucket = 60*nsub + nsub;
+
+// min hash slots for parameter names; the slots grow to a power of 2 at
+// least twice the number of parameters, so probing always ends
+static const size_t min_slot = 64;
+
+
+/******************************************************************************/
+// Tuned values of one parameter at one thread count, by size.
+struct tune_curve
+{
+    magma_int_t nthread;
+    std::vector< magma_int_t > n, value;  // tuned points, sorted by n
+    magma_int_t bucket_value[ nbucket ];  // value by size bucket, from points
+};
+
+struct tune_param
+{
+    std::string name;
+    std::vector< tune_curve > curves;     // sorted by nthread
+};
+
+// Immutable once published; magma_tune_set and magma_tune_load build a new one.
+struct tune_table
+{
+    std::vector< tune_param > params;
+    std::vector< int > slot;              // index in params, or -1
+};
+
+// Replaced table, kept for lookups in flight until both reader counts have
+// been seen at zero since it was replaced.
+struct tune_retired
+{
+    tune_table* table;
+    bool        drained[2];
+};
+
+static std::atomic< tune_table* > g_table( NULL );
+static std::atomic< int > g_epoch( 0 );                 // index in g_readers for new lookups
+static std::atomic< int > g_readers[2] = { {0}, {0} };  // lookups in flight, by epoch
+static std::vector< tune_retired > g_retired;
+static std::mutex g_tune_mutex;
+
+
+/******************************************************************************/
+// Returns bucket of size n: n itself below nsub, then nsub per octave.
+static inline int tune_bucket( magma_int_t n )
+{
+    if ( n < nsub ) {
+        return (n < 0 ? 0 : int(n));
+    }
+    int k;
+    frexp( double(n), &k );
+    k -= 1;  // n in [2^k, 2^(k+1)), k >= log2(nsub) = 3
+    if ( int64_t(1) << k > int64_t(n) ) {
+        k -= 1;  // rounded up by conversion to double
+    }
+    int b = nsub*(k - 2) + int((int64_t(n) >> (k - 3)) & (nsub - 1));
+    return min( b, nbucket - 1 );
+}
+
+// Returns log2 of the geometric center of bucket b.
+static double tune_bucket_center( int b )
+{
+    if ( b < nsub ) {
+        return log2( max( 0.5, double(b) ));
+    }
+    int k = b/nsub + 2;
+    int j = b % nsub;
+    return k + log2( (nsub + j + 0.5) / nsub );
+}
+
+// FNV-1a hash of name
+static inline uint32_t tune_hash( const char* name )
+{
+    uint32_t h = 2166136261u;
+    for( const char* p = name; *p != '\0'; ++p ) {
+        h = (h ^ (unsigned char) *p) * 16777619u;
+    }
+    return h;
+}
+
+
+/******************************************************************************/
+// Fills bucket_value with the value of the tuned point nearest in log(n) to
+// each bucket's center; ties go to the smaller n. Points in a bucket are
+// nearer its center than points outside, so tuned sizes map to their own
+// values, unless two of them share a bucket.
+static void tune_curve_fill( tune_curve& curve )
+{
+    size_t npoint = curve.n.size();
+    size_t j = 0;
+    for( int b = 0; b < nbucket; ++b ) {
+        double c = tune_bucket_center( b );
+        while ( j+1 < npoint
+                && fabs( log2( max( 0.5, double(curve.n[j+1]) )) - c )
+                 < fabs( log2( max( 0.5, double(curve.n[j]  ) )) - c )) {
+            ++j;
+        }
+        curve.bucket_value[b] = curve.value[j];
+    }
+}
+
+// Indexes params of table by name; after adding or sorting params.
+static void tune_table_index( tune_table* table )
+{
+    size_t nslot = min_slot;
+    while ( nslot < 2*table->params.size() ) {
+        nslot *= 2;
+    }
+    table->slot.assign( nslot, -1 );
+    for( size_t i = 0; i < table->params.size(); ++i ) {
+        size_t s = tune_hash( table->params[i].name.c_str() ) & (nslot - 1);
+        while ( table->slot[s] >= 0 ) {
+            s = (s + 1) & (nslot - 1);
+        }
+        table->slot[s] = int(i);
+    }
+}
+
+// Adds or replaces the point (n, value) of name at nthread.
+static void tune_table_set(
+    tune_table* table, const char* name,
+    magma_int_t n, magma_int_t nthread, magma_int_t value )
+{
+    std::vector< tune_param >& params = table->params;
+    size_t i = 0;
+    while ( i < params.size() && params[i].name != name ) {
+        ++i;
+    }
+    if ( i == params.size() ) {
+        params.push_back( tune_param() );
+        params[i].name = name;
+    }
+
+    std::vector< tune_curve >& curves = params[i].curves;
+    size_t c = 0;
+    while ( c < curves.size() && curves[c].nthread < nthread ) {
+        ++c;
+    }
+    if ( c == curves.size() || curves[c].nthread != nthread ) {
+        curves.insert( curves.begin() + c, tune_curve() );
+        curves[c].nthread = nthread;
+    }
+
+    tune_curve& curve = curves[c];
+    size_t j = std::lower_bound( curve.n.begin(), curve.n.end(), n ) - curve.n.begin();
+    if ( j < curve.n.size() && curve.n[j] == n ) {
+        curve.value[j] = value;
+    }
+    else {
+        curve.n.insert( curve.n.begin() + j, n );
+        curve.value.insert( curve.value.begin() + j, value );
+    }
+    tune_curve_fill( curve );
+}
+
+// Publishes table in place of the current one; caller holds g_tune_mutex.
+// A lookup counts itself in one of g_readers before loading g_table, so a
+// lookup holding a replaced table is counted from before the replacement.
+// Once each count has been zero since then, no lookup holds it, and it is
+// freed. Each publish flips g_epoch, so new lookups count in the other
+// g_readers and the count left behind drains, even under steady lookups.
+static void tune_publish( tune_table* table )
+{
+    if ( table != NULL ) {
+        tune_table_index( table );
+    }
+    tune_table* old = g_table.exchange( table );
+    if ( old != NULL ) {
+        tune_retired r = { old, { false, false } };
+        g_retired.push_back( r );
+    }
+    g_epoch.store( 1 - g_epoch.load() );
+
+    size_t k = 0;
+    for( size_t i = 0; i < g_retired.size(); ++i ) {
+        tune_retired& r = g_retired[i];
+        for( int e = 0; e < 2; ++e ) {
+            r.drained[e] = r.drained[e] || g_readers[e].load() == 0;
+        }
+        if ( r.drained[0] && r.drained[1] ) {
+            delete r.table;
+        }
+        else {
+            g_retired[k++] = r;
+        }
+    }
+    g_retired.resize( k );
+}
+
+
+/***************************************************************************//**
+    Looks up a parameter in the tuning table. The magma_get_*_nb functions
+    consult this before their built-in defaults. The table is loaded by
+    magma_init from the file in $MAGMA_TUNE, if set, or by magma_tune_load,
+    and written by testing_ztune.
+
+    Each parameter has values at tuned sizes, for one or more thread counts.
+    The value at other sizes is that of the tuned size nearest in log(n),
+    in 1/8 octave steps, so the lookup takes constant time.
+    The values for the largest tuned thread count <= nthread are used, or
+    for the smallest tuned thread count if all are larger.
+
+    @param[in]
+    name    Name of the parameter, e.g., "dgetrf_nb" for magma_get_dgetrf_nb.
+
+    @param[in]
+    n       Size of the problem: n, or min(m, n) for an m-by-n matrix.
+
+    @param[in]
+    nthread Number of CPU threads, for CPU-side parameters; 0 otherwise.
+
+    @param[out]
+    value   On success, the tuned value; unchanged otherwise.
+
+    @return true if the table has name, false otherwise.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C" magma_int_t
+magma_tune_get(
+    const char* name, magma_int_t n, magma_int_t nthread, magma_int_t* value )
+{
+    // seq_cst, so tune_publish sees this lookup or this lookup the new table
+    int epoch = g_epoch.load( std::memory_order_relaxed );
+    g_readers[ epoch ].fetch_add( 1 );
+    const tune_table* table = g_table.load();
+    magma_int_t found = false;
+    if ( table != NULL ) {
+        size_t nslot = table->slot.size();
+        size_t s = tune_hash( name ) & (nslot - 1);
+        while ( table->slot[s] >= 0 ) {
+            const tune_param& param = table->params[ table->slot[s] ];
+            if ( param.name == name ) {
+                const std::vector< tune_curve >& curves = param.curves;
+                size_t c = 0;
+                while ( c+1 < curves.size() && curves[c+1].nthread <= nthread ) {
+                    ++c;
+                }
+                *value = curves[c].bucket_value[ tune_bucket( n ) ];
+                found = true;
+                break;
+            }
+            s = (s + 1) & (nslot - 1);
+        }
+    }
+    g_readers[ epoch ].fetch_sub( 1, std::memory_order_release );
+    return found;
+}
+
+
+/***************************************************************************//**
+    Sets the tuned value of a parameter at size n and nthread threads,
+    adding it to the tuning table. Used by autotuners to try values.
+    Thread safe: concurrent magma_tune_set and magma_tune_load calls are
+    serialized, and lookups by other threads see either the old or the
+    new table. Each call copies the table, so setting many values is
+    better done with magma_tune_load. Replaced tables are freed by a later
+    call, once no lookup can still be using them.
+
+    @param[in]
+    name    Name of the parameter, e.g., "dgetrf_nb".
+
+    @param[in]
+    n       Size of the problem.
+
+    @param[in]
+    nthread Number of CPU threads, or 0 for any.
+
+    @param[in]
+    value   Tuned value.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C" void
+magma_tune_set(
+    const char* name, magma_int_t n, magma_int_t nthread, magma_int_t value )
+{
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    const tune_table* table = g_table.load( std::memory_order_acquire );
+    tune_table* copy = (table != NULL ? new tune_table( *table ) : new tune_table);
+    tune_table_set( copy, name, n, max( 0, nthread ), value );
+    tune_publish( copy );
+}
+
+
+/***************************************************************************//**
+    Removes all parameters from the tuning table, restoring the built-in
+    defaults. Must not be called while other threads call MAGMA.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C" void
+magma_tune_clear()
+{
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    tune_publish( NULL );
+    for( size_t i = 0; i < g_retired.size(); ++i ) {
+        delete g_retired[i].table;
+    }
+    g_retired.clear();
+}
+
+
+/***************************************************************************//**
+    Replaces the tuning table with parameters read from a file.
+    Each line has a parameter name, thread count, size, and value,
+    separated by spaces:
+
+        # name          nthread        n    value
+        dgetrf_nb             0     2048      128
+        dgetrf_nb             0     8192      256
+        dbulge_nb            16    10000      128
+
+    Blank lines and text after # are ignored. The thread count and size
+    must be >= 0, and the value >= 1; all must fit in magma_int_t.
+
+    @param[in]
+    filename    File to read.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_NOT_FOUND if filename cannot be opened.
+    @retval MAGMA_ERR_ILLEGAL_VALUE if a line is invalid; the table is unchanged.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C" magma_int_t
+magma_tune_load( const char* filename )
+{
+    FILE* file = fopen( filename, "r" );
+    if ( file == NULL ) {
+        fprintf( stderr, "%s: cannot open %s: %s\n", __func__, filename, strerror( errno ));
+        return MAGMA_ERR_NOT_FOUND;
+    }
+
+    tune_table* table = new tune_table;
+    magma_int_t info = MAGMA_SUCCESS;
+    char line[ 1024 ], name[ 256 ];
+    long long nthread, n, value;
+    for( int lineno = 1; fgets( line, sizeof(line), file ) != NULL; ++lineno ) {
+        char* comment = strchr( line, '#' );
+        if ( comment != NULL ) {
+            *comment = '\0';
+        }
+        char extra;
+        int cnt = sscanf( line, "%255s %lld %lld %lld %c", name, &nthread, &n, &value, &extra );
+        if ( cnt <= 0 ) {
+            continue;  // blank
+        }
+        if ( cnt != 4 || nthread < 0 || n < 0 || value < 1 ) {
+            fprintf( stderr, "%s: %s:%d: expected name, nthread >= 0, n >= 0, value >= 1\n",
+                     __func__, filename, lineno );
+            info = MAGMA_ERR_ILLEGAL_VALUE;
+            break;
+        }
+        if ( (magma_int_t) nthread != nthread || (magma_int_t) n != n
+             || (magma_int_t) value != value ) {
+            fprintf( stderr, "%s: %s:%d: nthread, n, or value overflows magma_int_t\n",
+                     __func__, filename, lineno );
+            info = MAGMA_ERR_ILLEGAL_VALUE;
+            break;
+        }
+        tune_table_set( table, name, n, nthread, value );
+    }
+    fclose( file );
+
+    if ( info != MAGMA_SUCCESS ) {
+        delete table;
+        return info;
+    }
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    tune_publish( table );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Writes the tuning table to a file, in the format of magma_tune_load.
+
+    @param[in]
+    filename    File to write.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_FILESYSTEM if filename cannot be written.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C" magma_int_t
+magma_tune_save( const char* filename )
+{
+    FILE* file = fopen( filename, "w" );
+    if ( file == NULL ) {
+        fprintf( stderr, "%s: cannot open %s: %s\n", __func__, filename, strerror( errno ));
+        return MAGMA_ERR_FILESYSTEM;
+    }
+
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    const tune_table* table = g_table.load( std::memory_order_acquire );
+
+    // sort by name for diffs between machines
+    std::vector< const tune_param* > params;
+    if ( table != NULL ) {
+        for( size_t i = 0; i < table->params.size(); ++i ) {
+            params.push_back( &table->params[i] );
+        }
+    }
+    std::sort( params.begin(), params.end(),
+               [] (const tune_param* a, const tune_param* b) { return a->name < b->name; } );
+
+    fprintf( file, "# MAGMA tuning table; see magma_tune_load\n"
+                   "# %-20s %8s %10s %8s\n", "name", "nthread", "n", "value" );
+    for( size_t i = 0; i < params.size(); ++i ) {
+        const std::vector< tune_curve >& curves = params[i]->curves;
+        for( size_t c = 0; c < curves.size(); ++c ) {
+            for( size_t j = 0; j < curves[c].n.size(); ++j ) {
+                fprintf( file, "  %-20s %8lld %10lld %8lld\n",
+                         params[i]->name.c_str(), (long long) curves[c].nthread,
+                         (long long) curves[c].n[j], (long long) curves[c].value[j] );
+            }
+        }
+    }
+
+    magma_int_t info = (ferror( file ) ? MAGMA_ERR_FILESYSTEM : MAGMA_SUCCESS);
+    if ( fclose( file ) != 0 ) {
+        info = MAGMA_ERR_FILESYSTEM;
+    }
+    return info;
+}
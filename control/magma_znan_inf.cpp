@@ -75,6 +75,172 @@ int magma_z_isnan_inf( magmaDoubleComplex x )
 }
 
 
+// entries of a column checked at once, in one vectorized pass
+#define NAN_INF_CHUNK 256
+
+// matrices with fewer entries than this are checked by one thread
+#define NAN_INF_PARALLEL 65536
+
+
+/******************************************************************************/
+// Checks entries x[0:len] of a column for NAN and INF, with x[0] in row i0.
+// Counts them in c_nan and c_inf, and sets first to the row of the first one,
+// or -1 if none. If amax is non-NULL, sets it to the max abs of the finite
+// entries, or 0.
+// Each chunk of the column is checked in one vectorized pass, summing x*0,
+// which is NAN iff the chunk has a NAN or INF; only those chunks are checked
+// entry by entry. If amax is non-NULL, the same pass finds the chunk max abs;
+// for complex, as the sqrt of the max of real(x)^2 + imag(x)^2 when that
+// can't over- or underflow, else with |x| of each entry.
+static void magma_znan_inf_col(
+    magma_int_t len, const magmaDoubleComplex *x, magma_int_t i0,
+    magma_int_t *c_nan, magma_int_t *c_inf, magma_int_t *first,
+    double *amax )
+{
+    #ifdef COMPLEX
+    const double *xr = (const double*) x;
+    const double tiny = sqrt( (std::numeric_limits<double>::min)() );
+    const double huge = sqrt( (std::numeric_limits<double>::max)() ) / 2;
+    #endif
+    magma_int_t j_nan = 0, j_inf = 0, j_first = -1;
+    double j_max = 0;
+
+    for (magma_int_t k = 0; k < len; k += NAN_INF_CHUNK) {
+        magma_int_t kend = min( k + NAN_INF_CHUNK, len );
+        double sum = 0, cmax = 0;
+        #ifdef COMPLEX
+        double smax = 0;
+        if (amax == NULL) {
+            #pragma omp simd reduction( +:sum )
+            for (magma_int_t i = 2*k; i < 2*kend; ++i) {
+                sum += xr[i]*0;
+            }
+        }
+        else {
+            #pragma omp simd reduction( +:sum ) reduction( max:cmax, smax )
+            for (magma_int_t i = k; i < kend; ++i) {
+                double re = xr[ 2*i ], im = xr[ 2*i+1 ];
+                double ar = fabs( re ), ai = fabs( im );
+                double s2 = re*re + im*im;
+                sum  += re*0 + im*0;
+                cmax = (ar > cmax ? ar : cmax);
+                cmax = (ai > cmax ? ai : cmax);
+                smax = (s2 > smax ? s2 : smax);
+            }
+        }
+        #else
+        if (amax == NULL) {
+            #pragma omp simd reduction( +:sum )
+            for (magma_int_t i = k; i < kend; ++i) {
+                sum += x[i]*0;
+            }
+        }
+        else {
+            #pragma omp simd reduction( +:sum ) reduction( max:cmax )
+            for (magma_int_t i = k; i < kend; ++i) {
+                double ax = fabs( x[i] );
+                sum  += x[i]*0;
+                cmax = (ax > cmax ? ax : cmax);
+            }
+        }
+        #endif
+
+        if (sum == 0) {
+            // all finite
+            if (amax == NULL) {
+                continue;
+            }
+            #ifdef COMPLEX
+            if (cmax > tiny && cmax < huge) {
+                double ax = sqrt( smax );
+                j_max = (ax > j_max ? ax : j_max);
+            }
+            else {
+                for (magma_int_t i = k; i < kend; ++i) {
+                    double ax = MAGMA_Z_ABS( x[i] );
+                    j_max = (ax > j_max ? ax : j_max);
+                }
+            }
+            #else
+            j_max = (cmax > j_max ? cmax : j_max);
+            #endif
+        }
+        else {
+            for (magma_int_t i = k; i < kend; ++i) {
+                if (magma_z_isnan( x[i] )) {
+                    j_nan++;
+                    j_first = (j_first < 0 ? i0 + i : j_first);
+                }
+                else if (magma_z_isinf( x[i] )) {
+                    j_inf++;
+                    j_first = (j_first < 0 ? i0 + i : j_first);
+                }
+                else if (amax != NULL) {
+                    double ax = MAGMA_Z_ABS( x[i] );
+                    j_max = (ax > j_max ? ax : j_max);
+                }
+            }
+        }
+    }
+
+    *c_nan = j_nan;
+    *c_inf = j_inf;
+    *first = j_first;
+    if (amax != NULL) {
+        *amax = j_max;
+    }
+}
+
+
+/******************************************************************************/
+// Checks the uplo part of A for NAN and INF, with OpenMP over blocks of
+// columns. Totals go in cnt_nan, cnt_inf, and amax; per column counts and
+// first rows go in col_nan, col_inf, col_first. Each output may be NULL.
+// Returns the number of NAN + INF values.
+static magma_int_t magma_znan_inf_scan(
+    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda,
+    magma_int_t *cnt_nan, magma_int_t *cnt_inf, double *amax,
+    magma_int_t *col_nan, magma_int_t *col_inf, magma_int_t *col_first )
+{
+    #define A(i_, j_) (A + (i_) + (j_)*lda)
+
+    magma_int_t c_nan = 0;
+    magma_int_t c_inf = 0;
+    double a_max = 0;
+
+    // blocks of 8 columns, round-robin, to balance triangular parts
+    #pragma omp parallel for schedule( static, 8 ) \
+                             reduction( +:c_nan, c_inf ) reduction( max:a_max ) \
+                             if ( (int64_t) m * n >= NAN_INF_PARALLEL )
+    for (magma_int_t j = 0; j < n; ++j) {
+        magma_int_t ibeg = (uplo == MagmaLower ? j : 0);                // i >= j
+        magma_int_t iend = (uplo == MagmaUpper ? min( j+1, m ) : m);   // i <= j
+        magma_int_t j_nan = 0, j_inf = 0, j_first = -1;
+        double j_max = 0;
+        if (ibeg < iend) {
+            magma_znan_inf_col( iend - ibeg, A(ibeg, j), ibeg,
+                                &j_nan, &j_inf, &j_first,
+                                (amax != NULL ? &j_max : NULL) );
+        }
+        c_nan += j_nan;
+        c_inf += j_inf;
+        a_max = (j_max > a_max ? j_max : a_max);
+        if (col_nan   != NULL) { col_nan[j]   = j_nan;   }
+        if (col_inf   != NULL) { col_inf[j]   = j_inf;   }
+        if (col_first != NULL) { col_first[j] = j_first; }
+    }
+
+    if (cnt_nan != NULL) { *cnt_nan = c_nan; }
+    if (cnt_inf != NULL) { *cnt_inf = c_inf; }
+    if (amax    != NULL) { *amax    = a_max; }
+
+    return (c_nan + c_inf);
+
+    #undef A
+}
+
+
 /***************************************************************************//**
     Purpose
     -------
@@ -84,6 +250,12 @@ int magma_z_isnan_inf( magmaDoubleComplex x )
     NAN is created by 0/0 and similar.
     INF is created by x/0 and similar, where x != 0.
 
+    Columns are checked in vectorized chunks, and large matrices are
+    checked by the OpenMP threads over blocks of columns.
+    See also magma_znan_inf_cols for counts per column,
+    magma_znan_inf_amax for the max abs value in the same pass, and
+    magma_znan_inf_any to stop at the first NAN or INF.
+
     Arguments
     ---------
     @param[in]
@@ -131,8 +303,87 @@ magma_int_t magma_znan_inf(
     magma_int_t *cnt_nan,
     magma_int_t *cnt_inf )
 {
-    #define A(i_, j_) (A + (i_) + (j_)*lda)
+    magma_int_t info = 0;
+    if (uplo != MagmaLower && uplo != MagmaUpper && uplo != MagmaFull)
+        info = -1;
+    else if (m < 0)
+        info = -2;
+    else if (n < 0)
+        info = -3;
+    else if (lda < m)
+        info = -5;
+    
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
     
+    return magma_znan_inf_scan( uplo, m, n, A, lda, cnt_nan, cnt_inf, NULL,
+                                NULL, NULL, NULL );
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    magma_znan_inf_cols checks a matrix that is located on the CPU host
+    for NAN (not-a-number) and INF (infinity) values, column by column,
+    as magma_znan_inf.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+            Specifies what part of the matrix A to check.
+      -     = MagmaUpper:  Upper triangular part of A
+      -     = MagmaLower:  Lower triangular part of A
+      -     = MagmaFull:   All of A
+
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrix A. m >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrix A. n >= 0.
+
+    @param[in]
+    A       COMPLEX_16 array, dimension (lda,n), on the CPU host.
+            The m-by-n matrix to be checked.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A. lda >= m.
+
+    @param[out]
+    col_nan INTEGER array, dimension (n).
+            If non-NULL, on exit col_nan[j] is the number of NAN values
+            in column j of A.
+
+    @param[out]
+    col_inf INTEGER array, dimension (n).
+            If non-NULL, on exit col_inf[j] is the number of INF values
+            in column j of A.
+
+    @param[out]
+    col_first INTEGER array, dimension (n).
+            If non-NULL, on exit col_first[j] is the row index (0-based)
+            of the first NAN or INF value in column j of A, or -1 if none.
+
+    @return
+      -     >= 0:  Returns number of NAN + number of INF values.
+      -     <  0:  If it returns -i, the i-th argument had an illegal value.
+
+    @ingroup magma_nan_inf
+*******************************************************************************/
+extern "C"
+magma_int_t magma_znan_inf_cols(
+    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda,
+    magma_int_t *col_nan,
+    magma_int_t *col_inf,
+    magma_int_t *col_first )
+{
     magma_int_t info = 0;
     if (uplo != MagmaLower && uplo != MagmaUpper && uplo != MagmaFull)
         info = -1;
@@ -148,38 +399,212 @@ magma_int_t magma_znan_inf(
         return info;
     }
     
-    int c_nan = 0;
-    int c_inf = 0;
+    return magma_znan_inf_scan( uplo, m, n, A, lda, NULL, NULL, NULL,
+                                col_nan, col_inf, col_first );
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    magma_znan_inf_amax checks a matrix that is located on the CPU host
+    for NAN (not-a-number) and INF (infinity) values, as magma_znan_inf,
+    and computes the max abs value of its finite entries in the same pass,
+    e.g., to guard a solution and get its max norm at once.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+            Specifies what part of the matrix A to check.
+      -     = MagmaUpper:  Upper triangular part of A
+      -     = MagmaLower:  Lower triangular part of A
+      -     = MagmaFull:   All of A
+
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrix A. m >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrix A. n >= 0.
+
+    @param[in]
+    A       COMPLEX_16 array, dimension (lda,n), on the CPU host.
+            The m-by-n matrix to be checked.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A. lda >= m.
+
+    @param[out]
+    cnt_nan INTEGER*
+            If non-NULL, on exit contains the number of NAN values in A.
+
+    @param[out]
+    cnt_inf INTEGER*
+            If non-NULL, on exit contains the number of INF values in A.
+
+    @param[out]
+    amax    DOUBLE PRECISION*
+            On exit, max | A(i,j) | over the finite entries of the uplo part
+            of A, or 0 if it has none. If A has no NAN or INF, this is
+            the max norm, as zlange( "M" ).
+
+    @return
+      -     >= 0:  Returns number of NAN + number of INF values.
+      -     <  0:  If it returns -i, the i-th argument had an illegal value.
+
+    @ingroup magma_nan_inf
+*******************************************************************************/
+extern "C"
+magma_int_t magma_znan_inf_amax(
+    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda,
+    magma_int_t *cnt_nan,
+    magma_int_t *cnt_inf,
+    double *amax )
+{
+    magma_int_t info = 0;
+    if (uplo != MagmaLower && uplo != MagmaUpper && uplo != MagmaFull)
+        info = -1;
+    else if (m < 0)
+        info = -2;
+    else if (n < 0)
+        info = -3;
+    else if (lda < m)
+        info = -5;
+    else if (amax == NULL)
+        info = -8;
+    
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
     
-    if (uplo == MagmaLower) {
-        for (int j = 0; j < n; ++j) {
-            for (int i = j; i < m; ++i) {  // i >= j
-                if      (magma_z_isnan( *A(i,j) )) { c_nan++; }
-                else if (magma_z_isinf( *A(i,j) )) { c_inf++; }
-            }
+    return magma_znan_inf_scan( uplo, m, n, A, lda, cnt_nan, cnt_inf, amax,
+                                NULL, NULL, NULL );
+}
+
+
+/******************************************************************************/
+// Returns true if x[0:len] has a NAN or INF. Stops at the first chunk whose
+// sum of x*0 is NAN, or before the next chunk once *found is set by
+// another thread.
+static bool magma_znan_inf_col_any(
+    magma_int_t len, const magmaDoubleComplex *x, const int *found )
+{
+    #ifdef COMPLEX
+    const double *xr = (const double*) x;
+    #endif
+    for (magma_int_t k = 0; k < len; k += NAN_INF_CHUNK) {
+        int done;
+        #pragma omp atomic read
+        done = *found;
+        if (done) {
+            return false;
         }
-    }
-    else if (uplo == MagmaUpper) {
-        for (int j = 0; j < n; ++j) {
-            for (int i = 0; i < m && i <= j; ++i) {  // i <= j
-                if      (magma_z_isnan( *A(i,j) )) { c_nan++; }
-                else if (magma_z_isinf( *A(i,j) )) { c_inf++; }
-            }
+        magma_int_t kend = min( k + NAN_INF_CHUNK, len );
+        double sum = 0;
+        #ifdef COMPLEX
+        #pragma omp simd reduction( +:sum )
+        for (magma_int_t i = 2*k; i < 2*kend; ++i) {
+            sum += xr[i]*0;
         }
-    }
-    else if (uplo == MagmaFull) {
-        for (int j = 0; j < n; ++j) {
-            for (int i = 0; i < m; ++i) {
-                if      (magma_z_isnan( *A(i,j) )) { c_nan++; }
-                else if (magma_z_isinf( *A(i,j) )) { c_inf++; }
-            }
+        #else
+        #pragma omp simd reduction( +:sum )
+        for (magma_int_t i = k; i < kend; ++i) {
+            sum += x[i]*0;
+        }
+        #endif
+        if (sum != 0) {
+            return true;
         }
     }
+    return false;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    magma_znan_inf_any checks whether a matrix that is located on the CPU
+    host has any NAN (not-a-number) or INF (infinity) value. Unlike
+    magma_znan_inf, it does not count them: it stops at the first chunk of
+    a column that has one, and the other OpenMP threads stop at their next
+    chunk, so a guard on a matrix with an early NAN or INF is cheap.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+            Specifies what part of the matrix A to check.
+      -     = MagmaUpper:  Upper triangular part of A
+      -     = MagmaLower:  Lower triangular part of A
+      -     = MagmaFull:   All of A
+
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrix A. m >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrix A. n >= 0.
+
+    @param[in]
+    A       COMPLEX_16 array, dimension (lda,n), on the CPU host.
+            The m-by-n matrix to be checked.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A. lda >= m.
+
+    @return
+      -     = 1:   A has a NAN or INF value.
+      -     = 0:   A has no NAN or INF value.
+      -     <  0:  If it returns -i, the i-th argument had an illegal value.
+
+    @ingroup magma_nan_inf
+*******************************************************************************/
+extern "C"
+magma_int_t magma_znan_inf_any(
+    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda )
+{
+    #define A(i_, j_) (A + (i_) + (j_)*lda)
+
+    magma_int_t info = 0;
+    if (uplo != MagmaLower && uplo != MagmaUpper && uplo != MagmaFull)
+        info = -1;
+    else if (m < 0)
+        info = -2;
+    else if (n < 0)
+        info = -3;
+    else if (lda < m)
+        info = -5;
     
-    if (cnt_nan != NULL) { *cnt_nan = c_nan; }
-    if (cnt_inf != NULL) { *cnt_inf = c_inf; }
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
     
-    return (c_nan + c_inf);
+    int found = 0;
+
+    // blocks of 8 columns, round-robin, as in magma_znan_inf
+    #pragma omp parallel for schedule( static, 8 ) \
+                             if ( (int64_t) m * n >= NAN_INF_PARALLEL )
+    for (magma_int_t j = 0; j < n; ++j) {
+        magma_int_t ibeg = (uplo == MagmaLower ? j : 0);                // i >= j
+        magma_int_t iend = (uplo == MagmaUpper ? min( j+1, m ) : m);   // i <= j
+        if (ibeg < iend && magma_znan_inf_col_any( iend - ibeg, A(ibeg, j), &found )) {
+            #pragma omp atomic write
+            found = 1;
+        }
+    }
+
+    return found;
+
+    #undef A
 }
 
 
@@ -0,0 +1,591 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <algorithm>
+
+#include "task_scheduler.hpp"
+#include "affinity.h"
+#include "trace.h"
+
+// number of nodes allocated at once when the pool is empty
+static const magma_int_t node_block_size = 256;
+
+// number of failed steal rounds before an idle worker sleeps
+static const magma_int_t spin_rounds = 64;
+
+// readers of a tag are pruned of finished tasks when the list reaches this size
+static const size_t max_readers = 32;
+
+// If err, prints error and throws exception.
+static void check( int err )
+{
+    if ( err != 0 ) {
+        fprintf( stderr, "Error: %s (%d)\n", strerror(err), err );
+        throw std::exception();
+    }
+}
+
+
+/***************************************************************************//**
+    @class magma_task_scheduler
+
+    Purpose
+    -------
+    Implements a thread pool with per-worker task deques, work stealing,
+    and dependency tracking between tasks. It is an alternative to
+    \ref magma_thread_queue, which uses a single queue under one mutex and
+    tracks no dependencies.
+
+    Each worker owns a deque. Tasks made ready by a worker (i.e., successors
+    of a task it just finished) go to the back of its own deque and are
+    executed LIFO, so data just written is likely still in cache. Tasks
+    submitted by the main thread are distributed round-robin. Idle workers
+    steal from the front of other deques, trying workers on the same NUMA
+    node first. Workers that find no work block on a condition variable
+    rather than spin.
+
+    Dependencies are declared as (tag, mode) pairs, where a tag is any address
+    identifying data, e.g., a tile. A task waits for the previous writer of
+    each tag it reads (read-after-write), and for the previous writer and all
+    readers of each tag it writes (write-after-write, write-after-read).
+    Dependencies are tracked only between tasks submitted since the last sync().
+
+    Tasks must be submitted from one thread (the main thread); tasks themselves
+    must not call push_task. As in \ref magma_thread_queue, tasks are allocated
+    with C++ new and deleted by the scheduler when done. The internal
+    descriptors holding dependency state are pooled and reused, so the
+    scheduler does no allocation in steady state.
+
+    With bind = true, worker i is bound to a cpu from the process' affinity
+    mask, spreading workers evenly across NUMA nodes with consecutive workers
+    on the same node.
+
+    Example
+    -------
+    @code
+    void master( int nt, double** tiles ) {
+        magma_task_scheduler sched;
+        sched.launch( 12 );  // 12 worker threads
+        for( int k=0; k < nt; ++k ) {
+            sched.push_task( new factor_task( tiles[k] ),
+                             { { tiles[k], MagmaAccessInOut } });
+            for( int j=k+1; j < nt; ++j ) {
+                sched.push_task( new update_task( tiles[k], tiles[j] ),
+                                 { { tiles[k], MagmaAccessIn    },
+                                   { tiles[j], MagmaAccessInOut } });
+            }
+        }
+        sched.sync();  // wait for all tasks
+    }
+    @endcode
+
+    @ingroup magma_thread
+*******************************************************************************/
+
+
+/***************************************************************************//**
+    Thread's main routine, executed by pthread_create.
+    @param[in,out] arg    magma_task_worker of the thread.
+*******************************************************************************/
+extern "C"
+void* magma_task_scheduler_main( void* arg )
+{
+    magma_task_worker* worker = (magma_task_worker*) arg;
+    worker->sched->worker_main( worker );
+    return NULL;  // implicitly does pthread_exit
+}
+
+
+/***************************************************************************//**
+    Creates scheduler with NO threads. Use launch() to create threads.
+*******************************************************************************/
+magma_task_scheduler::magma_task_scheduler():
+    tags       (),
+    workers    ( NULL ),
+    nthread    ( 0    ),
+    next_worker( 0    ),
+    ntask      ( 0    ),
+    nready     ( 0    ),
+    nsleep     ( 0    ),
+    quit_flag  ( false ),
+    free_list  ( NULL ),
+    free_shared( NULL ),
+    blocks     ()
+{
+    check( pthread_mutex_init( &mutex,      NULL ));
+    check( pthread_cond_init(  &cond,       NULL ));
+    check( pthread_cond_init(  &cond_ntask, NULL ));
+}
+
+
+/***************************************************************************//**
+    Calls quit(), then deallocates data.
+*******************************************************************************/
+magma_task_scheduler::~magma_task_scheduler()
+{
+    quit();
+    for( size_t i=0; i < blocks.size(); ++i ) {
+        delete[] blocks[i];
+    }
+    check( pthread_mutex_destroy( &mutex ));
+    check( pthread_cond_destroy( &cond ));
+    check( pthread_cond_destroy( &cond_ntask ));
+}
+
+
+/***************************************************************************//**
+    Creates threads.
+    @param[in] in_nthread    Number of threads to launch.
+    @param[in] bind          Whether to bind each thread to a cpu.
+*******************************************************************************/
+void magma_task_scheduler::launch( magma_int_t in_nthread, bool bind )
+{
+    assert( workers == NULL );  // else launch was called previously
+    nthread = in_nthread;
+    if ( nthread < 1 ) {
+        nthread = 1;
+    }
+    workers = new magma_task_worker[ nthread ];
+
+    // cpus allowed for this process, ordered by NUMA node
+    std::vector< std::pair<int,int> > cpus;  // (node, cpu)
+    #ifndef MAGMA_NOAFFINITY
+    if ( bind ) {
+        affinity_set allowed;
+        if ( allowed.get_affinity() == 0 ) {
+            int ncpu = allowed.get_count();
+            for( int i=0; i < ncpu; ++i ) {
+                int cpu = allowed.get_cpu( i );
+                cpus.push_back( std::make_pair( magma_get_cpu_numa_node( cpu ), cpu ));
+            }
+            std::sort( cpus.begin(), cpus.end() );
+        }
+    }
+    #endif
+
+    magma_int_t ncpu = magma_int_t( cpus.size() );
+    for( magma_int_t i=0; i < nthread; ++i ) {
+        magma_task_worker* w = &workers[i];
+        w->sched = this;
+        w->index = i;
+        w->cpu   = -1;
+        w->node  = 0;
+        w->seed  = (unsigned int)( 2*i + 1 );
+        if ( ncpu > 0 ) {
+            // spread workers evenly over cpus; wrap if oversubscribed
+            magma_int_t j = (nthread <= ncpu ? i*ncpu / nthread : i % ncpu);
+            w->node = cpus[j].first;
+            w->cpu  = cpus[j].second;
+        }
+        check( pthread_mutex_init( &w->mutex, NULL ));
+    }
+
+    // victims: workers on same node, then workers on other nodes,
+    // each group starting after this worker to spread out contention.
+    for( magma_int_t i=0; i < nthread; ++i ) {
+        for( magma_int_t pass=0; pass < 2; ++pass ) {
+            for( magma_int_t k=1; k < nthread; ++k ) {
+                magma_int_t j = (i + k) % nthread;
+                bool same = (workers[j].node == workers[i].node);
+                if ( same == (pass == 0) ) {
+                    workers[i].victims.push_back( j );
+                }
+            }
+        }
+    }
+
+    for( magma_int_t i=0; i < nthread; ++i ) {
+        check( pthread_create( &workers[i].thread, NULL, magma_task_scheduler_main, &workers[i] ));
+    }
+}
+
+
+/***************************************************************************//**
+    Worker loop: executes tasks from own deque, else steals from others,
+    else sleeps until tasks are enqueued. Exits when quit() was called and
+    no tasks remain.
+*******************************************************************************/
+void magma_task_scheduler::worker_main( magma_task_worker* worker )
+{
+    #ifndef MAGMA_NOAFFINITY
+    if ( worker->cpu >= 0 ) {
+        affinity_set set( worker->cpu );
+        if ( set.set_affinity() != 0 ) {
+            fprintf( stderr, "Error in sched_setaffinity (cpu %d)\n", worker->cpu );
+        }
+    }
+    #endif
+
+    magma_int_t idle = 0;
+    while( true ) {
+        magma_task_node* node = pop_task( worker );
+        if ( node == NULL ) {
+            node = steal_task( worker );
+        }
+        if ( node != NULL ) {
+            idle = 0;
+            // the flow from the predecessor that released the task, if any,
+            // ends here; task_done starts flows to the tasks it releases
+            trace_cpu_start( 0, "task", NULL );
+            trace_cpu_flow_end( "task", magma_int_t( uintptr_t( node )));
+            node->task->run();
+            task_done( worker, node );
+            trace_cpu_end( 0 );
+            continue;
+        }
+
+        idle += 1;
+        if ( idle < spin_rounds ) {
+            magma_yield();
+            continue;
+        }
+
+        // sleep until there is work or quit.
+        // nsleep is incremented before checking nready, and enqueue increments
+        // nready before checking nsleep, so no wakeup is lost.
+        idle = 0;
+        check( pthread_mutex_lock( &mutex ));
+        nsleep += 1;
+        while( nready == 0 && ! quit_flag ) {
+            check( pthread_cond_wait( &cond, &mutex ));
+        }
+        nsleep -= 1;
+        bool done = (nready == 0 && quit_flag);
+        check( pthread_mutex_unlock( &mutex ));
+        if ( done ) {
+            break;
+        }
+    }
+}
+
+
+/***************************************************************************//**
+    @return task from back of worker's own deque, or NULL if empty.
+*******************************************************************************/
+magma_task_node* magma_task_scheduler::pop_task( magma_task_worker* worker )
+{
+    magma_task_node* node = NULL;
+    check( pthread_mutex_lock( &worker->mutex ));
+    if ( ! worker->deque.empty() ) {
+        node = worker->deque.back();
+        worker->deque.pop_back();
+        nready -= 1;
+    }
+    check( pthread_mutex_unlock( &worker->mutex ));
+    return node;
+}
+
+
+/***************************************************************************//**
+    @return task from front of another worker's deque, or NULL if none found.
+    Victims whose lock is busy are skipped rather than waited for.
+*******************************************************************************/
+magma_task_node* magma_task_scheduler::steal_task( magma_task_worker* worker )
+{
+    magma_int_t nvictim = magma_int_t( worker->victims.size() );
+    if ( nvictim == 0 || nready == 0 ) {
+        return NULL;
+    }
+
+    // count victims on same node; start at random offset within each group
+    magma_int_t nlocal = 0;
+    while( nlocal < nvictim && workers[ worker->victims[nlocal] ].node == worker->node ) {
+        ++nlocal;
+    }
+    worker->seed = worker->seed*1103515245u + 12345u;
+    magma_int_t r = magma_int_t( worker->seed >> 16 );
+
+    for( magma_int_t k=0; k < nvictim; ++k ) {
+        magma_int_t j;
+        if ( k < nlocal ) {
+            j = worker->victims[ (r + k) % nlocal ];
+        }
+        else {
+            j = worker->victims[ nlocal + (r + k) % (nvictim - nlocal) ];
+        }
+        magma_task_worker* victim = &workers[j];
+        if ( pthread_mutex_trylock( &victim->mutex ) != 0 ) {
+            continue;
+        }
+        magma_task_node* node = NULL;
+        if ( ! victim->deque.empty() ) {
+            node = victim->deque.front();
+            victim->deque.pop_front();
+            nready -= 1;
+        }
+        check( pthread_mutex_unlock( &victim->mutex ));
+        if ( node != NULL ) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+
+/***************************************************************************//**
+    Puts ready task at back of worker's deque and wakes a sleeping worker.
+*******************************************************************************/
+void magma_task_scheduler::enqueue( magma_task_worker* worker, magma_task_node* node )
+{
+    check( pthread_mutex_lock( &worker->mutex ));
+    worker->deque.push_back( node );
+    check( pthread_mutex_unlock( &worker->mutex ));
+
+    nready += 1;
+    if ( nsleep > 0 ) {
+        check( pthread_mutex_lock( &mutex ));
+        check( pthread_cond_signal( &cond ));
+        check( pthread_mutex_unlock( &mutex ));
+    }
+}
+
+
+/***************************************************************************//**
+    Marks task as finished: deletes it, releases its successors onto the
+    worker's deque, and decrements number of outstanding tasks.
+    Signals main thread if it is waiting in sync().
+*******************************************************************************/
+void magma_task_scheduler::task_done( magma_task_worker* worker, magma_task_node* node )
+{
+    delete node->task;
+    node->task = NULL;
+
+    // after done is set, no successors are added, so succ can be read unlocked
+    while( node->lock.test_and_set( std::memory_order_acquire )) {}
+    node->done = true;
+    node->lock.clear( std::memory_order_release );
+
+    for( size_t i=0; i < node->succ.size(); ++i ) {
+        magma_task_node* s = node->succ[i];
+        if ( --s->ndep == 0 ) {
+            trace_cpu_flow_start( "task", magma_int_t( uintptr_t( s )));
+            enqueue( worker, s );
+        }
+    }
+    node->succ.clear();
+    release( node );
+
+    if ( --ntask == 0 ) {
+        check( pthread_mutex_lock( &mutex ));
+        check( pthread_cond_broadcast( &cond_ntask ));
+        check( pthread_mutex_unlock( &mutex ));
+    }
+}
+
+
+/***************************************************************************//**
+    @return node from pool, allocating a new block of nodes if pool is empty.
+    The node has one reference, for its execution.
+*******************************************************************************/
+magma_task_node* magma_task_scheduler::alloc_node()
+{
+    if ( free_list == NULL ) {
+        free_list = free_shared.exchange( NULL );
+    }
+    if ( free_list == NULL ) {
+        magma_task_node* block = new magma_task_node[ node_block_size ];
+        blocks.push_back( block );
+        for( magma_int_t i=0; i < node_block_size; ++i ) {
+            block[i].lock.clear();
+            block[i].next = (i+1 < node_block_size ? &block[i+1] : NULL);
+        }
+        free_list = block;
+    }
+    magma_task_node* node = free_list;
+    free_list  = node->next;
+    node->next = NULL;
+    node->task = NULL;
+    node->ndep = 1;
+    node->nref = 1;
+    node->done = false;
+    return node;
+}
+
+
+/******************************************************************************/
+void magma_task_scheduler::retain( magma_task_node* node )
+{
+    node->nref += 1;
+}
+
+
+/***************************************************************************//**
+    Drops a reference; the last reference returns node to the pool.
+    May be called from any thread.
+*******************************************************************************/
+void magma_task_scheduler::release( magma_task_node* node )
+{
+    if ( --node->nref == 0 ) {
+        magma_task_node* head = free_shared.load();
+        do {
+            node->next = head;
+        } while( ! free_shared.compare_exchange_weak( head, node ));
+    }
+}
+
+
+/***************************************************************************//**
+    Makes node depend on pred, unless pred has already finished.
+*******************************************************************************/
+void magma_task_scheduler::add_edge( magma_task_node* pred, magma_task_node* node )
+{
+    if ( pred == NULL || pred == node ) {
+        return;
+    }
+    while( pred->lock.test_and_set( std::memory_order_acquire )) {}
+    if ( ! pred->done ) {
+        pred->succ.push_back( node );
+        node->ndep += 1;
+    }
+    pred->lock.clear( std::memory_order_release );
+}
+
+
+/***************************************************************************//**
+    Add task without dependencies to scheduler.
+    Task must be allocated with C++ new.
+    @param[in] task    Task to schedule.
+*******************************************************************************/
+void magma_task_scheduler::push_task( magma_task* task )
+{
+    push_task( task, 0, NULL );
+}
+
+
+/***************************************************************************//**
+    Add task to scheduler; it executes once its dependencies are satisfied.
+    Task must be allocated with C++ new.
+    @param[in] task    Task to schedule.
+    @param[in] ndep    Number of dependencies.
+    @param[in] deps    Array of ndep dependencies.
+*******************************************************************************/
+void magma_task_scheduler::push_task( magma_task* task, magma_int_t ndep, const magma_dep* deps )
+{
+    if ( quit_flag ) {
+        fprintf( stderr, "Error: push_task() called after quit()\n" );
+        throw std::exception();
+    }
+    assert( workers != NULL );  // else launch was not called
+
+    magma_task_node* node = alloc_node();
+    node->task = task;
+    ntask += 1;
+
+    for( magma_int_t i=0; i < ndep; ++i ) {
+        tag_state& state = tags[ deps[i].tag ];
+        if ( deps[i].mode & MagmaAccessOut ) {
+            add_edge( state.writer, node );
+            for( size_t k=0; k < state.readers.size(); ++k ) {
+                add_edge( state.readers[k], node );
+                release( state.readers[k] );
+            }
+            state.readers.clear();
+            if ( state.writer != NULL ) {
+                release( state.writer );
+            }
+            state.writer = node;
+            retain( node );
+        }
+        else {
+            add_edge( state.writer, node );
+            if ( state.readers.size() >= max_readers ) {
+                size_t k2 = 0;
+                for( size_t k=0; k < state.readers.size(); ++k ) {
+                    if ( state.readers[k]->done ) {
+                        release( state.readers[k] );
+                    }
+                    else {
+                        state.readers[k2++] = state.readers[k];
+                    }
+                }
+                state.readers.resize( k2 );
+            }
+            state.readers.push_back( node );
+            retain( node );
+        }
+    }
+
+    // remove submission guard
+    if ( --node->ndep == 0 ) {
+        enqueue( &workers[ next_worker ], node );
+        next_worker = (next_worker + 1) % nthread;
+    }
+}
+
+
+/***************************************************************************//**
+    Add task to scheduler; it executes once its dependencies are satisfied.
+    Task must be allocated with C++ new.
+    @param[in] task    Task to schedule.
+    @param[in] deps    List of dependencies.
+*******************************************************************************/
+void magma_task_scheduler::push_task( magma_task* task, std::initializer_list< magma_dep > deps )
+{
+    push_task( task, magma_int_t( deps.size() ), deps.begin() );
+}
+
+
+/***************************************************************************//**
+    Releases references held by the dependency table.
+*******************************************************************************/
+void magma_task_scheduler::clear_deps()
+{
+    for( auto it = tags.begin(); it != tags.end(); ++it ) {
+        if ( it->second.writer != NULL ) {
+            release( it->second.writer );
+        }
+        for( size_t k=0; k < it->second.readers.size(); ++k ) {
+            release( it->second.readers[k] );
+        }
+    }
+    tags.clear();
+}
+
+
+/***************************************************************************//**
+    Block until all outstanding tasks have been finished.
+    Threads continue to be alive; more tasks can be pushed after sync.
+    Dependencies on tasks pushed before sync are forgotten.
+*******************************************************************************/
+void magma_task_scheduler::sync()
+{
+    check( pthread_mutex_lock( &mutex ));
+    while( ntask > 0 ) {
+        check( pthread_cond_wait( &cond_ntask, &mutex ));
+    }
+    check( pthread_mutex_unlock( &mutex ));
+    clear_deps();
+}
+
+
+/***************************************************************************//**
+    Waits for outstanding tasks, then sets quit_flag and wakes all threads,
+    telling them to exit, and waits for all threads to exit (i.e., joins them).
+    It is safe to call quit multiple times -- the first time all the threads are
+    joined; subsequent times it does nothing.
+    (Destructor also calls quit, but you may prefer to call it explicitly.)
+*******************************************************************************/
+void magma_task_scheduler::quit()
+{
+    if ( workers == NULL ) {
+        return;
+    }
+    sync();
+
+    check( pthread_mutex_lock( &mutex ));
+    quit_flag = true;
+    check( pthread_cond_broadcast( &cond ));
+    check( pthread_mutex_unlock( &mutex ));
+
+    for( magma_int_t i=0; i < nthread; ++i ) {
+        check( pthread_join( workers[i].thread, NULL ));
+        check( pthread_mutex_destroy( &workers[i].mutex ));
+    }
+    delete[] workers;
+    workers = NULL;
+}
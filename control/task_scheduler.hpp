@@ -0,0 +1,142 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#ifndef MAGMA_TASK_SCHEDULER_HPP
+#define MAGMA_TASK_SCHEDULER_HPP
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+
+#include "thread_queue.hpp"  // magma_task
+
+
+/******************************************************************************/
+extern "C"
+void* magma_task_scheduler_main( void* arg );
+
+
+/***************************************************************************//**
+    Access mode of a task dependency, see \ref magma_task_scheduler.
+    @ingroup magma_thread
+*******************************************************************************/
+enum magma_access_t {
+    MagmaAccessIn    = 1,  ///< task reads data
+    MagmaAccessOut   = 2,  ///< task writes data
+    MagmaAccessInOut = 3   ///< task reads and writes data
+};
+
+
+/***************************************************************************//**
+    Dependency of a task on data identified by tag.
+    The tag is an arbitrary address, typically the first element of a tile.
+    @ingroup magma_thread
+*******************************************************************************/
+struct magma_dep
+{
+    const void*    tag;
+    magma_access_t mode;
+};
+
+
+class magma_task_scheduler;
+
+
+/******************************************************************************/
+// Internal descriptor of a submitted task, holding its dependency state.
+// Descriptors are pooled by the scheduler and recycled, never freed while
+// the scheduler exists.
+struct magma_task_node
+{
+    magma_task*                     task;
+    std::atomic<magma_int_t>        ndep;    ///<  unfinished predecessors (+1 while being submitted)
+    std::atomic<magma_int_t>        nref;    ///<  references: 1 for execution + 1 per dependency table entry
+    std::atomic<bool>               done;    ///<  set when task finished; no successors added after
+    std::atomic_flag                lock;    ///<  spin lock for done and succ
+    std::vector< magma_task_node* > succ;    ///<  successors, released when task finishes
+    magma_task_node*                next;    ///<  link in free list
+};
+
+
+/******************************************************************************/
+// Per-thread worker state. Owner pushes and pops at back of deque (LIFO);
+// thieves steal from front (FIFO).
+struct magma_task_worker
+{
+    magma_task_scheduler*           sched;
+    magma_int_t                     index;
+    int                             cpu;     ///<  cpu the worker is bound to, or -1
+    int                             node;    ///<  NUMA node of cpu
+    unsigned int                    seed;    ///<  for randomized victim selection
+    std::vector< magma_int_t >      victims; ///<  same NUMA node first, then others
+    pthread_t                       thread;
+    pthread_mutex_t                 mutex;   ///<  mutex lock for deque
+    std::deque< magma_task_node* >  deque;
+    char                            pad[64]; ///<  avoid false sharing between workers
+};
+
+
+/******************************************************************************/
+class magma_task_scheduler
+{
+public:
+    magma_task_scheduler();
+    ~magma_task_scheduler();
+
+    void launch( magma_int_t in_nthread, bool bind=true );
+    void push_task( magma_task* task );
+    void push_task( magma_task* task, magma_int_t ndep, const magma_dep* deps );
+    void push_task( magma_task* task, std::initializer_list< magma_dep > deps );
+    void sync();
+    void quit();
+
+    magma_int_t get_nthread() const { return nthread; }
+
+protected:
+    friend void* magma_task_scheduler_main( void* arg );
+    void worker_main( magma_task_worker* worker );
+    magma_task_node* pop_task( magma_task_worker* worker );
+    magma_task_node* steal_task( magma_task_worker* worker );
+    void enqueue( magma_task_worker* worker, magma_task_node* node );
+    void task_done( magma_task_worker* worker, magma_task_node* node );
+
+    magma_task_node* alloc_node();
+    void retain( magma_task_node* node );
+    void release( magma_task_node* node );
+    void add_edge( magma_task_node* pred, magma_task_node* node );
+    void clear_deps();
+
+private:
+    // per-tag state for dependency tracking; accessed only by submitting thread
+    struct tag_state {
+        magma_task_node*                writer;
+        std::vector< magma_task_node* > readers;
+    };
+
+    std::unordered_map< const void*, tag_state > tags;
+
+    magma_task_worker*              workers;      ///<  array of workers
+    magma_int_t                     nthread;      ///<  number of workers
+    magma_int_t                     next_worker;  ///<  round-robin target for submitted ready tasks
+
+    std::atomic<magma_int_t>        ntask;        ///<  number of unfinished tasks
+    std::atomic<magma_int_t>        nready;       ///<  number of tasks in deques
+    std::atomic<magma_int_t>        nsleep;       ///<  number of workers waiting on cond
+    std::atomic<bool>               quit_flag;    ///<  quit() sets this to true; workers exit once idle
+    pthread_mutex_t                 mutex;        ///<  mutex lock for cond, cond_ntask
+    pthread_cond_t                  cond;         ///<  condition variable for nready and quit (see enqueue, quit)
+    pthread_cond_t                  cond_ntask;   ///<  condition variable for ntask (see sync, task_done)
+
+    magma_task_node*                free_list;    ///<  pool of nodes; accessed only by submitting thread
+    std::atomic<magma_task_node*>   free_shared;  ///<  nodes released by workers, reclaimed in alloc_node
+    std::vector< magma_task_node* > blocks;       ///<  node blocks allocated for the pool
+};
+
+#endif        //  #ifndef MAGMA_TASK_SCHEDULER_HPP
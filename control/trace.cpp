@@ -1,10 +1,16 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <errno.h>
 #include <string.h>      // strerror_r
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "trace.h"
 
@@ -22,19 +28,51 @@
 #define TRACE_METHOD 2
 
 
+/******************************************************************************/
+// phases are those of the Chrome trace event format
+enum trace_phase {
+    trace_begin      = 'B',
+    trace_end        = 'E',
+    trace_counter    = 'C',
+    trace_flow_start = 's',
+    trace_flow_end   = 'f'
+};
+
+// 48 bytes; tag must be a string literal or otherwise outlive the trace,
+// label is copied.
+struct trace_event
+{
+    int64_t     time;  // nanoseconds, steady clock
+    const char* tag;
+    union {
+        double  value; // counter
+        int64_t id;    // flow
+    };
+    char        label[ MAX_LABEL_LEN ];
+    char        phase;
+};
+
+// Ring buffer of one thread. Only the owner writes; head is released after
+// each event, so trace_finalize sees complete events.
+struct trace_buffer
+{
+    std::atomic< uint64_t > head;  // number of events recorded
+    uint64_t     mask;             // capacity - 1, capacity a power of 2
+    trace_event* events;
+};
+
+
 /******************************************************************************/
 struct event_log
 {
-    int    ncore;
-    int    cpu_id   [ MAX_CORES ];
-    double cpu_first;
-    double cpu_start[ MAX_CORES ][ MAX_EVENTS ];
-    double cpu_end  [ MAX_CORES ][ MAX_EVENTS ];
-    char   cpu_tag  [ MAX_CORES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    char   cpu_label[ MAX_CORES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    
+    int64_t cpu_first_ns;
+    std::atomic< uint64_t > cpu_capacity;
+    std::atomic< int > nthread;
+    std::atomic< trace_buffer* > threads[ MAX_TRACE_THREADS ];
+
     int           ngpu;
     int           nqueue;
+    double        cpu_first;
     magma_queue_t queues   [ MAX_GPU_QUEUES ];
     int           gpu_id   [ MAX_GPU_QUEUES ];
     magma_event_t gpu_first[ MAX_GPU_QUEUES ];
@@ -51,29 +89,153 @@ struct event_log
 // global log object
 struct event_log glog;
 
+// buffer of the calling thread, assigned on its first event;
+// trace_no_buffer if there were no free slots.
+static thread_local trace_buffer* thread_buffer = NULL;
+static trace_buffer trace_no_buffer;
+
+// slots of exited threads, reused with their buffers by new threads
+static std::mutex trace_slot_mutex;
+static std::vector< int > trace_free_slots;
+
+// Returns the slot of the calling thread to the free list when it exits.
+// Its events stay in the buffer, so the next thread in the slot appends to
+// the same row.
+struct trace_thread_slot
+{
+    int slot = -1;
+
+    ~trace_thread_slot()
+    {
+        if ( slot >= 0 ) {
+            std::lock_guard< std::mutex > guard( trace_slot_mutex );
+            trace_free_slots.push_back( slot );
+        }
+    }
+};
+
+static thread_local trace_thread_slot thread_slot;
+
 
 /******************************************************************************/
-void trace_init( int ncore, int ngpu, int nqueue, magma_queue_t* queues )
+static inline int64_t trace_now()
 {
-    if ( ncore > MAX_CORES ) {
-        fprintf( stderr, "Error in trace_init: ncore %d > MAX_CORES %d\n",
-                 ncore, MAX_CORES );
-        exit(1);
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+/******************************************************************************/
+// Capacity of new ring buffers, from $MAGMA_TRACE_EVENTS, rounded up to a
+// power of 2, else MAX_CPU_EVENTS.
+static uint64_t trace_capacity()
+{
+    uint64_t capacity = glog.cpu_capacity.load( std::memory_order_relaxed );
+    if ( capacity == 0 ) {
+        uint64_t request = MAX_CPU_EVENTS;
+        const char* str = getenv( "MAGMA_TRACE_EVENTS" );
+        if ( str != NULL && atoll( str ) > 0 ) {
+            request = atoll( str );
+        }
+        capacity = 1;
+        while( capacity < request ) {
+            capacity *= 2;
+        }
+        glog.cpu_capacity.store( capacity, std::memory_order_relaxed );
+    }
+    return capacity;
+}
+
+
+/******************************************************************************/
+// Returns the calling thread's buffer, assigning it a slot on first use:
+// the slot of an exited thread if any, else a new one. Only this first
+// call takes a lock. Returns NULL if more than MAX_TRACE_THREADS threads
+// are alive at once.
+static trace_buffer* trace_thread_buffer()
+{
+    if ( thread_buffer == NULL ) {
+        std::lock_guard< std::mutex > guard( trace_slot_mutex );
+        int t;
+        if ( ! trace_free_slots.empty() ) {
+            t = trace_free_slots.back();
+            trace_free_slots.pop_back();
+            thread_buffer = glog.threads[t].load( std::memory_order_relaxed );
+        }
+        else {
+            t = glog.nthread.load( std::memory_order_relaxed );
+            if ( t >= MAX_TRACE_THREADS ) {
+                static bool warned = false;
+                if ( ! warned ) {
+                    fprintf( stderr, "Error in %s: more than %lld threads; not traced.\n",
+                             __func__, (long long) MAX_TRACE_THREADS );
+                    warned = true;
+                }
+                thread_buffer = &trace_no_buffer;
+                return NULL;
+            }
+            uint64_t capacity = trace_capacity();
+            trace_buffer* buf = new trace_buffer;
+            buf->head.store( 0, std::memory_order_relaxed );
+            buf->mask   = capacity - 1;
+            buf->events = new trace_event[ capacity ];
+            glog.threads[t].store( buf, std::memory_order_release );
+            glog.nthread.store( t+1, std::memory_order_release );
+            thread_buffer = buf;
+        }
+        thread_slot.slot = t;
+    }
+    else if ( thread_buffer == &trace_no_buffer ) {
+        return NULL;
     }
+    return thread_buffer;
+}
+
+
+/******************************************************************************/
+static inline trace_event* trace_record( char phase, const char* tag, uint64_t* head )
+{
+    trace_buffer* buf = trace_thread_buffer();
+    if ( buf == NULL ) {
+        return NULL;
+    }
+    *head = buf->head.load( std::memory_order_relaxed );
+    trace_event* event = &buf->events[ *head & buf->mask ];
+    event->time  = trace_now();
+    event->tag   = tag;
+    event->phase = phase;
+    return event;
+}
+
+static inline void trace_commit( uint64_t head )
+{
+    thread_buffer->head.store( head + 1, std::memory_order_release );
+}
+
+
+/******************************************************************************/
+void trace_init( magma_int_t ncore, magma_int_t ngpu, magma_int_t nqueue, magma_queue_t* queues )
+{
     if ( ngpu*nqueue > MAX_GPU_QUEUES ) {
-        fprintf( stderr, "Error in trace_init: (ngpu=%d)*(nqueue=%d) > MAX_GPU_QUEUES=%d\n",
-                 ngpu, nqueue, MAX_GPU_QUEUES );
+        fprintf( stderr, "Error in trace_init: (ngpu=%lld)*(nqueue=%lld) > MAX_GPU_QUEUES=%lld\n",
+                 (long long) ngpu, (long long) nqueue, (long long) MAX_GPU_QUEUES );
         exit(1);
     }
-    
-    glog.ncore  = ncore;
+
     glog.ngpu   = ngpu;
     glog.nqueue = nqueue;
-    
-    // initialize ID = 0
-    for( int core = 0; core < ncore; ++core ) {
-        glog.cpu_id[core] = 0;
+
+    // discard CPU events of previous traces;
+    // no thread may be recording during trace_init.
+    int nthread = glog.nthread.load();
+    for( int t = 0; t < nthread; ++t ) {
+        trace_buffer* buf = glog.threads[t].load( std::memory_order_acquire );
+        if ( buf != NULL ) {
+            buf->head.store( 0, std::memory_order_relaxed );
+        }
     }
+
+    // initialize ID = 0
     for( int dev = 0; dev < ngpu; ++dev ) {
         for( int s = 0; s < nqueue; ++s ) {
             int t = dev*glog.nqueue + s;
@@ -97,36 +259,80 @@ void trace_init( int ncore, int ngpu, int nqueue, magma_queue_t* queues )
         magma_setdevice( dev );
         magma_device_sync();
     }
-    glog.cpu_first = magma_wtime();
+    glog.cpu_first    = magma_wtime();
+    glog.cpu_first_ns = trace_now();
 }
 
 
 /******************************************************************************/
-void trace_cpu_start( int core, const char* tag, const char* lbl )
+void trace_cpu_start( magma_int_t core, const char* tag, const char* lbl )
 {
-    int id = glog.cpu_id[core];
-    glog.cpu_start[core][id] = magma_wtime();
-    magma_strlcpy( glog.cpu_tag  [core][id], tag, MAX_LABEL_LEN );
-    magma_strlcpy( glog.cpu_label[core][id], lbl, MAX_LABEL_LEN );
+    uint64_t head;
+    trace_event* event = trace_record( trace_begin, tag, &head );
+    if ( event != NULL ) {
+        if ( lbl != NULL ) {
+            magma_strlcpy( event->label, lbl, MAX_LABEL_LEN );
+        }
+        else {
+            event->label[0] = '\0';
+        }
+        trace_commit( head );
+    }
 }
 
 
 /******************************************************************************/
-void trace_cpu_end( int core )
+void trace_cpu_end( magma_int_t core )
 {
-    int id = glog.cpu_id[core];
-    glog.cpu_end[core][id] = magma_wtime();
-    if ( id+1 < MAX_EVENTS ) {
-        glog.cpu_id[core] = id+1;
+    uint64_t head;
+    trace_event* event = trace_record( trace_end, NULL, &head );
+    if ( event != NULL ) {
+        trace_commit( head );
     }
-    else {
-        fprintf( stderr, "Error in %s: not enough CPU events.\n", __func__ );
+}
+
+
+/******************************************************************************/
+void trace_cpu_counter( const char* tag, double value )
+{
+    uint64_t head;
+    trace_event* event = trace_record( trace_counter, tag, &head );
+    if ( event != NULL ) {
+        event->value = value;
+        trace_commit( head );
+    }
+}
+
+
+/******************************************************************************/
+// A flow is an arrow from the scope enclosing flow_start to the scope
+// enclosing the flow_end with the same tag and id, e.g., from a task to the
+// task depending on it, on another thread.
+void trace_cpu_flow_start( const char* tag, magma_int_t id )
+{
+    uint64_t head;
+    trace_event* event = trace_record( trace_flow_start, tag, &head );
+    if ( event != NULL ) {
+        event->id = id;
+        trace_commit( head );
+    }
+}
+
+
+/******************************************************************************/
+void trace_cpu_flow_end( const char* tag, magma_int_t id )
+{
+    uint64_t head;
+    trace_event* event = trace_record( trace_flow_end, tag, &head );
+    if ( event != NULL ) {
+        event->id = id;
+        trace_commit( head );
     }
 }
 
 
 /******************************************************************************/
-void trace_gpu_start( int dev, int s, const char* tag, const char* lbl )
+void trace_gpu_start( magma_int_t dev, magma_int_t s, const char* tag, const char* lbl )
 {
     int t = dev*glog.nqueue + s;
     int id = glog.gpu_id[t];
@@ -142,7 +348,7 @@ void trace_gpu_start( int dev, int s, const char* tag, const char* lbl )
 
 
 /******************************************************************************/
-void trace_gpu_end( int dev, int s )
+void trace_gpu_end( magma_int_t dev, magma_int_t s )
 {
     int t = dev*glog.nqueue + s;
     int id = glog.gpu_id[t];
@@ -152,13 +358,184 @@ void trace_gpu_end( int dev, int s )
         glog.gpu_id[t] = id+1;
     }
     else {
-        fprintf( stderr, "Error in %s: not enough GPU events (dev %d, queue %d).\n", __func__, dev, s );
+        fprintf( stderr, "Error in %s: not enough GPU events (dev %lld, queue %lld).\n",
+                 __func__, (long long) dev, (long long) s );
     }
 }
 
 
 /******************************************************************************/
-void trace_finalize( const char* filename, const char* cssfile )
+// CPU scope, from matching start and end events of one thread.
+struct trace_slice
+{
+    double start, end;  // seconds since trace_init
+    const char* tag;
+    const char* label;
+    int depth;
+};
+
+// Returns the events of thread t still in its ring buffer, oldest first.
+// Warns if the oldest events were overwritten.
+static std::vector< trace_event* > trace_thread_events( int t )
+{
+    std::vector< trace_event* > events;
+    trace_buffer* buf = glog.threads[t].load( std::memory_order_acquire );
+    if ( buf == NULL ) {
+        return events;
+    }
+    uint64_t head  = buf->head.load( std::memory_order_acquire );
+    uint64_t first = 0;
+    if ( head > buf->mask + 1 ) {
+        first = head - (buf->mask + 1);
+        fprintf( stderr, "WARNING: trace on thread %d overwrote its %llu oldest events;"
+                 " set $MAGMA_TRACE_EVENTS to at least %llu.\n",
+                 t, (unsigned long long) first, (unsigned long long) head );
+    }
+    events.reserve( head - first );
+    for( uint64_t i = first; i < head; ++i ) {
+        events.push_back( &buf->events[ i & buf->mask ] );
+    }
+    return events;
+}
+
+// Returns the scopes in events of one thread. Scopes still open end at time end;
+// ends whose start was overwritten are dropped.
+static std::vector< trace_slice > trace_thread_slices(
+    const std::vector< trace_event* >& events, double end )
+{
+    std::vector< trace_slice > slices;
+    std::vector< size_t > open;
+    for( size_t i = 0; i < events.size(); ++i ) {
+        trace_event* event = events[i];
+        double time = (event->time - glog.cpu_first_ns) * 1e-9;
+        if ( event->phase == trace_begin ) {
+            trace_slice slice;
+            slice.start = time;
+            slice.end   = end;
+            slice.tag   = event->tag;
+            slice.label = (event->label[0] != '\0' ? event->label : event->tag);
+            slice.depth = (int) open.size();
+            open.push_back( slices.size() );
+            slices.push_back( slice );
+        }
+        else if ( event->phase == trace_end && ! open.empty() ) {
+            slices[ open.back() ].end = time;
+            open.pop_back();
+        }
+    }
+    return slices;
+}
+
+
+/******************************************************************************/
+// Writes str as a JSON string.
+static void trace_json_string( FILE* file, const char* str )
+{
+    fputc( '"', file );
+    for( const char* c = (str != NULL ? str : ""); *c != '\0'; ++c ) {
+        if ( *c == '"' || *c == '\\' ) {
+            fputc( '\\', file );
+            fputc( *c, file );
+        }
+        else if ( (unsigned char) *c < 0x20 ) {
+            fprintf( file, "\\u%04x", (unsigned char) *c );
+        }
+        else {
+            fputc( *c, file );
+        }
+    }
+    fputc( '"', file );
+}
+
+
+/******************************************************************************/
+// Chrome trace event format: process 0 has a row per CPU thread,
+// process 1 a row per GPU queue. Times are in microseconds.
+static void trace_finalize_json( FILE* trace_file )
+{
+    double time = magma_wtime() - glog.cpu_first;
+    int nthread = glog.nthread.load();
+
+    fprintf( trace_file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n" );
+    fprintf( trace_file,
+             "{\"ph\": \"M\", \"pid\": 0, \"name\": \"process_name\", \"args\": {\"name\": \"CPU\"}},\n"
+             "{\"ph\": \"M\", \"pid\": 1, \"name\": \"process_name\", \"args\": {\"name\": \"GPU\"}}" );
+
+    // output CPU events
+    for( int t = 0; t < nthread; ++t ) {
+        fprintf( trace_file,
+                 ",\n{\"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"name\": \"thread_name\","
+                 " \"args\": {\"name\": \"thread %d\"}}", t, t );
+
+        // scopes are output as complete events, so overwritten and
+        // open ones are handled as in SVG
+        std::vector< trace_event* > events = trace_thread_events( t );
+        std::vector< trace_slice > slices = trace_thread_slices( events, time );
+        for( size_t i = 0; i < slices.size(); ++i ) {
+            fprintf( trace_file, ",\n{\"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"name\": ",
+                     t, slices[i].start*1e6, (slices[i].end - slices[i].start)*1e6 );
+            trace_json_string( trace_file, slices[i].label );
+            fprintf( trace_file, ", \"cat\": " );
+            trace_json_string( trace_file, slices[i].tag );
+            fprintf( trace_file, "}" );
+        }
+
+        for( size_t i = 0; i < events.size(); ++i ) {
+            trace_event* event = events[i];
+            double ts = (event->time - glog.cpu_first_ns) * 1e-3;
+            if ( event->phase == trace_counter ) {
+                fprintf( trace_file, ",\n{\"ph\": \"C\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"name\": ", t, ts );
+                trace_json_string( trace_file, event->tag );
+                fprintf( trace_file, ", \"args\": {\"value\": %.17g}}", event->value );
+            }
+            else if ( event->phase == trace_flow_start || event->phase == trace_flow_end ) {
+                fprintf( trace_file, ",\n{\"ph\": \"%c\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"id\": %lld,%s \"cat\": \"flow\", \"name\": ",
+                         event->phase, t, ts, (long long) event->id,
+                         (event->phase == trace_flow_end ? " \"bp\": \"e\"," : "") );
+                trace_json_string( trace_file, event->tag );
+                fprintf( trace_file, "}" );
+            }
+        }
+    }
+
+    // output GPU events
+    for( int dev = 0; dev < glog.ngpu; ++dev ) {
+        magma_setdevice( dev );
+        for( int s = 0; s < glog.nqueue; ++s ) {
+            int t = dev*glog.nqueue + s;
+            fprintf( trace_file,
+                     ",\n{\"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"name\": \"thread_name\","
+                     " \"args\": {\"name\": \"GPU %d (s%d)\"}}", t, dev, s );
+            float start, end;
+            for( int i = 0; i < glog.gpu_id[t]; ++i ) {
+                #if TRACE_METHOD == 2
+                    start = glog.gpu_start[t][i] - glog.cpu_first;
+                    if ( i > 0 ) {
+                        // later of task's CPU start time and previous task's end time
+                        start = max( start, end );
+                    }
+                #else
+                    cudaEventElapsedTime( &start, glog.gpu_first[t], glog.gpu_start[t][i] );
+                    start *= 1e-3;  // ms to seconds
+                #endif
+                cudaEventElapsedTime( &end, glog.gpu_first[t], glog.gpu_end  [t][i] );
+                end   *= 1e-3;  // ms to seconds
+                fprintf( trace_file, ",\n{\"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"name\": ",
+                         t, start*1e6, (end - start)*1e6 );
+                trace_json_string( trace_file, glog.gpu_label[t][i] );
+                fprintf( trace_file, ", \"cat\": " );
+                trace_json_string( trace_file, glog.gpu_tag[t][i] );
+                fprintf( trace_file, "}" );
+            }
+        }
+    }
+
+    fprintf( trace_file, "\n]}\n" );
+}
+
+
+/******************************************************************************/
+static void trace_finalize_svg( FILE* trace_file, const char* cssfile )
 {
     // these are all in SVG "pixels"
     double xscale = 200.; // pixels per second
@@ -170,25 +547,13 @@ void trace_finalize( const char* filename, const char* cssfile )
     double left   = 2*margin + label;
     double xtick  = 0.5;  // interval of xticks (in seconds)
     char buf[ 1024 ];
-    
-    // sync devices
-    for( int dev = 0; dev < glog.ngpu; ++dev ) {
-        magma_setdevice( dev );
-        magma_device_sync();
-    }
+
     double time = magma_wtime() - glog.cpu_first;
-    
-    FILE* trace_file = fopen( filename, "w" );
-    if ( trace_file == NULL ) {
-        strerror_r( errno, buf, sizeof(buf) );
-        fprintf( stderr, "Can't open file '%s': %s (%d)\n", filename, buf, errno );
-        return;
-    }
-    fprintf( stderr, "writing trace to '%s'\n", filename );
-    
-    // row for each CPU and GPU/queue (with space between), time scale, legend
+    int nthread = glog.nthread.load();
+
+    // row for each CPU thread and GPU/queue (with space between), time scale, legend
     // 4 margins: at top, above time scale, above legend, at bottom
-    int h = (int)( (glog.ncore + glog.ngpu*glog.nqueue)*(height + space) - space + 2*height + 4*margin );
+    int h = (int)( (nthread + glog.ngpu*glog.nqueue)*(height + space) - space + 2*height + 4*margin );
     int w = (int)( left + time*xscale + margin );
     fprintf( trace_file,
              "<?xml version=\"1.0\" standalone=\"no\"?>\n"
@@ -199,7 +564,7 @@ void trace_finalize( const char* filename, const char* cssfile )
              "    xmlns:inkscape=\"http://www.inkscape.org/namespaces/inkscape\"\n"
              "    viewBox=\"0 0 %d %d\" width=\"%d\" height=\"%d\" preserveAspectRatio=\"none\">\n\n",
              w, h, w, h );
-    
+
     // Inkscape does not currently (Jan 2012) support external CSS;
     // see http://wiki.inkscape.org/wiki/index.php/CSS_Support
     // So embed CSS file here
@@ -216,45 +581,39 @@ void trace_finalize( const char* filename, const char* cssfile )
         fclose( css_file );
         fprintf( trace_file, "</style>\n\n" );
     }
-    
+
     // format takes: x, y, width, height, class (tag), id (label)
     const char* format =
         "<rect x=\"%8.3f\" y=\"%4.0f\" width=\"%8.3f\" height=\"%2.0f\" class=\"%-8s\" inkscape:label=\"%s\"/>\n";
-    
+
     // accumulate unique legend entries
     std::set< std::string > legend;
-    
-    // output CPU events
+
+    // output CPU events; nested scopes are drawn over their parents
     double top = margin;
-    for( int core = 0; core < glog.ncore; ++core ) {
-        if ( glog.cpu_id[core] > MAX_EVENTS ) {
-            glog.cpu_id[core] += 1;  // count last event
-            fprintf( stderr, "WARNING: trace on core %d, reached limit of %d events; output will be truncated.\n",
-                     core, glog.cpu_id[core] );
-        }
-        fprintf( trace_file, "<!-- core %d, nevents %d -->\n", core, glog.cpu_id[core] );
-        fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"core %d\">\n", core );
+    for( int t = 0; t < nthread; ++t ) {
+        std::vector< trace_slice > slices = trace_thread_slices( trace_thread_events( t ), time );
+        fprintf( trace_file, "<!-- thread %d, nscopes %d -->\n", t, (int) slices.size() );
+        fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"thread %d\">\n", t );
         fprintf( trace_file, "<text x=\"%8.3f\" y=\"%4.0f\" width=\"%4.0f\" height=\"%2.0f\">CPU %d:</text>\n",
                  margin,
                  top + height - pad,
                  label, height,
-                 core );
-        for( int i = 0; i < glog.cpu_id[core]; ++i ) {
-            double start  = glog.cpu_start[core][i] - glog.cpu_first;
-            double end    = glog.cpu_end  [core][i] - glog.cpu_first;
+                 t );
+        for( size_t i = 0; i < slices.size(); ++i ) {
             fprintf( trace_file, format,
-                     left + start*xscale,
+                     left + slices[i].start*xscale,
                      top,
-                     (end - start)*xscale,
+                     (slices[i].end - slices[i].start)*xscale,
                      height,
-                     glog.cpu_tag[core][i],
-                     glog.cpu_label[core][i] );
-            legend.insert( glog.cpu_tag[core][i] );
+                     slices[i].tag,
+                     slices[i].label );
+            legend.insert( slices[i].tag );
         }
         top += (height + space);
         fprintf( trace_file, "</g>\n\n" );
     }
-    
+
     // output GPU events
     for( int dev = 0; dev < glog.ngpu; ++dev ) {
         for( int s = 0; s < glog.nqueue; ++s ) {
@@ -268,7 +627,7 @@ void trace_finalize( const char* filename, const char* cssfile )
             fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"gpu %d queue %d\">\n", dev, s );
             fprintf( trace_file, "<text x=\"%8.3f\" y=\"%4.0f\" width=\"%4.0f\" height=\"%2.0f\">GPU %d (s%d):</text>\n",
                      margin,
-                     margin + (dev*glog.nqueue + s + glog.ncore)*(height + space) + height - pad,
+                     margin + (dev*glog.nqueue + s + nthread)*(height + space) + height - pad,
                      label, height,
                      dev, s );
             magma_setdevice( dev );
@@ -299,7 +658,7 @@ void trace_finalize( const char* filename, const char* cssfile )
             fprintf( trace_file, "</g>\n\n" );
         }
     }
-    
+
     // output time scale
     top += (-space + margin);
     fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"scale\">\n" );
@@ -318,7 +677,7 @@ void trace_finalize( const char* filename, const char* cssfile )
     }
     fprintf( trace_file, "</g>\n\n" );
     top += (height + margin);
-    
+
     // output legend
     fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"legend\">\n" );
     fprintf( trace_file, "<text x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\">Legend:</text>\n",
@@ -333,9 +692,40 @@ void trace_finalize( const char* filename, const char* cssfile )
         x += label + margin;
     }
     fprintf( trace_file, "</g>\n\n" );
-    
+
     fprintf( trace_file, "</svg>\n" );
-    
+}
+
+
+/******************************************************************************/
+// Writes Chrome trace JSON if filename ends in ".json", else SVG using cssfile.
+// No thread may be recording during trace_finalize.
+void trace_finalize( const char* filename, const char* cssfile )
+{
+    char buf[ 1024 ];
+
+    // sync devices
+    for( int dev = 0; dev < glog.ngpu; ++dev ) {
+        magma_setdevice( dev );
+        magma_device_sync();
+    }
+
+    FILE* trace_file = fopen( filename, "w" );
+    if ( trace_file == NULL ) {
+        strerror_r( errno, buf, sizeof(buf) );
+        fprintf( stderr, "Can't open file '%s': %s (%d)\n", filename, buf, errno );
+        return;
+    }
+    fprintf( stderr, "writing trace to '%s'\n", filename );
+
+    size_t len = strlen( filename );
+    if ( len >= 5 && strcmp( filename + len - 5, ".json" ) == 0 ) {
+        trace_finalize_json( trace_file );
+    }
+    else {
+        trace_finalize_svg( trace_file, cssfile );
+    }
+
     fclose( trace_file );
 }
 
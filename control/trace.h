@@ -17,13 +17,22 @@
 #endif
 
 // =============================================================================
-const magma_int_t MAX_CORES       = 1;                 // CPU cores
-const magma_int_t MAX_GPU_QUEUES  = MagmaMaxGPUs * 4;  // #devices * #queues per device
-const magma_int_t MAX_EVENTS      = 20000;
-const magma_int_t MAX_LABEL_LEN   = 16;
+const magma_int_t MAX_TRACE_THREADS = 1024;              // CPU threads that can record events at once
+const magma_int_t MAX_CPU_EVENTS    = 65536;             // default per-thread ring buffer; see trace_init
+const magma_int_t MAX_GPU_QUEUES    = MagmaMaxGPUs * 4;  // #devices * #queues per device
+const magma_int_t MAX_EVENTS        = 20000;             // per GPU queue
+const magma_int_t MAX_LABEL_LEN     = 16;
 
 
 // =============================================================================
+// CPU events are recorded in a lock-free ring buffer owned by the calling
+// thread, with nanosecond timestamps; when a buffer is full, the oldest
+// events are overwritten. Up to MAX_TRACE_THREADS threads can trace at
+// once; the row and buffer of an exited thread are reused by the next one.
+// Scopes (start/end) nest. The core argument is kept for compatibility;
+// events go to the calling thread's row.
+// trace_finalize writes Chrome trace JSON, viewable in chrome://tracing or
+// Perfetto, if filename ends in ".json", else SVG.
 #ifdef TRACING
 
 void trace_init     ( magma_int_t ncore, magma_int_t ngpu, magma_int_t nqueue, magma_queue_t *queues );
@@ -31,6 +40,10 @@ void trace_init     ( magma_int_t ncore, magma_int_t ngpu, magma_int_t nqueue, m
 void trace_cpu_start( magma_int_t core, const char* tag, const char* label );
 void trace_cpu_end  ( magma_int_t core );
 
+void trace_cpu_counter   ( const char* tag, double value );
+void trace_cpu_flow_start( const char* tag, magma_int_t id );
+void trace_cpu_flow_end  ( const char* tag, magma_int_t id );
+
 magma_event_t*
      trace_gpu_event( magma_int_t dev, magma_int_t queue_num, const char* tag, const char* label );
 void trace_gpu_start( magma_int_t dev, magma_int_t queue_num, const char* tag, const char* label );
@@ -45,6 +58,10 @@ void trace_finalize ( const char* filename, const char* cssfile );
 #define trace_cpu_start( x1, x2, x3     ) ((void)(0))
 #define trace_cpu_end(   x1             ) ((void)(0))
 
+#define trace_cpu_counter(    x1, x2    ) ((void)(0))
+#define trace_cpu_flow_start( x1, x2    ) ((void)(0))
+#define trace_cpu_flow_end(   x1, x2    ) ((void)(0))
+
 #define trace_gpu_event( x1, x2, x3, x4 ) (NULL)
 #define trace_gpu_start( x1, x2, x3, x4 ) ((void)(0))
 #define trace_gpu_end(   x1, x2         ) ((void)(0))
@@ -53,4 +70,27 @@ void trace_finalize ( const char* filename, const char* cssfile );
 
 #endif
 
+
+// =============================================================================
+// Traces a scope on the calling thread, from construction to destruction.
+// Empty, hence free, without TRACING.
+class trace_cpu_scope
+{
+public:
+    explicit trace_cpu_scope( const char* tag, const char* label=NULL )
+    {
+        trace_cpu_start( 0, tag, label );
+    }
+
+    ~trace_cpu_scope()
+    {
+        trace_cpu_end( 0 );
+    }
+
+private:
+    // not copyable
+    trace_cpu_scope( const trace_cpu_scope& );
+    trace_cpu_scope& operator = ( const trace_cpu_scope& );
+};
+
 #endif        //  #ifndef TRACE_H
@@ -75,6 +75,22 @@ void magma_swp2pswp(
 magma_int_t magma_get_smlsize_divideconquer();
 
 
+// =============================================================================
+// tuning table, overriding the get NB defaults
+
+magma_int_t magma_tune_get(
+    const char* name, magma_int_t n, magma_int_t nthread, magma_int_t* value );
+
+void magma_tune_set(
+    const char* name, magma_int_t n, magma_int_t nthread, magma_int_t value );
+
+void magma_tune_clear();
+
+magma_int_t magma_tune_load( const char* filename );
+
+magma_int_t magma_tune_save( const char* filename );
+
+
 // =============================================================================
 // memory allocation
 
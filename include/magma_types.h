@@ -820,6 +820,13 @@ typedef enum {
     Magma_UNITDIAGCOL  = 516, // to be deprecated
 } magma_scale_t;
 
+typedef enum {
+    Magma_NOREORDER    = 541,
+    Magma_RCM          = 542,
+    Magma_AMD          = 543,
+    Magma_ND           = 544
+} magma_reorder_t;
+
 
 typedef enum {
     Magma_SOLVE        = 801,
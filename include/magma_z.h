@@ -1807,6 +1807,27 @@ magma_znan_inf(
     magma_int_t *cnt_nan,
     magma_int_t *cnt_inf);
 
+magma_int_t
+magma_znan_inf_cols(
+    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda,
+    magma_int_t *col_nan,
+    magma_int_t *col_inf,
+    magma_int_t *col_first);
+
+magma_int_t
+magma_znan_inf_amax(
+    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda,
+    magma_int_t *cnt_nan,
+    magma_int_t *cnt_inf,
+    double *amax);
+
+magma_int_t
+magma_znan_inf_any(
+    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda);
+
 magma_int_t
 magma_znan_inf_gpu(
     magma_uplo_t uplo, magma_int_t m, magma_int_t n,
@@ -50,6 +50,17 @@ magma_zbulge_back(
     magmaDoubleComplex *T, magma_int_t ldt,
     magma_int_t* info);
 
+magma_int_t
+magma_zbulge_back_cpu(
+    magma_uplo_t uplo, 
+    magma_int_t n, magma_int_t nb, 
+    magma_int_t ne, magma_int_t Vblksiz,
+    magmaDoubleComplex *Z, magma_int_t ldz,
+    magmaDoubleComplex *V, magma_int_t ldv,
+    magmaDoubleComplex *TAU,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    magma_int_t* info);
+
 magma_int_t
 magma_zbulge_back_m(
     magma_int_t ngpu, magma_uplo_t uplo, 
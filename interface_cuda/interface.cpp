@@ -161,6 +161,10 @@ struct magma_device_info* g_magma_devices = NULL;
     but every thread may call it. If n threads call magma_init,
     the n-th call to magma_finalize will release resources.
 
+    If $MAGMA_TUNE is set, the first call loads the tuning table of block
+    sizes, etc., from that file; see magma_tune_load. If the file is
+    invalid, it prints an error, and the built-in defaults are used.
+
     When renumbering CUDA devices, call cudaSetValidDevices before calling magma_init.
     When setting CUDA device flags, call cudaSetDeviceFlags before calling magma_init.
 
@@ -221,6 +225,12 @@ magma_init()
                 }
             }
 
+            // machine-specific tuning table
+            const char* tune_file = getenv( "MAGMA_TUNE" );
+            if ( tune_file != NULL && tune_file[0] != '\0' ) {
+                magma_tune_load( tune_file );
+            }
+
             #ifndef MAGMA_NO_V1
                 #ifdef HAVE_PTHREAD_KEY
                     // create thread-specific key
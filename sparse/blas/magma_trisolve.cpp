@@ -11,6 +11,15 @@
 
 
 void magma_trisolve_free(magma_solve_info_t *solve_info) {
+    magma_solve_levels_t *levels = &solve_info->levels;
+    magma_free_cpu(levels->level_ptr);
+    magma_free_cpu(levels->perm);
+    magma_free_cpu(levels->row);
+    magma_free_cpu(levels->col);
+    magma_free_cpu(levels->val);
+    magma_free_cpu(levels->diag);
+    *levels = magma_solve_levels_t();
+
 #if CUDA_VERSION >= 11031
     if (solve_info->descr) {
         cusparseSpSM_destroyDescr(solve_info->descr);
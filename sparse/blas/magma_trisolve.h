@@ -35,6 +35,7 @@ void magma_trisolve_free(magma_solve_info_t *solve_info);
 
     Performs a triangular solve analysis for the given system matrix.
     Abstracts away interface for cuSPARSE/hipSPARSE.
+    For M on the CPU, builds the level schedule of magma_ztrisolve_cpu.
 
     Arguments
     ---------
@@ -80,6 +81,7 @@ magma_int_t magma_ztrisolve_analysis(
 
     Performs a triangular solve with the given solve info.
     Abstracts away interface for cuSPARSE/hipSPARSE.
+    For M on the CPU, solves with the OpenMP threads by levels.
 
     Arguments
     ---------
@@ -100,6 +100,8 @@
     For a given input matrix A and vectors x, y and scalars alpha, beta
     the wrapper determines the suitable SpMV computing
               y = alpha * A * x + beta * y.
+    For objects on the CPU, the CSR variants, CSR5, ELL, ELLPACKT, ELLRT,
+    and SELL-P are multiplied by magma_zspmv_cpu.
     Arguments
     ---------
 
@@ -327,7 +329,19 @@ magma_z_spmv(
             }
         }
     }
-    // CPU case missing!
+    // CPU case: native kernels; other formats are multiplied on the device
+    else if ( A.storage_type == Magma_CSR    ||
+              A.storage_type == Magma_CSRL   ||
+              A.storage_type == Magma_CSRU   ||
+              A.storage_type == Magma_CSRCOO ||
+              A.storage_type == Magma_CUCSR  ||
+              A.storage_type == Magma_CSR5   ||
+              A.storage_type == Magma_ELL    ||
+              A.storage_type == Magma_ELLPACKT ||
+              A.storage_type == Magma_ELLRT  ||
+              A.storage_type == Magma_SELLP ) {
+        CHECK( magma_zspmv_cpu( alpha, A, x, beta, y, queue ));
+    }
     else {
         CHECK( magma_zmtransfer( x, &dx, x.memory_location, Magma_DEV, queue ));
         CHECK( magma_zmtransfer( y, &dy, y.memory_location, Magma_DEV, queue ));
@@ -484,6 +498,8 @@ cleanup:
     For a given input matrix A and B and scalar alpha,
     the wrapper determines the suitable SpMV computing
               C = alpha * A * B.
+    For CSR matrices on the CPU, the product is computed by
+    magma_zspgemm_cpu.
     Arguments
     ---------
 
@@ -546,7 +562,19 @@ magma_z_spmm(
             }
         }
     }
-    // CPU case missing!
+    // CPU case: native product of CSR matrices; others are multiplied on the device
+    else if ( ( A.storage_type == Magma_CSR    ||
+                A.storage_type == Magma_CSRL   ||
+                A.storage_type == Magma_CSRU   ||
+                A.storage_type == Magma_CSRCOO ||
+                A.storage_type == Magma_CUCSR ) &&
+              ( B.storage_type == Magma_CSR    ||
+                B.storage_type == Magma_CSRL   ||
+                B.storage_type == Magma_CSRU   ||
+                B.storage_type == Magma_CSRCOO ||
+                B.storage_type == Magma_CUCSR ) ) {
+        CHECK( magma_zspgemm_cpu( MagmaNoTrans, A, B, C, queue ));
+    }
     else {
         A.storage_type = Magma_CSR;
         B.storage_type = Magma_CSR;
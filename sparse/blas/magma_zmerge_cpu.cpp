@@ -0,0 +1,727 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// vectors shorter than this are processed single-threaded
+#define MERGE_CPU_PARALLEL_SIZE 8192
+
+// upper bound on the threads used, for the partial sums kept on the stack
+#define MERGE_CPU_MAX_THREADS 256
+
+// rows processed together in the kernels working on several vectors
+#define MERGE_CPU_BLOCK 512
+
+
+/*
+    Fused vector kernels for the CPU Krylov solvers. Each kernel makes a
+    single pass over its vectors, except magma_zidrmerge_smooth_cpu, which
+    needs two. The vectors are split into one contiguous range per thread;
+    dot products are summed per thread, then over the threads in order,
+    so results are reproducible for a fixed number of threads.
+*/
+
+
+// Returns number of threads to use for vectors of length n: 1 for short
+// vectors or if called from inside a parallel region.
+static magma_int_t
+magma_zmerge_cpu_num_threads( magma_int_t n )
+{
+    magma_int_t num_threads = 1;
+#ifdef _OPENMP
+    if ( n >= MERGE_CPU_PARALLEL_SIZE && ! omp_in_parallel() ) {
+        num_threads = min( omp_get_max_threads(), MERGE_CPU_MAX_THREADS );
+    }
+#endif
+    return num_threads;
+}
+
+
+// Range [*begin, *end) of the n entries handled by the calling thread,
+// split over the team actually running, which may be smaller than the one
+// requested. Thread 0 stores the team size in *team, for the reduction of
+// the partial sums after the region. Returns the thread number.
+static inline magma_int_t
+magma_zmerge_cpu_range(
+    magma_int_t n,
+    magma_int_t *begin, magma_int_t *end, magma_int_t *team )
+{
+    magma_int_t t = 0, nt = 1;
+#ifdef _OPENMP
+    t  = omp_get_thread_num();
+    nt = omp_get_num_threads();
+#endif
+    if ( t == 0 ) {
+        *team = nt;
+    }
+    *begin = magma_int_t( int64_t(t)   * n / nt );
+    *end   = magma_int_t( int64_t(t+1) * n / nt );
+    return t;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the dot products of k vectors with a vector w,
+        dots(j) = v(:,j)^H w,  j = 0, ..., k-1,
+    in one pass over w. With k = 1, this is magma_zdotc on the CPU.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    k           magma_int_t
+                number of vectors v
+
+    @param[in]
+    v           magmaDoubleComplex_const_ptr
+                n-by-k array of vectors
+
+    @param[in]
+    ldv         magma_int_t
+                leading dimension of v
+
+    @param[in]
+    w           magmaDoubleComplex_const_ptr
+                vector of length n
+
+    @param[out]
+    dots        magmaDoubleComplex*
+                array of length k
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmdotc_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magmaDoubleComplex_const_ptr v,
+    magma_int_t ldv,
+    magmaDoubleComplex_const_ptr w,
+    magmaDoubleComplex *dots,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+    magma_int_t team = 1;
+    magmaDoubleComplex *partial = NULL;
+
+    CHECK( magma_zmalloc_cpu( &partial, num_threads*k ));
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t begin, end, t;
+        t = magma_zmerge_cpu_range( n, &begin, &end, &team );
+        magmaDoubleComplex *sum = partial + t*k;
+        for( magma_int_t j=0; j < k; j++ ){
+            sum[j] = MAGMA_Z_ZERO;
+        }
+        for( magma_int_t i0=begin; i0 < end; i0 += MERGE_CPU_BLOCK ){
+            magma_int_t i1 = min( i0 + MERGE_CPU_BLOCK, end );
+            for( magma_int_t j=0; j < k; j++ ){
+                const magmaDoubleComplex *vj = v + j*ldv;
+                magmaDoubleComplex s = MAGMA_Z_ZERO;
+                for( magma_int_t i=i0; i < i1; i++ ){
+                    s += MAGMA_Z_CONJ( vj[i] ) * w[i];
+                }
+                sum[j] += s;
+            }
+        }
+    }
+
+    for( magma_int_t j=0; j < k; j++ ){
+        dots[j] = MAGMA_Z_ZERO;
+        for( magma_int_t t=0; t < team; t++ ){
+            dots[j] += partial[ t*k + j ];
+        }
+    }
+
+cleanup:
+    magma_free_cpu( partial );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Subtracts a combination of k vectors from w and computes the norm of
+    the result,
+        w = w - v h,
+        nrm = || w ||_2,
+    in one pass over w. This is the update step of classical Gram-Schmidt.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    k           magma_int_t
+                number of vectors v
+
+    @param[in]
+    v           magmaDoubleComplex_const_ptr
+                n-by-k array of vectors
+
+    @param[in]
+    ldv         magma_int_t
+                leading dimension of v
+
+    @param[in]
+    h           const magmaDoubleComplex*
+                coefficients, array of length k
+
+    @param[in,out]
+    w           magmaDoubleComplex_ptr
+                vector of length n
+
+    @param[out]
+    nrm         double*
+                norm of the updated w
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmaxpy_nrm2_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magmaDoubleComplex_const_ptr v,
+    magma_int_t ldv,
+    const magmaDoubleComplex *h,
+    magmaDoubleComplex_ptr w,
+    double *nrm,
+    magma_queue_t queue )
+{
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+    magma_int_t team = 1;
+    double partial[ MERGE_CPU_MAX_THREADS ];
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t begin, end, t;
+        t = magma_zmerge_cpu_range( n, &begin, &end, &team );
+        double sum = 0.0;
+        for( magma_int_t i0=begin; i0 < end; i0 += MERGE_CPU_BLOCK ){
+            magma_int_t i1 = min( i0 + MERGE_CPU_BLOCK, end );
+            for( magma_int_t j=0; j < k; j++ ){
+                const magmaDoubleComplex *vj = v + j*ldv;
+                magmaDoubleComplex hj = h[j];
+                for( magma_int_t i=i0; i < i1; i++ ){
+                    w[i] -= vj[i] * hj;
+                }
+            }
+            for( magma_int_t i=i0; i < i1; i++ ){
+                sum += MAGMA_Z_REAL( MAGMA_Z_CONJ( w[i] ) * w[i] );
+            }
+        }
+        partial[t] = sum;
+    }
+
+    double sum = 0.0;
+    for( magma_int_t t=0; t < team; t++ ){
+        sum += partial[t];
+    }
+    *nrm = sqrt( sum );
+    return 0;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the solution and residual updates of CG with the residual norm:
+        x = x + alpha p,
+        r = r - alpha q,
+        rr = r^H r.
+    p may be the same vector as r; it is read before r is updated.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                step length
+
+    @param[in]
+    p           magmaDoubleComplex_const_ptr
+                search direction
+
+    @param[in]
+    q           magmaDoubleComplex_const_ptr
+                q = A p
+
+    @param[in,out]
+    x           magmaDoubleComplex_ptr
+                solution approximation
+
+    @param[in,out]
+    r           magmaDoubleComplex_ptr
+                residual
+
+    @param[out]
+    rr          double*
+                squared norm of the updated residual
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_const_ptr p,
+    magmaDoubleComplex_const_ptr q,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex_ptr r,
+    double *rr,
+    magma_queue_t queue )
+{
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+    magma_int_t team = 1;
+    double partial[ MERGE_CPU_MAX_THREADS ];
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t begin, end, t;
+        t = magma_zmerge_cpu_range( n, &begin, &end, &team );
+        double sum = 0.0;
+        for( magma_int_t i=begin; i < end; i++ ){
+            magmaDoubleComplex pi = p[i];
+            magmaDoubleComplex ri = r[i] - alpha * q[i];
+            x[i] += alpha * pi;
+            r[i] = ri;
+            sum += MAGMA_Z_REAL( MAGMA_Z_CONJ( ri ) * ri );
+        }
+        partial[t] = sum;
+    }
+
+    double sum = 0.0;
+    for( magma_int_t t=0; t < team; t++ ){
+        sum += partial[t];
+    }
+    *rr = sum;
+    return 0;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Updates the CG search direction,
+        p = r + beta p.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar beta
+
+    @param[in]
+    r           magmaDoubleComplex_const_ptr
+                residual
+
+    @param[in,out]
+    p           magmaDoubleComplex_ptr
+                search direction
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcgmerge_p_cpu(
+    magma_int_t n,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_ptr p,
+    magma_queue_t queue )
+{
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < n; i++ ){
+        p[i] = r[i] + beta * p[i];
+    }
+    return 0;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the intermediate residual of BiCGSTAB,
+        s = r - alpha v.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar alpha
+
+    @param[in]
+    r           magmaDoubleComplex_const_ptr
+                residual
+
+    @param[in]
+    v           magmaDoubleComplex_const_ptr
+                v = A p
+
+    @param[out]
+    s           magmaDoubleComplex_ptr
+                intermediate residual
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zbicgmerge_s_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_const_ptr v,
+    magmaDoubleComplex_ptr s,
+    magma_queue_t queue )
+{
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < n; i++ ){
+        s[i] = r[i] - alpha * v[i];
+    }
+    return 0;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the solution and residual updates of BiCGSTAB with the dot
+    products needed by the next iteration:
+        x = x + alpha p + omega s,
+        r = s - omega t,
+        rho = rr^H r,
+        nrm2 = r^H r.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar alpha
+
+    @param[in]
+    omega       magmaDoubleComplex
+                scalar omega
+
+    @param[in]
+    p           magmaDoubleComplex_const_ptr
+                search direction
+
+    @param[in]
+    s           magmaDoubleComplex_const_ptr
+                intermediate residual
+
+    @param[in]
+    t           magmaDoubleComplex_const_ptr
+                t = A s
+
+    @param[in]
+    rr          magmaDoubleComplex_const_ptr
+                shadow residual
+
+    @param[in,out]
+    x           magmaDoubleComplex_ptr
+                solution approximation
+
+    @param[out]
+    r           magmaDoubleComplex_ptr
+                residual
+
+    @param[out]
+    rho         magmaDoubleComplex*
+                rr^H r
+
+    @param[out]
+    nrm2        double*
+                squared norm of r
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zbicgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex omega,
+    magmaDoubleComplex_const_ptr p,
+    magmaDoubleComplex_const_ptr s,
+    magmaDoubleComplex_const_ptr t,
+    magmaDoubleComplex_const_ptr rr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex_ptr r,
+    magmaDoubleComplex *rho,
+    double *nrm2,
+    magma_queue_t queue )
+{
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+    magma_int_t team = 1;
+    magmaDoubleComplex partial_rho[ MERGE_CPU_MAX_THREADS ];
+    double partial_nrm2[ MERGE_CPU_MAX_THREADS ];
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t begin, end, id;
+        id = magma_zmerge_cpu_range( n, &begin, &end, &team );
+        magmaDoubleComplex sum_rho = MAGMA_Z_ZERO;
+        double sum_nrm2 = 0.0;
+        for( magma_int_t i=begin; i < end; i++ ){
+            magmaDoubleComplex ri = s[i] - omega * t[i];
+            x[i] += alpha * p[i] + omega * s[i];
+            r[i] = ri;
+            sum_rho  += MAGMA_Z_CONJ( rr[i] ) * ri;
+            sum_nrm2 += MAGMA_Z_REAL( MAGMA_Z_CONJ( ri ) * ri );
+        }
+        partial_rho[id]  = sum_rho;
+        partial_nrm2[id] = sum_nrm2;
+    }
+
+    *rho = MAGMA_Z_ZERO;
+    *nrm2 = 0.0;
+    for( magma_int_t id=0; id < team; id++ ){
+        *rho  += partial_rho[id];
+        *nrm2 += partial_nrm2[id];
+    }
+    return 0;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Updates the BiCGSTAB search direction,
+        p = r + beta ( p - omega v ).
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar beta
+
+    @param[in]
+    omega       magmaDoubleComplex
+                scalar omega
+
+    @param[in]
+    r           magmaDoubleComplex_const_ptr
+                residual
+
+    @param[in]
+    v           magmaDoubleComplex_const_ptr
+                v = A p
+
+    @param[in,out]
+    p           magmaDoubleComplex_ptr
+                search direction
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zbicgmerge_p_cpu(
+    magma_int_t n,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex omega,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_const_ptr v,
+    magmaDoubleComplex_ptr p,
+    magma_queue_t queue )
+{
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < n; i++ ){
+        p[i] = r[i] + beta * ( p[i] - omega * v[i] );
+    }
+    return 0;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Residual smoothing step of IDR(s): with t = rs - r,
+        gamma = (t^H rs) / (t^H t),
+        rs = rs - gamma t,
+        xs = xs - gamma (xs - x),
+        nrm = || rs ||_2.
+    t is not stored; the first pass computes the dot products, the second
+    the updates and the norm.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the vectors
+
+    @param[in]
+    r           magmaDoubleComplex_const_ptr
+                residual
+
+    @param[in]
+    x           magmaDoubleComplex_const_ptr
+                solution approximation
+
+    @param[in,out]
+    rs          magmaDoubleComplex_ptr
+                smoothed residual
+
+    @param[in,out]
+    xs          magmaDoubleComplex_ptr
+                smoothed solution approximation
+
+    @param[out]
+    nrm         double*
+                norm of the updated rs
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zidrmerge_smooth_cpu(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_const_ptr x,
+    magmaDoubleComplex_ptr rs,
+    magmaDoubleComplex_ptr xs,
+    double *nrm,
+    magma_queue_t queue )
+{
+    magma_int_t num_threads = magma_zmerge_cpu_num_threads( n );
+    magma_int_t team = 1;
+    magmaDoubleComplex partial_tr[ MERGE_CPU_MAX_THREADS ];
+    double partial_tt[ MERGE_CPU_MAX_THREADS ];
+    magmaDoubleComplex tr = MAGMA_Z_ZERO, gamma;
+    double tt = 0.0, sum = 0.0;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t begin, end, id;
+        id = magma_zmerge_cpu_range( n, &begin, &end, &team );
+        magmaDoubleComplex sum_tr = MAGMA_Z_ZERO;
+        double sum_tt = 0.0;
+        for( magma_int_t i=begin; i < end; i++ ){
+            magmaDoubleComplex ti = rs[i] - r[i];
+            sum_tr += MAGMA_Z_CONJ( ti ) * rs[i];
+            sum_tt += MAGMA_Z_REAL( MAGMA_Z_CONJ( ti ) * ti );
+        }
+        partial_tr[id] = sum_tr;
+        partial_tt[id] = sum_tt;
+    }
+    for( magma_int_t id=0; id < team; id++ ){
+        tr += partial_tr[id];
+        tt += partial_tt[id];
+    }
+    // rs == r gives t = 0, and the update is void
+    gamma = (tt > 0.0 ? tr / tt : MAGMA_Z_ZERO);
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t begin, end, id;
+        id = magma_zmerge_cpu_range( n, &begin, &end, &team );
+        double sum_nrm = 0.0;
+        for( magma_int_t i=begin; i < end; i++ ){
+            magmaDoubleComplex rsi = rs[i] - gamma * (rs[i] - r[i]);
+            xs[i] -= gamma * (xs[i] - x[i]);
+            rs[i] = rsi;
+            sum_nrm += MAGMA_Z_REAL( MAGMA_Z_CONJ( rsi ) * rsi );
+        }
+        partial_tt[id] = sum_nrm;
+    }
+    for( magma_int_t id=0; id < team; id++ ){
+        sum += partial_tt[id];
+    }
+    *nrm = sqrt( sum );
+    return 0;
+}
@@ -0,0 +1,644 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+#include <algorithm>
+
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// minimum number of products per thread; smaller products use fewer threads
+#define SPGEMM_CPU_FLOPS_PER_THREAD 32768
+
+// multiplier of the column index in the hash function
+#define SPGEMM_CPU_HASH_SCALE 107
+
+
+// Returns true if A is a CSR variant on the CPU.
+static bool
+magma_zspgemm_cpu_is_csr( const magma_z_matrix& A )
+{
+    return A.memory_location == Magma_CPU
+        && ( A.storage_type == Magma_CSR    ||
+             A.storage_type == Magma_CSRL   ||
+             A.storage_type == Magma_CSRU   ||
+             A.storage_type == Magma_CSRCOO ||
+             A.storage_type == Magma_CUCSR );
+}
+
+
+// Returns size of a hash table for n distinct keys: a power of 2, >= 2n.
+static inline magma_int_t
+magma_zspgemm_cpu_table_size( magma_int_t n )
+{
+    magma_int_t size = 8;
+    while ( size < 2*n ) {
+        size *= 2;
+    }
+    return size;
+}
+
+
+// Computes the number of products in each row of C = A*B, plus the number
+// of entries of C if C is given, into weight[i], and the prefix sums of
+// weight into prefix, of size num_rows+1. Returns the max over rows of the
+// number of products, bounded by B.num_cols, in *maxrow.
+static void
+magma_zspgemm_cpu_weights(
+    const magma_z_matrix& A, const magma_z_matrix& B, const magma_z_matrix* C,
+    magma_int_t *weight, double *prefix, magma_int_t *maxrow )
+{
+    magma_int_t rowmax = 0;
+    #pragma omp parallel for reduction( max: rowmax )
+    for( magma_int_t i=0; i < A.num_rows; i++ ){
+        magma_int_t flops = 0;
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+            flops += B.row[ A.col[j]+1 ] - B.row[ A.col[j] ];
+        }
+        rowmax = max( rowmax, min( flops, B.num_cols ));
+        if ( C != NULL ) {
+            flops += C->row[i+1] - C->row[i];
+        }
+        weight[i] = flops;
+    }
+    prefix[0] = 0;
+    for( magma_int_t i=0; i < A.num_rows; i++ ){
+        prefix[i+1] = prefix[i] + weight[i];
+    }
+    *maxrow = rowmax;
+}
+
+
+// Returns number of threads for the given total work: 1 for small products
+// or if called from inside a parallel region.
+static magma_int_t
+magma_zspgemm_cpu_num_threads( double work )
+{
+    magma_int_t num_threads = 1;
+#ifdef _OPENMP
+    if ( ! omp_in_parallel() ) {
+        num_threads = (magma_int_t) min( (double) omp_get_max_threads(),
+                                         ceil( work / SPGEMM_CPU_FLOPS_PER_THREAD ));
+        num_threads = max( num_threads, (magma_int_t) 1 );
+    }
+#endif
+    return num_threads;
+}
+
+
+// Splits n rows into nt contiguous blocks with about the same weight,
+// by the prefix sums of the weights: thread t gets rows [split[t], split[t+1]).
+static void
+magma_zspgemm_cpu_split(
+    magma_int_t n, const double *prefix, magma_int_t nt, magma_int_t *split )
+{
+    split[0] = 0;
+    for( magma_int_t t=1; t < nt; t++ ){
+        double target = prefix[n] * t / nt;
+        magma_int_t r = (magma_int_t)
+            ( std::lower_bound( prefix, prefix + n + 1, target ) - prefix );
+        split[t] = max( split[t-1], min( r, n ));
+    }
+    split[nt] = n;
+}
+
+
+// Returns the hash of column c in a table of size mask+1.
+static inline magma_int_t
+magma_zspgemm_cpu_hash( magma_index_t c, magma_int_t mask )
+{
+    return (magma_int_t) (((magma_uindex_t) c * SPGEMM_CPU_HASH_SCALE) & (magma_uindex_t) mask);
+}
+
+
+// Inserts column c in the hash table key of size mask+1;
+// returns true if it was not there yet.
+static inline bool
+magma_zspgemm_cpu_insert( magma_index_t *key, magma_int_t mask, magma_index_t c )
+{
+    magma_int_t h = magma_zspgemm_cpu_hash( c, mask );
+    while ( key[h] != c ) {
+        if ( key[h] == -1 ) {
+            key[h] = c;
+            return true;
+        }
+        h = (h + 1) & mask;
+    }
+    return false;
+}
+
+
+// Returns the slot of column c in the hash table key of size mask+1,
+// or -1 if c is not there.
+static inline magma_int_t
+magma_zspgemm_cpu_find( const magma_index_t *key, magma_int_t mask, magma_index_t c )
+{
+    magma_int_t h = magma_zspgemm_cpu_hash( c, mask );
+    while ( key[h] != c ) {
+        if ( key[h] == -1 ) {
+            return -1;
+        }
+        h = (h + 1) & mask;
+    }
+    return h;
+}
+
+
+// Symbolic product of CSR matrices: C->row and C->col of C = A*B, with
+// sorted columns. In the first pass, each thread counts the distinct
+// columns of its rows in a hash table; in the second, after the prefix sum
+// of the counts, it inserts them again and writes them out sorted.
+static magma_int_t
+magma_zspgemm_cpu_symbolic_csr(
+    magma_z_matrix A, magma_z_matrix B, magma_z_matrix *C,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_int_t *weight = NULL, *split = NULL;
+    double *prefix = NULL;
+    magma_index_t *table = NULL;
+    magma_int_t maxrow, capacity, num_threads;
+
+    CHECK( magma_imalloc_cpu( &weight, A.num_rows ));
+    CHECK( magma_dmalloc_cpu( &prefix, A.num_rows+1 ));
+    magma_zspgemm_cpu_weights( A, B, NULL, weight, prefix, &maxrow );
+
+    num_threads = magma_zspgemm_cpu_num_threads( prefix[ A.num_rows ] );
+    capacity = magma_zspgemm_cpu_table_size( maxrow );
+    CHECK( magma_imalloc_cpu( &split, num_threads+1 ));
+    CHECK( magma_index_malloc_cpu( &table, size_t(num_threads) * capacity ));
+    CHECK( magma_index_malloc_cpu( &C->row, A.num_rows+1 ));
+    magma_zspgemm_cpu_split( A.num_rows, prefix, num_threads, split );
+
+    #pragma omp parallel num_threads( num_threads )
+    {
+        magma_int_t nt = 1;
+        #ifdef _OPENMP
+        magma_int_t id = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #else
+        magma_int_t id = 0;
+        #endif
+        // the team may be smaller than requested, so each thread takes
+        // every nt-th block of rows, with the hash table of the block
+        for( magma_int_t b=id; b < num_threads; b += nt ){
+            magma_index_t *key = table + size_t(b) * capacity;
+            for( magma_int_t h=0; h < capacity; h++ ){
+                key[h] = -1;
+            }
+
+            // count distinct columns per row; clear the used part of the table
+            for( magma_int_t i=split[b]; i < split[b+1]; i++ ){
+                magma_int_t mask = magma_zspgemm_cpu_table_size( min( weight[i], B.num_cols )) - 1;
+                magma_index_t count = 0;
+                for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+                    magma_index_t k = A.col[j];
+                    for( magma_int_t l=B.row[k]; l < B.row[k+1]; l++ ){
+                        count += magma_zspgemm_cpu_insert( key, mask, B.col[l] );
+                    }
+                }
+                C->row[i+1] = count;
+                if ( count > 0 ) {
+                    for( magma_int_t h=0; h <= mask; h++ ){
+                        key[h] = -1;
+                    }
+                }
+            }
+        }
+    }
+    C->row[0] = 0;
+    for( magma_int_t i=0; i < A.num_rows; i++ ){
+        C->row[i+1] += C->row[i];
+    }
+    C->nnz = C->row[ A.num_rows ];
+    CHECK( magma_index_malloc_cpu( &C->col, C->nnz ));
+
+    #pragma omp parallel num_threads( num_threads )
+    {
+        magma_int_t nt = 1;
+        #ifdef _OPENMP
+        magma_int_t id = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #else
+        magma_int_t id = 0;
+        #endif
+        // the team may be smaller than requested, so each thread takes
+        // every nt-th block of rows, with the hash table of the block
+        for( magma_int_t b=id; b < num_threads; b += nt ){
+            magma_index_t *key = table + size_t(b) * capacity;
+
+            // insert again, then gather the columns and sort them
+            for( magma_int_t i=split[b]; i < split[b+1]; i++ ){
+                if ( C->row[i] == C->row[i+1] ) {
+                    continue;
+                }
+                magma_int_t mask = magma_zspgemm_cpu_table_size( min( weight[i], B.num_cols )) - 1;
+                for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+                    magma_index_t k = A.col[j];
+                    for( magma_int_t l=B.row[k]; l < B.row[k+1]; l++ ){
+                        magma_zspgemm_cpu_insert( key, mask, B.col[l] );
+                    }
+                }
+                magma_index_t *col = C->col + C->row[i];
+                magma_int_t count = 0;
+                for( magma_int_t h=0; h <= mask; h++ ){
+                    if ( key[h] != -1 ) {
+                        col[ count++ ] = key[h];
+                        key[h] = -1;
+                    }
+                }
+                std::sort( col, col + count );
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( weight );
+    magma_free_cpu( prefix );
+    magma_free_cpu( split );
+    magma_free_cpu( table );
+    return info;
+}
+
+
+// Numeric product of CSR matrices on the pattern of C: C->val = A*B, with
+// the products outside the pattern dropped. For each row, each thread
+// inserts the columns of C with their positions in a hash table, then
+// accumulates the products of the row into C->val through it.
+static magma_int_t
+magma_zspgemm_cpu_numeric_csr(
+    magma_z_matrix A, magma_z_matrix B, magma_z_matrix *C,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_int_t *weight = NULL, *split = NULL;
+    double *prefix = NULL;
+    magma_index_t *table = NULL;
+    magma_int_t maxrow, maxnnz = 0, capacity, num_threads;
+
+    CHECK( magma_imalloc_cpu( &weight, A.num_rows ));
+    CHECK( magma_dmalloc_cpu( &prefix, A.num_rows+1 ));
+    magma_zspgemm_cpu_weights( A, B, C, weight, prefix, &maxrow );
+    for( magma_int_t i=0; i < C->num_rows; i++ ){
+        maxnnz = max( maxnnz, (magma_int_t) (C->row[i+1] - C->row[i]) );
+    }
+
+    num_threads = magma_zspgemm_cpu_num_threads( prefix[ A.num_rows ] );
+    capacity = magma_zspgemm_cpu_table_size( maxnnz );
+    CHECK( magma_imalloc_cpu( &split, num_threads+1 ));
+    CHECK( magma_index_malloc_cpu( &table, size_t(2) * num_threads * capacity ));
+    magma_zspgemm_cpu_split( A.num_rows, prefix, num_threads, split );
+
+    #pragma omp parallel num_threads( num_threads )
+    {
+        magma_int_t nt = 1;
+        #ifdef _OPENMP
+        magma_int_t id = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #else
+        magma_int_t id = 0;
+        #endif
+        // the team may be smaller than requested, so each thread takes
+        // every nt-th block of rows, with the hash table of the block
+        for( magma_int_t b=id; b < num_threads; b += nt ){
+            magma_index_t *key = table + size_t(2) * b * capacity;
+            magma_index_t *pos = key + capacity;
+            for( magma_int_t h=0; h < capacity; h++ ){
+                key[h] = -1;
+            }
+
+            for( magma_int_t i=split[b]; i < split[b+1]; i++ ){
+                magma_int_t cbeg = C->row[i], cend = C->row[i+1];
+                if ( cbeg == cend ) {
+                    continue;
+                }
+                magma_int_t mask = magma_zspgemm_cpu_table_size( cend - cbeg ) - 1;
+                for( magma_int_t p=cbeg; p < cend; p++ ){
+                    magma_index_t c = C->col[p];
+                    magma_int_t h = magma_zspgemm_cpu_hash( c, mask );
+                    while ( key[h] != -1 ) {
+                        h = (h + 1) & mask;
+                    }
+                    key[h] = c;
+                    pos[h] = p;
+                    C->val[p] = MAGMA_Z_ZERO;
+                }
+                for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+                    magma_index_t k = A.col[j];
+                    magmaDoubleComplex a = A.val[j];
+                    for( magma_int_t l=B.row[k]; l < B.row[k+1]; l++ ){
+                        magma_int_t h = magma_zspgemm_cpu_find( key, mask, B.col[l] );
+                        if ( h >= 0 ) {
+                            C->val[ pos[h] ] += a * B.val[l];
+                        }
+                    }
+                }
+                for( magma_int_t h=0; h <= mask; h++ ){
+                    key[h] = -1;
+                }
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( weight );
+    magma_free_cpu( prefix );
+    magma_free_cpu( split );
+    magma_free_cpu( table );
+    return info;
+}
+
+
+// Checks that A, B, and C, if given, are CSR matrices on the CPU with
+// dimensions that match for C = op(A) * B.
+static magma_int_t
+magma_zspgemm_cpu_check(
+    magma_trans_t transA, const magma_z_matrix& A, const magma_z_matrix& B,
+    const magma_z_matrix* C )
+{
+    magma_int_t info = 0;
+    magma_int_t m = (transA == MagmaNoTrans ? A.num_rows : A.num_cols);
+    magma_int_t k = (transA == MagmaNoTrans ? A.num_cols : A.num_rows);
+    if ( ! magma_zspgemm_cpu_is_csr( A ) || ! magma_zspgemm_cpu_is_csr( B )
+         || ( C != NULL && ! magma_zspgemm_cpu_is_csr( *C ))) {
+        printf("error: format not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    else if ( k != B.num_rows
+              || ( C != NULL && ( C->num_rows != m || C->num_cols != B.num_cols ))) {
+        printf("error: matrix dimensions do not match.\n");
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    return info;
+}
+
+
+// Sets *At = op(A) for transA = MagmaTrans or MagmaConjTrans, and
+// *opA = *At; for MagmaNoTrans, sets *opA = A. If values is false,
+// only the pattern is transposed.
+static magma_int_t
+magma_zspgemm_cpu_op(
+    magma_trans_t transA, magma_z_matrix A, bool values,
+    magma_z_matrix *At, magma_z_matrix *opA,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if ( transA == MagmaNoTrans ) {
+        *opA = A;
+    }
+    else {
+        if ( ! values ) {
+            CHECK( magma_zmtransposestruct_cpu( A, At, queue ));
+        }
+        else if ( transA == MagmaConjTrans ) {
+            CHECK( magma_zmtransposeconj_cpu( A, At, queue ));
+        }
+        else {
+            CHECK( magma_zmtranspose_cpu( A, At, queue ));
+        }
+        *opA = *At;
+    }
+
+cleanup:
+    return info;
+}
+
+
+// Symbolic product C = opA * B into D, with values set to zero.
+static magma_int_t
+magma_zspgemm_cpu_pattern(
+    magma_z_matrix opA, magma_z_matrix B, magma_z_matrix *D,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    D->storage_type = Magma_CSR;
+    D->memory_location = Magma_CPU;
+    D->fill_mode = MagmaFull;
+    D->ownership = MagmaTrue;
+    D->num_rows = opA.num_rows;
+    D->num_cols = B.num_cols;
+    CHECK( magma_zspgemm_cpu_symbolic_csr( opA, B, D, queue ));
+    CHECK( magma_zmalloc_cpu( &D->val, D->nnz ));
+    #pragma omp parallel for
+    for( magma_int_t p=0; p < D->nnz; p++ ){
+        D->val[p] = MAGMA_Z_ZERO;
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes on the CPU the nonzero pattern of the sparse matrix product
+              C = op(A) * B,
+    with op(A) = A, A^T, or A^H, as the first phase of magma_zspgemm_cpu.
+    The columns in each row of C are sorted; the values are set to zero.
+    magma_zspgemm_cpu_numeric then computes the values, and can be called
+    again for new values of A and B with the same patterns.
+
+    Each OpenMP thread handles a block of rows with about the same number
+    of products, and finds the distinct columns of each row with a hash
+    table sized for that row. Products with fewer than 32768 scalar
+    multiplications, or calls from inside a parallel region, run
+    single-threaded.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                Operation op(A): MagmaNoTrans, MagmaTrans, or MagmaConjTrans.
+                For MagmaTrans and MagmaConjTrans, A is transposed
+                explicitly by magma_zmtranspose_cpu first.
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix A in CSR on the CPU
+
+    @param[in]
+    B           magma_z_matrix
+                sparse matrix B in CSR on the CPU
+
+    @param[out]
+    C           magma_z_matrix*
+                pattern of C = op(A) * B in CSR on the CPU.
+                C is overwritten without being freed.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zspgemm_cpu_symbolic(
+    magma_trans_t transA,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *C,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_z_matrix At={Magma_CSR}, opA={Magma_CSR}, D={Magma_CSR};
+
+    CHECK( magma_zspgemm_cpu_check( transA, A, B, NULL ));
+    CHECK( magma_zspgemm_cpu_op( transA, A, false, &At, &opA, queue ));
+    CHECK( magma_zspgemm_cpu_pattern( opA, B, &D, queue ));
+    *C = D;
+
+cleanup:
+    if ( info != 0 ) {
+        magma_zmfree( &D, queue );
+    }
+    magma_zmfree( &At, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes on the CPU the values of the sparse matrix product
+              C = op(A) * B
+    on a given nonzero pattern of C, as the second phase of
+    magma_zspgemm_cpu. The pattern is typically from
+    magma_zspgemm_cpu_symbolic, and reused for repeated products of
+    matrices with the same patterns. Entries of C that get no product are
+    set to zero; products outside the pattern of C are dropped, so any
+    pattern can be given, e.g., the pattern of A for the ParILUT residual
+    A - L*U, or a sparsity pattern for ISAI.
+
+    Each OpenMP thread handles a block of rows with about the same number
+    of products, and accumulates each row through a hash table mapping
+    the columns of C to their positions.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                Operation op(A): MagmaNoTrans, MagmaTrans, or MagmaConjTrans.
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix A in CSR on the CPU
+
+    @param[in]
+    B           magma_z_matrix
+                sparse matrix B in CSR on the CPU
+
+    @param[in,out]
+    C           magma_z_matrix*
+                On entry, the pattern of C in CSR on the CPU, with
+                op(A).num_rows rows, B.num_cols columns, and no duplicate
+                columns in a row.
+                On exit, the values of C = op(A) * B on that pattern.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zspgemm_cpu_numeric(
+    magma_trans_t transA,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *C,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_z_matrix At={Magma_CSR}, opA={Magma_CSR};
+
+    CHECK( magma_zspgemm_cpu_check( transA, A, B, C ));
+    CHECK( magma_zspgemm_cpu_op( transA, A, true, &At, &opA, queue ));
+    CHECK( magma_zspgemm_cpu_numeric_csr( opA, B, C, queue ));
+
+cleanup:
+    magma_zmfree( &At, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes on the CPU the sparse matrix product
+              C = op(A) * B,
+    with op(A) = A, A^T, or A^H, e.g., A^T A for transA = MagmaTrans and
+    B = A. This is the CPU path of magma_z_spmm.
+    Computes the pattern of C, as magma_zspgemm_cpu_symbolic, then its
+    values, as magma_zspgemm_cpu_numeric, transposing A only once; to
+    multiply matrices with the same patterns repeatedly, call these two
+    directly and reuse C.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                Operation op(A): MagmaNoTrans, MagmaTrans, or MagmaConjTrans.
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix A in CSR on the CPU
+
+    @param[in]
+    B           magma_z_matrix
+                sparse matrix B in CSR on the CPU
+
+    @param[out]
+    C           magma_z_matrix*
+                C = op(A) * B in CSR on the CPU, with sorted columns.
+                C is overwritten without being freed.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zspgemm_cpu(
+    magma_trans_t transA,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *C,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_z_matrix At={Magma_CSR}, opA={Magma_CSR}, D={Magma_CSR};
+
+    CHECK( magma_zspgemm_cpu_check( transA, A, B, NULL ));
+    CHECK( magma_zspgemm_cpu_op( transA, A, true, &At, &opA, queue ));
+    CHECK( magma_zspgemm_cpu_pattern( opA, B, &D, queue ));
+    CHECK( magma_zspgemm_cpu_numeric_csr( opA, B, &D, queue ));
+    *C = D;
+
+cleanup:
+    if ( info != 0 ) {
+        magma_zmfree( &D, queue );
+    }
+    magma_zmfree( &At, queue );
+    return info;
+}
@@ -0,0 +1,489 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+#include <algorithm>
+
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// number of vectors processed together in the SpMM kernels
+#define SPMV_CPU_VBLOCK 8
+
+// number of rows processed together in the ELL kernel
+#define SPMV_CPU_ELL_BLOCK 64
+
+// matrices with fewer nonzeros than this are multiplied single-threaded
+#define SPMV_CPU_PARALLEL_NNZ 20000
+
+
+// Returns number of threads to use for a product with nnz stored entries:
+// 1 for small matrices or if called from inside a parallel region.
+static magma_int_t
+magma_zspmv_cpu_num_threads( magma_int_t nnz )
+{
+    magma_int_t num_threads = 1;
+#ifdef _OPENMP
+    if ( nnz >= SPMV_CPU_PARALLEL_NNZ && ! omp_in_parallel() ) {
+        num_threads = omp_get_max_threads();
+    }
+#endif
+    return num_threads;
+}
+
+
+// y = alpha*sum + beta*y; y is not read if beta is zero, as in BLAS.
+static inline void
+magma_zspmv_cpu_update(
+    magmaDoubleComplex alpha, magmaDoubleComplex sum,
+    magmaDoubleComplex beta, magmaDoubleComplex *y )
+{
+    if ( MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO )) {
+        *y = alpha * sum;
+    } else {
+        *y = alpha * sum + beta * (*y);
+    }
+}
+
+
+// Position in a CSR5 matrix, giving the storage index of consecutive entries
+// in CSR order. Within a full tile that is not a fast-track tile, the
+// omega x sigma entries are stored transposed.
+class magma_zspmv_cpu_csr5_pos
+{
+public:
+    magma_zspmv_cpu_csr5_pos( const magma_z_matrix& A, magma_int_t j ):
+        A_( A ),
+        tile_size_( MAGMA_CSR5_OMEGA * A.csr5_sigma )
+    {
+        set_tile( j / tile_size_ );
+        magma_int_t q = j - base_;
+        lane_ = q / A_.csr5_sigma;
+        step_ = q % A_.csr5_sigma;
+    }
+
+    magma_int_t index() const
+    {
+        return (transposed_
+                ? base_ + step_*MAGMA_CSR5_OMEGA + lane_
+                : base_ + lane_*A_.csr5_sigma + step_);
+    }
+
+    void next()
+    {
+        if ( ++step_ == A_.csr5_sigma ) {
+            step_ = 0;
+            if ( ++lane_ == MAGMA_CSR5_OMEGA ) {
+                set_tile( tile_ + 1 );
+                lane_ = 0;
+            }
+        }
+    }
+
+private:
+    void set_tile( magma_int_t tile )
+    {
+        tile_ = tile;
+        base_ = tile * tile_size_;
+        transposed_ = (tile < A_.csr5_p-1 && A_.tile_ptr[tile] != A_.tile_ptr[tile+1]);
+    }
+
+    const magma_z_matrix& A_;
+    magma_int_t tile_size_, tile_, base_, lane_, step_;
+    bool transposed_;
+};
+
+
+// sum[v] = sum over entries j in [jbeg, jend) of val[j] * x[ col[j]*incx + v*ldx ],
+// for v < nv. For csr5, entries are located by magma_zspmv_cpu_csr5_pos.
+template< bool csr5 >
+static inline void
+magma_zspmv_cpu_rowdot(
+    const magma_z_matrix& A, magma_int_t jbeg, magma_int_t jend,
+    magma_int_t nv,
+    const magmaDoubleComplex *x, magma_int_t incx, magma_int_t ldx,
+    magmaDoubleComplex *sum )
+{
+    for( magma_int_t v=0; v < nv; v++ ){
+        sum[v] = MAGMA_Z_ZERO;
+    }
+    if ( jbeg >= jend ) {
+        return;
+    }
+    if ( csr5 ) {
+        magma_zspmv_cpu_csr5_pos pos( A, jbeg );
+        for( magma_int_t j=jbeg; j < jend; j++, pos.next() ){
+            magma_int_t k = pos.index();
+            const magmaDoubleComplex *xk = x + A.col[k]*incx;
+            for( magma_int_t v=0; v < nv; v++ ){
+                sum[v] += A.val[k] * xk[ v*ldx ];
+            }
+        }
+    }
+    else if ( nv == 1 && incx == 1 ) {
+        magmaDoubleComplex s = MAGMA_Z_ZERO;
+        for( magma_int_t j=jbeg; j < jend; j++ ){
+            s += A.val[j] * x[ A.col[j] ];
+        }
+        sum[0] = s;
+    }
+    else {
+        for( magma_int_t j=jbeg; j < jend; j++ ){
+            const magmaDoubleComplex *xk = x + A.col[j]*incx;
+            for( magma_int_t v=0; v < nv; v++ ){
+                sum[v] += A.val[j] * xk[ v*ldx ];
+            }
+        }
+    }
+}
+
+
+/*
+    CSR and CSR5 product with the nonzeros, not the rows, split evenly among
+    threads. Entries [begin[t], begin[t+1]) are done by part t, which writes
+    the rows starting in its range. A row straddling the start of the range
+    is owned by an earlier part; its partial sums go to carry and are added
+    afterwards. Vector element (i, v) is x[ i*incx + v*ldx ].
+    For CSR5, the parts are aligned to tiles.
+*/
+template< bool csr5 >
+static magma_int_t
+magma_zspmv_cpu_csr(
+    magmaDoubleComplex alpha,
+    const magma_z_matrix& A,
+    magma_int_t num_vecs,
+    const magmaDoubleComplex *x, magma_int_t incx, magma_int_t ldx,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y, magma_int_t incy, magma_int_t ldy )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows, nnz = A.row[ A.num_rows ];
+    magma_int_t num_threads = magma_zspmv_cpu_num_threads( nnz );
+    magma_int_t granularity = (csr5 ? MAGMA_CSR5_OMEGA * A.csr5_sigma : 1);
+    magma_int_t units = magma_ceildiv( nnz, granularity );
+    magma_int_t *begin = NULL, *first = NULL, *carry_row = NULL;
+    magmaDoubleComplex *carry = NULL;
+
+    CHECK( magma_imalloc_cpu( &begin, 3*(num_threads+1) ));
+    first     = begin + num_threads+1;
+    carry_row = first + num_threads+1;
+    CHECK( magma_zmalloc_cpu( &carry, num_threads*num_vecs ));
+
+    // ranges of nonzeros, and first row starting in each range
+    for( magma_int_t t=0; t <= num_threads; t++ ){
+        begin[t] = (magma_int_t) min( ((int64_t) t * units / num_threads) * granularity, (int64_t) nnz );
+        first[t] = std::lower_bound( A.row, A.row + n, (magma_index_t) begin[t] ) - A.row;
+    }
+    first[0] = 0;
+    first[num_threads] = n;
+
+    #pragma omp parallel for schedule(static,1) num_threads(num_threads)
+    for( magma_int_t t=0; t < num_threads; t++ ){
+        magma_int_t end = begin[t+1];
+        magmaDoubleComplex sum[ SPMV_CPU_VBLOCK ];
+        // row straddling the start of the range
+        carry_row[t] = -1;
+        if ( first[t] > 0 && A.row[ first[t] ] > begin[t] ) {
+            magma_int_t r = first[t] - 1;
+            magma_int_t jend = min( (magma_int_t) A.row[r+1], end );
+            carry_row[t] = r;
+            for( magma_int_t v0=0; v0 < num_vecs; v0 += SPMV_CPU_VBLOCK ){
+                magma_int_t nv = min( (magma_int_t) SPMV_CPU_VBLOCK, num_vecs - v0 );
+                magma_zspmv_cpu_rowdot< csr5 >( A, begin[t], jend, nv, x + v0*ldx, incx, ldx, sum );
+                for( magma_int_t v=0; v < nv; v++ ){
+                    carry[ t*num_vecs + v0 + v ] = sum[v];
+                }
+            }
+        }
+        // rows starting in the range; the last one may continue after it
+        if ( ! csr5 && num_vecs == 1 ) {
+            for( magma_int_t r=first[t]; r < first[t+1]; r++ ){
+                magma_int_t jend = min( (magma_int_t) A.row[r+1], end );
+                magmaDoubleComplex s = MAGMA_Z_ZERO;
+                for( magma_int_t j=A.row[r]; j < jend; j++ ){
+                    s += A.val[j] * x[ A.col[j] ];
+                }
+                magma_zspmv_cpu_update( alpha, s, beta, &y[ r ] );
+            }
+            continue;
+        }
+        for( magma_int_t r=first[t]; r < first[t+1]; r++ ){
+            magma_int_t jbeg = A.row[r];
+            magma_int_t jend = min( (magma_int_t) A.row[r+1], end );
+            for( magma_int_t v0=0; v0 < num_vecs; v0 += SPMV_CPU_VBLOCK ){
+                magma_int_t nv = min( (magma_int_t) SPMV_CPU_VBLOCK, num_vecs - v0 );
+                magma_zspmv_cpu_rowdot< csr5 >( A, jbeg, jend, nv, x + v0*ldx, incx, ldx, sum );
+                for( magma_int_t v=0; v < nv; v++ ){
+                    magma_zspmv_cpu_update( alpha, sum[v], beta, &y[ r*incy + (v0+v)*ldy ] );
+                }
+            }
+        }
+    }
+
+    // add partial sums of the rows split among parts, in order
+    for( magma_int_t t=0; t < num_threads; t++ ){
+        if ( carry_row[t] >= 0 ) {
+            for( magma_int_t v=0; v < num_vecs; v++ ){
+                y[ carry_row[t]*incy + v*ldy ] += alpha * carry[ t*num_vecs + v ];
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( begin );
+    magma_free_cpu( carry );
+    return info;
+}
+
+
+// ELL (column-major, padded with explicit zeros) product; blocks of rows,
+// vectorized over the rows of a block.
+static magma_int_t
+magma_zspmv_cpu_ell(
+    magmaDoubleComplex alpha,
+    const magma_z_matrix& A,
+    magma_int_t num_vecs,
+    const magmaDoubleComplex *x, magma_int_t incx, magma_int_t ldx,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y, magma_int_t incy, magma_int_t ldy )
+{
+    magma_int_t n = A.num_rows, width = A.max_nnz_row;
+    magma_int_t num_threads = magma_zspmv_cpu_num_threads( n*width );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t r0=0; r0 < n; r0 += SPMV_CPU_ELL_BLOCK ){
+        magma_int_t nr = min( (magma_int_t) SPMV_CPU_ELL_BLOCK, n - r0 );
+        magmaDoubleComplex sum[ SPMV_CPU_ELL_BLOCK ];
+        for( magma_int_t v=0; v < num_vecs; v++ ){
+            const magmaDoubleComplex *xv = x + v*ldx;
+            for( magma_int_t i=0; i < nr; i++ ){
+                sum[i] = MAGMA_Z_ZERO;
+            }
+            for( magma_int_t k=0; k < width; k++ ){
+                const magmaDoubleComplex *val = A.val + k*n + r0;
+                const magma_index_t *col = A.col + k*n + r0;
+                #pragma omp simd
+                for( magma_int_t i=0; i < nr; i++ ){
+                    sum[i] += val[i] * xv[ col[i]*incx ];
+                }
+            }
+            for( magma_int_t i=0; i < nr; i++ ){
+                magma_zspmv_cpu_update( alpha, sum[i], beta, &y[ (r0+i)*incy + v*ldy ] );
+            }
+        }
+    }
+    return 0;
+}
+
+
+// ELLPACKT and ELLRT (row-major, rows of length stride) product. Row i has
+// length[i] entries for ELLRT; for ELLPACKT, padding has column index -1.
+static magma_int_t
+magma_zspmv_cpu_ellrow(
+    magmaDoubleComplex alpha,
+    const magma_z_matrix& A,
+    magma_int_t stride,
+    const magma_index_t *length,
+    magma_int_t num_vecs,
+    const magmaDoubleComplex *x, magma_int_t incx, magma_int_t ldx,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y, magma_int_t incy, magma_int_t ldy )
+{
+    magma_int_t n = A.num_rows;
+    magma_int_t num_threads = magma_zspmv_cpu_num_threads( n*stride );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < n; i++ ){
+        const magmaDoubleComplex *val = A.val + i*stride;
+        const magma_index_t *col = A.col + i*stride;
+        magma_int_t len = (length != NULL ? length[i] : stride);
+        for( magma_int_t v=0; v < num_vecs; v++ ){
+            magmaDoubleComplex sum = MAGMA_Z_ZERO;
+            for( magma_int_t k=0; k < len && col[k] >= 0; k++ ){
+                sum += val[k] * x[ col[k]*incx + v*ldx ];
+            }
+            magma_zspmv_cpu_update( alpha, sum, beta, &y[ i*incy + v*ldy ] );
+        }
+    }
+    return 0;
+}
+
+
+// SELL-P product. Slices are split among threads by their number of stored
+// entries; within a slice, the rows are vectorized.
+static magma_int_t
+magma_zspmv_cpu_sellp(
+    magmaDoubleComplex alpha,
+    const magma_z_matrix& A,
+    magma_int_t num_vecs,
+    const magmaDoubleComplex *x, magma_int_t incx, magma_int_t ldx,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y, magma_int_t incy, magma_int_t ldy )
+{
+    magma_int_t info = 0;
+    magma_int_t C = A.blocksize, nslices = A.numblocks;
+    magma_int_t nnz = A.row[ nslices ];
+    magma_int_t num_threads = magma_zspmv_cpu_num_threads( nnz );
+    magma_int_t *first = NULL;
+    magmaDoubleComplex *work = NULL;
+
+    CHECK( magma_imalloc_cpu( &first, num_threads+1 ));
+    CHECK( magma_zmalloc_cpu( &work, num_threads*C ));
+    for( magma_int_t t=0; t <= num_threads; t++ ){
+        magma_index_t target = (magma_index_t) ((double) nnz * t / num_threads);
+        first[t] = std::lower_bound( A.row, A.row + nslices, target ) - A.row;
+    }
+    first[0] = 0;
+    first[num_threads] = nslices;
+
+    // parts are iterated, not tied to thread ids, so all are done
+    // even if the team is smaller than num_threads
+    #pragma omp parallel for schedule(static,1) num_threads(num_threads)
+    for( magma_int_t t=0; t < num_threads; t++ ){
+        magmaDoubleComplex *sum = work + t*C;
+        for( magma_int_t s=first[t]; s < first[t+1]; s++ ){
+            magma_int_t base = A.row[s];
+            magma_int_t width = (A.row[s+1] - base) / C;
+            magma_int_t nr = min( C, A.num_rows - s*C );
+            for( magma_int_t v=0; v < num_vecs; v++ ){
+                const magmaDoubleComplex *xv = x + v*ldx;
+                for( magma_int_t i=0; i < C; i++ ){
+                    sum[i] = MAGMA_Z_ZERO;
+                }
+                for( magma_int_t k=0; k < width; k++ ){
+                    const magmaDoubleComplex *val = A.val + base + k*C;
+                    const magma_index_t *col = A.col + base + k*C;
+                    #pragma omp simd
+                    for( magma_int_t i=0; i < C; i++ ){
+                        sum[i] += val[i] * xv[ col[i]*incx ];
+                    }
+                }
+                for( magma_int_t i=0; i < nr; i++ ){
+                    magma_zspmv_cpu_update( alpha, sum[i], beta, &y[ (s*C+i)*incy + v*ldy ] );
+                }
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( work );
+    magma_free_cpu( first );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes on the CPU the sparse matrix-vector product
+              y = alpha * A * x + beta * y,
+    or, for x with several columns, the sparse matrix-matrix product.
+    This is the CPU path of magma_z_spmv.
+
+    Supported formats are the CSR variants (CSR, CSRL, CSRU, CSRCOO, CUCSR),
+    ELL, ELLPACKT, ELLRT, SELL-P, and CSR5. The work is split among OpenMP
+    threads by number of nonzeros: for CSR and CSR5, rows may be shared
+    by threads, whose partial sums are added at the end; SELL-P slices
+    are split by their number of stored entries. The SELL-P and ELL kernels
+    are vectorized over the rows of a slice or block.
+    Matrices with fewer than 20000 nonzeros, or calls from inside a parallel
+    region, run single-threaded. If beta is zero, y need not be initialized.
+
+    Arguments
+    ---------
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar alpha
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix A on the CPU
+
+    @param[in]
+    x           magma_z_matrix
+                input vector(s) x on the CPU, in column-major or row-major
+                order for several vectors.
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar beta
+
+    @param[in,out]
+    y           magma_z_matrix
+                output vector(s) y on the CPU, in the same order as x.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zspmv_cpu(
+    magmaDoubleComplex alpha,
+    magma_z_matrix A,
+    magma_z_matrix x,
+    magmaDoubleComplex beta,
+    magma_z_matrix y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t num_vecs = 1, incx = 1, ldx = A.num_cols, incy = 1, ldy = A.num_rows;
+
+    if ( A.num_cols < x.num_rows || x.num_cols > 1 ) {
+        num_vecs = x.num_rows / A.num_cols * x.num_cols;
+        if ( x.major == MagmaRowMajor ) {
+            incx = num_vecs;
+            ldx  = 1;
+            incy = num_vecs;
+            ldy  = 1;
+        }
+    }
+
+    if ( A.storage_type == Magma_CSR   ||
+         A.storage_type == Magma_CSRL  ||
+         A.storage_type == Magma_CSRU  ||
+         A.storage_type == Magma_CSRCOO ||
+         A.storage_type == Magma_CUCSR )
+    {
+        CHECK( magma_zspmv_cpu_csr< false >( alpha, A, num_vecs, x.val, incx, ldx,
+                                             beta, y.val, incy, ldy ));
+    }
+    else if ( A.storage_type == Magma_CSR5 ) {
+        CHECK( magma_zspmv_cpu_csr< true >( alpha, A, num_vecs, x.val, incx, ldx,
+                                            beta, y.val, incy, ldy ));
+    }
+    else if ( A.storage_type == Magma_ELL ) {
+        CHECK( magma_zspmv_cpu_ell( alpha, A, num_vecs, x.val, incx, ldx,
+                                    beta, y.val, incy, ldy ));
+    }
+    else if ( A.storage_type == Magma_ELLPACKT ) {
+        CHECK( magma_zspmv_cpu_ellrow( alpha, A, A.max_nnz_row, NULL,
+                                       num_vecs, x.val, incx, ldx, beta, y.val, incy, ldy ));
+    }
+    else if ( A.storage_type == Magma_ELLRT ) {
+        CHECK( magma_zspmv_cpu_ellrow( alpha, A, magma_roundup( A.max_nnz_row, A.alignment ), A.row,
+                                       num_vecs, x.val, incx, ldx, beta, y.val, incy, ldy ));
+    }
+    else if ( A.storage_type == Magma_SELLP ) {
+        CHECK( magma_zspmv_cpu_sellp( alpha, A, num_vecs, x.val, incx, ldx,
+                                      beta, y.val, incy, ldy ));
+    }
+    else {
+        printf("error: format not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+cleanup:
+    return info;
+}
@@ -26,6 +26,11 @@ magma_int_t magma_ztrisolve_analysis(magma_z_matrix M, magma_solve_info_t *solve
 {
     magma_int_t info = 0;
 
+    if (M.memory_location == Magma_CPU) {
+        return magma_ztrisolve_analysis_cpu(M, solve_info, upper_triangular,
+                                            unit_diagonal, transpose, queue);
+    }
+
     cusparseHandle_t cusparseHandle = NULL;
     cusparseFillMode_t fill_mode = upper_triangular ? CUSPARSE_FILL_MODE_UPPER
                                                     : CUSPARSE_FILL_MODE_LOWER;
@@ -118,6 +123,11 @@ magma_int_t magma_ztrisolve(magma_z_matrix M, magma_solve_info_t solve_info, boo
 {
     magma_int_t info = 0;
 
+    if (M.memory_location == Magma_CPU) {
+        return magma_ztrisolve_cpu(M, solve_info, upper_triangular,
+                                   unit_diagonal, transpose, b, x, queue);
+    }
+
     cusparseHandle_t cusparseHandle = NULL;
     cusparseFillMode_t fill_mode = upper_triangular ? CUSPARSE_FILL_MODE_UPPER
                                                     : CUSPARSE_FILL_MODE_LOWER;
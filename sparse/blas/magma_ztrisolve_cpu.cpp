@@ -0,0 +1,366 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "magma_trisolve.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// matrices with fewer nonzeros than this are solved single-threaded
+#define TRISOLVE_CPU_PARALLEL_NNZ 20000
+
+// levels with fewer entries (plus rows) than this per thread are solved by
+// one thread instead of being split among the threads
+#define TRISOLVE_CPU_LEVEL_NNZ 64
+
+// runs of levels with fewer entries (plus rows) than this each are solved
+// by one thread, without a barrier in between
+#define TRISOLVE_CPU_TINY_LEVEL_NNZ 64
+
+
+// Solves rows perm[rbeg : rend] of the level schedule, in order:
+// x[i] = (b[i] - sum_k val[k] x[col[k]]) / d[i], for nrhs columns of b and x.
+template< bool unit >
+static inline void
+magma_ztrisolve_cpu_rows(
+    const magma_solve_levels_t& L, magma_int_t rbeg, magma_int_t rend,
+    magma_int_t nrhs, const magmaDoubleComplex *b, magmaDoubleComplex *x,
+    magma_int_t ld )
+{
+    const magmaDoubleComplex *val  = (const magmaDoubleComplex*) L.val;
+    const magmaDoubleComplex *dinv = (const magmaDoubleComplex*) L.diag;
+    for( magma_int_t r=rbeg; r < rend; r++ ){
+        magma_index_t i = L.perm[r];
+        for( magma_int_t v=0; v < nrhs; v++ ){
+            const magmaDoubleComplex *xv = x + v*ld;
+            magmaDoubleComplex s = b[ i + v*ld ];
+            for( magma_int_t k=L.row[r]; k < L.row[r+1]; k++ ){
+                s -= val[k] * xv[ L.col[k] ];
+            }
+            x[ i + v*ld ] = (unit ? s : s * dinv[r]);
+        }
+    }
+}
+
+
+// Solves with the level schedule: levels with enough entries are split
+// among the threads, with a barrier after each; smaller levels are solved
+// by a single thread, and runs of tiny levels are solved together.
+template< bool unit >
+static void
+magma_ztrisolve_cpu_levels(
+    const magma_solve_levels_t& L, magma_int_t nrhs,
+    const magmaDoubleComplex *b, magmaDoubleComplex *x, magma_int_t ld )
+{
+    magma_int_t num_threads = 1;
+#ifdef _OPENMP
+    if ( L.row[ L.num_rows ] + L.num_rows >= TRISOLVE_CPU_PARALLEL_NNZ
+         && ! omp_in_parallel() ) {
+        num_threads = omp_get_max_threads();
+    }
+#endif
+    if ( num_threads == 1 ) {
+        magma_ztrisolve_cpu_rows< unit >( L, 0, L.num_rows, nrhs, b, x, ld );
+        return;
+    }
+
+    #pragma omp parallel num_threads( num_threads )
+    {
+        magma_int_t nt = 1;
+#ifdef _OPENMP
+        nt = omp_get_num_threads();
+#endif
+        magma_int_t l = 0;
+        while ( l < L.num_levels ) {
+            magma_int_t rbeg = L.level_ptr[l];
+            magma_int_t rend = L.level_ptr[l+1];
+            magma_int_t work = L.row[rend] - L.row[rbeg] + rend - rbeg;
+            if ( work >= TRISOLVE_CPU_LEVEL_NNZ * nt ) {
+                #pragma omp for schedule( static )
+                for( magma_int_t r=rbeg; r < rend; r++ ){
+                    magma_ztrisolve_cpu_rows< unit >( L, r, r+1, nrhs, b, x, ld );
+                }
+                l++;
+            }
+            else {
+                magma_int_t e = l+1;
+                if ( work < TRISOLVE_CPU_TINY_LEVEL_NNZ ) {
+                    while ( e < L.num_levels
+                            && L.row[ L.level_ptr[e+1] ] - L.row[ L.level_ptr[e] ]
+                               + L.level_ptr[e+1] - L.level_ptr[e] < TRISOLVE_CPU_TINY_LEVEL_NNZ ) {
+                        e++;
+                    }
+                }
+                #pragma omp single
+                magma_ztrisolve_cpu_rows< unit >( L, rbeg, L.level_ptr[e], nrhs, b, x, ld );
+                l = e;
+            }
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Performs the analysis of a triangular solve on the CPU, the CPU path of
+    magma_ztrisolve_analysis. Builds the level sets of the rows of the
+    triangular matrix: a row is in level l if the rows it depends on are
+    in levels < l, so the rows of a level can be solved in parallel.
+    The rows, with their off-diagonal entries and inverse diagonal, are
+    stored in order of levels in solve_info->levels, for locality in
+    the solve. Entries of M in the other triangle are ignored.
+    The values of M are copied, so the analysis must be redone after
+    they change.
+
+    Arguments
+    ---------
+
+    @param[in]
+    M           magma_z_matrix
+                triangular system matrix in CSR on the CPU
+
+    @param[in,out]
+    solve_info  magma_solve_info_t*
+                analysis data; a previous CPU analysis in it is freed.
+
+    @param[in]
+    upper_triangular bool
+                true if the system matrix is upper triangular,
+                false if it is lower triangular.
+
+    @param[in]
+    unit_diagonal bool
+                true if the system matrix is assumed to have a unit diagonal,
+                false otherwise.
+
+    @param[in]
+    transpose   bool
+                true if the system matrix should be transposed for the solve.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    ********************************************************************/
+magma_int_t magma_ztrisolve_analysis_cpu(magma_z_matrix M, magma_solve_info_t *solve_info, bool upper_triangular, bool unit_diagonal, bool transpose, magma_queue_t queue)
+{
+    magma_int_t info = 0;
+
+    magma_solve_levels_t *L = &solve_info->levels;
+    magma_int_t n = M.num_rows;
+    magma_index_t *trow = NULL, *tcol = NULL, *tmap = NULL, *level = NULL;
+    const magma_index_t *erow, *ecol;
+    magmaDoubleComplex *val = NULL, *dinv = NULL;
+    // rows of op(M) depend on rows before them if op(M) is lower triangular
+    bool lower = (upper_triangular == transpose);
+
+    magma_trisolve_free( solve_info );
+    L->num_rows = n;
+
+    // op(M) in CSR; for the transpose, tmap gives the entries of M
+    if ( transpose ) {
+        CHECK( magma_index_malloc_cpu( &trow, n+1 ));
+        CHECK( magma_index_malloc_cpu( &tcol, M.nnz ));
+        CHECK( magma_index_malloc_cpu( &tmap, M.nnz ));
+        for( magma_int_t i=0; i <= n; i++ ){
+            trow[i] = 0;
+        }
+        for( magma_int_t k=0; k < M.row[n]; k++ ){
+            trow[ M.col[k]+1 ]++;
+        }
+        for( magma_int_t i=0; i < n; i++ ){
+            trow[i+1] += trow[i];
+        }
+        for( magma_int_t i=0; i < n; i++ ){
+            for( magma_int_t k=M.row[i]; k < M.row[i+1]; k++ ){
+                magma_index_t p = trow[ M.col[k] ]++;
+                tcol[p] = i;
+                tmap[p] = k;
+            }
+        }
+        for( magma_int_t i=n; i > 0; i-- ){
+            trow[i] = trow[i-1];
+        }
+        trow[0] = 0;
+        erow = trow;
+        ecol = tcol;
+    }
+    else {
+        erow = M.row;
+        ecol = M.col;
+    }
+
+    // level of each row: 1 + max level of the rows it depends on
+    CHECK( magma_index_malloc_cpu( &level, n ));
+    L->num_levels = 0;
+    for( magma_int_t t=0; t < n; t++ ){
+        magma_int_t i = (lower ? t : n-1-t);
+        magma_index_t lev = 0;
+        for( magma_int_t k=erow[i]; k < erow[i+1]; k++ ){
+            magma_index_t j = ecol[k];
+            if ( lower ? j < i : j > i ) {
+                lev = max( lev, level[j]+1 );
+            }
+        }
+        level[i] = lev;
+        L->num_levels = max( L->num_levels, (magma_int_t) lev+1 );
+    }
+
+    // rows sorted by level, by counting sort
+    CHECK( magma_index_malloc_cpu( &L->level_ptr, L->num_levels+1 ));
+    CHECK( magma_index_malloc_cpu( &L->perm, max( n, 1 )));
+    for( magma_int_t l=0; l <= L->num_levels; l++ ){
+        L->level_ptr[l] = 0;
+    }
+    for( magma_int_t i=0; i < n; i++ ){
+        L->level_ptr[ level[i]+1 ]++;
+    }
+    for( magma_int_t l=0; l < L->num_levels; l++ ){
+        L->level_ptr[l+1] += L->level_ptr[l];
+    }
+    for( magma_int_t i=0; i < n; i++ ){
+        L->perm[ L->level_ptr[ level[i] ]++ ] = i;
+    }
+    for( magma_int_t l=L->num_levels; l > 0; l-- ){
+        L->level_ptr[l] = L->level_ptr[l-1];
+    }
+    L->level_ptr[0] = 0;
+
+    // off-diagonal entries and inverse diagonal, in level order
+    CHECK( magma_index_malloc_cpu( &L->row, n+1 ));
+    #pragma omp parallel for
+    for( magma_int_t r=0; r < n; r++ ){
+        magma_index_t i = L->perm[r];
+        magma_index_t count = 0;
+        for( magma_int_t k=erow[i]; k < erow[i+1]; k++ ){
+            magma_index_t j = ecol[k];
+            count += (lower ? j < i : j > i);
+        }
+        L->row[r+1] = count;
+    }
+    L->row[0] = 0;
+    for( magma_int_t r=0; r < n; r++ ){
+        L->row[r+1] += L->row[r];
+    }
+    CHECK( magma_index_malloc_cpu( &L->col, max( L->row[n], 1 )));
+    CHECK( magma_zmalloc_cpu( &val, max( L->row[n], 1 )));
+    L->val = val;
+    if ( ! unit_diagonal ) {
+        CHECK( magma_zmalloc_cpu( &dinv, max( n, 1 )));
+        L->diag = dinv;
+    }
+    #pragma omp parallel for
+    for( magma_int_t r=0; r < n; r++ ){
+        magma_index_t i = L->perm[r];
+        magma_index_t p = L->row[r];
+        magmaDoubleComplex d = MAGMA_Z_ZERO;
+        for( magma_int_t k=erow[i]; k < erow[i+1]; k++ ){
+            magma_index_t j = ecol[k];
+            magmaDoubleComplex a = M.val[ transpose ? tmap[k] : k ];
+            if ( lower ? j < i : j > i ) {
+                L->col[p] = j;
+                val[p] = a;
+                p++;
+            }
+            else if ( j == i ) {
+                d += a;
+            }
+        }
+        if ( dinv != NULL ) {
+            dinv[r] = MAGMA_Z_ONE / d;
+        }
+    }
+
+cleanup:
+    if ( info != 0 ) {
+        magma_trisolve_free( solve_info );
+    }
+    magma_free_cpu( trow );
+    magma_free_cpu( tcol );
+    magma_free_cpu( tmap );
+    magma_free_cpu( level );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Performs a triangular solve on the CPU with the level schedule from
+    magma_ztrisolve_analysis_cpu, the CPU path of magma_ztrisolve.
+    Levels with enough work, 64 entries per thread, are solved in parallel
+    by the OpenMP threads, with a barrier between levels; smaller levels
+    are solved by a single thread, and runs of consecutive tiny levels
+    without a barrier in between. Matrices with fewer than 20000 nonzeros, or calls
+    from inside a parallel region, run single-threaded.
+    x may be the same as b.
+
+    Arguments
+    ---------
+
+    @param[in]
+    M           magma_z_matrix
+                triangular system matrix in CSR on the CPU
+
+    @param[in]
+    solve_info  magma_solve_info_t
+                analysis data produced by magma_ztrisolve_analysis_cpu.
+
+    @param[in]
+    upper_triangular bool
+                true if the system matrix is upper triangular,
+                false if it is lower triangular. Same as in the analysis.
+
+    @param[in]
+    unit_diagonal bool
+                true if the system matrix is assumed to have a unit diagonal,
+                false otherwise. Same as in the analysis.
+
+    @param[in]
+    transpose   bool
+                true if the system matrix should be transposed for the solve.
+                Same as in the analysis.
+
+    @param[in]
+    b           magma_z_matrix
+                right-hand sides on the CPU, in column-major order
+
+    @param[in,out]
+    x           magma_z_matrix
+                solution on the CPU, in column-major order
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    ********************************************************************/
+magma_int_t magma_ztrisolve_cpu(magma_z_matrix M, magma_solve_info_t solve_info, bool upper_triangular, bool unit_diagonal, bool transpose, magma_z_matrix b, magma_z_matrix x, magma_queue_t queue)
+{
+    magma_int_t info = 0;
+    const magma_solve_levels_t& L = solve_info.levels;
+
+    if ( L.row == NULL || L.num_rows != M.num_rows ) {
+        printf("error: triangular solve without analysis on the CPU.\n");
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    else if ( b.memory_location != Magma_CPU || x.memory_location != Magma_CPU ) {
+        printf("error: linear algebra objects are not located in same memory!\n");
+        info = MAGMA_ERR_INVALID_PTR;
+    }
+    else if ( L.diag == NULL ) {
+        magma_ztrisolve_cpu_levels< true >( L, b.num_cols, b.val, x.val, M.num_rows );
+    }
+    else {
+        magma_ztrisolve_cpu_levels< false >( L, b.num_cols, b.val, x.val, M.num_rows );
+    }
+    return info;
+}
@@ -733,6 +733,15 @@ magma_zprecondfree(
         magma_free( precond_par->U_dgraphindegree_bak );
         precond_par->U_dgraphindegree_bak = NULL;
     }
+    if ( precond_par->P.val != NULL ) {
+        magma_zmfree( &precond_par->P, queue );
+    }
+    if ( precond_par->PT.val != NULL ) {
+        magma_zmfree( &precond_par->PT, queue );
+    }
+    if ( precond_par->Pwork.val != NULL ) {
+        magma_zmfree( &precond_par->Pwork, queue );
+    }
 
     precond_par->solver = Magma_NONE;
     
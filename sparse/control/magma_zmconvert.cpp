@@ -9,6 +9,9 @@
        @author Hartwig Anzt
 */
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <cuda.h>  // for CUDA_VERSION
 
@@ -39,11 +42,385 @@
 #endif
 
 
+// conversions with fewer rows or entries than this run single-threaded
+#define MCONVERT_CPU_PARALLEL_SIZE 8192
+
+// upper bound on the threads used, for the block sums kept on the stack
+#define MCONVERT_CPU_MAX_THREADS 256
+
+
+/*
+    The CPU conversions are split into a structure phase and a value phase.
+    The structure phase counts the entries per row (or slice) in parallel,
+    turns the counts into offsets with a parallel prefix sum, and allocates
+    the target. In the value phase, every row is scattered independently,
+    together with its padding, so the target needs no separate zero fill.
+    magma_zmconvert_values runs the value phase alone to refresh a target
+    whose sparsity pattern is unchanged.
+*/
+
+
+// Returns number of threads to use for n rows or entries: 1 for small
+// problems or if called from inside a parallel region.
+static magma_int_t
+magma_zmconvert_num_threads( magma_int_t n )
+{
+    magma_int_t num_threads = 1;
+#ifdef _OPENMP
+    if ( n >= MCONVERT_CPU_PARALLEL_SIZE && ! omp_in_parallel() ) {
+        num_threads = min( omp_get_max_threads(), MCONVERT_CPU_MAX_THREADS );
+    }
+#endif
+    return num_threads;
+}
+
+
+// Exclusive prefix sum in place: on entry, ptr[i] is the count of row i,
+// i = 0, ..., n-1; on exit, ptr[i] is the offset of row i, and ptr[n] the
+// total. Each thread sums its block, the block sums are scanned in order,
+// then each thread scans its block starting from its offset. The blocks are
+// split over the team actually running, which may be smaller than requested.
+static void
+magma_zmconvert_scan( magma_int_t n, magma_index_t *ptr )
+{
+    magma_int_t num_threads = magma_zmconvert_num_threads( n );
+    magma_index_t block_sum[ MCONVERT_CPU_MAX_THREADS+1 ];
+
+    block_sum[0] = 0;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t t = 0, nt = 1;
+#ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+#endif
+        magma_int_t begin = magma_int_t( int64_t(t)   * n / nt );
+        magma_int_t end   = magma_int_t( int64_t(t+1) * n / nt );
+        magma_index_t sum = 0;
+        for( magma_int_t i=begin; i < end; i++ ) {
+            sum += ptr[i];
+        }
+        block_sum[t+1] = sum;
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for( magma_int_t k=0; k < nt; k++ ) {
+                block_sum[k+1] += block_sum[k];
+            }
+            ptr[n] = block_sum[nt];
+        }
+        sum = block_sum[t];
+        for( magma_int_t i=begin; i < end; i++ ) {
+            magma_index_t count = ptr[i];
+            ptr[i] = sum;
+            sum += count;
+        }
+    }
+}
+
+
+// Copies n elements of the given size from src to dst, one block per thread.
+static void
+magma_zmconvert_copy( magma_int_t n, size_t size, const void *src, void *dst )
+{
+    magma_int_t num_threads = magma_zmconvert_num_threads( n );
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t t = 0, nt = 1;
+#ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+#endif
+        magma_int_t begin = magma_int_t( int64_t(t)   * n / nt );
+        magma_int_t end   = magma_int_t( int64_t(t+1) * n / nt );
+        memcpy( (char*) dst + begin*size, (const char*) src + begin*size,
+                (end-begin)*size );
+    }
+}
+
+
+// Longest row of the CSR matrix A.
+static magma_index_t
+magma_zmconvert_maxrowlength( magma_z_matrix A )
+{
+    magma_index_t maxrowlength = 0;
+    magma_int_t num_threads = magma_zmconvert_num_threads( A.num_rows );
+
+    #pragma omp parallel for schedule(static) reduction(max:maxrowlength) num_threads(num_threads)
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        if ( A.row[i+1]-A.row[i] > maxrowlength )
+            maxrowlength = A.row[i+1]-A.row[i];
+    }
+    return maxrowlength;
+}
+
+
+// Fills the row index of every entry of the CSR matrix A (COO, CSRCOO).
+static void
+magma_zmconvert_rowidx( magma_z_matrix A, magma_index_t *rowidx )
+{
+    magma_int_t num_threads = magma_zmconvert_num_threads( A.nnz );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            rowidx[j] = i;
+        }
+    }
+}
+
+
+// Storage of row i in the ELL-type matrix E (ELLPACKT, ELL, ELLD, ELLRT,
+// SELLP): its slots are start, start+stride, ..., start+(slots-1)*stride.
+// rowlength is the padded row length, unused for SELLP.
+static inline void
+magma_zmconvert_ell_row(
+    magma_z_matrix *E, magma_storage_t format, magma_int_t rowlength,
+    magma_int_t i,
+    magma_int_t *start, magma_int_t *stride, magma_int_t *slots )
+{
+    if ( format == Magma_ELL ) {
+        *start  = i;
+        *stride = E->num_rows;
+        *slots  = rowlength;
+    } else if ( format == Magma_SELLP ) {
+        magma_int_t C = E->blocksize;
+        *start  = E->row[i/C] + i%C;
+        *stride = C;
+        *slots  = (E->row[i/C+1] - E->row[i/C]) / C;
+    } else {
+        *start  = i*rowlength;
+        *stride = 1;
+        *slots  = rowlength;
+    }
+}
+
+
+// Value phase of CSR to ELLPACKT, ELL, ELLD, ELLRT, and SELLP: scatters the
+// rows of A into B, whose structure is set up. Unless values_only, the
+// column indices and the padding are written as well; for SELLP, this
+// includes the padding rows of the last slice.
+static void
+magma_zmconvert_csr2ell(
+    magma_z_matrix A, magma_z_matrix *B, magma_storage_t format,
+    magma_int_t rowlength, magma_int_t values_only )
+{
+    magmaDoubleComplex zero = MAGMA_Z_MAKE( 0.0, 0.0 );
+    magma_index_t padcol = ( format == Magma_ELLPACKT || format == Magma_ELLD ) ? -1 : 0;
+    magma_int_t rows = A.num_rows;
+    if ( format == Magma_SELLP && ! values_only ) {
+        rows = B->numblocks * B->blocksize;
+    }
+    magma_int_t num_threads = magma_zmconvert_num_threads( A.nnz );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < rows; i++ ) {
+        magma_int_t start, stride, slots, offset = 0;
+        magma_int_t begin = 0, end = 0;
+        if ( i < A.num_rows ) {
+            begin = A.row[i];
+            end   = A.row[i+1];
+        }
+        magma_zmconvert_ell_row( B, format, rowlength, i, &start, &stride, &slots );
+
+        if ( format == Magma_ELLD ) {
+            // diagonal element first, in slot 0, padding if missing
+            magma_int_t diag = 0;
+            offset = 1;
+            for( magma_int_t j=begin; j < end; j++ ) {
+                if ( A.col[j] == i ) {
+                    B->val[start] = A.val[j];
+                    if ( ! values_only )
+                        B->col[start] = A.col[j];
+                    diag = 1;
+                } else {
+                    B->val[start+offset*stride] = A.val[j];
+                    if ( ! values_only )
+                        B->col[start+offset*stride] = A.col[j];
+                    offset++;
+                }
+            }
+            if ( ! diag && ! values_only ) {
+                B->val[start] = zero;
+                B->col[start] = padcol;
+            }
+        } else {
+            for( magma_int_t j=begin; j < end; j++ ) {
+                B->val[start+offset*stride] = A.val[j];
+                if ( ! values_only )
+                    B->col[start+offset*stride] = A.col[j];
+                offset++;
+            }
+        }
+        if ( ! values_only ) {
+            for( ; offset < slots; offset++ ) {
+                B->val[start+offset*stride] = zero;
+                B->col[start+offset*stride] = padcol;
+            }
+            if ( format == Magma_ELLRT ) {
+                B->row[i] = end - begin;
+            }
+        }
+    }
+}
+
+
+// Value phase of CSR to CSRD: scatters the rows of A into B, diagonal
+// element first.
+static void
+magma_zmconvert_csr2csrd( magma_z_matrix A, magma_z_matrix *B, magma_int_t values_only )
+{
+    magma_int_t num_threads = magma_zmconvert_num_threads( A.nnz );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        magma_int_t count = 1;
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            magma_int_t k = A.row[i];
+            if ( A.col[j] != i ) {
+                k += count;
+                count++;
+            }
+            B->val[k] = A.val[j];
+            if ( ! values_only )
+                B->col[k] = A.col[j];
+        }
+    }
+}
+
+
+// Value phase of CSR to DENSE (row-major). Unless values_only, the rows are
+// zeroed first.
+static void
+magma_zmconvert_csr2dense( magma_z_matrix A, magma_z_matrix *B, magma_int_t values_only )
+{
+    magmaDoubleComplex zero = MAGMA_Z_MAKE( 0.0, 0.0 );
+    magma_int_t num_threads = magma_zmconvert_num_threads( A.num_rows*A.num_cols );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        magmaDoubleComplex *Bi = B->val + i*A.num_cols;
+        if ( ! values_only ) {
+            for( magma_int_t j=0; j < A.num_cols; j++ )
+                Bi[j] = zero;
+        }
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ )
+            Bi[ A.col[j] ] = A.val[j];
+    }
+}
+
+
+// Transposes the tiles between CSR order (src) and CSR5 order (dst), or
+// back if to_csr; tile_ptr, csr5_p, and csr5_sigma are taken from the
+// CSR5 matrix C. Fast-track tiles and the last tile are copied. col is
+// not written if NULL.
+static void
+magma_zmconvert_csr5_tiles(
+    magma_z_matrix C, magma_int_t to_csr,
+    const magmaDoubleComplex *src_val, const magma_index_t *src_col,
+    magmaDoubleComplex *dst_val, magma_index_t *dst_col )
+{
+    magma_int_t tile = MAGMA_CSR5_OMEGA * C.csr5_sigma;
+    magma_int_t num_threads = magma_zmconvert_num_threads( C.nnz );
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t par_id = 0; par_id < C.csr5_p; par_id++ ) {
+        magma_int_t first = par_id * tile;
+        // the last tile and fast-track tiles are not transposed
+        if ( par_id == C.csr5_p-1 || C.tile_ptr[par_id] == C.tile_ptr[par_id + 1] ) {
+            magma_int_t last = ( par_id == C.csr5_p-1 ) ? C.nnz : first + tile;
+            for( magma_int_t idx = first; idx < last; idx++ ) {
+                dst_val[idx] = src_val[idx];
+                if ( dst_col != NULL )
+                    dst_col[idx] = src_col[idx];
+            }
+            continue;
+        }
+        for( magma_int_t idx = 0; idx < tile; idx++ ) {
+            // entry idx in CSR order is (idx % sigma, idx / sigma) in the tile
+            magma_int_t csr_idx  = first + idx;
+            magma_int_t csr5_idx = first + (idx % C.csr5_sigma) * MAGMA_CSR5_OMEGA
+                                         + idx / C.csr5_sigma;
+            magma_int_t s = to_csr ? csr5_idx : csr_idx;
+            magma_int_t d = to_csr ? csr_idx : csr5_idx;
+            dst_val[d] = src_val[s];
+            if ( dst_col != NULL )
+                dst_col[d] = src_col[s];
+        }
+    }
+}
+
+
+// ELLPACKT, ELL, ELLD, ELLRT, or SELLP to CSR: counts the nonzeros of every
+// row, computes the row pointer by a prefix sum, and gathers the rows;
+// explicit zeros are dropped, as by magma_z_csr_compressor. For ELLD, the
+// diagonal element is moved back to its place within the row.
+static magma_int_t
+magma_zmconvert_ell2csr(
+    magma_z_matrix A, magma_z_matrix *B, magma_storage_t format,
+    magma_int_t rowlength )
+{
+    magma_int_t info = 0;
+    magmaDoubleComplex zero = MAGMA_Z_MAKE( 0.0, 0.0 );
+    magma_int_t num_threads = magma_zmconvert_num_threads( A.num_rows*rowlength );
+
+    CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        magma_int_t start, stride, slots, count = 0;
+        magma_zmconvert_ell_row( &A, format, rowlength, i, &start, &stride, &slots );
+        for( magma_int_t k=0; k < slots; k++ ) {
+            if ( A.val[start+k*stride] != zero )
+                count++;
+        }
+        B->row[i] = count;
+    }
+    magma_zmconvert_scan( A.num_rows, B->row );
+    B->nnz = B->row[A.num_rows];
+
+    CHECK( magma_zmalloc_cpu( &B->val, B->nnz ));
+    CHECK( magma_index_malloc_cpu( &B->col, B->nnz ));
+
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        magma_int_t start, stride, slots, smaller = -1;
+        magma_int_t nz = B->row[i];
+        magma_zmconvert_ell_row( &A, format, rowlength, i, &start, &stride, &slots );
+        if ( format == Magma_ELLD ) {
+            // number of entries preceding the diagonal element in CSR order
+            magma_index_t diagcol = A.col[start];
+            smaller = 0;
+            for( magma_int_t k=1; k < slots; k++ ) {
+                if ( (A.col[start+k] < diagcol) && (A.val[start+k] != zero) )
+                    smaller++;
+            }
+        }
+        for( magma_int_t k=0; k < slots; k++ ) {
+            magma_int_t s = k;
+            if ( smaller >= 0 )
+                s = ( k < smaller ) ? k+1 : ( k == smaller ? 0 : k );
+            if ( A.val[start+s*stride] != zero ) {
+                B->val[nz] = A.val[start+s*stride];
+                B->col[nz] = A.col[start+s*stride];
+                nz++;
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
 /**
     Purpose
     -------
 
     Helper function to compress CSR containing zero-entries.
+    The nonzeros of each row are counted in parallel, the new row pointer
+    is the prefix sum of the counts, and the rows are compressed in parallel.
 
 
     Arguments
@@ -96,29 +473,28 @@ magma_z_csr_compressor(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_int_t num_threads = magma_zmconvert_num_threads( (*row)[*n] );
 
-    magma_index_t i,j, nnz_new=0, (*row_nnz)=NULL, nnz_this_row;
-    CHECK( magma_index_malloc_cpu( &(row_nnz), (*n) ));
     CHECK( magma_index_malloc_cpu( rown, *n+1 ));
-    for( i=0; i<*n; i++ ) {
-        (*rown)[i] = nnz_new;
-        nnz_this_row = 0;
-        for( j=(*row)[i]; j<(*row)[i+1]; j++ ) {
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i<*n; i++ ) {
+        magma_index_t nnz_this_row = 0;
+        for( magma_int_t j=(*row)[i]; j<(*row)[i+1]; j++ ) {
             if ( (MAGMA_Z_REAL((*val)[j]) != 0) || (MAGMA_Z_IMAG((*val)[j]) != 0) ) {
-                nnz_new++;
                 nnz_this_row++;
             }
         }
-        row_nnz[i] = nnz_this_row;
+        (*rown)[i] = nnz_this_row;
     }
-    (*rown)[*n] = nnz_new;
+    magma_zmconvert_scan( *n, *rown );
 
-    CHECK( magma_zmalloc_cpu( valn, nnz_new ));
-    CHECK( magma_index_malloc_cpu( coln, nnz_new ));
+    CHECK( magma_zmalloc_cpu( valn, (*rown)[*n] ));
+    CHECK( magma_index_malloc_cpu( coln, (*rown)[*n] ));
 
-    nnz_new = 0;
-    for( i=0; i<*n; i++ ) {
-        for( j=(*row)[i]; j<(*row)[i+1]; j++ ) {
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for( magma_int_t i=0; i<*n; i++ ) {
+        magma_index_t nnz_new = (*rown)[i];
+        for( magma_int_t j=(*row)[i]; j<(*row)[i+1]; j++ ) {
             if ( (MAGMA_Z_REAL((*val)[j]) != 0) || (MAGMA_Z_IMAG((*val)[j]) != 0) ) {
                 (*valn)[nnz_new]= (*val)[j];
                 (*coln)[nnz_new]= (*col)[j];
@@ -130,12 +506,13 @@ magma_z_csr_compressor(
 
 cleanup:
     if ( info != 0 ) {
-        magma_free_cpu( valn );
-        magma_free_cpu( coln );
-        magma_free_cpu( rown );
+        magma_free_cpu( *valn );
+        magma_free_cpu( *coln );
+        magma_free_cpu( *rown );
+        *valn = NULL;
+        *coln = NULL;
+        *rown = NULL;
     }
-    magma_free_cpu( row_nnz );
-    row_nnz = NULL;
     return info;
 }
 
@@ -224,8 +601,6 @@ magma_zmconvert(
     B->calibrator = NULL;
     B->dcalibrator = NULL;
 
-    magmaDoubleComplex zero = MAGMA_Z_MAKE( 0.0, 0.0 );
-
     // check whether matrix on CPU
     if ( A.memory_location == Magma_CPU )
     {
@@ -248,13 +623,9 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
 
-                for( magma_int_t i=0; i < A.nnz; i++) {
-                    B->val[i] = A.val[i];
-                    B->col[i] = A.col[i];
-                }
-                for( magma_int_t i=0; i < A.num_rows+1; i++) {
-                    B->row[i] = A.row[i];
-                }
+                magma_zmconvert_copy( A.nnz, sizeof(magmaDoubleComplex), A.val, B->val );
+                magma_zmconvert_copy( A.nnz, sizeof(magma_index_t), A.col, B->col );
+                magma_zmconvert_copy( A.num_rows+1, sizeof(magma_index_t), A.row, B->row );
             }
             // CSR to CUCSR
             else if ( new_format == Magma_CUCSR ){
@@ -273,22 +644,26 @@ magma_zmconvert(
                 B->true_nnz = A.true_nnz;
                 B->diameter = A.diameter;
 
-                magma_int_t numzeros=0;
+                magma_int_t num_threads = magma_zmconvert_num_threads( A.nnz );
+                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
+                #pragma omp parallel for schedule(static) num_threads(num_threads)
                 for( magma_int_t i=0; i < A.num_rows; i++) {
+                    magma_index_t numzeros = 0;
                     for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++) {
                         if ( A.col[j] <= i) {
                             numzeros++;
                         }
                     }
+                    B->row[i] = numzeros;
                 }
-                B->nnz = numzeros;
-                CHECK( magma_zmalloc_cpu( &B->val, numzeros ));
-                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
-                CHECK( magma_index_malloc_cpu( &B->col, numzeros ));
+                magma_zmconvert_scan( A.num_rows, B->row );
+                B->nnz = B->row[A.num_rows];
+                CHECK( magma_zmalloc_cpu( &B->val, B->nnz ));
+                CHECK( magma_index_malloc_cpu( &B->col, B->nnz ));
 
-                numzeros=0;
+                #pragma omp parallel for schedule(static) num_threads(num_threads)
                 for( magma_int_t i=0; i < A.num_rows; i++) {
-                    B->row[i]=numzeros;
+                    magma_index_t numzeros = B->row[i];
                     for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++) {
                         if ( A.col[j] < i) {
                             B->val[numzeros] = A.val[j];
@@ -308,7 +683,6 @@ magma_zmconvert(
                         }
                     }
                 }
-                B->row[B->num_rows] = numzeros;
             }
 
             // CSR to CSRU
@@ -321,22 +695,26 @@ magma_zmconvert(
                 B->num_cols = A.num_cols;
                 B->diameter = A.diameter;
                 B->fill_mode = MagmaUpper;
-                magma_int_t numzeros=0;
+                magma_int_t num_threads = magma_zmconvert_num_threads( A.nnz );
+                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
+                #pragma omp parallel for schedule(static) num_threads(num_threads)
                 for( magma_int_t i=0; i < A.num_rows; i++) {
+                    magma_index_t numzeros = 0;
                     for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++) {
                         if ( A.col[j] >= i) {
                             numzeros++;
                         }
                     }
+                    B->row[i] = numzeros;
                 }
-                B->nnz = numzeros;
-                CHECK( magma_zmalloc_cpu( &B->val, numzeros ));
-                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
-                CHECK( magma_index_malloc_cpu( &B->col, numzeros ));
+                magma_zmconvert_scan( A.num_rows, B->row );
+                B->nnz = B->row[A.num_rows];
+                CHECK( magma_zmalloc_cpu( &B->val, B->nnz ));
+                CHECK( magma_index_malloc_cpu( &B->col, B->nnz ));
 
-                numzeros=0;
+                #pragma omp parallel for schedule(static) num_threads(num_threads)
                 for( magma_int_t i=0; i < A.num_rows; i++) {
-                    B->row[i]=numzeros;
+                    magma_index_t numzeros = B->row[i];
                     for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++) {
                         if ( A.col[j] >= i) {
                             B->val[numzeros] = A.val[j];
@@ -345,7 +723,6 @@ magma_zmconvert(
                         }
                     }
                 }
-                B->row[B->num_rows] = numzeros;
             }
 
             // CSR to CSRD (diagonal elements first)
@@ -364,22 +741,8 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
 
-                for(magma_int_t i=0; i < A.num_rows; i++) {
-                    magma_int_t count = 1;
-                    for(magma_int_t j=A.row[i]; j < A.row[i+1]; j++) {
-                        if ( A.col[j] == i ) {
-                            B->col[A.row[i]] = A.col[j];
-                            B->val[A.row[i]] = A.val[j];
-                        } else {
-                            B->col[A.row[i]+count] = A.col[j];
-                            B->val[A.row[i]+count] = A.val[j];
-                            count++;
-                        }
-                    }
-                }
-                for( magma_int_t i=0; i < A.num_rows+1; i++) {
-                    B->row[i] = A.row[i];
-                }
+                magma_zmconvert_csr2csrd( A, B, 0 );
+                magma_zmconvert_copy( A.num_rows+1, sizeof(magma_index_t), A.row, B->row );
             }
 
             // CSR to COO
@@ -390,11 +753,7 @@ magma_zmconvert(
                 magma_free_cpu( B->row );
                 CHECK( magma_index_malloc_cpu( &B->row, A.nnz ));
 
-                for(magma_int_t i=0; i < A.num_rows; i++) {
-                    for(magma_int_t j=A.row[i]; j < A.row[i+1]; j++) {
-                        B->row[j] = i;
-                    }
-                }
+                magma_zmconvert_rowidx( A, B->row );
             }
 
             // CSR to CSRCOO
@@ -404,11 +763,7 @@ magma_zmconvert(
 
                 CHECK( magma_index_malloc_cpu( &B->rowidx, A.nnz ));
 
-                for(magma_int_t i=0; i < A.num_rows; i++) {
-                    for(magma_int_t j=A.row[i]; j < A.row[i+1]; j++) {
-                        B->rowidx[j] = i;
-                    }
-                }
+                magma_zmconvert_rowidx( A, B->rowidx );
             }
 
             // CSR to CSRLIST
@@ -455,32 +810,14 @@ magma_zmconvert(
                 B->max_nnz_row = A.max_nnz_row;
                 B->diameter = A.diameter;
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
-                CHECK( magma_index_malloc_cpu( &length, A.num_rows));
-
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
-                }
+                magma_index_t maxrowlength = magma_zmconvert_maxrowlength( A );
                 //printf( "Conversion to ELLPACK with %d elements per row: ",
                                                                 // maxrowlength );
                 //fflush(stdout);
                 CHECK( magma_zmalloc_cpu( &B->val, maxrowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->col, maxrowlength*A.num_rows ));
 
-                for( i=0; i < (maxrowlength*A.num_rows); i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] =  -1;
-                }
-                for( i=0; i < A.num_rows; i++ ) {
-                    magma_int_t offset = 0;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
-                        B->val[i*maxrowlength+offset] = A.val[j];
-                        B->col[i*maxrowlength+offset] = A.col[j];
-                        offset++;
-                    }
-                }
+                magma_zmconvert_csr2ell( A, B, Magma_ELLPACKT, maxrowlength, 0 );
                 B->max_nnz_row = maxrowlength;
             }
 
@@ -497,33 +834,14 @@ magma_zmconvert(
                 B->diameter = A.diameter;
 
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
-                CHECK( magma_index_malloc_cpu( &length, A.num_rows));
-
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
-                }
+                magma_index_t maxrowlength = magma_zmconvert_maxrowlength( A );
                 //printf( "Conversion to ELL with %d elements per row: ",
                                                                // maxrowlength );
                 //fflush(stdout);
                 CHECK( magma_zmalloc_cpu( &B->val, maxrowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->col, maxrowlength*A.num_rows ));
 
-                for( i=0; i < (maxrowlength*A.num_rows); i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] = 0;
-                }
-
-                for( i=0; i < A.num_rows; i++ ) {
-                    magma_int_t offset = 0;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
-                        B->val[offset*A.num_rows+i] = A.val[j];
-                        B->col[offset*A.num_rows+i] = A.col[j];
-                        offset++;
-                    }
-                }
+                magma_zmconvert_csr2ell( A, B, Magma_ELL, maxrowlength, 0 );
                 B->max_nnz_row = maxrowlength;
                 //printf( "done\n" );
             }
@@ -541,39 +859,14 @@ magma_zmconvert(
                 B->diameter = A.diameter;
 
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
-                CHECK( magma_index_malloc_cpu( &length, A.num_rows));
-
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
-                }
+                magma_index_t maxrowlength = magma_zmconvert_maxrowlength( A );
                 //printf( "Conversion to ELL with %d elements per row: ",
                                                                // maxrowlength );
                 //fflush(stdout);
                 CHECK( magma_zmalloc_cpu( &B->val, maxrowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->col, maxrowlength*A.num_rows ));
 
-
-                for( i=0; i < (maxrowlength*A.num_rows); i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] =  -1;
-                }
-
-                for( i=0; i < A.num_rows; i++ ) {
-                    magma_int_t offset = 1;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
-                        if ( A.col[j] == i ) { // diagonal case
-                            B->val[i*maxrowlength] = A.val[j];
-                            B->col[i*maxrowlength] = A.col[j];
-                        } else {
-                            B->val[i*maxrowlength+offset] = A.val[j];
-                            B->col[i*maxrowlength+offset] = A.col[j];
-                            offset++;
-                        }
-                    }
-                }
+                magma_zmconvert_csr2ell( A, B, Magma_ELLD, maxrowlength, 0 );
                 B->max_nnz_row = maxrowlength;
             }
 
@@ -590,14 +883,7 @@ magma_zmconvert(
                 B->diameter = A.diameter;
 
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
-                CHECK( magma_index_malloc_cpu( &length, A.num_rows));
-
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
-                }
+                magma_index_t maxrowlength = magma_zmconvert_maxrowlength( A );
 
                 //printf( "Conversion to ELLRT with %d elements per row: ",
                 //                                                   maxrowlength );
@@ -609,20 +895,8 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->col, rowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows ));
 
-                for( i=0; i < rowlength*A.num_rows; i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] =  0;
-                }
-
-                for( i=0; i < A.num_rows; i++ ) {
-                    magma_int_t offset = 0;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
-                        B->val[i*rowlength+offset] = A.val[j];
-                        B->col[i*rowlength+offset] = A.col[j];
-                        offset++;
-                    }
-                    B->row[i] = A.row[i+1] - A.row[i];
-                }
+                // also sets the row lengths in B->row
+                magma_zmconvert_csr2ell( A, B, Magma_ELLRT, rowlength, 0 );
                 B->max_nnz_row = maxrowlength;
                 //printf( "done\n" );
             }
@@ -655,32 +929,29 @@ magma_zmconvert(
                 magma_int_t C = B->blocksize;
                 magma_int_t slices = ( A.num_rows+C-1)/(C);
                 B->numblocks = slices;
-                magma_int_t alignedlength, alignment = B->alignment;
+                magma_int_t alignment = B->alignment;
+                magma_index_t maxalignedlength = 0;
+                magma_int_t num_threads = magma_zmconvert_num_threads( A.num_rows );
                 // conversion
-                magma_index_t i, j, k, maxrowlength=0;
-                CHECK( magma_index_malloc_cpu( &length, C));
                 // B-row points to the start of each slice
                 CHECK( magma_index_malloc_cpu( &B->row, slices+1 ));
 
-
-                B->row[0] = 0;
-                for( i=0; i < slices; i++ ) {
-                    maxrowlength = 0;
-                    for(j=0; j < C; j++) {
-                        if (i*C+j < A.num_rows) {
-                            length[j] = A.row[i*C+j+1]-A.row[i*C+j];
-                        }
-                        else
-                            length[j]=0;
-                        if (length[j] > maxrowlength) {
-                            maxrowlength = length[j];
+                // slice sizes, turned into slice pointers by the prefix sum
+                #pragma omp parallel for schedule(static) reduction(max:maxalignedlength) num_threads(num_threads)
+                for( magma_int_t i=0; i < slices; i++ ) {
+                    magma_index_t maxrowlength = 0;
+                    for( magma_int_t line=i*C; line < min( (i+1)*C, A.num_rows ); line++ ) {
+                        if ( A.row[line+1]-A.row[line] > maxrowlength ) {
+                            maxrowlength = A.row[line+1]-A.row[line];
                         }
                     }
-                    alignedlength = magma_roundup( maxrowlength, alignment );
-                    B->row[i+1] = B->row[i] + alignedlength * C;
-                    if ( alignedlength > B->max_nnz_row )
-                        B->max_nnz_row = alignedlength;
+                    magma_index_t alignedlength = magma_roundup( maxrowlength, alignment );
+                    B->row[i] = alignedlength * C;
+                    if ( alignedlength > maxalignedlength )
+                        maxalignedlength = alignedlength;
                 }
+                magma_zmconvert_scan( slices, B->row );
+                B->max_nnz_row = maxalignedlength;
                 B->nnz = B->row[slices];
                 //printf( "Conversion to SELLC with %d slices of size %d and"
                 //       " %d nonzeros.\n", slices, C, B->nnz );
@@ -689,25 +960,8 @@ magma_zmconvert(
                 CHECK( magma_zmalloc_cpu( &B->val, B->row[slices] ));
                 CHECK( magma_index_malloc_cpu( &B->col, B->row[slices] ));
 
-                // zero everything
-                for( i=0; i < B->row[slices]; i++ ) {
-                    B->val[ i ] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[ i ] =  0;
-                }
-                // fill in values
-                for( i=0; i < slices; i++ ) {
-                    for(j=0; j < C; j++) {
-                        magma_int_t line = i*C+j;
-                        magma_int_t offset = 0;
-                        if ( line < A.num_rows) {
-                            for( k=A.row[line]; k < A.row[line+1]; k++ ) {
-                                B->val[ B->row[i] + j +offset*C ] = A.val[k];
-                                B->col[ B->row[i] + j +offset*C ] = A.col[k];
-                                offset++;
-                            }
-                        }
-                    }
-                }
+                // fill in values and padding
+                magma_zmconvert_csr2ell( A, B, Magma_SELLP, 0, 0 );
                 //B->nnz = A.nnz;
             }
 
@@ -727,14 +981,7 @@ magma_zmconvert(
                 // conversion
                 CHECK( magma_zmalloc_cpu( &B->val, A.num_rows*A.num_cols ));
 
-                for( magma_int_t i=0; i<(A.num_rows)*(A.num_cols); i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                }
-
-                for(magma_int_t i=0; i < A.num_rows; i++ ) {
-                    for(magma_int_t j=A.row[i]; j < A.row[i+1]; j++ )
-                        B->val[i * (A.num_cols) + A.col[j] ] = A.val[ j ];
-                }
+                magma_zmconvert_csr2dense( A, B, 0 );
 
                 //printf( "done\n" );
             }
@@ -764,9 +1011,7 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
 
-                for( magma_int_t i=0; i < A.num_rows+1; i++) {
-                    B->row[i] = A.row[i];
-                }
+                magma_zmconvert_copy( A.num_rows+1, sizeof(magma_index_t), A.row, B->row );
 
                 // compute sigma
                 int r = 4;
@@ -812,35 +1057,40 @@ magma_zmconvert(
                 B->csr5_p = ceil((double)B->nnz
                                  / (double)(MAGMA_CSR5_OMEGA * B->csr5_sigma));
                 //printf("sigma = %i, p = %i\n", B->csr5_sigma, B->csr5_p);
-                // malloc the newly added arrays for CSR5
-                CHECK( magma_uindex_malloc_cpu( &B->tile_ptr, B->csr5_p+1 ));
-                for( magma_int_t i=0; i<B->csr5_p+1; i++) {
-                    B->tile_ptr[i] = 0;
-                }
-
-                CHECK( magma_uindex_malloc_cpu( &B->tile_desc,
-                          B->csr5_p * MAGMA_CSR5_OMEGA * B->csr5_num_packets ));
-                for( magma_int_t i=0; i<B->csr5_p * MAGMA_CSR5_OMEGA
-                                        * B->csr5_num_packets; i++) {
-                    B->tile_desc[i] = 0;
-                }
 
+                // the tiles are independent, so all steps run in parallel
+                // over the tiles
+                int num_thread = magma_zmconvert_num_threads( B->nnz );
+                magma_int_t num_desc = B->csr5_p * MAGMA_CSR5_OMEGA
+                                       * B->csr5_num_packets;
 
+                // malloc the newly added arrays for CSR5
+                CHECK( magma_uindex_malloc_cpu( &B->tile_ptr, B->csr5_p+1 ));
+                CHECK( magma_uindex_malloc_cpu( &B->tile_desc, num_desc ));
                 CHECK( magma_zmalloc_cpu( &B->calibrator, B->csr5_p ));
-                for( magma_int_t i=0; i<B->csr5_p; i++) {
-                    B->calibrator[i] = MAGMA_Z_MAKE(0., 0.);
-                }
-
                 CHECK( magma_index_malloc_cpu( &B->tile_desc_offset_ptr,
                                                B->csr5_p+1 ));
+                // dirty flags of the tiles
+                CHECK( magma_index_malloc_cpu( &length, B->csr5_p ));
+
+                #pragma omp parallel for schedule(static) num_threads(num_thread)
+                for( magma_int_t i=0; i<num_desc; i++) {
+                    B->tile_desc[i] = 0;
+                }
+                #pragma omp parallel for schedule(static) num_threads(num_thread)
                 for( magma_int_t i=0; i<B->csr5_p+1; i++) {
+                    B->tile_ptr[i] = 0;
                     B->tile_desc_offset_ptr[i] = 0;
+                    if ( i < B->csr5_p ) {
+                        B->calibrator[i] = MAGMA_Z_MAKE(0., 0.);
+                    }
                 }
 
 
                 // convert csr data to csr5 data (3 steps)
                 // step 1 generate tile pointer
                 // step 1.1 binary search row pointer
+                #pragma omp parallel for schedule(static) num_threads(num_thread)
                 for (magma_index_t global_id = 0; global_id <= B->csr5_p;
                      global_id++)
                 {
@@ -866,29 +1116,30 @@ magma_zmconvert(
                     B->tile_ptr[global_id] = start-1;
                 }
                 
-                // step 1.2 check empty rows
+                // step 1.2 check empty rows; the flags are set in a second
+                // pass, as each tile reads the pointer of the next one
+                #pragma omp parallel for schedule(static) num_threads(num_thread)
                 for (magma_index_t group_id = 0; group_id < B->csr5_p; group_id++) {
                     int dirty = 0;
                 
                     magma_uindex_t start = B->tile_ptr[group_id];
                     magma_uindex_t stop  = B->tile_ptr[group_id+1];
-                    start = (start << 1) >> 1;
-                    stop  = (stop << 1) >> 1;
                 
-                    if (start == stop)
-                        continue;
-                
-                    for (magma_uindex_t row_idx = start; row_idx <= stop; row_idx++) {
-                        if (B->row[row_idx] == B->row[row_idx+1]) {
-                            dirty = 1;
-                            break;
+                    if (start != stop) {
+                        for (magma_uindex_t row_idx = start; row_idx <= stop; row_idx++) {
+                            if (B->row[row_idx] == B->row[row_idx+1]) {
+                                dirty = 1;
+                                break;
+                            }
                         }
                     }
-                
-                    if (dirty) {
-                        start |= sizeof(magma_uindex_t) == 4
+                    length[group_id] = dirty;
+                }
+                #pragma omp parallel for schedule(static) num_threads(num_thread)
+                for (magma_index_t group_id = 0; group_id < B->csr5_p; group_id++) {
+                    if (length[group_id]) {
+                        B->tile_ptr[group_id] |= sizeof(magma_uindex_t) == 4
                                            ? 0x80000000 : 0x8000000000000000;
-                        B->tile_ptr[group_id] = start;
                     }
                 }
                 B->csr5_tail_tile_start = (B->tile_ptr[B->csr5_p-1] << 1) >> 1;
@@ -899,6 +1150,8 @@ magma_zmconvert(
                                      + B->csr5_bit_scansum_offset;
                 
                 //generate_tile_descriptor_s1_kernel
+                // tile par_id only sets bits of its own descriptor
+                #pragma omp parallel for schedule(static) num_threads(num_thread)
                 for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
                     const magma_index_t row_start = B->tile_ptr[par_id]
                                                     & 0x7FFFFFFF;
@@ -927,7 +1180,6 @@ magma_zmconvert(
                 }
                 
                 //generate_tile_descriptor_s2_kernel
-                int num_thread = 1; //omp_get_max_threads();
                 magma_index_t *s_segn_scan_all, *s_present_all;
                 
                 CHECK( magma_index_malloc_cpu( &s_segn_scan_all,
@@ -935,20 +1187,18 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &s_present_all,
                                            2 * MAGMA_CSR5_OMEGA * num_thread ));
                 
-                
-                //int *s_segn_scan_all = (int *)malloc(2 * MAGMA_CSR5_OMEGA
-                //                                   * sizeof(int) * num_thread);
-                //int *s_present_all   = (int *)malloc(2 * MAGMA_CSR5_OMEGA
-                //                                   * sizeof(int) * num_thread);
                 for (magma_index_t i = 0; i < num_thread; i++)
                     s_present_all[i * 2 * MAGMA_CSR5_OMEGA + MAGMA_CSR5_OMEGA]
                         = 1;
                 
                 //const int bit_all_offset = bit_y_offset + bit_scansum_offset;
                 
-                //#pragma omp parallel for
+                #pragma omp parallel for schedule(static) num_threads(num_thread)
                 for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
-                    int tid = 0; //omp_get_thread_num();
+                    int tid = 0;
+#ifdef _OPENMP
+                    tid = omp_get_thread_num();
+#endif
                     int *s_segn_scan = &s_segn_scan_all[tid * 2
                                                         * MAGMA_CSR5_OMEGA];
                     int *s_present = &s_present_all[tid * 2
@@ -1022,6 +1272,7 @@ magma_zmconvert(
                     if (with_empty_rows) {
                         B->tile_desc_offset_ptr[par_id]
                             = s_segn_scan[MAGMA_CSR5_OMEGA];
+                        #pragma omp atomic write
                         B->tile_desc_offset_ptr[B->csr5_p] = 1;
                     }
                 
@@ -1056,17 +1307,8 @@ magma_zmconvert(
                 magma_free_cpu(s_present_all);
                 
                 if (B->tile_desc_offset_ptr[B->csr5_p]) {
-                    //scan_single(B->tile_desc_offset_ptr, p+1);
-                    int old_val, new_val;
-                    old_val = B->tile_desc_offset_ptr[0];
-                    B->tile_desc_offset_ptr[0] = 0;
-                    for (int i = 1; i < B->csr5_p+1; i++)
-                    {
-                        new_val = B->tile_desc_offset_ptr[i];
-                        B->tile_desc_offset_ptr[i] = old_val
-                                                + B->tile_desc_offset_ptr[i-1];
-                        old_val = new_val;
-                    }
+                    B->tile_desc_offset_ptr[B->csr5_p] = 0;
+                    magma_zmconvert_scan( B->csr5_p, B->tile_desc_offset_ptr );
                 }
                 
                 B->csr5_num_offsets = B->tile_desc_offset_ptr[B->csr5_p];
@@ -1074,11 +1316,16 @@ magma_zmconvert(
                 if (B->csr5_num_offsets) {
                     CHECK( magma_index_malloc_cpu( &B->tile_desc_offset
                                                    , B->csr5_num_offsets ));
+                    // not every offset is set below
+                    #pragma omp parallel for schedule(static) num_threads(num_thread)
+                    for( magma_int_t i=0; i<B->csr5_num_offsets; i++) {
+                        B->tile_desc_offset[i] = 0;
+                    }
                 
                     //err = generate_tile_descriptor_offset
                     const int bit_bitflag = 32 - bit_all_offset;
                 
-                    //#pragma omp parallel for
+                    #pragma omp parallel for schedule(static) num_threads(num_thread)
                     for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
                         bool with_empty_rows = (B->tile_ptr[par_id] >> 31)&0x1;
                         if (!with_empty_rows)
@@ -1176,40 +1423,7 @@ magma_zmconvert(
                 }
                 
                 // step 3. transpose column_index and value arrays
-                //#pragma omp parallel for
-                for (int par_id = 0; par_id < B->csr5_p; par_id++) {
-                    // if this is fast track tile, do not transpose it
-                    if (B->tile_ptr[par_id] == B->tile_ptr[par_id + 1]) {
-                        for (int idx = 0; idx < MAGMA_CSR5_OMEGA * B->csr5_sigma; idx++) {
-                            int src_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * B->csr5_sigma + idx;
-                            B->col[src_idx] = A.col[src_idx];
-                            B->val[src_idx] = A.val[src_idx];
-                        }
-                        continue;
-                    }
-                    //#pragma simd
-                    if (par_id < B->csr5_p-1) {
-                        for (int idx = 0; idx < MAGMA_CSR5_OMEGA * B->csr5_sigma; idx++) {
-                            int idx_y = idx % B->csr5_sigma;
-                            int idx_x = idx / B->csr5_sigma;
-                            int src_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * B->csr5_sigma + idx;
-                            int dst_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * B->csr5_sigma + idx_y
-                                          * MAGMA_CSR5_OMEGA + idx_x;
-                
-                            B->col[dst_idx] = A.col[src_idx];
-                            B->val[dst_idx] = A.val[src_idx];
-                        }
-                    }
-                    else { // the last tile
-                        for (int idx = par_id * MAGMA_CSR5_OMEGA * B->csr5_sigma; idx < B->nnz; idx++) {
-                            B->col[idx] = A.col[idx];
-                            B->val[idx] = A.val[idx];
-                        }
-                    }
-                }
+                magma_zmconvert_csr5_tiles( *B, 0, A.val, A.col, B->val, B->col );
 
                 //printf( "done\n" );
             }
@@ -1291,17 +1505,8 @@ magma_zmconvert(
                 B->max_nnz_row = A.max_nnz_row;
                 B->diameter = A.diameter;
 
-                // conversion
-
-                CHECK( magma_index_malloc_cpu( &row_tmp, A.num_rows+1 ));
-                //fill the row-pointer
-                for( magma_int_t i=0; i < A.num_rows+1; i++ )
-                    row_tmp[i] = i*A.max_nnz_row;
-                //now use AA_ELL, IA_ELL, row_tmp as CSR with some zeros.
-                //The CSR compressor removes these
-                CHECK( magma_z_csr_compressor(&A.val, &row_tmp, &A.col,
-                           &B->val, &B->row, &B->col, &B->num_rows, queue ));
-                B->nnz = B->row[B->num_rows];
+                // conversion; explicit zeros, among them the padding, are removed
+                CHECK( magma_zmconvert_ell2csr( A, B, Magma_ELLPACKT, A.max_nnz_row ));
             }
 
             // ELL (column-major) to CSR
@@ -1318,42 +1523,12 @@ magma_zmconvert(
                 B->max_nnz_row = A.max_nnz_row;
                 B->diameter = A.diameter;
 
-                // conversion
-                CHECK( magma_zmalloc_cpu( &val_tmp, A.num_rows*A.max_nnz_row ));
-                CHECK( magma_index_malloc_cpu( &row_tmp, A.num_rows+1 ));
-                CHECK( magma_index_malloc_cpu( &col_tmp, A.num_rows*A.max_nnz_row ));
-
-                //fill the row-pointer
-                for( magma_int_t i=0; i < A.num_rows+1; i++ )
-                    row_tmp[i] = i*A.max_nnz_row;
-                //transform RowMajor to ColMajor
-                for( magma_int_t j=0; j < A.max_nnz_row; j++ ) {
-                    for( magma_int_t i=0; i < A.num_rows; i++ ) {
-                        col_tmp[i*A.max_nnz_row+j] = A.col[j*A.num_rows+i];
-                        val_tmp[i*A.max_nnz_row+j] = A.val[j*A.num_rows+i];
-                    }
-                }
-                //now use AA_ELL, IA_ELL, row_tmp as CSR with some zeros.
-                //The CSR compressor removes these
-                CHECK( magma_z_csr_compressor(&val_tmp, &row_tmp, &col_tmp,
-                           &B->val, &B->row, &B->col, &B->num_rows, queue ));
-
-                B->nnz = B->row[B->num_rows];
+                // conversion; explicit zeros, among them the padding, are removed
+                CHECK( magma_zmconvert_ell2csr( A, B, Magma_ELL, A.max_nnz_row ));
             }
 
             // ELLD (ELLPACK with diagonal element first) to CSR
             else if ( old_format == Magma_ELLD ) {
-          /*      CHECK( magma_zmconvert( A, B, Magma_ELL, Magma_CSR, queue ));
-                for( magma_int_t i=0; i < A.num_rows; i++) {
-                    magma_zindexsortval(
-                    B->col,
-                    B->val,
-                    B->row[i],
-                    B->row[i+1]-1,
-                    queue );
-                }
-            */
-
                 //printf( "Conversion to CSR: " );
                 //fflush(stdout);
                 // fill in information for B
@@ -1366,40 +1541,9 @@ magma_zmconvert(
                 B->max_nnz_row = A.max_nnz_row;
                 B->diameter = A.diameter;
 
-                // conversion
-                CHECK( magma_index_malloc_cpu( &row_tmp, A.num_rows+1 ));
-                //fill the row-pointer
-                for( magma_int_t i=0; i < A.num_rows+1; i++ )
-                    row_tmp[i] = i*A.max_nnz_row;
-                // sort the diagonal element into the right place
-                CHECK( magma_zmalloc_cpu( &val_tmp2, A.num_rows*A.max_nnz_row ));
-                CHECK( magma_index_malloc_cpu( &col_tmp2, A.num_rows*A.max_nnz_row ));
-
-                for( magma_int_t j=0; j < A.num_rows; j++ ) {
-                    magma_index_t diagcol = A.col[j*A.max_nnz_row];
-                    magma_int_t smaller = 0;
-                    for( magma_int_t i=1; i < A.max_nnz_row; i++ ) {
-                        if ( (A.col[j*A.max_nnz_row+i] < diagcol)
-                             && (A.val[j*A.max_nnz_row+i] !=  zero) )
-                            smaller++;
-                    }
-                    for( magma_int_t i=0; i < smaller; i++ ) {
-                        col_tmp2[j*A.max_nnz_row+i] = A.col[j*A.max_nnz_row+i+1];
-                        val_tmp2[j*A.max_nnz_row+i] = A.val[j*A.max_nnz_row+i+1];
-                    }
-                    col_tmp2[j*A.max_nnz_row+smaller] = A.col[j*A.max_nnz_row];
-                    val_tmp2[j*A.max_nnz_row+smaller] = A.val[j*A.max_nnz_row];
-                    for( magma_int_t i=smaller+1; i < A.max_nnz_row; i++ ) {
-                        col_tmp2[j*A.max_nnz_row+i] = A.col[j*A.max_nnz_row+i];
-                        val_tmp2[j*A.max_nnz_row+i] = A.val[j*A.max_nnz_row+i];
-                    }
-                }
-
-                //now use AA_ELL, IA_ELL, row_tmp as CSR with some zeros.
-                //The CSR compressor removes these
-                CHECK( magma_z_csr_compressor(&val_tmp2, &row_tmp, &col_tmp2,
-                           &B->val, &B->row, &B->col, &B->num_rows, queue ));
-                B->nnz = B->row[B->num_rows];
+                // conversion; the diagonal element is sorted into the right
+                // place, explicit zeros, among them the padding, are removed
+                CHECK( magma_zmconvert_ell2csr( A, B, Magma_ELLD, A.max_nnz_row ));
             }
 
             // ELLRT to CSR
@@ -1418,16 +1562,8 @@ magma_zmconvert(
 
                 magma_int_t threads_per_row = A.alignment;
                 magma_int_t rowlength = magma_roundup( A.max_nnz_row, threads_per_row );
-                // conversion
-                CHECK( magma_index_malloc_cpu( &row_tmp, A.num_rows+1 ));
-                //fill the row-pointer
-                for( magma_int_t i=0; i < A.num_rows+1; i++ )
-                    row_tmp[i] = i*rowlength;
-                //now use AA_ELL, IA_ELL, row_tmp as CSR with some zeros.
-                //The CSR compressor removes these
-                CHECK( magma_z_csr_compressor(&A.val, &row_tmp, &A.col,
-                       &B->val, &B->row, &B->col, &B->num_rows, queue ));
-                B->nnz = B->row[B->num_rows];
+                // conversion; explicit zeros, among them the padding, are removed
+                CHECK( magma_zmconvert_ell2csr( A, B, Magma_ELLRT, rowlength ));
                 //printf( "done\n" );
             }
 
@@ -1443,46 +1579,10 @@ magma_zmconvert(
                 B->nnz = A.nnz;
                 B->max_nnz_row = A.max_nnz_row;
                 B->diameter = A.diameter;
-                magma_int_t C = A.blocksize;
-                magma_int_t slices = A.numblocks;
                 B->blocksize = A.blocksize;
                 B->numblocks = A.numblocks;
-                // conversion
-                CHECK( magma_zmalloc_cpu( &val_tmp,
-                                          A.max_nnz_row*(A.num_rows+C) ));
-                CHECK( magma_index_malloc_cpu( &row_tmp, A.num_rows+C ));
-                CHECK( magma_index_malloc_cpu( &col_tmp,
-                                               A.max_nnz_row*(A.num_rows+C) ));
-                // zero everything
-                for(magma_int_t i=0; i < A.max_nnz_row*(A.num_rows+C); i++ ) {
-                    val_tmp[ i ] = MAGMA_Z_MAKE(0., 0.);
-                    col_tmp[ i ] =  0;
-                }
-
-                //fill the row-pointer
-                for( magma_int_t i=0; i < A.num_rows+1; i++ ) {
-                    row_tmp[i] = A.max_nnz_row*i;
-                }
-
-                //transform RowMajor to ColMajor
-                for( magma_int_t k=0; k < slices; k++) {
-                    magma_int_t blockinfo = (A.row[k+1]-A.row[k])/A.blocksize;
-                    for( magma_int_t j=0; j < C; j++ ) {
-                        for( magma_int_t i=0; i < blockinfo; i++ ) {
-                            col_tmp[ (k*C+j)*A.max_nnz_row+i ] =
-                                                    A.col[A.row[k]+i*C+j];
-                            val_tmp[ (k*C+j)*A.max_nnz_row+i ] =
-                                                    A.val[A.row[k]+i*C+j];
-                        }
-                    }
-                }
-
-                //now use AA_ELL, IA_ELL, row_tmp as CSR with some zeros.
-                //The CSR compressor removes these
-
-                CHECK( magma_z_csr_compressor(&val_tmp, &row_tmp, &col_tmp,
-                           &B->val, &B->row, &B->col, &B->num_rows, queue ));
-                B->nnz = B->row[B->num_rows];
+                // conversion; explicit zeros, among them the padding, are removed
+                CHECK( magma_zmconvert_ell2csr( A, B, Magma_SELLP, A.max_nnz_row ));
                 //printf( "done\n" );
             }
 
@@ -1504,50 +1604,10 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->row, B->num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, B->nnz ));
 
-                for( magma_int_t i=0; i < A.num_rows+1; i++) {
-                    B->row[i] = A.row[i];
-                }
+                magma_zmconvert_copy( A.num_rows+1, sizeof(magma_index_t), A.row, B->row );
 
                 // step 1. transpose column_index and value arrays
-                //#pragma omp parallel for
-                for (int par_id = 0; par_id < A.csr5_p; par_id++)
-                {
-                    // if this is fast track tile, do not transpose it
-                    if (A.tile_ptr[par_id] == A.tile_ptr[par_id + 1])
-                    {
-                        for (int idx = 0; idx < MAGMA_CSR5_OMEGA * A.csr5_sigma; idx++) {
-                            int src_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * A.csr5_sigma + idx;
-                            B->col[src_idx] = A.col[src_idx];
-                            B->val[src_idx] = A.val[src_idx];
-                        }
-                        continue;
-                    }
-                    if (par_id < A.csr5_p-1) {
-                        //#pragma simd
-                        for (int idx = 0; idx < MAGMA_CSR5_OMEGA * A.csr5_sigma;
-                                idx++)
-                        {
-                            int idx_y = idx % MAGMA_CSR5_OMEGA;
-                            int idx_x = idx / MAGMA_CSR5_OMEGA;
-                            int src_idx = par_id * MAGMA_CSR5_OMEGA*A.csr5_sigma
-                                      + idx;
-                            int dst_idx = par_id * MAGMA_CSR5_OMEGA*A.csr5_sigma
-                                      + idx_y * A.csr5_sigma + idx_x;
-                            B->col[dst_idx] = A.col[src_idx];
-                            B->val[dst_idx] = A.val[src_idx];
-                        }
-                    }
-                    else // the last tile
-                    {
-                        for (int idx = par_id * MAGMA_CSR5_OMEGA
-                                       * A.csr5_sigma; idx < A.nnz; idx++)
-                        {
-                            B->col[idx] = A.col[idx];
-                            B->val[idx] = A.val[idx];
-                        }
-                    }
-                }
+                magma_zmconvert_csr5_tiles( A, 1, A.val, A.col, B->val, B->col );
 
                 //printf( "done\n" );
             }
@@ -1567,34 +1627,35 @@ magma_zmconvert(
 
                 // conversion
 
-                B->nnz=0;
-                for( magma_int_t i=0; i<(A.num_rows)*(A.num_cols); i++ ) {
-                    if ( MAGMA_Z_REAL(A.val[i]) != 0.0 || MAGMA_Z_IMAG(A.val[i]) != 0.0 )
-                        (B->nnz)++;
+                magma_int_t num_threads = magma_zmconvert_num_threads( A.num_rows*A.num_cols );
+                CHECK( magma_index_malloc_cpu( &B->row, B->num_rows+1 ));
+                #pragma omp parallel for schedule(static) num_threads(num_threads)
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    magma_index_t count = 0;
+                    for( magma_int_t j=0; j < A.num_cols; j++ ) {
+                        magmaDoubleComplex v = A.val[ i*A.num_cols + j ];
+                        if ( MAGMA_Z_REAL(v) != 0.0 || MAGMA_Z_IMAG(v) != 0.0 )
+                            count++;
+                    }
+                    B->row[i] = count;
                 }
+                magma_zmconvert_scan( A.num_rows, B->row );
+                B->nnz = B->row[A.num_rows];
                 CHECK( magma_zmalloc_cpu( &B->val, B->nnz));
-                CHECK( magma_index_malloc_cpu( &B->row, B->num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, B->nnz ));
 
-                magma_int_t i = 0;
-                magma_int_t j = 0;
-                magma_int_t k = 0;
-
-                for(i=0; i<(A.num_rows)*(A.num_cols); i++)
-                {
-                    if ( i%(B->num_cols) == 0 )
-                    {
-                        (B->row)[k] = j;
-                        k++;
-                    }
-                    if ( MAGMA_Z_REAL(A.val[i]) != 0 || MAGMA_Z_IMAG(A.val[i]) != 0)
-                    {
-                        (B->val)[j] = A.val[i];
-                        (B->col)[j] = i%(B->num_cols);
-                        j++;
+                #pragma omp parallel for schedule(static) num_threads(num_threads)
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    magma_index_t k = B->row[i];
+                    for( magma_int_t j=0; j < A.num_cols; j++ ) {
+                        magmaDoubleComplex v = A.val[ i*A.num_cols + j ];
+                        if ( MAGMA_Z_REAL(v) != 0.0 || MAGMA_Z_IMAG(v) != 0.0 ) {
+                            B->val[k] = v;
+                            B->col[k] = j;
+                            k++;
+                        }
                     }
                 }
-                (B->row)[B->num_rows]=B->nnz;
 
                 //printf( "done\n" );
             }
@@ -1997,3 +2058,123 @@ cleanup:
     }
     return info;
 }
+
+
+/**
+    Purpose
+    -------
+
+    Refreshes the values of a matrix B that was converted from CSR with
+    magma_zmconvert, after the values of the CSR matrix changed, but not
+    its sparsity pattern. Only the value phase of the conversion runs:
+    nothing is allocated, and the column indices, the padding, and any
+    format data stay as they are. This is the cheap path for iterative
+    methods that repeatedly convert matrices with a fixed pattern, e.g.,
+    in every sweep of an incomplete factorization.
+
+    B must hold the result of magma_zmconvert( A0, B, Magma_CSR,
+    new_format, queue ) for a CSR matrix A0 with the same sparsity pattern
+    as A. Only the sizes are checked, not the pattern. Supported on the CPU
+    for the target formats CSR, CUCSR, CSRD, COO, CSRCOO, ELLPACKT, ELL,
+    ELLD, ELLRT, SELLP, CSR5, and DENSE.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix A in CSR
+
+    @param[in,out]
+    B           magma_z_matrix*
+                A in new format; the values are updated
+
+    @param[in]
+    old_format  magma_storage_t
+                original storage format, Magma_CSR
+
+    @param[in]
+    new_format  magma_storage_t
+                storage format of B
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmconvert_values(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_storage_t old_format,
+    magma_storage_t new_format,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( A.memory_location != Magma_CPU || B->memory_location != Magma_CPU
+         || old_format != Magma_CSR ) {
+        printf("error: conversion not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    if ( B->storage_type != new_format || B->num_rows != A.num_rows
+         || B->num_cols != A.num_cols || B->val == NULL ) {
+        printf("error: target does not match the matrix.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    switch( new_format ) {
+        case Magma_CSR:
+        case Magma_CUCSR:
+        case Magma_COO:
+        case Magma_CSRCOO:
+            if ( B->nnz != A.nnz ) {
+                printf("error: target does not match the matrix.\n");
+                info = MAGMA_ERR_NOT_SUPPORTED;
+                goto cleanup;
+            }
+            magma_zmconvert_copy( A.nnz, sizeof(magmaDoubleComplex), A.val, B->val );
+            break;
+        case Magma_CSRD:
+            if ( B->nnz != A.nnz ) {
+                printf("error: target does not match the matrix.\n");
+                info = MAGMA_ERR_NOT_SUPPORTED;
+                goto cleanup;
+            }
+            magma_zmconvert_csr2csrd( A, B, 1 );
+            break;
+        case Magma_ELLPACKT:
+        case Magma_ELL:
+        case Magma_ELLD:
+            magma_zmconvert_csr2ell( A, B, new_format, B->max_nnz_row, 1 );
+            break;
+        case Magma_ELLRT:
+            magma_zmconvert_csr2ell( A, B, new_format,
+                magma_roundup( B->max_nnz_row, B->alignment ), 1 );
+            break;
+        case Magma_SELLP:
+            magma_zmconvert_csr2ell( A, B, new_format, 0, 1 );
+            break;
+        case Magma_CSR5:
+            if ( B->nnz != A.nnz ) {
+                printf("error: target does not match the matrix.\n");
+                info = MAGMA_ERR_NOT_SUPPORTED;
+                goto cleanup;
+            }
+            magma_zmconvert_csr5_tiles( *B, 0, A.val, NULL, B->val, NULL );
+            break;
+        case Magma_DENSE:
+            magma_zmconvert_csr2dense( A, B, 1 );
+            break;
+        default:
+            printf("error: format not supported.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+cleanup:
+    return info;
+}
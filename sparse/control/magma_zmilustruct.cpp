@@ -12,7 +12,14 @@
 //  in this file, many routines are taken from
 //  the IO functions provided by MatrixMarket
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 /******************************************************************************
@@ -54,11 +61,12 @@ void magma_zshell_sort(
 // factors magma_int_to separate upper and lower parts
 // sorts the entries in each row of A by index
 // assumes no zero rows
+// sequential reference for magma_zsymbolic_ilu
 */
 
 extern "C"
 magma_int_t
-magma_zsymbolic_ilu(
+magma_zsymbolic_ilu_seq(
     const magma_int_t levfill,                 /* level of fill */
     const magma_int_t n,                       /* order of matrix */
     magma_int_t *nzl,                          /* input-output */
@@ -261,7 +269,7 @@ void magma_zmexFunction(magma_int_t nlhs, magma_int_t n, magmaDoubleComplex omeg
 
 
     /* the following will fail and return to matlab if insufficient storage */
-    magma_zsymbolic_ilu(levfill, n, &nzl, &nzu, ia, ja, ial, jal, iau, jau);
+    magma_zsymbolic_ilu_seq(levfill, n, &nzl, &nzu, ia, ja, ial, jal, iau, jau);
 }
 
 /* shell sort
@@ -270,6 +278,251 @@ void magma_zmexFunction(magma_int_t nlhs, magma_int_t n, magmaDoubleComplex omeg
 */
 
 
+/**
+    Purpose
+    -------
+
+    Parallel symbolic ILU(k) factorization of the CSR pattern ia, ja.
+    Gives the same pattern as magma_zsymbolic_ilu_seq: row i of L, U starts
+    from row i of A with level 0, and for every k in row i of L, in
+    ascending order, the entry (i,j) of U(k,:) is added with level
+    lev(i,k) + lev(k,j) + 1 if this is at most levfill. The level of an
+    existing entry is lowered to the minimum.
+
+    Row i only depends on the rows of U in its L part, which are all
+    numbered less than i. The threads claim the rows in ascending order
+    from a shared counter, and wait on a per-row flag before merging a row
+    of U that is not done yet. As the smallest unfinished row never waits,
+    this schedules the rows along the levels of the actual dependency DAG
+    of the factors. Each thread merges with a marker array indexed by
+    column that holds the current level of each entry, and a heap that
+    yields the L entries in ascending order, including the new fill-in.
+    As row i has at most i entries in L and n-i in U, the heap and the L
+    and U columns of the row share one array of length n, so each thread
+    needs 2n indices of workspace.
+
+    The patterns are first computed into per-row buffers, which gives the
+    exact number of nonzeros of L and U; jal and jau are then allocated
+    once with the exact size, and the rows are copied in parallel.
+
+    Arguments
+    ---------
+
+    @param[in]
+    levfill     magma_int_t
+                Level of fill.
+
+    @param[in]
+    n           magma_int_t
+                Order of the matrix.
+
+    @param[in]
+    ia          const magma_index_t*
+                Row pointer of A, size n+1.
+
+    @param[in]
+    ja          const magma_index_t*
+                Column indices of A. Need not be sorted.
+
+    @param[out]
+    ial         magma_index_t*
+                Row pointer of the strictly lower factor L, size n+1.
+
+    @param[out]
+    jal         magma_index_t**
+                Sorted column indices of L, allocated here.
+
+    @param[out]
+    iau         magma_index_t*
+                Row pointer of the upper factor U, size n+1.
+
+    @param[out]
+    jau         magma_index_t**
+                Sorted column indices of U, allocated here.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zsymbolic_ilu(
+    magma_int_t levfill,
+    magma_int_t n,
+    const magma_index_t *ia,
+    const magma_index_t *ja,
+    magma_index_t *ial,
+    magma_index_t **jal,
+    magma_index_t *iau,
+    magma_index_t **jau,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_int_t num_threads = 1;
+    // per row: buffer with the L columns, the U columns and the U levels
+    magma_index_t **rowbuf = NULL, *lcnt = NULL, *ucnt = NULL;
+    // per thread: level of each column (-1 if not in the row), and for row
+    // i the heap of the L columns still to merge growing from 0, the L
+    // columns merged growing down from i-1, and the U columns from i
+    magma_index_t *work = NULL;
+    std::atomic<magma_int_t> *done = NULL;
+    std::atomic<magma_int_t> next_row( 0 ), failed( 0 );
+
+    magma_free_cpu( *jal );
+    magma_free_cpu( *jau );
+    *jal = NULL;
+    *jau = NULL;
+
+#ifdef _OPENMP
+    num_threads = max( 1, min( omp_get_max_threads(), n ));
+#endif
+
+    CHECK( magma_malloc_cpu( (void**) &rowbuf, max(n,1)*sizeof(magma_index_t*) ));
+    CHECK( magma_index_malloc_cpu( &lcnt, n+1 ));
+    CHECK( magma_index_malloc_cpu( &ucnt, n+1 ));
+    CHECK( magma_index_malloc_cpu( &work, size_t(2)*num_threads*max(n,1) ));
+    done = new std::atomic<magma_int_t>[ max(n,1) ];
+    for( magma_int_t i=0; i<n; i++ ){
+        rowbuf[i] = NULL;
+        done[i].store( 0, std::memory_order_relaxed );
+    }
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        magma_int_t id = 0;
+#ifdef _OPENMP
+        id = omp_get_thread_num();
+#endif
+        magma_index_t *lev  = work + size_t(2)*id*max(n,1);
+        magma_index_t *heap = lev  + n;
+        std::greater<magma_index_t> later;
+
+        for( magma_int_t j=0; j<n; j++ ){
+            lev[j] = -1;
+        }
+
+        for( magma_int_t i = next_row++; i < n; i = next_row++ ){
+            magma_int_t nheap = 0, nlo = 0, nup = 0;
+            // lo[-j] is the j-th L column merged, up[j] the j-th U column
+            magma_index_t *lo = heap + i - 1;
+            magma_index_t *up = heap + i;
+
+            // row of A, with level 0
+            for( magma_int_t j=ia[i]; j<ia[i+1]; j++ ){
+                magma_index_t col = ja[j];
+                if( lev[col] < 0 ){
+                    lev[col] = 0;
+                    if( col < i ){
+                        heap[nheap++] = col;
+                        std::push_heap( heap, heap+nheap, later );
+                    } else {
+                        up[nup++] = col;
+                    }
+                }
+            }
+
+            // merge the rows of U in ascending order
+            while( nheap > 0 ){
+                std::pop_heap( heap, heap+nheap, later );
+                magma_index_t k = heap[--nheap];
+                lo[ -(nlo++) ] = k;
+                while( done[k].load( std::memory_order_acquire ) == 0 ){
+                    if( failed.load( std::memory_order_relaxed ) != 0 ){
+                        break;
+                    }
+                }
+                if( failed.load( std::memory_order_relaxed ) != 0 ){
+                    break;
+                }
+                const magma_index_t *ucol = rowbuf[k] + lcnt[k];
+                const magma_index_t *ulev = ucol + ucnt[k];
+                magma_index_t levk = lev[k];
+                for( magma_int_t j=0; j<ucnt[k]; j++ ){
+                    magma_index_t col = ucol[j];
+                    magma_index_t newlev = levk + ulev[j] + 1;
+                    if( col == k ){
+                        continue;
+                    } else if( lev[col] >= 0 ){
+                        lev[col] = min( lev[col], newlev );
+                    } else if( newlev <= levfill ){
+                        lev[col] = newlev;
+                        if( col < i ){
+                            heap[nheap++] = col;
+                            std::push_heap( heap, heap+nheap, later );
+                        } else {
+                            up[nup++] = col;
+                        }
+                    }
+                }
+            }
+            if( failed.load( std::memory_order_relaxed ) != 0 ){
+                break;
+            }
+
+            // L is already sorted, as the heap yields it in order
+            std::sort( up, up+nup );
+            if( magma_index_malloc_cpu( &rowbuf[i], nlo + 2*nup ) != MAGMA_SUCCESS ){
+                failed.store( 1 );
+                break;
+            }
+            for( magma_int_t j=0; j<nlo; j++ ){
+                rowbuf[i][j] = lo[-j];
+                lev[ lo[-j] ] = -1;
+            }
+            for( magma_int_t j=0; j<nup; j++ ){
+                rowbuf[i][nlo+j] = up[j];
+                rowbuf[i][nlo+nup+j] = lev[ up[j] ];
+                lev[ up[j] ] = -1;
+            }
+            lcnt[i] = nlo;
+            ucnt[i] = nup;
+            done[i].store( 1, std::memory_order_release );
+        }
+    }
+    if( failed.load() != 0 ){
+        info = MAGMA_ERR_HOST_ALLOC;
+        goto cleanup;
+    }
+
+    // exact sizes of L and U
+    ial[0] = 0;
+    iau[0] = 0;
+    for( magma_int_t i=0; i<n; i++ ){
+        ial[i+1] = ial[i] + lcnt[i];
+        iau[i+1] = iau[i] + ucnt[i];
+    }
+    CHECK( magma_index_malloc_cpu( jal, ial[n] ));
+    CHECK( magma_index_malloc_cpu( jau, iau[n] ));
+
+    #pragma omp parallel for schedule(static)
+    for( magma_int_t i=0; i<n; i++ ){
+        for( magma_int_t j=0; j<lcnt[i]; j++ ){
+            (*jal)[ ial[i]+j ] = rowbuf[i][j];
+        }
+        for( magma_int_t j=0; j<ucnt[i]; j++ ){
+            (*jau)[ iau[i]+j ] = rowbuf[i][ lcnt[i]+j ];
+        }
+    }
+
+cleanup:
+    if( rowbuf != NULL ){
+        for( magma_int_t i=0; i<n; i++ ){
+            magma_free_cpu( rowbuf[i] );
+        }
+    }
+    magma_free_cpu( rowbuf );
+    magma_free_cpu( lcnt );
+    magma_free_cpu( ucnt );
+    magma_free_cpu( work );
+    delete[] done;
+    return info;
+}
+
+
 
 /**
     Purpose
@@ -317,7 +570,7 @@ magma_zsymbilu(
 {
     magma_int_t info = 0;
     
-    magma_z_matrix A_copy={Magma_CSR}, B={Magma_CSR};
+    magma_z_matrix B={Magma_CSR};
     magma_z_matrix hA={Magma_CSR}, CSRCOOA={Magma_CSR};
     
     // make sure the target structure is empty
@@ -325,7 +578,6 @@ magma_zsymbilu(
     magma_zmfree( U, queue );
     
     if( A->memory_location == Magma_CPU && A->storage_type == Magma_CSR ){
-        CHECK( magma_zmtransfer( *A, &A_copy, Magma_CPU, Magma_CPU, queue ));
         CHECK( magma_zmtransfer( *A, &B, Magma_CPU, Magma_CPU, queue ));
 
         // possibility to scale to unit diagonal
@@ -334,47 +586,36 @@ magma_zsymbilu(
         CHECK( magma_zmconvert( B, L, Magma_CSR, Magma_CSR , queue));
         CHECK( magma_zmconvert( B, U, Magma_CSR, Magma_CSR, queue ));
 
-        magma_int_t num_lnnz = (levels > 0 ) ? B.nnz/2*(2*levels+50) : B.nnz;
-        magma_int_t num_unnz = (levels > 0 ) ? B.nnz/2*(2*levels+50) : B.nnz;
-
-        magma_free_cpu( L->col );
-        magma_free_cpu( U->col );
-        CHECK( magma_index_malloc_cpu( &L->col, num_lnnz ));
-        CHECK( magma_index_malloc_cpu( &U->col, num_unnz ));
-
-        magma_zsymbolic_ilu( levels, A->num_rows, &num_lnnz, &num_unnz, B.row, B.col,
-                                            L->row, L->col, U->row, U->col );
-        L->nnz = num_lnnz;
-        U->nnz = num_unnz;
+        // the symbolic factorization allocates L->col, U->col with the exact fill
+        CHECK( magma_zsymbolic_ilu( levels, A->num_rows, B.row, B.col,
+                                    L->row, &L->col, U->row, &U->col, queue ));
+        L->nnz = L->row[ L->num_rows ];
+        U->nnz = U->row[ U->num_rows ];
         magma_free_cpu( L->val );
         magma_free_cpu( U->val );
         CHECK( magma_zmalloc_cpu( &L->val, L->nnz ));
         CHECK( magma_zmalloc_cpu( &U->val, U->nnz ));
-        for( magma_int_t i=0; i<L->nnz; i++ )
-            L->val[i] = MAGMA_Z_MAKE( 0.0, 0.0 );
 
-        for( magma_int_t i=0; i<U->nnz; i++ )
-            U->val[i] = MAGMA_Z_MAKE( 0.0, 0.0 );
-        // take the original values (scaled) as initial guess for L
+        // take the original values (scaled) as initial guess for L and U;
+        // the rows of L and U are sorted
+        #pragma omp parallel for schedule(dynamic,256)
         for(magma_int_t i=0; i<L->num_rows; i++){
+            for(magma_int_t k=L->row[i]; k<L->row[i+1]; k++)
+                L->val[k] = MAGMA_Z_ZERO;
+            for(magma_int_t k=U->row[i]; k<U->row[i+1]; k++)
+                U->val[k] = MAGMA_Z_ZERO;
             for(magma_int_t j=B.row[i]; j<B.row[i+1]; j++){
                 magma_index_t lcol = B.col[j];
-                for(magma_int_t k=L->row[i]; k<L->row[i+1]; k++){
-                    if( L->col[k] == lcol ){
-                        L->val[k] =  B.val[j];
-                    }
+                magma_index_t *begin = L->col + L->row[i], *end = L->col + L->row[i+1];
+                magmaDoubleComplex *val = L->val + L->row[i];
+                if( lcol >= i ){
+                    begin = U->col + U->row[i];
+                    end = U->col + U->row[i+1];
+                    val = U->val + U->row[i];
                 }
-            }
-        }
-
-        // take the original values (scaled) as initial guess for U
-        for(magma_int_t i=0; i<U->num_rows; i++){
-            for(magma_int_t j=B.row[i]; j<B.row[i+1]; j++){
-                magma_index_t lcol = B.col[j];
-                for(magma_int_t k=U->row[i]; k<U->row[i+1]; k++){
-                    if( U->col[k] == lcol ){
-                        U->val[k] =  B.val[j];
-                    }
+                magma_index_t *k = std::lower_bound( begin, end, lcol );
+                if( k != end && *k == lcol ){
+                    val[ k-begin ] = B.val[j];
                 }
             }
         }
@@ -386,9 +627,14 @@ magma_zsymbilu(
         CHECK( magma_zmalloc_cpu( &A->val, L->nnz+U->nnz ));
         A->nnz = L->nnz+U->nnz;
         
-        magma_int_t z = 0;
+        // the values of L and U are the original entries of A
+        #pragma omp parallel for schedule(static)
+        for(magma_int_t i=0; i<=A->num_rows; i++){
+            A->row[i] = L->row[i] + U->row[i];
+        }
+        #pragma omp parallel for schedule(dynamic,256)
         for(magma_int_t i=0; i<A->num_rows; i++){
-            A->row[i] = z;
+            magma_int_t z = A->row[i];
             for(magma_int_t j=L->row[i]; j<L->row[i+1]; j++){
                 A->col[z] = L->col[j];
                 A->val[z] = L->val[j];
@@ -400,18 +646,6 @@ magma_zsymbilu(
                 z++;
             }
         }
-        A->row[A->num_rows] = z;
-        // reset the values of A to the original entries
-        for(magma_int_t i=0; i<A->num_rows; i++){
-            for(magma_int_t j=A_copy.row[i]; j<A_copy.row[i+1]; j++){
-                magma_index_t lcol = A_copy.col[j];
-                for(magma_int_t k=A->row[i]; k<A->row[i+1]; k++){
-                    if( A->col[k] == lcol ){
-                        A->val[k] =  A_copy.val[j];
-                    }
-                }
-            }
-        }
     }
     else {
         magma_storage_t A_storage = A->storage_type;
@@ -432,7 +666,6 @@ cleanup:
         magma_zmfree( L, queue );
         magma_zmfree( U, queue );
     }
-    magma_zmfree( &A_copy, queue );
     magma_zmfree( &B, queue );
     magma_zmfree( &hA, queue );
     magma_zmfree( &CSRCOOA, queue );
@@ -16,6 +16,17 @@
 #include <algorithm>
 #include <vector>
 #include <utility>  // pair
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "magmasparse_internal.h"
 #include "magmasparse_mmio.h"
@@ -36,108 +47,300 @@ static bool compare_first(
 }
 
 
+// entries per thread below which the reader does not use more threads
+#define MTX_ENTRIES_PER_THREAD 65536
+
+// the per-thread row histograms hold at most this many entries per nonzero,
+// so matrices with many more rows than nonzeros use fewer threads
+#define MTX_COUNT_PER_NNZ 4
+
+// exact powers of ten in double precision, for the fast path of mtx_parse_double
+static const double mtx_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+static inline bool mtx_is_blank( char c )
+{
+    return (c == ' ' || c == '\t' || c == '\r');
+}
+
+
 /**
     Purpose
     -------
+    Parses a decimal integer in [p, end), skipping leading blanks.
+    Returns pointer past the number, or NULL if there is no valid number.
+*/
+static inline const char*
+mtx_parse_index( const char* p, const char* end, magma_index_t* x )
+{
+    while ( p < end && mtx_is_blank( *p ) )
+        ++p;
+    bool neg = false;
+    if ( p < end && (*p == '-' || *p == '+') ) {
+        neg = (*p == '-');
+        ++p;
+    }
+    if ( p == end || *p < '0' || *p > '9' )
+        return NULL;
+    long long v = 0;
+    while ( p < end && *p >= '0' && *p <= '9' ) {
+        v = 10*v + (*p - '0');
+        if ( v > 2147483647LL )
+            return NULL;
+        ++p;
+    }
+    *x = (magma_index_t) (neg ? -v : v);
+    return p;
+}
 
-    Reads in a matrix stored in coo format from a Matrix Market (.mtx)
-    file and converts it into CSR format. It duplicates the off-diagonal
-    entries in the symmetric case.
 
-    Arguments
-    ---------
-    
-    @param[out]
-    type        magma_storage_t*
-                storage type of matrix
-                
-    @param[out]
-    location    magma_location_t*
-                location of matrix
-                
-    @param[out]
-    n_row       magma_int_t*
-                number of rows in matrix
-                
-    @param[out]
-    n_col       magma_int_t*
-                number of columns in matrix
-                
-    @param[out]
-    nnz         magma_int_t*
-                number of nonzeros in matrix
-                
-    @param[out]
-    val         magmaDoubleComplex**
-                value array of CSR output
+/**
+    Purpose
+    -------
+    Parses a floating point number in [p, end), skipping leading blanks.
+    Numbers with at most 19 significant digits whose value m * 10^e has
+    m < 2^53 and |e| <= 22 are computed directly, which is exact since both
+    m and 10^e are representable; all others go through strtod. The result
+    is therefore identical to strtod, and to fscanf's %lf.
+    Returns pointer past the number, or NULL if there is no valid number.
+*/
+static inline const char*
+mtx_parse_double( const char* p, const char* end, double* x )
+{
+    while ( p < end && mtx_is_blank( *p ) )
+        ++p;
+    const char* start = p;
+    bool neg = false, any = false, slow = false;
+    unsigned long long m = 0;
+    int ndigit = 0, exp10 = 0;
+
+    if ( p < end && (*p == '-' || *p == '+') ) {
+        neg = (*p == '-');
+        ++p;
+    }
+    for( ; p < end && *p >= '0' && *p <= '9'; ++p ) {
+        any = true;
+        if ( m != 0 || *p != '0' ) {
+            if ( ndigit < 19 ) { m = 10*m + (*p - '0'); ++ndigit; }
+            else { slow = true; }
+        }
+    }
+    if ( p < end && *p == '.' ) {
+        for( ++p; p < end && *p >= '0' && *p <= '9'; ++p ) {
+            any = true;
+            if ( m != 0 || *p != '0' ) {
+                if ( ndigit < 19 ) { m = 10*m + (*p - '0'); ++ndigit; }
+                else { slow = true; }
+            }
+            --exp10;
+        }
+    }
+    if ( any && p < end && (*p == 'e' || *p == 'E') ) {
+        const char* q = p + 1;
+        bool eneg = false;
+        if ( q < end && (*q == '-' || *q == '+') ) {
+            eneg = (*q == '-');
+            ++q;
+        }
+        if ( q < end && *q >= '0' && *q <= '9' ) {
+            int e = 0;
+            for( ; q < end && *q >= '0' && *q <= '9'; ++q ) {
+                if ( e < 100000 )
+                    e = 10*e + (*q - '0');
+            }
+            exp10 += (eneg ? -e : e);
+            p = q;
+        }
+        else {
+            slow = true;
+        }
+    }
+    if ( any && ! slow && (p == end || mtx_is_blank( *p ) || *p == '\n') ) {
+        if ( m == 0 ) {
+            *x = (neg ? -0.0 : 0.0);
+            return p;
+        }
+        if ( m <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22 ) {
+            double v = (double) m;
+            v = (exp10 >= 0 ? v * mtx_pow10[ exp10 ] : v / mtx_pow10[ -exp10 ]);
+            *x = (neg ? -v : v);
+            return p;
+        }
+    }
 
-    @param[out]
-    row         magma_index_t**
-                row pointer of CSR output
+    // slow path: inf, nan, long mantissas, large exponents
+    char buf[ 128 ];
+    size_t len = 0;
+    for( p = start; p < end && ! mtx_is_blank( *p ) && *p != '\n'; ++p ) {
+        if ( len == sizeof(buf)-1 )
+            return NULL;
+        buf[ len++ ] = *p;
+    }
+    buf[ len ] = '\0';
+    char* tail;
+    *x = strtod( buf, &tail );
+    if ( tail == buf )
+        return NULL;
+    return start + (tail - buf);
+}
 
-    @param[out]
-    col         magma_index_t**
-                column indices of CSR output
 
-    @param[in]
-    filename    const char*
-                filname of the mtx matrix
-    @param[in]
-    queue       magma_queue_t
-                Queue to execute in.
+/**
+    Purpose
+    -------
+    Returns the number of entry lines in [p, end): lines that are neither
+    blank nor comments.
+*/
+static magma_int_t
+mtx_count_entries( const char* p, const char* end )
+{
+    magma_int_t n = 0;
+    while ( p < end ) {
+        const char* eol = (const char*) memchr( p, '\n', end - p );
+        if ( eol == NULL )
+            eol = end;
+        while ( p < eol && mtx_is_blank( *p ) )
+            ++p;
+        if ( p < eol && *p != '%' )
+            ++n;
+        p = eol + 1;
+    }
+    return n;
+}
 
-    @ingroup magmasparse_zaux
-    ********************************************************************/
 
-extern "C"
-magma_int_t read_z_csr_from_mtx(
-    magma_storage_t *type,
-    magma_location_t *location,
-    magma_int_t* n_row,
-    magma_int_t* n_col,
-    magma_int_t* nnz,
+/**
+    Purpose
+    -------
+    Parses the entry lines in [p, end) into coo_row, coo_col, coo_val,
+    starting at entry k and ignoring entries beyond nnz. Indices are converted
+    to 0-based. nvalue is the number of values per entry: 0 for pattern,
+    1 for real or integer, 2 for complex matrices.
+    Sets *has_zero if an explicit zero value was read in a real matrix.
+    Returns 0, or MAGMA_ERR_UNKNOWN on a malformed or out of range entry.
+*/
+static magma_int_t
+magma_z_mtx_parse_chunk(
+    const char* p,
+    const char* end,
+    magma_int_t k,
+    magma_int_t nnz,
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    int nvalue,
+    magma_index_t *coo_row,
+    magma_index_t *coo_col,
+    magmaDoubleComplex *coo_val,
+    int *has_zero )
+{
+    while ( p < end && k < nnz ) {
+        const char* eol = (const char*) memchr( p, '\n', end - p );
+        if ( eol == NULL )
+            eol = end;
+        while ( p < eol && mtx_is_blank( *p ) )
+            ++p;
+        if ( p < eol && *p != '%' ) {
+            magma_index_t ROW, COL;
+            double VAL = 1.0, VALC = 0.0;
+            p = mtx_parse_index( p, eol, &ROW );
+            if ( p != NULL ) p = mtx_parse_index( p, eol, &COL );
+            if ( p != NULL && nvalue >= 1 ) p = mtx_parse_double( p, eol, &VAL );
+            if ( p != NULL && nvalue >= 2 ) p = mtx_parse_double( p, eol, &VALC );
+            if ( p == NULL || ROW < 1 || ROW > num_rows || COL < 1 || COL > num_cols ) {
+                return MAGMA_ERR_UNKNOWN;
+            }
+            if ( nvalue == 1 && VAL == 0 ) {
+                *has_zero = 1;
+            }
+            coo_row[k] = ROW - 1;
+            coo_col[k] = COL - 1;
+            coo_val[k] = MAGMA_Z_MAKE( VAL, VALC );
+            ++k;
+        }
+        p = eol + 1;
+    }
+    return 0;
+}
+
+
+/**
+    Purpose
+    -------
+    Reads a Matrix Market coordinate file into CSR format, duplicating the
+    off-diagonal entries of symmetric and hermitian matrices.
+
+    The file is memory-mapped and split into line-aligned chunks, which are
+    counted and then parsed in parallel. The CSR structure is assembled by a
+    parallel bucket pass: each thread counts the entries of its share per row,
+    a prefix sum over rows and threads gives the row pointer and each thread's
+    offsets, and each thread scatters its share. Entries within a row keep
+    file order (an entry before its mirror), and rows are then stably sorted
+    by column index, so the result is the same as reading sequentially.
+
+    Also returns the symmetry of the file and, in has_zero, whether a real
+    matrix contains explicit zeros.
+*/
+static magma_int_t
+magma_z_mtx_read_csr(
+    const char *filename,
+    magma_int_t *n_row,
+    magma_int_t *n_col,
+    magma_int_t *nnz,
     magmaDoubleComplex **val,
     magma_index_t **row,
     magma_index_t **col,
-    const char *filename,
+    magma_symmetry_t *sym,
+    int *has_zero,
     magma_queue_t queue )
 {
     char buffer[ 1024 ];
     magma_int_t info = 0;
-    
+
     magma_index_t *coo_col=NULL, *coo_row=NULL;
     magmaDoubleComplex *coo_val=NULL;
-    magma_index_t *new_col=NULL, *new_row=NULL;
-    magmaDoubleComplex *new_val=NULL;
-    magma_int_t hermitian = 0;
-    
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
-    
+    magma_index_t *count=NULL;
+    magma_int_t *chunk_start=NULL, *chunk_info=NULL;
+    const char **chunk=NULL;
+    char *data = NULL;
+    size_t data_size = 0;
+    long offset = 0;
+    magma_int_t nchunk = 1, nthread = 1, nentry = 0;
+    magma_index_t num_rows, num_cols, num_nonzeros;
+    int nvalue = 1, mirror = 0, hermitian = 0;
+
+    *val = NULL;
+    *row = NULL;
+    *col = NULL;
+    *has_zero = 0;
+
     FILE *fid = NULL;
     MM_typecode matcode;
     fid = fopen(filename, "r");
-    
+
     if (fid == NULL) {
         printf("%% Unable to open file %s\n", filename);
         info = MAGMA_ERR_NOT_FOUND;
         goto cleanup;
     }
-    
+
     printf("%% Reading sparse matrix from file (%s):", filename);
     fflush(stdout);
-    
+
     if (mm_read_banner(fid, &matcode) != 0) {
         printf("\n%% Could not process Matrix Market banner: %s.\n", matcode);
         info = MAGMA_ERR_NOT_SUPPORTED;
         goto cleanup;
     }
-    
+
     if (!mm_is_valid(matcode)) {
         printf("\n%% Invalid Matrix Market file.\n");
         info = MAGMA_ERR_NOT_SUPPORTED;
         goto cleanup;
     }
-    
+
     if ( ! ( ( mm_is_real(matcode)    ||
                mm_is_integer(matcode) ||
                mm_is_pattern(matcode) ||
@@ -151,185 +354,336 @@ magma_int_t read_z_csr_from_mtx(
         info = MAGMA_ERR_NOT_SUPPORTED;
         goto cleanup;
     }
-    
-    magma_index_t num_rows, num_cols, num_nonzeros;
+
     if (mm_read_mtx_crd_size(fid, &num_rows, &num_cols, &num_nonzeros) != 0) {
         info = MAGMA_ERR_UNKNOWN;
         goto cleanup;
     }
-    
-    *type     = Magma_CSR;
-    *location = Magma_CPU;
-    *n_row    = num_rows;
-    *n_col    = num_cols;
-    *nnz      = num_nonzeros;
-    
-    CHECK( magma_index_malloc_cpu( &coo_col, *nnz ) );
-    CHECK( magma_index_malloc_cpu( &coo_row, *nnz ) );
-    CHECK( magma_zmalloc_cpu( &coo_val, *nnz ) );
+    nvalue    = (mm_is_pattern(matcode) ? 0 : (mm_is_complex(matcode) ? 2 : 1));
+    hermitian = mm_is_hermitian(matcode);
+    mirror    = mm_is_symmetric(matcode) || hermitian;
 
-    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf \n", &ROW, &COL, &VAL);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, 0.);
+    // map the entries following the size line
+    offset = ftell( fid );
+    #ifndef _WIN32
+    {
+        struct stat st;
+        if ( offset < 0 || fstat( fileno( fid ), &st ) != 0 ) {
+            info = MAGMA_ERR_UNKNOWN;
+            goto cleanup;
         }
-    } else if (mm_is_pattern(matcode) ) {
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            magma_index_t ROW, COL;
-            
-            fscanf(fid, " %d %d \n", &ROW, &COL );
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( 1.0, 0.);
+        data_size = (size_t) st.st_size;
+        if ( data_size > 0 ) {
+            void *map = mmap( NULL, data_size, PROT_READ, MAP_PRIVATE, fileno( fid ), 0 );
+            if ( map == MAP_FAILED ) {
+                data_size = 0;
+                info = MAGMA_ERR_HOST_ALLOC;
+                goto cleanup;
+            }
+            madvise( map, data_size, MADV_WILLNEED );
+            data = (char*) map;
         }
-    } else if (mm_is_complex(matcode) ){
-        for (magma_int_t i = 0; i < *nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL, VALC;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf %lf\n", &ROW, &COL, &VAL, &VALC);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, VALC);
+    }
+    #else
+    {
+        fseek( fid, 0, SEEK_END );
+        data_size = (size_t) ftell( fid );
+        CHECK( magma_malloc_cpu( (void**) &data, data_size ));
+        fseek( fid, 0, SEEK_SET );
+        if ( fread( data, 1, data_size, fid ) != data_size ) {
+            info = MAGMA_ERR_UNKNOWN;
+            goto cleanup;
         }
-        // printf(" ...successfully read complex matrix... ");
-    } else {
-        printf("\n%% Unrecognized data type\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
     }
+    #endif
     fclose(fid);
     fid = NULL;
+
+    // split entries into line-aligned chunks, several per thread for balance
+    #ifdef _OPENMP
+    nthread = magma_ceildiv( num_nonzeros, MTX_ENTRIES_PER_THREAD );
+    nthread = max( 1, min( nthread, (magma_int_t) omp_get_max_threads() ));
+    #endif
+    nchunk = (nthread > 1 ? 4*nthread : 1);
+    CHECK( magma_malloc_cpu( (void**) &chunk, (nchunk+1)*sizeof(const char*) ));
+    CHECK( magma_malloc_cpu( (void**) &chunk_start, (nchunk+1)*sizeof(magma_int_t) ));
+    CHECK( magma_malloc_cpu( (void**) &chunk_info, nchunk*sizeof(magma_int_t) ));
+    {
+        const char *begin = data + offset, *end = data + data_size;
+        chunk[0] = begin;
+        for( magma_int_t c=1; c < nchunk; ++c ) {
+            const char *p = begin + (end - begin) / nchunk * c;
+            p = max( p, chunk[c-1] );
+            const char *eol = (const char*) memchr( p, '\n', end - p );
+            chunk[c] = (eol == NULL ? end : eol + 1);
+        }
+        chunk[nchunk] = end;
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(nthread)
+    for( magma_int_t c=0; c < nchunk; ++c ) {
+        chunk_start[c+1] = mtx_count_entries( chunk[c], chunk[c+1] );
+    }
+    chunk_start[0] = 0;
+    for( magma_int_t c=0; c < nchunk; ++c ) {
+        chunk_start[c+1] += chunk_start[c];
+    }
+    if ( chunk_start[nchunk] < num_nonzeros ) {
+        printf("\n%% File has %lld entries, expected %lld.\n",
+               (long long) chunk_start[nchunk], (long long) num_nonzeros );
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+
+    CHECK( magma_index_malloc_cpu( &coo_col, num_nonzeros ) );
+    CHECK( magma_index_malloc_cpu( &coo_row, num_nonzeros ) );
+    CHECK( magma_zmalloc_cpu( &coo_val, num_nonzeros ) );
+
+    #pragma omp parallel for schedule(dynamic) num_threads(nthread)
+    for( magma_int_t c=0; c < nchunk; ++c ) {
+        int zero = 0;
+        chunk_info[c] = magma_z_mtx_parse_chunk(
+            chunk[c], chunk[c+1], chunk_start[c], num_nonzeros,
+            num_rows, num_cols, nvalue, coo_row, coo_col, coo_val, &zero );
+        if ( zero ) {
+            #pragma omp atomic write
+            *has_zero = 1;
+        }
+    }
+    for( magma_int_t c=0; c < nchunk; ++c ) {
+        if ( chunk_info[c] != 0 ) {
+            printf("\n%% Invalid entry in Matrix Market file.\n");
+            info = chunk_info[c];
+            goto cleanup;
+        }
+    }
+
+    #ifndef _WIN32
+    munmap( data, data_size );
+    #else
+    magma_free_cpu( data );
+    #endif
+    data = NULL;
     printf(" done. Converting to CSR:");
     fflush(stdout);
+
+    *sym = Magma_GENERAL;
+    if ( mirror ) {
+        printf("\n%% Detected symmetric case.");
+        *sym = Magma_SYMMETRIC;
+    }
+
+    // bucket entries by row; per-thread counts in count[ t*num_rows + i ]
+    if ( num_rows > 0 ) {
+        int64_t max_threads = int64_t( MTX_COUNT_PER_NNZ ) * num_nonzeros / num_rows;
+        if ( max_threads < nthread ) {
+            nthread = max( (magma_int_t) max_threads, (magma_int_t) 1 );
+        }
+    }
+    CHECK( magma_index_malloc_cpu( row, num_rows+1 ));
+    CHECK( magma_index_malloc_cpu( &count, size_t(nthread) * num_rows ));
+    #pragma omp parallel num_threads(nthread)
+    {
+        #ifdef _OPENMP
+        magma_int_t id = omp_get_thread_num();
+        magma_int_t nt = omp_get_num_threads();
+        #else
+        magma_int_t id = 0;
+        magma_int_t nt = 1;
+        #endif
+        magma_index_t *cnt = count + size_t(id) * num_rows;
+        magma_int_t first = (magma_int_t) ( (double) num_nonzeros * id / nt );
+        magma_int_t last  = (magma_int_t) ( (double) num_nonzeros * (id+1) / nt );
+
+        for( magma_int_t i=0; i < num_rows; ++i ) {
+            cnt[i] = 0;
+        }
+        for( magma_int_t i=first; i < last; ++i ) {
+            cnt[ coo_row[i] ]++;
+            if ( mirror && coo_row[i] != coo_col[i] ) {
+                cnt[ coo_col[i] ]++;
+            }
+        }
+        #pragma omp barrier
+
+        #pragma omp for
+        for( magma_int_t i=0; i < num_rows; ++i ) {
+            magma_index_t sum = 0;
+            for( magma_int_t t=0; t < nt; ++t ) {
+                magma_index_t tmp = count[ size_t(t) * num_rows + i ];
+                count[ size_t(t) * num_rows + i ] = sum;
+                sum += tmp;
+            }
+            (*row)[i+1] = sum;
+        }
+
+        #pragma omp single
+        {
+            (*row)[0] = 0;
+            for( magma_int_t i=0; i < num_rows; ++i ) {
+                (*row)[i+1] += (*row)[i];
+            }
+            nentry = (*row)[num_rows];
+            if ( magma_index_malloc_cpu( col, nentry ) != 0 ||
+                 magma_zmalloc_cpu( val, nentry ) != 0 ) {
+                info = MAGMA_ERR_HOST_ALLOC;
+            }
+        }
+
+        if ( info == 0 ) {
+            for( magma_int_t i=first; i < last; ++i ) {
+                magma_index_t r = coo_row[i], c = coo_col[i];
+                magma_index_t dest = (*row)[r] + cnt[r]++;
+                (*col)[dest] = c;
+                (*val)[dest] = coo_val[i];
+                if ( mirror && r != c ) {
+                    dest = (*row)[c] + cnt[c]++;
+                    (*col)[dest] = r;
+                    (*val)[dest] = (hermitian == 0) ? coo_val[i] : conj(coo_val[i]);
+                }
+            }
+            #pragma omp barrier
+
+            // sort column indices within each row
+            // copy into vector of pairs (column index, value), sort by column index, then copy back
+            std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
+            #pragma omp for schedule(dynamic, 1024)
+            for( magma_int_t k=0; k < num_rows; ++k ) {
+                magma_index_t kk  = (*row)[k];
+                magma_index_t len = (*row)[k+1] - (*row)[k];
+                bool sorted = true;
+                for( magma_index_t i=1; i < len && sorted; ++i ) {
+                    sorted = ( (*col)[kk+i-1] <= (*col)[kk+i] );
+                }
+                if ( sorted )
+                    continue;
+                rowval.resize( len );
+                for( magma_index_t i=0; i < len; ++i ) {
+                    rowval[i] = std::make_pair( (*col)[kk+i], (*val)[kk+i] );
+                }
+                std::stable_sort( rowval.begin(), rowval.end(), compare_first );
+                for( magma_index_t i=0; i < len; ++i ) {
+                    (*col)[kk+i] = rowval[i].first;
+                    (*val)[kk+i] = rowval[i].second;
+                }
+            }
+        }
+    }
+    if ( info != 0 )
+        goto cleanup;
+
+    *n_row = num_rows;
+    *n_col = num_cols;
+    *nnz   = nentry;
+
+cleanup:
+    if ( fid != NULL ) {
+        fclose( fid );
+        fid = NULL;
+    }
+    if ( data != NULL ) {
+        #ifndef _WIN32
+        munmap( data, data_size );
+        #else
+        magma_free_cpu( data );
+        #endif
+    }
+    if ( info != 0 ) {
+        magma_free_cpu( *val );
+        magma_free_cpu( *row );
+        magma_free_cpu( *col );
+        *val = NULL;
+        *row = NULL;
+        *col = NULL;
+    }
+    magma_free_cpu( chunk );
+    magma_free_cpu( chunk_start );
+    magma_free_cpu( chunk_info );
+    magma_free_cpu( count );
+    magma_free_cpu( coo_row );
+    magma_free_cpu( coo_col );
+    magma_free_cpu( coo_val );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Reads in a matrix stored in coo format from a Matrix Market (.mtx)
+    file and converts it into CSR format. It duplicates the off-diagonal
+    entries in the symmetric case.
+
+    Arguments
+    ---------
     
+    @param[out]
+    type        magma_storage_t*
+                storage type of matrix
+                
+    @param[out]
+    location    magma_location_t*
+                location of matrix
+                
+    @param[out]
+    n_row       magma_int_t*
+                number of rows in matrix
+                
+    @param[out]
+    n_col       magma_int_t*
+                number of columns in matrix
+                
+    @param[out]
+    nnz         magma_int_t*
+                number of nonzeros in matrix
+                
+    @param[out]
+    val         magmaDoubleComplex**
+                value array of CSR output
 
-    if( mm_is_hermitian(matcode) ) {
-        hermitian = 1;
-        printf("hermitian case!\n\n\n");
-    }
-    if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) { 
-                                        // duplicate off diagonal entries
-        printf("\n%% Detected symmetric case.");
-        
-        magma_index_t off_diagonals = 0;
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            if (coo_row[i] != coo_col[i])
-                ++off_diagonals;
-        }
-        magma_index_t true_nonzeros = 2*off_diagonals + (*nnz - off_diagonals);
-        
-        //printf("%% total number of nonzeros: %d\n%%", int(*nnz));
+    @param[out]
+    row         magma_index_t**
+                row pointer of CSR output
 
-        CHECK( magma_index_malloc_cpu( &new_row, true_nonzeros ));
-        CHECK( magma_index_malloc_cpu( &new_col, true_nonzeros ));
-        CHECK( magma_zmalloc_cpu( &new_val, true_nonzeros ));
-    
-        magma_index_t ptr = 0;
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            if (coo_row[i] != coo_col[i]) {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-                new_col[ptr] = coo_row[i];
-                new_row[ptr] = coo_col[i];
-                new_val[ptr] = (hermitian == 0) ? coo_val[i] : conj(coo_val[i]);
-                ptr++;
-            } else {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-            }
-        }
-        
-        magma_free_cpu(coo_row); 
-        magma_free_cpu(coo_col); 
-        magma_free_cpu(coo_val);
+    @param[out]
+    col         magma_index_t**
+                column indices of CSR output
 
-        coo_row = new_row;
-        coo_col = new_col;
-        coo_val = new_val;
-        
-        *nnz = true_nonzeros;
-    } // end symmetric case
-    
-    CHECK( magma_zmalloc_cpu( val, *nnz ) );
-    
-    CHECK( magma_index_malloc_cpu( col, *nnz ) );
-    CHECK( magma_index_malloc_cpu( row, (*n_row+1) ) );
-    CHECK( magma_zmalloc_cpu( val, *nnz ) );
+    @param[in]
+    filename    const char*
+                filname of the mtx matrix
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
 
-    // original code from  Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (*row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < *nnz; i++)
-        (*row)[coo_row[i]]++;
-    
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (*row)[i];
-        (*row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (*row)[num_rows] = *nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < *nnz; i++) {
-        magma_index_t row_  = coo_row[i];
-        magma_index_t dest = (*row)[row_];
-        (*col)[dest] = coo_col[i];
-        (*val)[dest] = coo_val[i];
-        (*row)[row_]++;
-    }
-    
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp  = (*row)[i];
-        (*row)[i] = last;
-        last      = temp;
-    }
-    
-    (*row)[*n_row] = *nnz;
+    @ingroup magmasparse_zaux
+    ********************************************************************/
 
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < *n_row; ++k) {
-        int kk  = (*row)[k];
-        int len = (*row)[k+1] - (*row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (*col)[kk+i], (*val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (*col)[kk+i] = rowval[i].first;
-            (*val)[kk+i] = rowval[i].second;
-        }
-    }
+extern "C"
+magma_int_t read_z_csr_from_mtx(
+    magma_storage_t *type,
+    magma_location_t *location,
+    magma_int_t* n_row,
+    magma_int_t* n_col,
+    magma_int_t* nnz,
+    magmaDoubleComplex **val,
+    magma_index_t **row,
+    magma_index_t **col,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_symmetry_t sym;
+    int has_zero;
 
+    CHECK( magma_z_mtx_read_csr( filename, n_row, n_col, nnz, val, row, col,
+                                 &sym, &has_zero, queue ));
+    *type     = Magma_CSR;
+    *location = Magma_CPU;
     printf(" done.\n");
+
 cleanup:
-    if ( fid != NULL ) {
-        fclose( fid );
-        fid = NULL;
-    }
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
     return info;
 }
 
@@ -920,6 +1274,7 @@ cleanup:
     Reads in a matrix stored in coo format from a Matrix Market (.mtx)
     file and converts it into CSR format. It duplicates the off-diagonal
     entries in the symmetric case.
+    Binary files written by magma_zwrite_csr_bin are also accepted.
 
     Arguments
     ---------
@@ -945,239 +1300,32 @@ magma_z_csr_mtx(
     const char *filename,
     magma_queue_t queue )
 {
-    char buffer[ 1024 ];
     magma_int_t info = 0;
 
     int csr_compressor = 0;       // checks for zeros in original file
     
     magma_z_matrix B={Magma_CSR};
-
-    magma_index_t *coo_col = NULL;
-    magma_index_t *coo_row = NULL;
-    magmaDoubleComplex *coo_val = NULL;
-    magmaDoubleComplex *new_val = NULL;
-    magma_index_t* new_row = NULL;
-    magma_index_t* new_col = NULL;
-    magma_int_t hermitian = 0;
+    magma_symmetry_t sym = Magma_GENERAL;
     
     // make sure the target structure is empty
     magma_zmfree( A, queue );
     A->ownership = MagmaTrue;
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
-    
-    FILE *fid = NULL;
-    MM_typecode matcode;
-    fid = fopen(filename, "r");
-    
-    if (fid == NULL) {
-        printf("%% Unable to open file %s\n", filename);
-        info = MAGMA_ERR_NOT_FOUND;
-        goto cleanup;
-    }
-    
-    printf("%% Reading sparse matrix from file (%s):", filename);
-    fflush(stdout);
-    
-    if (mm_read_banner(fid, &matcode) != 0) {
-        printf("\n%% Could not process Matrix Market banner: %s.\n", matcode);
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
-    }
     
-    if (!mm_is_valid(matcode)) {
-        printf("\n%% Invalid Matrix Market file.\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
-    }
-    
-    if ( ! ( ( mm_is_real(matcode)    ||
-               mm_is_integer(matcode) ||
-               mm_is_pattern(matcode) ||
-               mm_is_complex(matcode) ) &&
-             mm_is_coordinate(matcode)  &&
-             mm_is_sparse(matcode) ) )
-    {
-        mm_snprintf_typecode( buffer, sizeof(buffer), matcode );
-        printf("\n%% Sorry, MAGMA-sparse does not support Market Market type: [%s]\n", buffer );
-        printf("%% Only real-valued or pattern coordinate matrices are supported.\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
-    }
-
-    magma_index_t num_rows, num_cols, num_nonzeros;
-    if (mm_read_mtx_crd_size(fid, &num_rows, &num_cols, &num_nonzeros) != 0) {
-        info = MAGMA_ERR_UNKNOWN;
+    // binary file from magma_zwrite_csr_bin: copy the mapped matrix
+    if ( magma_mcsr_is_binary( filename ) ) {
+        CHECK( magma_zread_csr_bin( &B, filename, queue ));
+        info = magma_zmtransfer( B, A, Magma_CPU, Magma_CPU, queue );
+        magma_zclose_csr_bin( &B, queue );
         goto cleanup;
     }
     
+    CHECK( magma_z_mtx_read_csr( filename, &A->num_rows, &A->num_cols, &A->nnz,
+                                 &A->val, &A->row, &A->col,
+                                 &sym, &csr_compressor, queue ));
     A->storage_type    = Magma_CSR;
     A->memory_location = Magma_CPU;
-    A->num_rows        = num_rows;
-    A->num_cols        = num_cols;
-    A->nnz             = num_nonzeros;
     A->fill_mode       = MagmaFull;
-    
-    CHECK( magma_index_malloc_cpu( &coo_col, A->nnz ) );
-    CHECK( magma_index_malloc_cpu( &coo_row, A->nnz ) );
-    CHECK( magma_zmalloc_cpu( &coo_val, A->nnz ) );
-
-    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf \n", &ROW, &COL, &VAL);
-            if ( VAL == 0 )
-                csr_compressor = 1;
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, 0.);
-        }
-    } else if (mm_is_pattern(matcode) ) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            
-            fscanf(fid, " %d %d \n", &ROW, &COL );
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( 1.0, 0.);
-        }
-    } else if (mm_is_complex(matcode) ){
-        for (magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL, VALC;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf %lf\n", &ROW, &COL, &VAL, &VALC);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, VALC);
-        }
-        // printf(" ...successfully read complex matrix... ");
-    } else {
-        printf("\n%% Unrecognized data type\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
-    }
-    fclose(fid);
-    fid = NULL;
-    printf(" done. Converting to CSR:");
-    fflush(stdout);
-    
-    A->sym = Magma_GENERAL;
-
-
-    if( mm_is_hermitian(matcode) ) {
-        hermitian = 1;
-    }
-    if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) { 
-                                        // duplicate off diagonal entries
-        printf("\n%% Detected symmetric case.");
-        A->sym = Magma_SYMMETRIC;
-        magma_index_t off_diagonals = 0;
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            if (coo_row[i] != coo_col[i])
-                ++off_diagonals;
-        }
-        magma_index_t true_nonzeros = 2*off_diagonals + (A->nnz - off_diagonals);
-        
-        //printf("%% total number of nonzeros: %d\n%%", int(A->nnz));
-
-        CHECK( magma_index_malloc_cpu( &new_row, true_nonzeros ));
-        CHECK( magma_index_malloc_cpu( &new_col, true_nonzeros ));
-        CHECK( magma_zmalloc_cpu( &new_val, true_nonzeros ));
-        
-        magma_index_t ptr = 0;
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            if (coo_row[i] != coo_col[i]) {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-                new_col[ptr] = coo_row[i];
-                new_row[ptr] = coo_col[i];
-                new_val[ptr] = (hermitian == 0) ? coo_val[i] : conj(coo_val[i]);
-                ptr++;
-            } else {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-            }
-        }
-        
-        magma_free_cpu(coo_row);
-        magma_free_cpu(coo_col);
-        magma_free_cpu(coo_val);
-
-        coo_row = new_row;
-        coo_col = new_col;
-        coo_val = new_val;
-        A->nnz = true_nonzeros;
-        //printf("total number of nonzeros: %d\n", A->nnz);
-    } // end symmetric case
-    
-    CHECK( magma_zmalloc_cpu( &A->val, A->nnz ));
-    CHECK( magma_index_malloc_cpu( &A->col, A->nnz ));
-    CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ));
-    
-    // original code from Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (A->row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < A->nnz; i++)
-        (A->row)[coo_row[i]]++;
-        
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (A->row)[i];
-        (A->row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (A->row)[num_rows] = A->nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < A->nnz; i++) {
-        magma_index_t row_ = coo_row[i];
-        magma_index_t dest = (A->row)[row_];
-        (A->col)[dest] = coo_col[i];
-        (A->val)[dest] = coo_val[i];
-        (A->row)[row_]++;
-    }    
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
-    coo_row = NULL;
-    coo_col = NULL;
-    coo_val = NULL;
-
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp    = (A->row)[i];
-        (A->row)[i] = last;
-        last        = temp;
-    }
-    (A->row)[A->num_rows] = A->nnz;
-    
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < A->num_rows; ++k) {
-        int kk  = (A->row)[k];
-        int len = (A->row)[k+1] - (A->row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (A->col)[kk+i], (A->val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (A->col)[kk+i] = rowval[i].first;
-            (A->val)[kk+i] = rowval[i].second;
-        }
-    }
+    A->sym             = sym;
 
     if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
         //printf("removing zeros: ");
@@ -1185,7 +1333,7 @@ magma_z_csr_mtx(
         CHECK( magma_z_csr_compressor(
             &(A->val), &(A->row), &(A->col),
             &B.val, &B.row, &B.col, &B.num_rows, queue ));
-        B.nnz = B.row[num_rows];
+        B.nnz = B.row[B.num_rows];
         //printf(" remaining nonzeros:%d ", B.nnz);
         magma_free_cpu( A->val );
         magma_free_cpu( A->row );
@@ -1197,14 +1345,7 @@ magma_z_csr_mtx(
     A->true_nnz = A->nnz;
     printf(" done.\n");
 cleanup:
-    if ( fid != NULL ) {
-        fclose( fid );
-        fid = NULL;
-    }
     magma_zmfree( &B, queue );
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
     return info;
 }
 
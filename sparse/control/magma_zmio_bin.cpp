@@ -0,0 +1,445 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+static_assert( sizeof(magma_mcsr_header) == 128, "magma_mcsr_header must be 128 bytes" );
+
+// number of components per value, stored in the header
+#if defined(PRECISION_z) || defined(PRECISION_c)
+#define NCOMPONENT 2
+#else
+#define NCOMPONENT 1
+#endif
+
+
+/**
+    Purpose
+    -------
+    Returns true if storage is written as CSR arrays (row, col, val).
+*/
+static bool is_csr_storage( magma_storage_t storage )
+{
+    return (storage == Magma_CSR  || storage == Magma_CSRL ||
+            storage == Magma_CSRU || storage == Magma_CSRD);
+}
+
+
+/**
+    Purpose
+    -------
+    Rounds offset up to a multiple of MAGMA_MCSR_ALIGN.
+*/
+static int64_t mcsr_align( int64_t offset )
+{
+    return (offset + MAGMA_MCSR_ALIGN - 1) / MAGMA_MCSR_ALIGN * MAGMA_MCSR_ALIGN;
+}
+
+
+/**
+    Purpose
+    -------
+    Checks a header read from a file of file_size bytes against the
+    precision and index type of this build.
+    Returns 0, or MAGMA_ERR_NOT_SUPPORTED with a message.
+*/
+static magma_int_t
+magma_zmcsr_check_header( const magma_mcsr_header *h, int64_t file_size )
+{
+    magma_int_t info = 0;
+    bool csr = is_csr_storage( (magma_storage_t) h->storage_type );
+    if ( memcmp( h->magic, MAGMA_MCSR_MAGIC, sizeof(h->magic) ) != 0 ) {
+        printf("%% Not a binary MAGMA sparse matrix file.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    else if ( h->version != MAGMA_MCSR_VERSION || h->endian != MAGMA_MCSR_ENDIAN ) {
+        printf("%% Unsupported version or byte order of binary matrix file.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    else if ( h->index_size != (int32_t) sizeof(magma_index_t) ||
+              h->value_size != (int32_t) sizeof(magmaDoubleComplex) ||
+              h->ncomponent != NCOMPONENT ) {
+        printf("%% Binary matrix file has a different precision or index size.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    else if ( ! csr && h->storage_type != Magma_DENSE ) {
+        printf("%% Binary matrix file has unsupported storage type.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    else if ( h->num_rows < 0 || h->num_cols < 0 || h->nnz < 0
+              || h->file_size > file_size
+              || h->val_offset % MAGMA_MCSR_ALIGN != 0
+              || h->val_offset + h->nnz * h->value_size > h->file_size
+              || (csr && ( h->row_offset % MAGMA_MCSR_ALIGN != 0
+                        || h->col_offset % MAGMA_MCSR_ALIGN != 0
+                        || h->row_offset + (h->num_rows+1) * h->index_size > h->col_offset
+                        || h->col_offset + h->nnz * h->index_size > h->val_offset ))
+              || (! csr && h->nnz != h->num_rows * h->num_cols) ) {
+        printf("%% Binary matrix file is truncated or corrupt.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Writes a matrix to a binary file (.mcsr) that magma_zread_csr_bin can
+    map into memory without parsing. The file holds a header
+    (magma_mcsr_header), the row pointer, column indices, and values, each
+    aligned to MAGMA_MCSR_ALIGN bytes.
+
+    CSR, CSRL, CSRU, and CSRD matrices are written as they are; dense
+    matrices and vectors (Magma_DENSE) as values only. Other formats are
+    converted to CSR, and matrices on the device are copied to the host first.
+    The file is specific to the precision and the index size of the build.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix or dense vector
+
+    @param[in]
+    filename    const char*
+                output filename
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zwrite_csr_bin(
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix B={Magma_CSR}, C={Magma_CSR};
+    magma_mcsr_header h;
+    const char zeros[ MAGMA_MCSR_ALIGN ] = { 0 };
+    FILE *fp = NULL;
+    bool csr;
+
+    // bring the matrix to the host, in CSR unless dense
+    if ( A.memory_location != Magma_CPU ) {
+        CHECK( magma_zmtransfer( A, &B, A.memory_location, Magma_CPU, queue ));
+    } else {
+        B = A;
+        B.ownership = MagmaFalse;  // view only; not freed at cleanup
+    }
+    if ( ! is_csr_storage( B.storage_type ) && B.storage_type != Magma_DENSE ) {
+        CHECK( magma_zmconvert( B, &C, B.storage_type, Magma_CSR, queue ));
+        magma_zmfree( &B, queue );
+        B = C;
+        C = {Magma_CSR};
+    }
+    csr = is_csr_storage( B.storage_type );
+
+    memset( &h, 0, sizeof(h) );
+    memcpy( h.magic, MAGMA_MCSR_MAGIC, sizeof(h.magic) );
+    h.version      = MAGMA_MCSR_VERSION;
+    h.endian       = MAGMA_MCSR_ENDIAN;
+    h.index_size   = sizeof(magma_index_t);
+    h.value_size   = sizeof(magmaDoubleComplex);
+    h.ncomponent   = NCOMPONENT;
+    h.storage_type = B.storage_type;
+    h.sym          = B.sym;
+    h.fill_mode    = B.fill_mode;
+    h.major        = B.major;
+    h.num_rows     = B.num_rows;
+    h.num_cols     = B.num_cols;
+    if ( csr ) {
+        h.nnz        = B.row[ B.num_rows ];
+        h.row_offset = mcsr_align( sizeof(h) );
+        h.col_offset = mcsr_align( h.row_offset + (h.num_rows+1) * h.index_size );
+        h.val_offset = mcsr_align( h.col_offset + h.nnz * h.index_size );
+    } else {
+        h.nnz        = h.num_rows * h.num_cols;
+        h.val_offset = mcsr_align( sizeof(h) );
+    }
+    h.file_size = h.val_offset + h.nnz * h.value_size;
+
+    printf("%% Writing binary matrix to file (%s):", filename);
+    fflush(stdout);
+
+    fp = fopen( filename, "wb" );
+    if ( fp == NULL ) {
+        printf("\n%% error writing matrix: missing write permission\n");
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    // each array is followed by padding up to the next offset
+    if ( fwrite( &h, sizeof(h), 1, fp ) != 1 ) {
+        info = MAGMA_ERR_UNKNOWN;
+    }
+    if ( info == 0 && csr ) {
+        int64_t pos = sizeof(h);
+        if ( fwrite( zeros, 1, h.row_offset - pos, fp ) != size_t( h.row_offset - pos )
+             || fwrite( B.row, h.index_size, h.num_rows+1, fp ) != size_t( h.num_rows+1 ) ) {
+            info = MAGMA_ERR_UNKNOWN;
+        }
+        pos = h.row_offset + (h.num_rows+1) * h.index_size;
+        if ( info == 0 &&
+             ( fwrite( zeros, 1, h.col_offset - pos, fp ) != size_t( h.col_offset - pos )
+               || fwrite( B.col, h.index_size, h.nnz, fp ) != size_t( h.nnz ) )) {
+            info = MAGMA_ERR_UNKNOWN;
+        }
+        pos = h.col_offset + h.nnz * h.index_size;
+        if ( info == 0 &&
+             fwrite( zeros, 1, h.val_offset - pos, fp ) != size_t( h.val_offset - pos )) {
+            info = MAGMA_ERR_UNKNOWN;
+        }
+    }
+    else if ( info == 0 ) {
+        int64_t pos = sizeof(h);
+        if ( fwrite( zeros, 1, h.val_offset - pos, fp ) != size_t( h.val_offset - pos )) {
+            info = MAGMA_ERR_UNKNOWN;
+        }
+    }
+    if ( info == 0 &&
+         fwrite( B.val, h.value_size, h.nnz, fp ) != size_t( h.nnz )) {
+        info = MAGMA_ERR_UNKNOWN;
+    }
+    if ( fclose( fp ) != 0 ) {
+        info = MAGMA_ERR_UNKNOWN;
+    }
+    fp = NULL;
+    if ( info != 0 ) {
+        printf("\n%% error writing matrix\n");
+        goto cleanup;
+    }
+    printf(" done.\n");
+
+cleanup:
+    if ( fp != NULL ) {
+        fclose( fp );
+    }
+    magma_zmfree( &B, queue );
+    magma_zmfree( &C, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Reads a matrix written by magma_zwrite_csr_bin.
+
+    The file is memory-mapped and A points into the mapping: no data is
+    copied or parsed, and pages are loaded on first access. A->ownership is
+    MagmaFalse, so magma_zmfree does not release the arrays; release the
+    mapping with magma_zclose_csr_bin instead. The mapping is private:
+    modifying A does not change the file.
+    On Windows, the arrays are read into memory owned by A.
+
+    To get a regular matrix owned by MAGMA, use magma_z_csr_mtx, which also
+    accepts binary files.
+
+    Arguments
+    ---------
+
+    @param[out]
+    A           magma_z_matrix*
+                matrix view of the file
+
+    @param[in]
+    filename    const char*
+                filename of the binary matrix
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zread_csr_bin(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_mcsr_header h;
+    char *base = NULL;
+    int64_t file_size = 0;
+
+    // make sure the target structure is empty
+    magma_zmfree( A, queue );
+
+    #ifndef _WIN32
+    int fd = open( filename, O_RDONLY );
+    if ( fd < 0 ) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    {
+        struct stat st;
+        if ( fstat( fd, &st ) != 0 || st.st_size < (off_t) sizeof(h) ) {
+            printf("%% Binary matrix file is truncated or corrupt.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        file_size = st.st_size;
+    }
+    if ( pread( fd, &h, sizeof(h), 0 ) != (ssize_t) sizeof(h) ) {
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    CHECK( magma_zmcsr_check_header( &h, file_size ));
+    {
+        // copy-on-write mapping, so the matrix can be modified in memory
+        void *map = mmap( NULL, h.file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+        if ( map == MAP_FAILED ) {
+            info = MAGMA_ERR_HOST_ALLOC;
+            goto cleanup;
+        }
+        base = (char*) map;
+    }
+    A->ownership = MagmaFalse;
+    #else
+    FILE *fid = fopen( filename, "rb" );
+    if ( fid == NULL ) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    fseek( fid, 0, SEEK_END );
+    file_size = ftell( fid );
+    fseek( fid, 0, SEEK_SET );
+    if ( file_size < (int64_t) sizeof(h) || fread( &h, sizeof(h), 1, fid ) != 1 ) {
+        printf("%% Binary matrix file is truncated or corrupt.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    CHECK( magma_zmcsr_check_header( &h, file_size ));
+    CHECK( magma_malloc_cpu( (void**) &base, h.file_size ));
+    fseek( fid, 0, SEEK_SET );
+    if ( fread( base, 1, h.file_size, fid ) != size_t( h.file_size )) {
+        magma_free_cpu( base );
+        base = NULL;
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    A->ownership = MagmaFalse;
+    #endif
+
+    A->storage_type    = (magma_storage_t) h.storage_type;
+    A->memory_location = Magma_CPU;
+    A->sym             = (magma_symmetry_t) h.sym;
+    A->fill_mode       = (magma_uplo_t) h.fill_mode;
+    A->major           = (magma_order_t) h.major;
+    A->num_rows        = h.num_rows;
+    A->num_cols        = h.num_cols;
+    A->nnz             = h.nnz;
+    A->true_nnz        = h.nnz;
+    A->mapping         = base;
+    A->mapping_size    = size_t( h.file_size );
+    A->val             = (magmaDoubleComplex*) (base + h.val_offset);
+    if ( is_csr_storage( A->storage_type )) {
+        A->row = (magma_index_t*) (base + h.row_offset);
+        A->col = (magma_index_t*) (base + h.col_offset);
+        if ( A->row[0] != 0 || A->row[ A->num_rows ] != A->nnz ) {
+            printf("%% Binary matrix file is truncated or corrupt.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            magma_zclose_csr_bin( A, queue );
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    #ifndef _WIN32
+    if ( fd >= 0 ) {
+        close( fd );  // the mapping stays valid
+    }
+    #else
+    if ( fid != NULL ) {
+        fclose( fid );
+    }
+    #endif
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Releases a matrix read by magma_zread_csr_bin, unmapping the file,
+    and resets A to an empty matrix. The mapping is recorded in A->mapping;
+    matrices without one are passed to magma_zmfree, which frees only
+    arrays owned by MAGMA.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    A           magma_z_matrix*
+                matrix view from magma_zread_csr_bin
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zclose_csr_bin(
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( A->mapping != NULL ) {
+        if ( A->ownership != MagmaFalse || A->memory_location != Magma_CPU ) {
+            info = MAGMA_ERR_INVALID_PTR;
+            goto cleanup;
+        }
+        #ifndef _WIN32
+        munmap( A->mapping, A->mapping_size );
+        #else
+        magma_free_cpu( A->mapping );
+        #endif
+        *A = {Magma_CSR};
+    }
+    else {
+        magma_zmfree( A, queue );
+    }
+
+cleanup:
+    return info;
+}
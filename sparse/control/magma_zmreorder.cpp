@@ -0,0 +1,1004 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include "magmasparse_internal.h"
+
+// nested dissection: subgraphs with at most this many vertices are not
+// bisected further, but ordered by approximate minimum degree
+#define MREORDER_ND_LEAF    128
+
+// nested dissection: the bisection coarsens the graph until it has at most
+// this many vertices, or until a matching shrinks it by less than 10%
+#define MREORDER_ND_COARSE  64
+
+// nested dissection: passes of the boundary refinement on every level
+#define MREORDER_ND_PASSES  4
+
+
+// Undirected graph in CSR layout, with vertex and edge weights.
+// For a matrix A, the structure of A + A^T without the diagonal.
+typedef struct magma_zmreorder_graph
+{
+    magma_int_t n;
+    std::vector< magma_index_t > ptr;
+    std::vector< magma_index_t > adj;
+    std::vector< magma_index_t > vwgt;
+    std::vector< magma_index_t > ewgt;
+} magma_zmreorder_graph;
+
+
+// orders vertices by increasing degree, ties by index
+struct magma_zmreorder_degree_less
+{
+    const magma_zmreorder_graph *G;
+
+    bool operator()( magma_index_t a, magma_index_t b ) const
+    {
+        magma_index_t da = G->ptr[a+1] - G->ptr[a];
+        magma_index_t db = G->ptr[b+1] - G->ptr[b];
+        return da < db || ( da == db && a < b );
+    }
+};
+
+
+// graph of A + A^T without the diagonal, with unit weights
+static void
+magma_zmreorder_matrix_graph(
+    magma_z_matrix A,
+    magma_zmreorder_graph &G )
+{
+    magma_int_t n = A.num_rows;
+
+    G.n = n;
+    G.ptr.assign( n+1, 0 );
+    for( magma_int_t i=0; i < n; i++ ) {
+        for( magma_index_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            magma_index_t c = A.col[j];
+            if ( c != i ) {
+                G.ptr[i+1]++;
+                G.ptr[c+1]++;
+            }
+        }
+    }
+    for( magma_int_t i=0; i < n; i++ ) {
+        G.ptr[i+1] += G.ptr[i];
+    }
+    G.adj.resize( G.ptr[n] );
+    std::vector< magma_index_t > fill( G.ptr.begin(), G.ptr.end()-1 );
+    for( magma_int_t i=0; i < n; i++ ) {
+        for( magma_index_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            magma_index_t c = A.col[j];
+            if ( c != i ) {
+                G.adj[ fill[i]++ ] = c;
+                G.adj[ fill[c]++ ] = i;
+            }
+        }
+    }
+
+    // sort the adjacency lists and remove duplicate edges
+    magma_index_t nnz = 0, begin = 0;
+    for( magma_int_t i=0; i < n; i++ ) {
+        magma_index_t end = G.ptr[i+1];
+        std::sort( G.adj.begin() + begin, G.adj.begin() + end );
+        G.ptr[i] = nnz;
+        for( magma_index_t k=begin; k < end; k++ ) {
+            if ( k == begin || G.adj[k] != G.adj[k-1] ) {
+                G.adj[ nnz++ ] = G.adj[k];
+            }
+        }
+        begin = end;
+    }
+    G.ptr[n] = nnz;
+    G.adj.resize( nnz );
+    G.vwgt.assign( n, 1 );
+    G.ewgt.assign( nnz, 1 );
+}
+
+
+// subgraph of G induced by verts[0:nv-1], with unit weights;
+// map has to be -1 for all vertices of G, and is restored on exit
+static void
+magma_zmreorder_subgraph(
+    const magma_zmreorder_graph &G,
+    const magma_index_t *verts,
+    magma_int_t nv,
+    magma_index_t *map,
+    magma_zmreorder_graph &S )
+{
+    for( magma_int_t k=0; k < nv; k++ ) {
+        map[ verts[k] ] = k;
+    }
+    S.n = nv;
+    S.ptr.assign( nv+1, 0 );
+    S.adj.clear();
+    for( magma_int_t k=0; k < nv; k++ ) {
+        magma_index_t v = verts[k];
+        for( magma_index_t j=G.ptr[v]; j < G.ptr[v+1]; j++ ) {
+            if ( map[ G.adj[j] ] >= 0 ) {
+                S.adj.push_back( map[ G.adj[j] ] );
+            }
+        }
+        S.ptr[k+1] = S.adj.size();
+    }
+    S.vwgt.assign( nv, 1 );
+    S.ewgt.assign( S.adj.size(), 1 );
+    for( magma_int_t k=0; k < nv; k++ ) {
+        map[ verts[k] ] = -1;
+    }
+}
+
+
+// Breadth-first search from root over the vertices with level < 0.
+// Appends the visited vertices to order[*len], sets their level,
+// and returns the number of levels.
+static magma_int_t
+magma_zmreorder_bfs(
+    const magma_zmreorder_graph &G,
+    magma_index_t root,
+    magma_index_t *level,
+    magma_index_t *order,
+    magma_int_t *len )
+{
+    magma_int_t head = *len, tail = *len, nlevels = 1;
+
+    level[root] = 0;
+    order[tail++] = root;
+    while ( head < tail ) {
+        magma_index_t v = order[head++];
+        for( magma_index_t j=G.ptr[v]; j < G.ptr[v+1]; j++ ) {
+            magma_index_t u = G.adj[j];
+            if ( level[u] < 0 ) {
+                level[u] = level[v] + 1;
+                nlevels = level[u] + 1;
+                order[tail++] = u;
+            }
+        }
+    }
+    *len = tail;
+    return nlevels;
+}
+
+
+// Pseudo-peripheral vertex (George and Liu) of the connected component
+// of root. Only vertices with level < 0 are searched; level is restored
+// on exit, order is workspace.
+static magma_index_t
+magma_zmreorder_peripheral(
+    const magma_zmreorder_graph &G,
+    magma_index_t root,
+    magma_index_t *level,
+    magma_index_t *order )
+{
+    magma_int_t len = 0;
+    magma_int_t ecc = magma_zmreorder_bfs( G, root, level, order, &len );
+
+    while ( true ) {
+        // vertex of minimum degree in the last level
+        magma_index_t cand = order[len-1];
+        for( magma_int_t k=len-1; k >= 0 && level[ order[k] ] == ecc-1; k-- ) {
+            magma_index_t v = order[k];
+            if ( G.ptr[v+1] - G.ptr[v] < G.ptr[cand+1] - G.ptr[cand] ) {
+                cand = v;
+            }
+        }
+        for( magma_int_t k=0; k < len; k++ ) {
+            level[ order[k] ] = -1;
+        }
+        len = 0;
+        magma_int_t e = magma_zmreorder_bfs( G, cand, level, order, &len );
+        if ( e <= ecc ) {
+            break;
+        }
+        root = cand;
+        ecc = e;
+    }
+    for( magma_int_t k=0; k < len; k++ ) {
+        level[ order[k] ] = -1;
+    }
+    return root;
+}
+
+
+// reverse Cuthill-McKee ordering of G
+static void
+magma_zmreorder_rcm(
+    const magma_zmreorder_graph &G,
+    magma_index_t *perm )
+{
+    magma_int_t n = G.n, len = 0;
+    std::vector< magma_index_t > level( n, -1 ), work( n );
+    std::vector< char > visited( n, 0 );
+    magma_zmreorder_degree_less less = { &G };
+
+    for( magma_int_t s=0; s < n; s++ ) {
+        if ( visited[s] ) {
+            continue;
+        }
+        // Cuthill-McKee in this component, neighbors by increasing degree
+        magma_index_t root = magma_zmreorder_peripheral( G, s, &level[0], &work[0] );
+        magma_int_t head = len;
+        visited[root] = 1;
+        perm[len++] = root;
+        while ( head < len ) {
+            magma_index_t v = perm[head++];
+            magma_int_t first = len;
+            for( magma_index_t j=G.ptr[v]; j < G.ptr[v+1]; j++ ) {
+                magma_index_t u = G.adj[j];
+                if ( ! visited[u] ) {
+                    visited[u] = 1;
+                    perm[len++] = u;
+                }
+            }
+            std::sort( perm + first, perm + len, less );
+        }
+    }
+    std::reverse( perm, perm + n );
+}
+
+
+// Approximate minimum degree ordering of G on the quotient graph:
+// every step eliminates a variable of minimum approximate external degree
+// (Amestoy, Davis, Duff) and turns it into an element. The elements
+// adjacent to it, and the elements covered by it, are absorbed.
+// There is no supervariable detection.
+static void
+magma_zmreorder_amd(
+    const magma_zmreorder_graph &G,
+    magma_index_t *perm )
+{
+    magma_int_t n = G.n, mindeg = 0;
+    // Av: adjacent variables, Ev: adjacent elements, Le: variables of an element
+    std::vector< std::vector< magma_index_t > > Av( n ), Ev( n ), Le( n );
+    std::vector< magma_index_t > deg( n ), head( n+1, -1 ), next( n ), prev( n );
+    std::vector< magma_index_t > mark( n, -1 ), w( n, -1 ), Lp;
+    // 0: variable, 1: element, 2: absorbed element
+    std::vector< char > status( n, 0 );
+
+    // degree lists
+    #define MREORDER_INSERT( i ) {                                  \
+        next[i] = head[ deg[i] ];  prev[i] = -1;                    \
+        if ( next[i] >= 0 ) prev[ next[i] ] = i;                    \
+        head[ deg[i] ] = i;                                         \
+    }
+    #define MREORDER_REMOVE( i ) {                                  \
+        if ( prev[i] >= 0 ) next[ prev[i] ] = next[i];              \
+        else head[ deg[i] ] = next[i];                              \
+        if ( next[i] >= 0 ) prev[ next[i] ] = prev[i];              \
+    }
+
+    for( magma_int_t i=0; i < n; i++ ) {
+        Av[i].assign( G.adj.begin() + G.ptr[i], G.adj.begin() + G.ptr[i+1] );
+        deg[i] = Av[i].size();
+        MREORDER_INSERT( i );
+    }
+
+    for( magma_int_t k=0; k < n; k++ ) {
+        while ( head[mindeg] < 0 ) {
+            mindeg++;
+        }
+        magma_index_t p = head[mindeg];
+        MREORDER_REMOVE( p );
+        perm[k] = p;
+
+        // the new element p: Lp = Av[p] + the variables of its elements
+        Lp.clear();
+        mark[p] = k;
+        for( size_t j=0; j < Av[p].size(); j++ ) {
+            magma_index_t i = Av[p][j];
+            if ( mark[i] != k ) {
+                mark[i] = k;
+                Lp.push_back( i );
+            }
+        }
+        for( size_t j=0; j < Ev[p].size(); j++ ) {
+            magma_index_t e = Ev[p][j];
+            if ( status[e] != 1 ) {
+                continue;
+            }
+            for( size_t l=0; l < Le[e].size(); l++ ) {
+                magma_index_t i = Le[e][l];
+                if ( mark[i] != k ) {
+                    mark[i] = k;
+                    Lp.push_back( i );
+                }
+            }
+            status[e] = 2;
+            std::vector< magma_index_t >().swap( Le[e] );
+        }
+        std::vector< magma_index_t >().swap( Av[p] );
+        std::vector< magma_index_t >().swap( Ev[p] );
+        status[p] = 1;
+
+        // prune the adjacency of the variables in Lp
+        for( size_t j=0; j < Lp.size(); j++ ) {
+            magma_index_t i = Lp[j];
+            MREORDER_REMOVE( i );
+            size_t m = 0;
+            for( size_t l=0; l < Av[i].size(); l++ ) {
+                if ( mark[ Av[i][l] ] != k ) {
+                    Av[i][m++] = Av[i][l];
+                }
+            }
+            Av[i].resize( m );
+            m = 0;
+            for( size_t l=0; l < Ev[i].size(); l++ ) {
+                if ( status[ Ev[i][l] ] == 1 ) {
+                    Ev[i][m++] = Ev[i][l];
+                }
+            }
+            Ev[i].resize( m );
+            Ev[i].push_back( p );
+        }
+
+        // w[e] = | Le[e] \ Lp | for the other elements adjacent to Lp
+        for( size_t j=0; j < Lp.size(); j++ ) {
+            magma_index_t i = Lp[j];
+            for( size_t l=0; l+1 < Ev[i].size(); l++ ) {
+                magma_index_t e = Ev[i][l];
+                if ( w[e] < 0 ) {
+                    w[e] = Le[e].size();
+                }
+                w[e]--;
+            }
+        }
+
+        // approximate external degrees; elements inside Lp are absorbed
+        magma_int_t lp = Lp.size();
+        for( size_t j=0; j < Lp.size(); j++ ) {
+            magma_index_t i = Lp[j];
+            magma_int_t d = Av[i].size() + lp - 1;
+            for( size_t l=0; l+1 < Ev[i].size(); l++ ) {
+                magma_index_t e = Ev[i][l];
+                if ( status[e] != 1 ) {
+                    continue;
+                }
+                if ( w[e] == 0 ) {
+                    status[e] = 2;
+                } else {
+                    d += w[e];
+                }
+            }
+            d = min( d, deg[i] + lp - 1 );
+            d = max( 0, min( d, n-k-2 ));
+            deg[i] = d;
+            MREORDER_INSERT( i );
+            mindeg = min( mindeg, d );
+        }
+        for( size_t j=0; j < Lp.size(); j++ ) {
+            magma_index_t i = Lp[j];
+            for( size_t l=0; l < Ev[i].size(); l++ ) {
+                w[ Ev[i][l] ] = -1;
+            }
+        }
+        Le[p] = Lp;
+    }
+
+    #undef MREORDER_INSERT
+    #undef MREORDER_REMOVE
+}
+
+
+// coarsening by heavy-edge matching: cmap maps the vertices of G
+// to the vertices of the coarse graph C
+static void
+magma_zmreorder_coarsen(
+    const magma_zmreorder_graph &G,
+    std::vector< magma_index_t > &cmap,
+    magma_zmreorder_graph &C )
+{
+    magma_int_t n = G.n, nc = 0;
+    std::vector< magma_index_t > match( n, -1 );
+
+    cmap.assign( n, -1 );
+    for( magma_int_t v=0; v < n; v++ ) {
+        if ( cmap[v] >= 0 ) {
+            continue;
+        }
+        magma_index_t best = -1, bw = 0;
+        for( magma_index_t j=G.ptr[v]; j < G.ptr[v+1]; j++ ) {
+            magma_index_t u = G.adj[j];
+            if ( cmap[u] < 0 && u != v && G.ewgt[j] > bw ) {
+                best = u;
+                bw = G.ewgt[j];
+            }
+        }
+        cmap[v] = nc;
+        if ( best >= 0 ) {
+            cmap[best] = nc;
+            match[v] = best;
+            match[best] = v;
+        }
+        nc++;
+    }
+
+    // coarse vertex c is built from its members in increasing order of c;
+    // pos[c'] is the position of the edge (c,c') in C.adj
+    std::vector< magma_index_t > pos( nc, -1 );
+    C.n = nc;
+    C.ptr.assign( nc+1, 0 );
+    C.vwgt.assign( nc, 0 );
+    C.adj.clear();
+    C.ewgt.clear();
+    for( magma_int_t v=0; v < n; v++ ) {
+        if ( match[v] >= 0 && match[v] < v ) {
+            continue;
+        }
+        magma_index_t c = cmap[v], start = C.adj.size();
+        magma_index_t members[2] = { (magma_index_t) v, match[v] };
+        for( int m=0; m < 2 && members[m] >= 0; m++ ) {
+            magma_index_t f = members[m];
+            C.vwgt[c] += G.vwgt[f];
+            for( magma_index_t j=G.ptr[f]; j < G.ptr[f+1]; j++ ) {
+                magma_index_t cu = cmap[ G.adj[j] ];
+                if ( cu == c ) {
+                    continue;
+                }
+                if ( pos[cu] >= start ) {
+                    C.ewgt[ pos[cu] ] += G.ewgt[j];
+                } else {
+                    pos[cu] = C.adj.size();
+                    C.adj.push_back( cu );
+                    C.ewgt.push_back( G.ewgt[j] );
+                }
+            }
+        }
+        C.ptr[c+1] = C.adj.size();
+    }
+}
+
+
+// greedy boundary refinement of the bisection side of G: moves vertices
+// that reduce the edge cut, or keep it and improve the balance
+static void
+magma_zmreorder_refine(
+    const magma_zmreorder_graph &G,
+    std::vector< char > &side )
+{
+    magma_int_t n = G.n, wside[2] = { 0, 0 }, maxv = 0;
+
+    for( magma_int_t v=0; v < n; v++ ) {
+        wside[ (int) side[v] ] += G.vwgt[v];
+        maxv = max( maxv, (magma_int_t) G.vwgt[v] );
+    }
+    // allowed imbalance: 5%, and at least one vertex
+    magma_int_t tol = max( (wside[0] + wside[1]) / 20, maxv );
+
+    for( int pass=0; pass < MREORDER_ND_PASSES; pass++ ) {
+        magma_int_t moved = 0;
+        for( magma_int_t v=0; v < n; v++ ) {
+            int s = side[v];
+            magma_int_t ext = 0, in = 0;
+            for( magma_index_t j=G.ptr[v]; j < G.ptr[v+1]; j++ ) {
+                if ( side[ G.adj[j] ] == s ) {
+                    in += G.ewgt[j];
+                } else {
+                    ext += G.ewgt[j];
+                }
+            }
+            if ( ext == 0 || wside[s] == G.vwgt[v] ) {
+                continue;
+            }
+            magma_int_t gain = ext - in;
+            magma_int_t oldimb = wside[s] - wside[1-s];
+            magma_int_t newimb = oldimb - 2*G.vwgt[v];
+            oldimb = max( oldimb, -oldimb );
+            newimb = max( newimb, -newimb );
+            if ( ( gain > 0 && ( newimb <= tol || newimb < oldimb )) ||
+                 ( gain == 0 && newimb < oldimb ) ) {
+                side[v] = 1-s;
+                wside[s] -= G.vwgt[v];
+                wside[1-s] += G.vwgt[v];
+                moved++;
+            }
+        }
+        if ( moved == 0 ) {
+            break;
+        }
+    }
+}
+
+
+// multilevel bisection of G into side 0 and side 1
+static void
+magma_zmreorder_bisect(
+    const magma_zmreorder_graph &G,
+    std::vector< char > &side )
+{
+    std::vector< magma_zmreorder_graph > coarse;
+    std::vector< std::vector< magma_index_t > > cmaps;
+
+    // coarsening
+    const magma_zmreorder_graph *cur = &G;
+    while ( cur->n > MREORDER_ND_COARSE ) {
+        magma_zmreorder_graph C;
+        std::vector< magma_index_t > cmap;
+        magma_zmreorder_coarsen( *cur, cmap, C );
+        if ( 10*C.n > 9*cur->n ) {
+            break;
+        }
+        coarse.push_back( C );
+        cmaps.push_back( cmap );
+        cur = &coarse.back();
+    }
+
+    // initial bisection of the coarsest graph: breadth-first search from
+    // pseudo-peripheral vertices until side 0 has half of the weight
+    magma_int_t n = cur->n, total = 0, acc = 0;
+    std::vector< magma_index_t > level( n, -1 ), order( n ), work( n );
+    for( magma_int_t v=0; v < n; v++ ) {
+        total += cur->vwgt[v];
+    }
+    side.assign( n, 1 );
+    for( magma_int_t s=0; s < n && 2*acc < total; s++ ) {
+        if ( level[s] >= 0 ) {
+            continue;
+        }
+        magma_index_t root = magma_zmreorder_peripheral( *cur, s, &level[0], &work[0] );
+        magma_int_t len = 0;
+        magma_zmreorder_bfs( *cur, root, &level[0], &order[0], &len );
+        for( magma_int_t k=0; k < len && 2*acc < total; k++ ) {
+            side[ order[k] ] = 0;
+            acc += cur->vwgt[ order[k] ];
+        }
+    }
+    magma_zmreorder_refine( *cur, side );
+
+    // projection to the finer graphs, with refinement on every level
+    for( magma_int_t l = coarse.size(); l > 0; l-- ) {
+        const magma_zmreorder_graph &F = ( l == 1 ? G : coarse[l-2] );
+        std::vector< char > fside( F.n );
+        for( magma_int_t v=0; v < F.n; v++ ) {
+            fside[v] = side[ cmaps[l-1][v] ];
+        }
+        magma_zmreorder_refine( F, fside );
+        side.swap( fside );
+    }
+}
+
+
+// nested dissection of the subgraph of G induced by verts[0:nv-1];
+// on exit, verts holds these vertices in elimination order
+static void
+magma_zmreorder_nd(
+    const magma_zmreorder_graph &G,
+    magma_index_t *verts,
+    magma_int_t nv,
+    magma_index_t *map )
+{
+    magma_int_t n0 = 0, n1 = 0;
+    if ( nv == 0 ) {
+        return;
+    }
+    {
+        magma_zmreorder_graph S;
+        std::vector< magma_index_t > order( nv );
+        std::vector< char > side;
+        magma_zmreorder_subgraph( G, verts, nv, map, S );
+
+        if ( nv > MREORDER_ND_LEAF ) {
+            magma_zmreorder_bisect( S, side );
+
+            // vertex separator: the smaller boundary of the edge cut
+            magma_int_t nb[2] = { 0, 0 };
+            std::vector< char > boundary( nv, 0 );
+            for( magma_int_t v=0; v < nv; v++ ) {
+                for( magma_index_t j=S.ptr[v]; j < S.ptr[v+1]; j++ ) {
+                    if ( side[ S.adj[j] ] != side[v] ) {
+                        boundary[v] = 1;
+                        nb[ (int) side[v] ]++;
+                        break;
+                    }
+                }
+            }
+            int sepside = ( nb[0] <= nb[1] ? 0 : 1 );
+            for( magma_int_t v=0; v < nv; v++ ) {
+                if ( boundary[v] && side[v] == sepside ) {
+                    side[v] = 2;
+                }
+                n0 += ( side[v] == 0 );
+                n1 += ( side[v] == 1 );
+            }
+        }
+        if ( n0 == 0 || n1 == 0 ) {
+            // leaf, or no useful separator
+            magma_zmreorder_amd( S, &order[0] );
+            for( magma_int_t k=0; k < nv; k++ ) {
+                order[k] = verts[ order[k] ];
+            }
+            std::copy( order.begin(), order.end(), verts );
+            return;
+        }
+
+        // side 0, side 1, separator
+        magma_int_t c[3] = { 0, n0, n0+n1 };
+        for( magma_int_t v=0; v < nv; v++ ) {
+            order[ c[ (int) side[v] ]++ ] = verts[v];
+        }
+        std::copy( order.begin(), order.end(), verts );
+    }
+    magma_zmreorder_nd( G, verts,    n0, map );
+    magma_zmreorder_nd( G, verts+n0, n1, map );
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Computes a symmetric reordering of the square sparse matrix A, for
+    bandwidth or fill reduction. The ordering uses the graph of A + A^T,
+    so it also applies to matrices with an unsymmetric pattern.
+    Row and column i of the reordered matrix P A P^T are row and column
+    perm[i] of A; see magma_zmpermute and magma_zvpermute.
+
+    The orderings are:
+    Magma_RCM:       reverse Cuthill-McKee, started in a pseudo-peripheral
+                     vertex of every connected component; reduces the
+                     bandwidth and profile.
+    Magma_AMD:       approximate minimum degree on the quotient graph,
+                     with element absorption, but without the supervariable
+                     detection of the AMD package; reduces the fill of
+                     ILU(k) and of complete factorizations.
+    Magma_ND:        multilevel nested dissection: every subgraph is
+                     coarsened by heavy-edge matching, bisected by a
+                     breadth-first search, and refined on the way back;
+                     the separator is the smaller boundary of the edge cut,
+                     and is ordered last. Subgraphs of up to 128 vertices
+                     are ordered with AMD.
+    Magma_NOREORDER: identity.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                square input matrix in CSR format on the CPU
+
+    @param[in]
+    order       magma_reorder_t
+                ordering: Magma_RCM, Magma_AMD, Magma_ND, Magma_NOREORDER
+
+    @param[out]
+    perm        magma_index_t**
+                permutation of length A.num_rows, allocated on the CPU;
+                free with magma_free_cpu
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmreorder(
+    magma_z_matrix A,
+    magma_reorder_t order,
+    magma_index_t **perm,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+    magma_zmreorder_graph G;
+    std::vector< magma_index_t > map;
+
+    *perm = NULL;
+    if ( A.memory_location != Magma_CPU || A.storage_type != Magma_CSR
+         || A.num_rows != A.num_cols ) {
+        printf("error: reordering requires a square CSR matrix on the CPU.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    CHECK( magma_index_malloc_cpu( perm, max( n, 1 ) ));
+
+    if ( order == Magma_NOREORDER ) {
+        for( magma_int_t i=0; i < n; i++ ) {
+            (*perm)[i] = i;
+        }
+        goto cleanup;
+    }
+
+    magma_zmreorder_matrix_graph( A, G );
+    if ( order == Magma_RCM ) {
+        magma_zmreorder_rcm( G, *perm );
+    }
+    else if ( order == Magma_AMD ) {
+        magma_zmreorder_amd( G, *perm );
+    }
+    else if ( order == Magma_ND ) {
+        map.assign( n, -1 );
+        for( magma_int_t i=0; i < n; i++ ) {
+            (*perm)[i] = i;
+        }
+        magma_zmreorder_nd( G, *perm, n, &map[0] );
+    }
+    else {
+        printf("error: ordering not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+cleanup:
+    if ( info != 0 ) {
+        magma_free_cpu( *perm );
+        *perm = NULL;
+    }
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Applies a symmetric permutation to the square sparse matrix A:
+    B = P A P^T, with row and column i of B being row and column perm[i]
+    of A. The column indices of every row of B are sorted.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                square input matrix in CSR format on the CPU
+
+    @param[in]
+    perm        magma_index_t*
+                permutation of length A.num_rows, e.g. from magma_zmreorder
+
+    @param[out]
+    B           magma_z_matrix*
+                permuted matrix in CSR format on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmpermute(
+    magma_z_matrix A,
+    magma_index_t *perm,
+    magma_z_matrix *B,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+    magma_index_t *iperm = NULL;
+
+    if ( A.memory_location != Magma_CPU || A.storage_type != Magma_CSR
+         || A.num_rows != A.num_cols ) {
+        printf("error: permutation requires a square CSR matrix on the CPU.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    magma_zmfree( B, queue );
+    B->ownership = MagmaTrue;
+    B->storage_type = Magma_CSR;
+    B->memory_location = Magma_CPU;
+    B->num_rows = n;
+    B->num_cols = n;
+    B->nnz = A.nnz;
+    B->true_nnz = A.nnz;
+    B->fill_mode = MagmaFull;
+    CHECK( magma_index_malloc_cpu( &B->row, n+1 ));
+    CHECK( magma_index_malloc_cpu( &B->col, max( A.nnz, 1 ) ));
+    CHECK( magma_zmalloc_cpu( &B->val, max( A.nnz, 1 ) ));
+    CHECK( magma_index_malloc_cpu( &iperm, max( n, 1 ) ));
+
+    for( magma_int_t i=0; i < n; i++ ) {
+        iperm[ perm[i] ] = i;
+    }
+    B->row[0] = 0;
+    for( magma_int_t i=0; i < n; i++ ) {
+        B->row[i+1] = B->row[i] + A.row[ perm[i]+1 ] - A.row[ perm[i] ];
+    }
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for( magma_int_t i=0; i < n; i++ ) {
+        magma_index_t src = A.row[ perm[i] ], dst = B->row[i];
+        magma_index_t len = B->row[i+1] - dst;
+        magma_index_t *col = B->col + dst;
+        magmaDoubleComplex *val = B->val + dst;
+        // insertion sort of the new column indices
+        for( magma_index_t k=0; k < len; k++ ) {
+            magma_index_t c = iperm[ A.col[src+k] ];
+            magmaDoubleComplex v = A.val[src+k];
+            magma_index_t l = k;
+            while ( l > 0 && col[l-1] > c ) {
+                col[l] = col[l-1];
+                val[l] = val[l-1];
+                l--;
+            }
+            col[l] = c;
+            val[l] = v;
+        }
+    }
+
+cleanup:
+    if ( info != 0 ) {
+        magma_zmfree( B, queue );
+    }
+    magma_free_cpu( iperm );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Permutes the rows of the dense vectors x on the CPU:
+    y = P x, that is y(i,:) = x(perm[i],:), for MagmaNoTrans, and
+    y = P^T x, that is y(perm[i],:) = x(i,:), for MagmaTrans.
+    With B = P A P^T from magma_zmpermute, A x = b is solved by solving
+    B y = P b and setting x = P^T y.
+
+    Arguments
+    ---------
+
+    @param[in]
+    x           magma_z_matrix
+                input vectors on the CPU
+
+    @param[in]
+    perm        magma_index_t*
+                permutation of length x.num_rows, e.g. from magma_zmreorder
+
+    @param[in]
+    trans       magma_trans_t
+                MagmaNoTrans for P x, MagmaTrans for P^T x
+
+    @param[out]
+    y           magma_z_matrix*
+                permuted vectors on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zvpermute(
+    magma_z_matrix x,
+    magma_index_t *perm,
+    magma_trans_t trans,
+    magma_z_matrix *y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = x.num_rows;
+
+    if ( x.memory_location != Magma_CPU ) {
+        printf("error: permutation requires vectors on the CPU.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    CHECK( magma_zvinit( y, Magma_CPU, x.num_rows, x.num_cols, MAGMA_Z_ZERO, queue ));
+    y->major = x.major;
+
+    for( magma_int_t j=0; j < x.num_cols; j++ ) {
+        // element (i,j) is at i*ld + j*step
+        magma_int_t ld = ( x.major == MagmaRowMajor ? x.num_cols : 1 );
+        magma_int_t step = ( x.major == MagmaRowMajor ? 1 : x.num_rows );
+        magmaDoubleComplex *xj = x.val + j*step, *yj = y->val + j*step;
+        if ( trans == MagmaNoTrans ) {
+            #pragma omp parallel for
+            for( magma_int_t i=0; i < n; i++ ) {
+                yj[ i*ld ] = xj[ perm[i]*ld ];
+            }
+        } else {
+            #pragma omp parallel for
+            for( magma_int_t i=0; i < n; i++ ) {
+                yj[ perm[i]*ld ] = xj[ i*ld ];
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Reordering pre-pass for the factorization preconditioners: computes the
+    ordering precond->reorder of A, and returns B = P A P^T in CSR format,
+    in the memory location of A. The preconditioner is then set up for B.
+    P and P^T are stored as CSR matrices on the device in precond->P and
+    precond->PT, together with the work vector precond->Pwork; the left
+    preconditioner application first permutes the input vector with P,
+    the right one permutes the output vector with P^T.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                system matrix
+
+    @param[out]
+    B           magma_z_matrix*
+                reordered system matrix
+
+    @param[in,out]
+    precond     magma_z_preconditioner*
+                preconditioner with the ordering in precond->reorder
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zprecondreorder(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+    magma_index_t *perm = NULL;
+    magma_z_matrix hA={Magma_CSR}, hACSR={Magma_CSR}, hB={Magma_CSR};
+    magma_z_matrix hP={Magma_CSR}, hPT={Magma_CSR};
+
+    CHECK( magma_zmtransfer( A, &hA, A.memory_location, Magma_CPU, queue ));
+    CHECK( magma_zmconvert( hA, &hACSR, hA.storage_type, Magma_CSR, queue ));
+    CHECK( magma_zmreorder( hACSR, precond->reorder, &perm, queue ));
+    CHECK( magma_zmpermute( hACSR, perm, &hB, queue ));
+    CHECK( magma_zmtransfer( hB, B, Magma_CPU, A.memory_location, queue ));
+
+    // P has the entries (i, perm[i]), P^T the entries (perm[i], i)
+    hP.storage_type = hPT.storage_type = Magma_CSR;
+    hP.memory_location = hPT.memory_location = Magma_CPU;
+    hP.num_rows = hP.num_cols = hP.nnz = hP.true_nnz = n;
+    hPT.num_rows = hPT.num_cols = hPT.nnz = hPT.true_nnz = n;
+    CHECK( magma_index_malloc_cpu( &hP.row, n+1 ));
+    CHECK( magma_index_malloc_cpu( &hP.col, max( n, 1 ) ));
+    CHECK( magma_zmalloc_cpu( &hP.val, max( n, 1 ) ));
+    CHECK( magma_index_malloc_cpu( &hPT.row, n+1 ));
+    CHECK( magma_index_malloc_cpu( &hPT.col, max( n, 1 ) ));
+    CHECK( magma_zmalloc_cpu( &hPT.val, max( n, 1 ) ));
+    for( magma_int_t i=0; i <= n; i++ ) {
+        hP.row[i] = hPT.row[i] = i;
+    }
+    for( magma_int_t i=0; i < n; i++ ) {
+        hP.col[i] = perm[i];
+        hPT.col[ perm[i] ] = i;
+        hP.val[i] = hPT.val[i] = MAGMA_Z_ONE;
+    }
+
+    CHECK( magma_zmtransfer( hP, &precond->P, Magma_CPU, Magma_DEV, queue ));
+    CHECK( magma_zmtransfer( hPT, &precond->PT, Magma_CPU, Magma_DEV, queue ));
+    CHECK( magma_zvinit( &precond->Pwork, Magma_DEV, n, 1, MAGMA_Z_ZERO, queue ));
+
+cleanup:
+    if ( info != 0 ) {
+        magma_zmfree( B, queue );
+        magma_zmfree( &precond->P, queue );
+        magma_zmfree( &precond->PT, queue );
+        magma_zmfree( &precond->Pwork, queue );
+    }
+    magma_free_cpu( perm );
+    magma_zmfree( &hA, queue );
+    magma_zmfree( &hACSR, queue );
+    magma_zmfree( &hB, queue );
+    magma_zmfree( &hP, queue );
+    magma_zmfree( &hPT, queue );
+    return info;
+}
@@ -10,12 +10,35 @@
 
 */
 #include <cstdlib>
+#include <algorithm>
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
+// minimum number of nonzeros per thread; smaller matrices use fewer threads
+#define TRANS_NNZ_PER_THREAD 16384
+
+// the per-thread histograms hold at most this many entries per nonzero,
+// so matrices with many more columns than nonzeros use fewer threads
+#define TRANS_COUNT_PER_NNZ 4
 
 
 /**
  * op(from[i], to[i]);
+ *
+ * Transposes A into B by a counting sort over the column indices of A:
+ * every thread counts the nonzeros per column in a contiguous block of rows
+ * of A, balanced by nonzeros; a prefix sum over columns and threads gives
+ * B->row and each thread's offsets; then every thread scatters its block.
+ * Since row blocks are ordered by thread, the column indices in each row of
+ * B come out in increasing order, the same as a sequential transpose.
+ * The histograms take nthreads * A.num_cols entries; the number of threads
+ * is limited so this stays within TRANS_COUNT_PER_NNZ * A.nnz, as zeroing and
+ * scanning them would otherwise cost more than the transpose.
+ * For Magma_CSRCOO, B->rowidx is filled with the row indices of B; other
+ * formats get no rowidx, as magma_zmfree would not release it.
+ * A is not modified.
  */
 template <typename Operator>
 inline magma_int_t
@@ -27,95 +50,117 @@ magma_z_mtrans_template(
 {
     magma_int_t info = 0;
     
-    magma_index_t *linked_list;
-    magma_index_t *row_ptr;
-    magma_index_t *last_rowel;
+    magma_index_t *count = NULL;   // nthreads x B->num_rows histograms
+    magma_index_t *split = NULL;   // first row of A handled by each thread
+    magma_int_t num_threads = 1;
     
-    // magma_int_t num_threads;
-    // magma_int_t el_per_block;
     magma_zmfree( B, queue );
     B->ownership = MagmaTrue;
     
     B->storage_type = A.storage_type;
     B->memory_location = A.memory_location;
     
-    B->num_rows = A.num_rows;
-    B->num_cols = A.num_cols;
+    B->num_rows = A.num_cols;
+    B->num_cols = A.num_rows;
     B->nnz      = A.nnz;
     
-    CHECK( magma_index_malloc_cpu( &linked_list, A.nnz ));
-    CHECK( magma_index_malloc_cpu( &row_ptr, A.num_rows ));
-    CHECK( magma_index_malloc_cpu( &last_rowel, A.num_rows ));
-    CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &B->rowidx, A.nnz ));
+    CHECK( magma_index_malloc_cpu( &B->row, B->num_rows+1 ));
+    B->rowidx = NULL;
+    if ( B->storage_type == Magma_CSRCOO ) {
+        CHECK( magma_index_malloc_cpu( &B->rowidx, A.nnz ));
+    }
     CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
     CHECK( magma_zmalloc_cpu( &B->val, A.nnz ) );
     
-    magma_free_cpu( A.rowidx );
-    
-    CHECK( magma_zmatrix_addrowindex(&A, queue) );
-    
-    //#pragma omp parallel
-    // {
-    //     num_threads = omp_get_max_threads();
-    // }
-    
-    //#pragma omp parallel for
-    for( magma_int_t i=0; i<A.num_rows; i++ ){
-        row_ptr[i] = -1;
-    }
-    //#pragma omp parallel for
-    for( magma_int_t i=0; i<A.num_rows+1; i++ ){
-        B->row[i] = 0;
+    #ifdef _OPENMP
+    num_threads = min( (magma_int_t) omp_get_max_threads(),
+                       magma_ceildiv( A.nnz, TRANS_NNZ_PER_THREAD ) );
+    if ( B->num_rows > 0 ) {
+        int64_t max_threads = int64_t( TRANS_COUNT_PER_NNZ ) * A.nnz / B->num_rows;
+        if ( max_threads < num_threads ) {
+            num_threads = (magma_int_t) max_threads;
+        }
     }
+    num_threads = max( num_threads, (magma_int_t) 1 );
+    #endif
     
-    //el_per_block = magma_ceildiv( A.num_rows, num_threads );
-
-    //#pragma omp parallel
+    CHECK( magma_index_malloc_cpu( &count, size_t(num_threads) * B->num_rows ));
+    CHECK( magma_index_malloc_cpu( &split, num_threads+1 ));
+    
+    #pragma omp parallel num_threads( num_threads )
     {
-        // magma_int_t id = omp_get_thread_num();
-        for(magma_int_t i=0; i<A.nnz; i++ ){
-            magma_index_t row = A.col[ i ];
-            //if( (row < (id+1)*el_per_block) && (row >=(id)*el_per_block)  ){
-            {
-                if( row_ptr[row] == -1 ){
-                    row_ptr[ row ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                } else {
-                    linked_list[ last_rowel[ row ] ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
+        #ifdef _OPENMP
+        magma_int_t id = omp_get_thread_num();
+        magma_int_t nt = omp_get_num_threads();
+        #else
+        magma_int_t id = 0;
+        magma_int_t nt = 1;
+        #endif
+        
+        // split the rows of A into blocks with about the same number of nonzeros
+        #pragma omp single
+        {
+            split[0] = 0;
+            for( magma_int_t t=1; t < nt; t++ ){
+                magma_index_t target = (magma_index_t) ( (double) A.nnz * t / nt );
+                magma_index_t r = (magma_index_t)
+                    ( std::lower_bound( A.row, A.row + A.num_rows + 1, target ) - A.row );
+                split[t] = max( split[t-1], min( r, (magma_index_t) A.num_rows ));
+            }
+            split[nt] = A.num_rows;
+        }
+        magma_index_t *cnt = count + size_t(id) * B->num_rows;
+        
+        // histogram of the column indices in this thread's rows
+        for( magma_int_t c=0; c < B->num_rows; c++ ){
+            cnt[c] = 0;
+        }
+        for( magma_int_t i=split[id]; i < split[id+1]; i++ ){
+            for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+                cnt[ A.col[j] ]++;
+            }
+        }
+        #pragma omp barrier
+        
+        // per column: exclusive scan over threads; column totals into B->row
+        #pragma omp for
+        for( magma_int_t c=0; c < B->num_rows; c++ ){
+            magma_index_t sum = 0;
+            for( magma_int_t t=0; t < nt; t++ ){
+                magma_index_t tmp = count[ size_t(t) * B->num_rows + c ];
+                count[ size_t(t) * B->num_rows + c ] = sum;
+                sum += tmp;
+            }
+            B->row[c+1] = sum;
+        }
+        
+        #pragma omp single
+        {
+            B->row[0] = 0;
+            for( magma_int_t c=0; c < B->num_rows; c++ ){
+                B->row[c+1] += B->row[c];
+            }
+        }
+        
+        // scatter this thread's rows into B
+        for( magma_int_t i=split[id]; i < split[id+1]; i++ ){
+            for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+                magma_index_t c = A.col[j];
+                magma_index_t k = B->row[c] + cnt[c]++;
+                op(A.val[j], B->val[k]);
+                B->col[k] = i;
+                if ( B->rowidx != NULL ) {
+                    B->rowidx[k] = c;
                 }
-                B->row[row+1] = B->row[row+1] + 1;
             }
         }
     }
     
-    // new rowptr
-    B->row[0]=0;   
-    magma_zmatrix_createrowptr( B->num_rows, B->row, queue );
-    
-
     assert( B->row[B->num_rows] == A.nnz );
     
-    //#pragma omp parallel for
-    for( magma_int_t row=0; row<A.num_rows; row++){
-        magma_int_t el = row_ptr[row];
-        if( el>-1 ) {
-            for( magma_int_t i=B->row[row]; i<B->row[row+1]; i++ ){
-                op(A.val[el], B->val[i]);
-                B->col[i] = A.rowidx[el];
-                el = linked_list[el];
-            }
-        }
-    }
-    
 cleanup:
-    magma_free_cpu( row_ptr );
-    magma_free_cpu( last_rowel );
-    magma_free_cpu( linked_list );
-    magma_free_cpu( A.rowidx );
+    magma_free_cpu( count );
+    magma_free_cpu( split );
     return info;
 }
 
@@ -56,16 +56,14 @@ magma_zparilu_sweep(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    int i, j;
-
 
     magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
-    int il, iu, jl, ju;
 
     #pragma omp parallel for
     for (int k=0; k < A.nnz; k++) {
-        i = A.rowidx[k];
-        j = A.col[k];
+        int i = A.rowidx[k];
+        int j = A.col[k];
+        int il, iu, jl, ju;
 
         magmaDoubleComplex s, sp;
         s =  A.val[k];
@@ -139,13 +137,9 @@ magma_zparilu_sweep_sync(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    int i, j;
-
 
     magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
     
-    int il, iu, jl, ju;
-    
     magmaDoubleComplex *L_new_val = NULL, *U_new_val = NULL, *val_swap = NULL;
     
     CHECK( magma_zmalloc_cpu( &L_new_val, L->nnz ));
@@ -159,8 +153,9 @@ magma_zparilu_sweep_sync(
     
     #pragma omp parallel for
     for (int k=0; k < A.nnz; k++) {
-        i = A.rowidx[k];
-        j = A.col[k];
+        int i = A.rowidx[k];
+        int j = A.col[k];
+        int il, iu, jl, ju;
         
         magmaDoubleComplex s, sp;
         s =  A.val[k];
@@ -201,3 +196,367 @@ cleanup:
     
     return info;
 }
+
+
+
+// Updates the factor entry of nonzero k of A in place, as in
+// magma_zparilu_sweep, and returns its squared residual |a - (L*U)_ij|^2
+// from the values before the update.
+static inline double
+magma_zparilu_update(
+    const magma_z_matrix& A,
+    magma_int_t k,
+    magma_z_matrix *L,
+    magma_z_matrix *U )
+{
+    magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
+    int i = A.rowidx[k];
+    int j = A.col[k];
+    int il, iu, jl, ju;
+
+    magmaDoubleComplex s, sp, r;
+    s =  A.val[k];
+    sp = zero;
+
+    il = L->row[i];
+    iu = U->row[j];
+
+    while (il < L->row[i+1] && iu < U->row[j+1])
+    {
+        sp = zero;
+        jl = L->col[il];
+        ju = U->col[iu];
+
+        // avoid branching
+        sp = ( jl == ju ) ? L->val[il] * U->val[iu] : sp;
+        s = ( jl == ju ) ? s-sp : s;
+        il = ( jl <= ju ) ? il+1 : il;
+        iu = ( jl >= ju ) ? iu+1 : iu;
+    }
+    // undo the last operation (it must be the last)
+    s += sp;
+
+    if ( i > j ) {    // modify l entry
+        magmaDoubleComplex ujj = U->val[U->row[j+1]-1];
+        r = s - L->val[il-1] * ujj;
+        L->val[il-1] =  s / ujj;
+    }
+    else {            // modify u entry
+        r = s - U->val[iu-1];
+        U->val[iu-1] = s;
+    }
+    return MAGMA_Z_REAL(r) * MAGMA_Z_REAL(r)
+         + MAGMA_Z_IMAG(r) * MAGMA_Z_IMAG(r);
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    This function does one asynchronous ParILU sweep, as magma_zparilu_sweep,
+    and computes the residual of the fixed-point iteration,
+    || A - L*U || in the Frobenius norm on the sparsity pattern of A, from the
+    values each entry has when it is updated. This costs one more multiply
+    per entry and allows stopping the sweeps once they converged.
+
+    The entries of A are split into one contiguous range per thread. A is
+    sorted row-major, which is a valid order of the dependencies of the
+    fixed-point iteration, so each thread does a Gauss-Seidel sweep over its
+    range, and a sequential sweep gives the exact ILU(0) factors.
+    Input and output array are identical.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                System matrix in COO, sorted row-major.
+
+    @param[in,out]
+    L           magma_z_matrix*
+                Current approximation for the lower triangular factor
+                The format is sorted CSR.
+
+    @param[in,out]
+    U           magma_z_matrix*
+                Current approximation for the upper triangular factor
+                The format is sorted CSC (U^T in CSR).
+
+    @param[out]
+    res         double*
+                Residual || A - L*U ||_F on the pattern of A, before the sweep
+                for entries updated by other threads concurrently.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zparilu_sweep_res(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_z_matrix *U,
+    double *res,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    double sum = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:sum)
+    for (int k=0; k < A.nnz; k++) {
+        sum += magma_zparilu_update( A, k, L, U );
+    }
+    *res = sqrt( sum );
+
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Prepares the colored ParILU sweeps of magma_zparilu_sweep_colored.
+    The rows of A are split into blocks of consecutive rows with about
+    bsize nonzeros each, sized so a block's entries of A, L and U stay in
+    cache during the sweep. The blocks are colored greedily so that blocks
+    of the same color have no column of A in common.
+
+    An update of entry (i,j) reads row i of L and column j of U, and writes
+    either L(i,j) or U(i,j). Row i of L is only touched by entries of row i,
+    and column j of U only by entries of column j, so blocks of one color
+    can be swept concurrently without data races. Orderings with small
+    bandwidth, such as the RCM pre-pass of magma_zmreorder, give few colors.
+
+    Matrices that need more than 64 colors, e.g., with a dense column,
+    return MAGMA_ERR_NOT_SUPPORTED; use magma_zparilu_sweep_res for them.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                System matrix in COO, sorted row-major.
+
+    @param[in]
+    bsize       magma_int_t
+                Target number of nonzeros per block.
+
+    @param[out]
+    block_row   magma_index_t**
+                Array of nblocks+1 entries, allocated here: block b has the
+                rows block_row[b] to block_row[b+1]-1.
+
+    @param[out]
+    block_order magma_index_t**
+                Array of nblocks entries, allocated here: the blocks sorted
+                by color.
+
+    @param[out]
+    color_ptr   magma_index_t**
+                Array of ncolors+1 entries, allocated here: the blocks of
+                color c are block_order[ color_ptr[c] ] to
+                block_order[ color_ptr[c+1]-1 ].
+
+    @param[out]
+    ncolors     magma_int_t*
+                Number of colors.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zparilu_colors(
+    magma_z_matrix A,
+    magma_int_t bsize,
+    magma_index_t **block_row,
+    magma_index_t **block_order,
+    magma_index_t **color_ptr,
+    magma_int_t *ncolors,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    uint64_t *mask = NULL;          // colors of the blocks touching each column
+    magma_index_t *block_color = NULL;
+    magma_int_t nblocks = 0, nc = 0;
+
+    *block_row = NULL;
+    *block_order = NULL;
+    *color_ptr = NULL;
+    *ncolors = 0;
+
+    if ( bsize <= 0 ) {
+        info = -2;
+        goto cleanup;
+    }
+
+    // blocks of consecutive rows with about bsize nonzeros
+    CHECK( magma_index_malloc_cpu( block_row, A.num_rows+1 ));
+    (*block_row)[0] = 0;
+    for (magma_int_t i=0; i < A.num_rows; i++) {
+        if ( A.row[i+1] - A.row[ (*block_row)[nblocks] ] >= bsize
+             || i == A.num_rows-1 ) {
+            (*block_row)[++nblocks] = i+1;
+        }
+    }
+
+    // greedy coloring: the lowest color not used by a block sharing a column
+    CHECK( magma_malloc_cpu( (void**) &mask, max( A.num_cols, 1 ) * sizeof(uint64_t) ));
+    CHECK( magma_index_malloc_cpu( &block_color, max( nblocks, 1 ) ));
+    for (magma_int_t c=0; c < A.num_cols; c++) {
+        mask[c] = 0;
+    }
+    for (magma_int_t b=0; b < nblocks; b++) {
+        uint64_t used = 0;
+        for (magma_int_t k=A.row[ (*block_row)[b] ]; k < A.row[ (*block_row)[b+1] ]; k++) {
+            used |= mask[ A.col[k] ];
+        }
+        if ( used == ~uint64_t(0) ) {
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        magma_int_t c = 0;
+        while ( (used >> c) & 1 ) {
+            c++;
+        }
+        block_color[b] = c;
+        nc = max( nc, c+1 );
+        for (magma_int_t k=A.row[ (*block_row)[b] ]; k < A.row[ (*block_row)[b+1] ]; k++) {
+            mask[ A.col[k] ] |= uint64_t(1) << c;
+        }
+    }
+
+    // sort the blocks by color, keeping their order within a color
+    CHECK( magma_index_malloc_cpu( color_ptr, nc+1 ));
+    CHECK( magma_index_malloc_cpu( block_order, max( nblocks, 1 ) ));
+    for (magma_int_t c=0; c <= nc; c++) {
+        (*color_ptr)[c] = 0;
+    }
+    for (magma_int_t b=0; b < nblocks; b++) {
+        (*color_ptr)[ block_color[b]+1 ]++;
+    }
+    for (magma_int_t c=0; c < nc; c++) {
+        (*color_ptr)[c+1] += (*color_ptr)[c];
+    }
+    for (magma_int_t b=0; b < nblocks; b++) {
+        (*block_order)[ (*color_ptr)[ block_color[b] ]++ ] = b;
+    }
+    for (magma_int_t c=nc; c > 0; c--) {
+        (*color_ptr)[c] = (*color_ptr)[c-1];
+    }
+    (*color_ptr)[0] = 0;
+    *ncolors = nc;
+
+cleanup:
+    if ( info != 0 ) {
+        magma_free_cpu( *block_row );
+        magma_free_cpu( *block_order );
+        magma_free_cpu( *color_ptr );
+        *block_row = NULL;
+        *block_order = NULL;
+        *color_ptr = NULL;
+    }
+    magma_free_cpu( mask );
+    magma_free_cpu( block_color );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    This function does one colored ParILU sweep with the blocks of
+    magma_zparilu_colors, and computes the residual as
+    magma_zparilu_sweep_res. The colors are swept one after the other; the
+    blocks of a color are swept concurrently, each one in row-major order
+    as a Gauss-Seidel sweep. There are no data races, and the result does
+    not depend on the number of threads. Blocks of later colors see the
+    values of earlier colors from the same sweep, blocks of earlier colors
+    those of later colors from the previous sweep. Hence the number of
+    sweeps grows as the blocks get smaller: with one color, e.g. one block,
+    one sweep gives the exact ILU(0) factors, and blocks of a few times
+    nnz / (number of threads) converge in about as many sweeps as the
+    asynchronous sweeps of magma_zparilu_sweep_res.
+    Input and output array are identical.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                System matrix in COO, sorted row-major.
+
+    @param[in,out]
+    L           magma_z_matrix*
+                Current approximation for the lower triangular factor
+                The format is sorted CSR.
+
+    @param[in,out]
+    U           magma_z_matrix*
+                Current approximation for the upper triangular factor
+                The format is sorted CSC (U^T in CSR).
+
+    @param[in]
+    block_row   const magma_index_t*
+                Row blocks from magma_zparilu_colors.
+
+    @param[in]
+    block_order const magma_index_t*
+                Blocks sorted by color from magma_zparilu_colors.
+
+    @param[in]
+    color_ptr   const magma_index_t*
+                Start of each color in block_order from magma_zparilu_colors.
+
+    @param[in]
+    ncolors     magma_int_t
+                Number of colors.
+
+    @param[out]
+    res         double*
+                Residual || A - L*U ||_F on the pattern of A, from the values
+                before each update.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zparilu_sweep_colored(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_z_matrix *U,
+    const magma_index_t *block_row,
+    const magma_index_t *block_order,
+    const magma_index_t *color_ptr,
+    magma_int_t ncolors,
+    double *res,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    double sum = 0.0;
+
+    #pragma omp parallel reduction(+:sum)
+    for (magma_int_t c=0; c < ncolors; c++) {
+        #pragma omp for schedule(dynamic)
+        for (magma_int_t p=color_ptr[c]; p < color_ptr[c+1]; p++) {
+            magma_index_t b = block_order[p];
+            for (magma_int_t k=A.row[ block_row[b] ]; k < A.row[ block_row[b+1] ]; k++) {
+                sum += magma_zparilu_update( A, k, L, U );
+            }
+        }
+    }
+    *res = sqrt( sum );
+
+    return info;
+}
@@ -2833,8 +2833,17 @@ magma_zparilut_insert(
     Purpose
     -------
     This function identifies the candidates like they appear as ILU1 fill-in.
-    In this version, the matrices are assumed unordered,
-    the linked list is traversed to acces the entries of a row.
+    Candidates are the entries of the ILU(0) pattern L0, U0 missing in L, U,
+    followed by the ILU1 fill-in (row, col2) for every L(row,col1) and
+    U(col1,col2) that is neither in L, U nor already a candidate.
+
+    The rows are split into one contiguous range per thread. Each thread
+    generates the candidates of its rows into its own buffer, using a
+    marker array indexed by column to test in O(1) whether an entry exists
+    or was already added. A prefix sum over the thread counts then gives
+    the offset of each thread in the output, and the threads copy their
+    buffers into a fresh CSR matrix in parallel. No linked lists, no
+    placeholders, and no compaction pass are needed.
 
     Arguments
     ---------
@@ -2856,12 +2865,12 @@ magma_zparilut_insert(
                 Current upper triangular factor.
 
     @param[in,out]
-    LU_new      magma_z_matrix*
-                List of candidates for L in COO format.
+    L_new       magma_z_matrix*
+                List of candidates for L in CSR format with row indices.
 
     @param[in,out]
-    LU_new      magma_z_matrix*
-                List of candidates for U in COO format.
+    U_new       magma_z_matrix*
+                List of candidates for U in CSR format with row indices.
 
     @param[in]
     queue       magma_queue_t
@@ -2870,6 +2879,44 @@ magma_zparilut_insert(
     @ingroup magmasparse_zaux
 *******************************************************************************/
 
+// Makes sure the candidate buffer col, val of *size entries holds at least
+// required entries, keeping its contents.
+static magma_int_t
+magma_zparilut_candidates_grow(
+    magma_index_t **col,
+    magmaDoubleComplex **val,
+    magma_int_t *size,
+    magma_int_t required )
+{
+    magma_int_t info = 0;
+    magma_index_t *new_col = NULL;
+    magmaDoubleComplex *new_val = NULL;
+    magma_int_t new_size = max( 2*(*size), max( required, 1024 ));
+
+    if ( required <= *size ) {
+        return info;
+    }
+    CHECK( magma_index_malloc_cpu( &new_col, new_size ));
+    CHECK( magma_zmalloc_cpu( &new_val, new_size ));
+    if ( *size > 0 ) {
+        memcpy( new_col, *col, (*size)*sizeof(magma_index_t) );
+        memcpy( new_val, *val, (*size)*sizeof(magmaDoubleComplex) );
+    }
+    magma_free_cpu( *col );
+    magma_free_cpu( *val );
+    *col = new_col;
+    *val = new_val;
+    *size = new_size;
+    new_col = NULL;
+    new_val = NULL;
+
+cleanup:
+    magma_free_cpu( new_col );
+    magma_free_cpu( new_val );
+    return info;
+}
+
+
 extern "C" magma_int_t
 magma_zparilut_candidates(
     magma_z_matrix L0,
@@ -2881,479 +2928,224 @@ magma_zparilut_candidates(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    magma_index_t *insertedL;
-    magma_index_t *insertedU;
-    double thrs = 1e-8;
-    
-    magma_int_t orig = 1; // the pattern L0 and U0 is considered
-    magma_int_t existing = 0; // existing elements are also considered
-    magma_int_t ilufill = 1;
-    
-    magma_int_t num_threads;
-    
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-    
-    // for now: also some part commented out. If it turns out
-    // this being correct, I need to clean up the code.
-
-    CHECK( magma_index_malloc_cpu( &L_new->row, L.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &U_new->row, U.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &insertedL, L.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &insertedU, U.num_rows+1 )); 
-    
-    #pragma omp parallel for
-    for( magma_int_t i=0; i<L.num_rows+1; i++ ){
-        L_new->row[i] = 0;
-        U_new->row[i] = 0;
-        insertedL[i] = 0;
-        insertedU[i] = 0;
-    }
-    L_new->num_rows = L.num_rows;
-    L_new->num_cols = L.num_cols;
-    L_new->storage_type = Magma_CSR;
-    L_new->memory_location = Magma_CPU;
-    
-    U_new->num_rows = L.num_rows;
-    U_new->num_cols = L.num_cols;
-    U_new->storage_type = Magma_CSR;
-    U_new->memory_location = Magma_CPU;
-    
-    // go over the original matrix - this is the only way to allow elements to come back...
-    if( orig == 1 ){
-       #pragma omp parallel for
-        for( magma_index_t row=0; row<L0.num_rows; row++){
-            magma_int_t numaddrowL = 0;
-            magma_int_t ilu0 = L0.row[row];
-            magma_int_t ilut = L.row[row];
-            magma_int_t endilu0 = L0.row[ row+1 ];
-            magma_int_t endilut = L.row[ row+1 ]; 
-            magma_int_t ilu0col;
-            magma_int_t ilutcol;
-            do{
-                ilu0col = L0.col[ ilu0 ];
-                ilutcol = L.col[ ilut ];
-                if( ilu0col == ilutcol ){
-                    ilu0++;
-                    ilut++;
-                    if( existing==1 )
-                        numaddrowL++;
-                }
-                else if( ilutcol<ilu0col ){
-                    ilut++;
-                    if( existing==1 )
-                        numaddrowL++;
-                }
-                else {
-                    // this element is missing in the current approximation
-                    // mark it as candidate
-                    numaddrowL++;
-                    ilu0++;
-                }
-            }while( ilut<endilut && ilu0<endilu0 );
-            // do the rest if existing
-            if( ilu0<endilu0 ){
-                do{
-                    numaddrowL++;
-                    ilu0++;
-                }while( ilu0<endilu0 ); 
-            }
-            L_new->row[ row+1 ] = L_new->row[ row+1 ]+numaddrowL;
-        }
-        
-        // same for U
-       #pragma omp parallel for
-        for( magma_index_t row=0; row<U0.num_rows; row++){
-            magma_int_t numaddrowU = 0;
-            magma_int_t ilu0 = U0.row[row];
-            magma_int_t ilut = U.row[row];
-            magma_int_t endilu0 = U0.row[ row+1 ];
-            magma_int_t endilut = U.row[ row+1 ]; 
-            magma_int_t ilu0col;
-            magma_int_t ilutcol;
-            do{
-                ilu0col = U0.col[ ilu0 ];
-                ilutcol = U.col[ ilut ];
-                if( ilu0col == ilutcol ){
-                    ilu0++;
-                    ilut++;
-                    if( existing==1 )
-                        numaddrowU++;
-                }
-                else if( ilutcol<ilu0col ){
-                    ilut++;
-                    if( existing==1 )
-                        numaddrowU++;
-                }
-                else {
-                    // this element is missing in the current approximation
-                    // mark it as candidate
-                    numaddrowU++;
-                    ilu0++;
-                }
-            }while( ilut<endilut && ilu0<endilu0 );
-            if( ilu0<endilu0 ){
-                do{
-                    numaddrowU++;
-                    ilu0++;
-                }while( ilu0<endilu0 ); 
-            }
-            U_new->row[ row+1 ] = U_new->row[ row+1 ]+numaddrowU;
-        }
-    } // end original
-    if( ilufill == 1 ){
-        // how to determine candidates:
-        // for each node i, look at any "intermediate" neighbor nodes numbered
-        // less, and then see if this neighbor has another neighbor j numbered
-        // more than the intermediate; if so, fill in is (i,j) if it is not
-        // already nonzero
-        #pragma omp parallel for
-        for( magma_index_t row=0; row<L.num_rows; row++){
-            magma_int_t numaddrowL = 0, numaddrowU = 0;
-            // loop first element over row - only for elements smaller the diagonal
-            for( magma_index_t el1=L.row[row]; el1<L.row[row+1]-1; el1++ ){
-                magma_index_t col1 = L.col[ el1 ];
-                // now check the upper triangular
-                // second loop first element over row - only for elements larger the intermediate
-                for( magma_index_t el2 = U.row[ col1 ]+1; el2 < U.row[ col1+1 ]; el2++ ){
-                    magma_index_t col2 = U.col[ el2 ];
-                    magma_index_t cand_row = row;
-                    magma_index_t cand_col = col2;
-                    // check whether this element already exists
-                    // first case: part of L
-                    if( cand_col < row ){
-                        // check whether this element already exists in L
-                        magma_int_t exist = 0;
-                        if( existing == 0 ){
-                            for(magma_index_t k=L.row[cand_row]; k<L.row[cand_row+1]; k++ ){
-                                if( L.col[ k ] == cand_col ){
-                                        exist = 1;
-                                        break;
-                                }
-                            }
-                        }
-                        // if it does not exist, increase counter for this location
-                        // use the entry one further down to allow for parallel insertion
-                        if( exist == 0 ){
-                            //printf("checked row: %d this element does not yet exist in L: (%d,%d)\n", cand_row, cand_col);
-                            numaddrowL++;
-                            //numaddL[ row+1 ]++;
-                        }
-                    } else {
-                        // check whether this element already exists in U
-                        magma_int_t exist = 0;
-                        if( existing == 0 ){
-                            for(magma_index_t k=U.row[cand_row]; k<U.row[cand_row+1]; k++ ){
-                                if( U.col[ k ] == cand_col ){
-                                        exist = 1;
-                                        break;
-                                }
-                            }
-                        }
-                        // if it does not exist, increase counter for this location
-                        // use the entry one further down to allow for parallel insertion
-                        if( exist == 0 ){
-                            //printf("checked row: %d this element does not yet exist in L: (%d,%d)\n", cand_row, cand_col);
-                            numaddrowU++;
-                            //numaddL[ row+1 ]++;
-                        }
-                    }
-                }
-    
-            }
-            U_new->row[ row+1 ] = U_new->row[ row+1 ]+numaddrowU;
-            L_new->row[ row+1 ] = L_new->row[ row+1 ]+numaddrowL;
-        }
-    } // end ilu-fill
-    //end = magma_sync_wtime( queue ); printf("llop 1.2 : %.2e\n", end-start);
-    // #########################################################################
+    magma_int_t num_threads = 1, n = L.num_rows;
 
-    // get the total candidate count
-    L_new->nnz = 0;
-    U_new->nnz = 0;
-    L_new->row[ 0 ] = L_new->nnz;
-    U_new->row[ 0 ] = U_new->nnz;
+    // per thread: candidate buffers for L and U, their sizes and counts,
+    // and the offsets of the thread in L_new and U_new
+    magma_index_t **colL = NULL, **colU = NULL, *mark = NULL;
+    magmaDoubleComplex **valL = NULL, **valU = NULL;
+    magma_int_t *sizeL = NULL, *sizeU = NULL, *nnzL = NULL, *nnzU = NULL;
+    magma_int_t *offL = NULL, *offU = NULL;
 
-    #pragma omp parallel
-    {
-#ifdef _OPENMP
-    magma_int_t id = omp_get_thread_num();
-#else
-    magma_int_t id = 0;
-#endif
-        if( id == 0 ){
-            for( magma_int_t i = 0; i<L.num_rows; i++ ){
-                L_new->nnz = L_new->nnz + L_new->row[ i+1 ];
-                L_new->row[ i+1 ] = L_new->nnz;
-            }
-        }
-        if( id == num_threads-1 ){
-            for( magma_int_t i = 0; i<U.num_rows; i++ ){
-                U_new->nnz = U_new->nnz + U_new->row[ i+1 ];
-                U_new->row[ i+1 ] = U_new->nnz;
-            }
-        }
-    }
-    magma_zmalloc_cpu( &L_new->val, L_new->nnz );
-    magma_index_malloc_cpu( &L_new->rowidx, L_new->nnz );
-    magma_index_malloc_cpu( &L_new->col, L_new->nnz );
-    
-    magma_zmalloc_cpu( &U_new->val, U_new->nnz );
-    magma_index_malloc_cpu( &U_new->rowidx, U_new->nnz );
-    magma_index_malloc_cpu( &U_new->col, U_new->nnz );
-    
-    #pragma omp parallel for
-    for( magma_int_t i=0; i<L_new->nnz; i++ ){
-        L_new->val[i] = MAGMA_Z_ZERO;
-    }
-    #pragma omp parallel for
-    for( magma_int_t i=0; i<U_new->nnz; i++ ){
-        U_new->val[i] = MAGMA_Z_ZERO;
-    }
-    
-    #pragma omp parallel for
-    for( magma_int_t i=0; i<L_new->nnz; i++ ){
-        L_new->col[i] = -1;
-        L_new->rowidx[i] = -1;
-    }
-    #pragma omp parallel for
-    for( magma_int_t i=0; i<U_new->nnz; i++ ){
-        U_new->col[i] = -1;
-        U_new->rowidx[i] = -1;
-    }
-
-    // #########################################################################
+    const magmaDoubleComplex c_orig = MAGMA_Z_MAKE( 3.0, 0.0 );
+    const magmaDoubleComplex c_fill = MAGMA_Z_ONE;
 
-    
-    if( orig == 1 ){
-        
-       #pragma omp parallel for
-        for( magma_index_t row=0; row<L0.num_rows; row++){
-            magma_int_t laddL = 0;
-            magma_int_t offsetL = L_new->row[row];
-            magma_int_t ilu0 = L0.row[row];
-            magma_int_t ilut = L.row[row];
-            magma_int_t endilu0 = L0.row[ row+1 ];
-            magma_int_t endilut = L.row[ row+1 ]; 
-            magma_int_t ilu0col;
-            magma_int_t ilutcol;
-            do{
-                ilu0col = L0.col[ ilu0 ];
-                ilutcol = L.col[ ilut ];
-                if( ilu0col == ilutcol ){
-                    ilu0++;
-                    ilut++;
-                    if( existing==1 ){
-                        L_new->col[ offsetL + laddL ] = ilu0col;
-                        L_new->rowidx[ offsetL + laddL ] = row;
-                        L_new->val[ offsetL + laddL ] = MAGMA_Z_ONE;
-                        laddL++;
-                    }
-                }
-                else if( ilutcol<ilu0col ){
-                    if( existing==1 ){
-                        L_new->col[ offsetL + laddL ] = ilutcol;
-                        L_new->rowidx[ offsetL + laddL ] = row;
-                        L_new->val[ offsetL + laddL ] = MAGMA_Z_ONE;
-                        laddL++;
-                    }
-                    ilut++;
-                }
-                else {
-                    // this element is missing in the current approximation
-                    // mark it as candidate
-                    L_new->col[ offsetL + laddL ] = ilu0col;
-                    L_new->rowidx[ offsetL + laddL ] = row;
-                    L_new->val[ offsetL + laddL ] = MAGMA_Z_ONE + MAGMA_Z_ONE + MAGMA_Z_ONE;
-                    laddL++;
-                    ilu0++;
-                }
-            }while( ilut<endilut && ilu0<endilu0 );
-            if( ilu0<endilu0 ){
-                do{
-                    ilu0col = L0.col[ ilu0 ];
-                    L_new->col[ offsetL + laddL ] = ilu0col;
-                    L_new->rowidx[ offsetL + laddL ] = row;
-                    L_new->val[ offsetL + laddL ] = MAGMA_Z_ONE + MAGMA_Z_ONE + MAGMA_Z_ONE;
-                    laddL++;
-                    ilu0++;
-                }while( ilu0<endilu0 ); 
-            }
-            insertedL[row] = laddL;
-        }
-        
-        // same for U
-       #pragma omp parallel for
-        for( magma_index_t row=0; row<U0.num_rows; row++){
-            magma_int_t laddU = 0;
-            magma_int_t offsetU = U_new->row[row];
-            magma_int_t ilu0 = U0.row[row];
-            magma_int_t ilut = U.row[row];
-            magma_int_t endilu0 = U0.row[ row+1 ];
-            magma_int_t endilut = U.row[ row+1 ]; 
-            magma_int_t ilu0col;
-            magma_int_t ilutcol;
-            do{
-                ilu0col = U0.col[ ilu0 ];
-                ilutcol = U.col[ ilut ];
-                if( ilu0col == ilutcol ){
-                    ilu0++;
-                    ilut++;
-                    if( existing==1 ){
-                        U_new->col[ offsetU + laddU ] = ilu0col;
-                        U_new->rowidx[ offsetU + laddU ] = row;
-                        U_new->val[ offsetU + laddU ] = MAGMA_Z_ONE;
-                        laddU++;
-                    }
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    // the markers take num_threads * num_cols entries; limit the number of
+    // threads so they take at most 4 entries per nonzero of L and U, as
+    // resetting them would otherwise cost more than generating the candidates
+    if( L.num_cols > 0 ){
+        int64_t max_threads = 4 * (int64_t(L.nnz) + U.nnz) / L.num_cols;
+        if( max_threads < num_threads ){
+            num_threads = max( (magma_int_t) max_threads, 1 );
+        }
+    }
+    
+    L_new->num_rows = L.num_rows;
+    L_new->num_cols = L.num_cols;
+    L_new->storage_type = Magma_CSR;
+    L_new->memory_location = Magma_CPU;
+    
+    U_new->num_rows = L.num_rows;
+    U_new->num_cols = L.num_cols;
+    U_new->storage_type = Magma_CSR;
+    U_new->memory_location = Magma_CPU;
+
+    CHECK( magma_index_malloc_cpu( &L_new->row, n+1 ));
+    CHECK( magma_index_malloc_cpu( &U_new->row, n+1 ));
+    CHECK( magma_malloc_cpu( (void**) &colL, num_threads*sizeof(magma_index_t*) ));
+    CHECK( magma_malloc_cpu( (void**) &colU, num_threads*sizeof(magma_index_t*) ));
+    CHECK( magma_malloc_cpu( (void**) &valL, num_threads*sizeof(magmaDoubleComplex*) ));
+    CHECK( magma_malloc_cpu( (void**) &valU, num_threads*sizeof(magmaDoubleComplex*) ));
+    for( magma_int_t t=0; t<num_threads; t++ ){
+        colL[t] = NULL;
+        colU[t] = NULL;
+        valL[t] = NULL;
+        valU[t] = NULL;
+    }
+    CHECK( magma_imalloc_cpu( &sizeL, 6*num_threads ));
+    sizeU = sizeL + num_threads;
+    nnzL  = sizeU + num_threads;
+    nnzU  = nnzL  + num_threads;
+    offL  = nnzU  + num_threads;
+    offU  = offL  + num_threads;
+    for( magma_int_t t=0; t<6*num_threads; t++ ){
+        sizeL[t] = 0;
+    }
+    // one marker per thread and column: mark[col] == row if (row,col) is
+    // in L or U, or already a candidate. L and U columns of a row are disjoint.
+    CHECK( magma_index_malloc_cpu( &mark, size_t(num_threads) * max(L.num_cols, 1) ));
+    
+    // #########################################################################
+    // generate the candidates of each thread's rows into its buffers
+    #pragma omp parallel reduction(+:info)
+    {
+        magma_int_t nt = 1, id = 0;
+#ifdef _OPENMP
+        nt = omp_get_num_threads();
+        id = omp_get_thread_num();
+#endif
+        for( magma_int_t t=id; t<num_threads; t+=nt ){
+            magma_index_t *markt = mark + size_t(t) * max(L.num_cols, 1);
+            magma_int_t begin = magma_int_t( int64_t(n)*t / num_threads );
+            magma_int_t end = magma_int_t( int64_t(n)*(t+1) / num_threads );
+            for( magma_int_t col=0; col<L.num_cols; col++ ){
+                markt[col] = -1;
+            }
+            for( magma_index_t row=begin; row<end && info == 0; row++ ){
+                magma_int_t rowL = 0, rowU = 0;
+                for( magma_index_t k=L.row[row]; k<L.row[row+1]; k++ ){
+                    markt[ L.col[k] ] = row;
                 }
-                else if( ilutcol<ilu0col ){
-                    if( existing==1 ){
-                        U_new->col[ offsetU + laddU ] = ilutcol;
-                        U_new->rowidx[ offsetU + laddU ] = row;
-                        U_new->val[ offsetU + laddU ] = MAGMA_Z_ONE;
-                        laddU++;
+                for( magma_index_t k=U.row[row]; k<U.row[row+1]; k++ ){
+                    markt[ U.col[k] ] = row;
+                }
+                // room for the ILU(0) entries missing in L and U
+                info += magma_zparilut_candidates_grow( &colL[t], &valL[t], &sizeL[t],
+                                nnzL[t] + L0.row[row+1] - L0.row[row] );
+                info += magma_zparilut_candidates_grow( &colU[t], &valU[t], &sizeU[t],
+                                nnzU[t] + U0.row[row+1] - U0.row[row] );
+                if( info != 0 ){
+                    break;
+                }
+                
+                // go over the original matrix - this is the only way to allow
+                // elements to come back...
+                for( magma_index_t k=L0.row[row]; k<L0.row[row+1]; k++ ){
+                    magma_index_t col = L0.col[k];
+                    if( markt[col] != row ){
+                        markt[col] = row;
+                        colL[t][ nnzL[t] ] = col;
+                        valL[t][ nnzL[t] ] = c_orig;
+                        nnzL[t]++;
+                        rowL++;
                     }
-                    ilut++;
                 }
-                else {
-                    // this element is missing in the current approximation
-                    // mark it as candidate
-                    U_new->col[ offsetU + laddU ] = ilu0col;
-                    U_new->rowidx[ offsetU + laddU ] = row;
-                    U_new->val[ offsetU + laddU ] = MAGMA_Z_ONE + MAGMA_Z_ONE + MAGMA_Z_ONE;
-                    laddU++;
-                    ilu0++;
+                for( magma_index_t k=U0.row[row]; k<U0.row[row+1]; k++ ){
+                    magma_index_t col = U0.col[k];
+                    if( markt[col] != row ){
+                        markt[col] = row;
+                        colU[t][ nnzU[t] ] = col;
+                        valU[t][ nnzU[t] ] = c_orig;
+                        nnzU[t]++;
+                        rowU++;
+                    }
                 }
-            }while( ilut<endilut && ilu0<endilu0 );
-            if( ilu0<endilu0 ){
-                do{
-                    ilu0col = U0.col[ ilu0 ];
-                    U_new->col[ offsetU + laddU ] = ilu0col;
-                    U_new->rowidx[ offsetU + laddU ] = row;
-                    U_new->val[ offsetU + laddU ] = MAGMA_Z_ONE + MAGMA_Z_ONE + MAGMA_Z_ONE;
-                    laddU++;
-                    ilu0++;
-                }while( ilu0<endilu0 ); 
-            }
-            insertedU[row] = laddU;
-        }
-    } // end original
-    
-    if( ilufill==1 ){
-        #pragma omp parallel for
-        for( magma_index_t row=0; row<L.num_rows; row++){
-            magma_int_t laddL = 0;
-            magma_int_t laddU = 0;
-            magma_int_t offsetL = L_new->row[row] + insertedL[row];
-            magma_int_t offsetU = U_new->row[row] + insertedU[row];
-            // loop first element over row - only for elements smaller the diagonal
-            for( magma_index_t el1=L.row[row]; el1<L.row[row+1]-1; el1++ ){
                 
-                magma_index_t col1 = L.col[ el1 ];
-                // now check the upper triangular
-                // second loop first element over row - only for elements larger the intermediate
-                for( magma_index_t el2 = U.row[ col1 ]+1; el2 < U.row[ col1+1 ]; el2++ ){
-                    magma_index_t col2 = U.col[ el2 ];
-                    magma_index_t cand_row = row;
-                    magma_index_t cand_col = col2;
-                    //$########### we now have the candidate cand_row cand_col
-                    
-                    
-                    // check whether this element already exists
-                    // first case: part of L
-                    if( cand_col < row ){
-                        magma_int_t exist = 0;
-                        if( existing == 0 ){
-                            for(magma_index_t k=L.row[cand_row]; k<L.row[cand_row+1]; k++ ){
-                                if( L.col[ k ] == cand_col ){
-                                        exist = 1;
-                                        break;
-                                }
-                            }
-                        }
-    #ifdef AVOID_DUPLICATES
-                        for( magma_int_t k=L_new->row[cand_row]; k<L_new->row[cand_row+1]; k++){
-                            if( L_new->col[ k ] == cand_col ){
-                                // element included in LU and nonzero
-                                exist = 1;
-                                break;
-                            }
-                        }
-    #endif
-                        // if it does not exist, increase counter for this location
-                        // use the entry one further down to allow for parallel insertion
-                        if( exist == 0 ){
-                            //  printf("---------------->>>  candidate in L at (%d, %d)\n", cand_row, cand_col);
-                            //add in the next location for this row
-                            // L_new->val[ numaddL[row] + laddL ] =  MAGMA_Z_MAKE(1e-14,0.0);
-                            L_new->rowidx[ offsetL + laddL ] = cand_row;
-                            L_new->col[ offsetL + laddL ] = cand_col;
-                            L_new->val[ offsetL + laddL ] = MAGMA_Z_ONE;
-                            // L_new->list[ numaddL[row] + laddL ] = -1;
-                            // L_new->row[ numaddL[row] + laddL ] = -1;
-                            laddL++;
-                        }
-                    } else {
-                        // check whether this element already exists in U
-                        magma_int_t exist = 0;
-                        if( existing == 0 ){
-                            for(magma_index_t k=U.row[cand_row]; k<U.row[cand_row+1]; k++ ){
-                                if( U.col[ k ] == cand_col ){
-                                        exist = 1;
-                                        break;
-                                }
-                            }
-                        }
-    #ifdef AVOID_DUPLICATES
-                        for( magma_int_t k=U_new->row[cand_row]; k<U_new->row[cand_row+1]; k++){
-                            if( U_new->col[ k ] == cand_col ){
-                                // element included in LU and nonzero
-                                exist = 1;
-                                break;
-                            }
+                // how to determine candidates:
+                // for each node i, look at any "intermediate" neighbor nodes
+                // numbered less, and then see if this neighbor has another
+                // neighbor j numbered more than the intermediate; if so, fill
+                // in is (i,j) if it is not already nonzero
+                // loop first element over row - only for elements smaller the diagonal
+                for( magma_index_t el1=L.row[row]; el1<L.row[row+1]-1; el1++ ){
+                    magma_index_t col1 = L.col[ el1 ];
+                    magma_int_t len = U.row[ col1+1 ] - U.row[ col1 ];
+                    info += magma_zparilut_candidates_grow( &colL[t], &valL[t], &sizeL[t], nnzL[t] + len );
+                    info += magma_zparilut_candidates_grow( &colU[t], &valU[t], &sizeU[t], nnzU[t] + len );
+                    if( info != 0 ){
+                        break;
+                    }
+                    // second loop first element over row - only for elements larger the intermediate
+                    for( magma_index_t el2 = U.row[ col1 ]+1; el2 < U.row[ col1+1 ]; el2++ ){
+                        magma_index_t col2 = U.col[ el2 ];
+                        if( markt[col2] == row ){
+                            continue;
                         }
-    #endif
-                        // if it does not exist, increase counter for this location
-                        // use the entry one further down to allow for parallel insertion
-                        if( exist == 0 ){
-                            //  printf("---------------->>>  candidate in U at (%d, %d) stored in %d\n", cand_row, cand_col, numaddU[row] + laddU);
-                            //add in the next location for this row
-                            // U_new->val[ numaddU[row] + laddU ] =  MAGMA_Z_MAKE(1e-14,0.0);
-                            U_new->rowidx[ offsetU + laddU ] = cand_row;
-                            U_new->col[ offsetU + laddU ] = cand_col;
-                            U_new->val[ offsetU + laddU ] = MAGMA_Z_ONE;
-                            // U_new->list[ numaddU[row] + laddU ] = -1;
-                            // U_new->row[ numaddU[row] + laddU ] = -1;
-                            laddU++;
-                            //if( cand_row > cand_col )
-                             //   printf("inserted illegal candidate in case 4: (%d,%d) coming from (%d,%d)->(%d,%d)\n", cand_row, cand_col, row, col1, U.col[U.row[ cand_col ]], UR.col[ el2 ]);
+                        markt[col2] = row;
+                        if( col2 < row ){
+                            colL[t][ nnzL[t] ] = col2;
+                            valL[t][ nnzL[t] ] = c_fill;
+                            nnzL[t]++;
+                            rowL++;
+                        } else {
+                            colU[t][ nnzU[t] ] = col2;
+                            valU[t][ nnzU[t] ] = c_fill;
+                            nnzU[t]++;
+                            rowU++;
                         }
                     }
                 }
+                // count for now, row pointer after the offsets are known
+                L_new->row[ row+1 ] = rowL;
+                U_new->row[ row+1 ] = rowU;
             }
-            //insertedU[row] = insertedU[row] + laddU;
-            //insertedL[row] = insertedL[row] + laddL;
         }
-    } //end ilufill
-    
-#ifdef AVOID_DUPLICATES
-        // #####################################################################
-        
-        CHECK( magma_zparilut_thrsrm( 1, L_new, &thrs, queue ) );
-        CHECK( magma_zparilut_thrsrm( 1, U_new, &thrs, queue ) );
+    }
+    CHECK( info );
 
-        // #####################################################################
-#endif
+    // #########################################################################
+    // offsets of the threads, then allocate the fresh CSR
+    L_new->nnz = 0;
+    U_new->nnz = 0;
+    for( magma_int_t t=0; t<num_threads; t++ ){
+        offL[t] = L_new->nnz;
+        offU[t] = U_new->nnz;
+        L_new->nnz += nnzL[t];
+        U_new->nnz += nnzU[t];
+    }
+    L_new->row[ 0 ] = 0;
+    U_new->row[ 0 ] = 0;
+    CHECK( magma_zmalloc_cpu( &L_new->val, L_new->nnz ));
+    CHECK( magma_index_malloc_cpu( &L_new->rowidx, L_new->nnz ));
+    CHECK( magma_index_malloc_cpu( &L_new->col, L_new->nnz ));
+    CHECK( magma_zmalloc_cpu( &U_new->val, U_new->nnz ));
+    CHECK( magma_index_malloc_cpu( &U_new->rowidx, U_new->nnz ));
+    CHECK( magma_index_malloc_cpu( &U_new->col, U_new->nnz ));
+
+    // row pointers from the offsets, and copy of the buffers
+    #pragma omp parallel for schedule(static,1)
+    for( magma_int_t t=0; t<num_threads; t++ ){
+        magma_int_t begin = magma_int_t( int64_t(n)*t / num_threads );
+        magma_int_t end = magma_int_t( int64_t(n)*(t+1) / num_threads );
+        magma_index_t ptrL = offL[t], ptrU = offU[t];
+        for( magma_index_t row=begin; row<end; row++ ){
+            for( magma_index_t k=ptrL; k<ptrL + L_new->row[ row+1 ]; k++ ){
+                L_new->rowidx[k] = row;
+            }
+            for( magma_index_t k=ptrU; k<ptrU + U_new->row[ row+1 ]; k++ ){
+                U_new->rowidx[k] = row;
+            }
+            ptrL += L_new->row[ row+1 ];
+            ptrU += U_new->row[ row+1 ];
+            L_new->row[ row+1 ] = ptrL;
+            U_new->row[ row+1 ] = ptrU;
+        }
+        if( nnzL[t] > 0 ){
+            memcpy( L_new->col + offL[t], colL[t], nnzL[t]*sizeof(magma_index_t) );
+            memcpy( L_new->val + offL[t], valL[t], nnzL[t]*sizeof(magmaDoubleComplex) );
+        }
+        if( nnzU[t] > 0 ){
+            memcpy( U_new->col + offU[t], colU[t], nnzU[t]*sizeof(magma_index_t) );
+            memcpy( U_new->val + offU[t], valU[t], nnzU[t]*sizeof(magmaDoubleComplex) );
+        }
+    }
 
 cleanup:
-    magma_free_cpu( insertedL );
-    magma_free_cpu( insertedU );
+    for( magma_int_t t=0; colL != NULL && t<num_threads; t++ ){
+        magma_free_cpu( colL[t] );
+        magma_free_cpu( colU[t] );
+        magma_free_cpu( valL[t] );
+        magma_free_cpu( valU[t] );
+    }
+    magma_free_cpu( colL );
+    magma_free_cpu( colU );
+    magma_free_cpu( valL );
+    magma_free_cpu( valU );
+    magma_free_cpu( sizeL );
+    magma_free_cpu( mark );
     return info;
 }
 
@@ -4540,7 +4332,8 @@ cleanup:
 /***************************************************************************//**
     Purpose
     -------
-    This routine approximates the threshold for removing num_rm elements.
+    This routine computes the threshold for removing num_rm elements,
+    using the parallel sample-select magma_zsampleselect_cpu.
 
     Arguments
     ---------
@@ -4579,22 +4372,14 @@ magma_zparilut_set_thrs_randomselect(
     magma_int_t info = 0;
     
     magma_int_t size =  LU->nnz;
-    const magma_int_t incx = 1;
-    // copy as we may change the elements
-    magmaDoubleComplex *val=NULL;
-    CHECK( magma_zmalloc_cpu( &val, size ));
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
     assert( size > num_rm );
-    blasf77_zcopy(&size, LU->val, &incx, val, &incx );
-    if( order == 0 ){
-        magma_zselectrandom( val, size, num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[num_rm]);
-    } else {
-         magma_zselectrandom( val, size, size-num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
-    }
+    CHECK( magma_zsampleselect_cpu( size, (order == 0 ? num_rm : size-num_rm), 0,
+               LU->val, thrs, &tmp_ptr, &tmp_size, queue ));
 
 cleanup:
-    magma_free_cpu( val );
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
@@ -4604,6 +4389,7 @@ cleanup:
     -------
     This routine approximates the threshold for removing num_rm elements.
     It takes into account the scaling with the diagonal.
+    Uses the parallel sample-select magma_zsampleselect_cpu.
 
     Arguments
     ---------
@@ -4647,22 +4433,14 @@ magma_zparilut_set_thrs_L_scaled(
     magma_int_t info = 0;
     
     magma_int_t size =  L->nnz;
-    const magma_int_t incx = 1;
-    // copy as we may change the elements
-    magmaDoubleComplex *val=NULL;
-    CHECK( magma_zmalloc_cpu( &val, size ));
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
     assert( size > num_rm );
-    blasf77_zcopy(&size, L->val, &incx, val, &incx );
-    if( order == 0 ){
-        magma_zselectrandom( val, size, num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[num_rm]);
-    } else {
-         magma_zselectrandom( val, size, size-num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
-    }
+    CHECK( magma_zsampleselect_cpu( size, (order == 0 ? num_rm : size-num_rm), 0,
+               L->val, thrs, &tmp_ptr, &tmp_size, queue ));
 
 cleanup:
-    magma_free_cpu( val );
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
@@ -4752,7 +4530,8 @@ cleanup:
 /***************************************************************************//**
     Purpose
     -------
-    This routine approximates the threshold for removing num_rm elements.
+    This routine approximates the threshold for removing num_rm elements,
+    using one bucketing pass of magma_zsampleselect_approx_cpu.
 
     Arguments
     ---------
@@ -4791,70 +4570,14 @@ magma_zparilut_set_thrs_randomselect_approx(
     magma_int_t info = 0;
     
     magma_int_t size =  LU->nnz;
-    const magma_int_t incx = 1;
-    //magma_int_t incy = 1;
-    //magma_int_t nz_copy = LU->nnz;
-    magma_int_t num_threads = 1;
-    magma_int_t el_per_block;
-    //magma_int_t num_rm_loc;
-    magmaDoubleComplex *dthrs;
-    magmaDoubleComplex *val;
-    
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
+    assert( size > num_rm );
+    CHECK( magma_zsampleselect_approx_cpu( size, (order == 0 ? num_rm : size-num_rm), 0,
+               LU->val, thrs, &tmp_ptr, &tmp_size, queue ));
 
-    if( LU->nnz <= 680){
-       CHECK( magma_zparilut_set_thrs_randomselect(
-           num_rm,
-           LU,
-           order,
-           thrs,
-           queue ) );
-    } else {
-        CHECK( magma_zmalloc_cpu( &val, size ));
-        blasf77_zcopy(&size, LU->val, &incx, val, &incx );
-        assert( size > num_rm );
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-        num_threads = 272;
-        CHECK( magma_zmalloc_cpu( &dthrs, num_threads ));
-        
-        
-        el_per_block = magma_ceildiv( LU->nnz, num_threads );
-        
-        #pragma omp parallel for
-        for( magma_int_t i=0; i<num_threads; i++ ){
-            magma_int_t start = min(i*el_per_block, size);
-            magma_int_t end = min((i+1)*el_per_block,LU->nnz);
-            magma_int_t loc_nz = end-start;
-            magma_int_t loc_rm = (int) (num_rm)/num_threads;
-            if( i == num_threads-1){
-                loc_rm = (int) (loc_nz * num_rm)/size;
-            }
-            if( loc_nz > loc_rm ){
-            if( order == 0 ){
-                magma_zselectrandom( val+start, loc_nz, loc_rm, queue );
-                dthrs[i] = val[start+loc_rm];
-            } else {
-                 magma_zselectrandom( val+start, loc_nz, loc_nz-loc_rm, queue );
-                dthrs[i] = val[start+loc_nz-loc_rm];  
-            }
-        }
-            
-        }
-        
-        // compute the median
-        magma_zselectrandom( dthrs, num_threads, (num_threads+1)/2, queue);
-        
-        *thrs = MAGMA_Z_ABS(dthrs[(num_threads+1)/2]);
-    }
 cleanup:
-    magma_free_cpu( val );
-    magma_free_cpu( dthrs );
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
@@ -4927,7 +4650,8 @@ cleanup:
 /***************************************************************************//**
     Purpose
     -------
-    This routine provides the exact threshold for removing num_rm elements.
+    This routine provides the exact threshold for removing num_rm elements,
+    using the parallel sample-select magma_zsampleselect_cpu.
 
     Arguments
     ---------
@@ -4964,67 +4688,18 @@ magma_zparilut_set_exact_thrs(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    magmaDoubleComplex element;
-    magmaDoubleComplex *val=NULL;
-    const magma_int_t incy = 1;
-    const magma_int_t incx = 1;
-    magma_int_t loc_nnz;
-    double ratio;
-    magma_int_t loc_num_rm;
-    magma_int_t num_threads=1;
-    magmaDoubleComplex *elements = NULL;
-
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-    // two options: either there are enough candidates such that we can use
-    // a parallel first step of order-statistics, or not...
-    
-    ratio = ((double)num_rm)/((double)LU->nnz);
-    loc_num_rm = (int) ((double)ratio*(double)loc_nnz);
-    loc_num_rm = num_rm;
-    CHECK( magma_zmalloc_cpu( &val, loc_nnz ));
-    CHECK( magma_zmalloc_cpu( &elements, num_threads ));
     
-    blasf77_zcopy(&loc_nnz, LU->val, &incx, val, &incy );
-    // first step: every thread sorts a chunk of the array
-    // extract the num_rm elements in this chunk
-    // this only works if num_rm > loc_nnz / num_threads
-    if( loc_nnz / num_threads > loc_num_rm ){
-        #pragma omp parallel
-        {
-    #ifdef _OPENMP
-    magma_int_t id = omp_get_thread_num();
-#else
-    magma_int_t id = 0;
-#endif
-            if(id<num_threads){
-                magma_zorderstatistics(
-                    val + id*loc_nnz/num_threads, loc_nnz/num_threads, loc_num_rm, order, &elements[id], queue );
-            }
-        }
-        // Now copy the num_rm left-most elements of every chunk to the beginning of the array.
-        for( magma_int_t i=1; i<num_threads; i++){
-            blasf77_zcopy(&loc_num_rm, val+i*loc_nnz/num_threads, &incy, val+i*loc_num_rm, &incy );
-        }
-        // now we only look at the left num_threads*num_rm elements and use order stats
-        magma_zorderstatistics(
-                    val, num_threads*loc_num_rm, loc_num_rm, order, &element, queue );
-    } else {
-        magma_zorderstatistics(
-                    val, loc_nnz, loc_num_rm, order, &element, queue );
-    }
-
-    *thrs = element;
+    magma_int_t size =  LU->nnz;
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
+    double element = 0.0;
+    assert( size > num_rm );
+    CHECK( magma_zsampleselect_cpu( size, (order == 0 ? num_rm : size-num_rm), 0,
+               LU->val, &element, &tmp_ptr, &tmp_size, queue ));
+    *thrs = MAGMA_Z_MAKE( element, 0.0 );
 
 cleanup:
-    magma_free_cpu( val );
-    magma_free_cpu( elements );
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
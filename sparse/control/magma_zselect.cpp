@@ -12,9 +12,26 @@
 //  in this file, many routines are taken from
 //  the IO functions provided by MatrixMarket
 
+#include <algorithm>
+
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #define SWAP(a, b)  { tmp = a; a = b; b = tmp; }
 
+// default number of samples and number of buckets of the sample-select;
+// bucket indices are stored in one byte
+#define SAMPLESELECT_SAMPLE_SIZE 1024
+#define SAMPLESELECT_BUCKETS     256
+
+// exact selection in arrays shorter than this uses std::nth_element
+#define SAMPLESELECT_BASECASE    4096
+
+// arrays shorter than this are processed single-threaded
+#define SAMPLESELECT_PARALLEL_SIZE 65536
+
 
 magma_int_t
 magma_zpartition( 
@@ -227,3 +244,338 @@ magma_zselectrandom(
     }
     return info;
 }
+
+
+
+// Returns number of threads to use for selecting from n elements:
+// 1 for small arrays or if called from inside a parallel region.
+static magma_int_t
+magma_zsampleselect_num_threads( magma_int_t n )
+{
+    magma_int_t num_threads = 1;
+#ifdef _OPENMP
+    if ( n >= SAMPLESELECT_PARALLEL_SIZE && ! omp_in_parallel() ) {
+        num_threads = omp_get_max_threads();
+    }
+#endif
+    return num_threads;
+}
+
+
+// Magnitude used as key of the sample-select; NaN is ordered last.
+// MAGMA_Z_ABS scales, so tiny and huge entries neither underflow nor overflow.
+static inline double
+magma_zsampleselect_key( const magmaDoubleComplex& x )
+{
+    double a = MAGMA_Z_ABS( x );
+    return (a != a ? (double) MAGMA_D_INF : a);
+}
+
+
+// Sample-select on the magnitudes of val. With exact = 1 returns in
+// *thrs the magnitude of the element of rank subset_size in ascending order,
+// otherwise an approximation from a single bucketing pass.
+static magma_int_t
+magma_zsampleselect_cpu_template(
+    magma_int_t exact,
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magma_int_t sample_size,
+    const magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size )
+{
+    magma_int_t info = 0;
+
+    magma_int_t n = total_size, k = subset_size;
+    magma_int_t num_threads = magma_zsampleselect_num_threads( n );
+    magma_int_t nsample, nbucket, bucket;
+    size_t required_size;
+    double *cur = NULL, *next = NULL, *sample, *splitter;
+    magma_int_t *counts;
+    unsigned char *oracle = NULL;
+    // deterministic pseudo-random sample positions, so thresholds are reproducible
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+
+    if ( total_size <= 0 ) {
+        info = -1;
+    } else if ( subset_size < 0 || subset_size >= total_size ) {
+        info = -2;
+    } else if ( sample_size < 0 ) {
+        info = -3;
+    }
+    if ( info != 0 ) {
+        goto cleanup;
+    }
+
+    nsample = min( (sample_size > 0 ? sample_size : SAMPLESELECT_SAMPLE_SIZE), n );
+    // workspace: sample, splitters, per-thread bucket counts, and for the
+    // exact selection two buffers of keys and the bucket index per element
+    required_size = size_t(nsample + SAMPLESELECT_BUCKETS) * sizeof(double)
+                  + size_t(num_threads) * SAMPLESELECT_BUCKETS * sizeof(magma_int_t)
+                  + (exact || n <= nsample ? size_t(n) * (2*sizeof(double) + 1) : 0);
+    CHECK( magma_realloc_cpu_if_necessary( tmp_ptr, tmp_size, required_size ));
+    sample   = (double*) *tmp_ptr;
+    splitter = sample + nsample;
+    counts   = (magma_int_t*) (splitter + SAMPLESELECT_BUCKETS);
+    if ( exact || n <= nsample ) {
+        cur    = (double*) (counts + num_threads * SAMPLESELECT_BUCKETS);
+        next   = cur + n;
+        oracle = (unsigned char*) (next + n);
+    }
+
+    if ( n <= nsample ) {
+        for( magma_int_t i=0; i < n; i++ ){
+            cur[i] = magma_zsampleselect_key( val[i] );
+        }
+    }
+
+    // the first round reads the keys from val, later rounds from cur
+    for( magma_int_t round=0; true; round++ ){
+        if ( n <= nsample || (round > 0 && n <= SAMPLESELECT_BASECASE) ) {
+            std::nth_element( cur, cur + k, cur + n );
+            *thrs = cur[k];
+            break;
+        }
+
+        // sorted sample, and splitters evenly spaced in the sample;
+        // bucket b holds splitter[b-1] <= x < splitter[b]
+        for( magma_int_t j=0; j < nsample; j++ ){
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            magma_int_t i = (magma_int_t) ((state >> 33) % n);
+            sample[j] = (round == 0 ? magma_zsampleselect_key( val[i] ) : cur[i]);
+        }
+        std::sort( sample, sample + nsample );
+        nbucket = 2;
+        while( 2*nbucket <= min( (magma_int_t) SAMPLESELECT_BUCKETS, nsample )) {
+            nbucket *= 2;
+        }
+        for( magma_int_t b=1; b < nbucket; b++ ){
+            splitter[b-1] = sample[ b*nsample / nbucket ];
+        }
+
+        // bucket counts of each thread's chunk, with a branch-free search
+        #pragma omp parallel for num_threads(num_threads)
+        for( magma_int_t t=0; t < num_threads; t++ ){
+            magma_int_t *cnt = counts + t*SAMPLESELECT_BUCKETS;
+            for( magma_int_t b=0; b < nbucket; b++ ){
+                cnt[b] = 0;
+            }
+            magma_int_t ibeg = magma_int_t( (int64_t) t * n / num_threads );
+            magma_int_t iend = magma_int_t( (int64_t) (t+1) * n / num_threads );
+            for( magma_int_t i=ibeg; i < iend; i++ ){
+                double x = (round == 0 ? magma_zsampleselect_key( val[i] ) : cur[i]);
+                magma_int_t b = 0;
+                for( magma_int_t step = nbucket/2; step > 0; step /= 2 ){
+                    b += (x >= splitter[ b+step-1 ] ? step : 0);
+                }
+                cnt[b]++;
+                if ( exact ) {
+                    if ( round == 0 ) {
+                        cur[i] = x;
+                    }
+                    oracle[i] = (unsigned char) b;
+                }
+            }
+        }
+
+        // bucket containing rank k
+        magma_int_t before = 0, count = 0;
+        for( bucket=0; bucket < nbucket; bucket++ ){
+            count = 0;
+            for( magma_int_t t=0; t < num_threads; t++ ){
+                count += counts[ t*SAMPLESELECT_BUCKETS + bucket ];
+            }
+            if ( k < before + count ) {
+                break;
+            }
+            before += count;
+        }
+
+        if ( ! exact ) {
+            // the bucket bound closer in rank to k
+            if ( 2*(k - before) < count ) {
+                *thrs = (bucket > 0 ? splitter[bucket-1] : sample[0]);
+            } else {
+                *thrs = (bucket < nbucket-1 ? splitter[bucket] : sample[nsample-1]);
+            }
+            break;
+        }
+        if ( count == n ) {
+            // no progress, e.g., all values equal
+            std::nth_element( cur, cur + k, cur + n );
+            *thrs = cur[k];
+            break;
+        }
+
+        // gather the bucket into next, each thread after the preceding ones
+        #pragma omp parallel for num_threads(num_threads)
+        for( magma_int_t t=0; t < num_threads; t++ ){
+            magma_int_t offset = 0;
+            for( magma_int_t s=0; s < t; s++ ){
+                offset += counts[ s*SAMPLESELECT_BUCKETS + bucket ];
+            }
+            magma_int_t ibeg = magma_int_t( (int64_t) t * n / num_threads );
+            magma_int_t iend = magma_int_t( (int64_t) (t+1) * n / num_threads );
+            for( magma_int_t i=ibeg; i < iend; i++ ){
+                if ( oracle[i] == bucket ) {
+                    next[ offset++ ] = cur[i];
+                }
+            }
+        }
+        std::swap( cur, next );
+        n = count;
+        k = k - before;
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects a threshold separating the subset_size smallest
+    magnitude elements from the rest, i.e., it returns the magnitude of the
+    element of rank subset_size in ascending order of magnitude (0-based).
+    CPU counterpart of magma_zsampleselect.
+
+    The magnitudes are sorted into 256 buckets bounded by splitters
+    taken from a sorted random sample. Only the bucket containing the sought rank
+    is kept, and the process is repeated until it is small enough for a
+    direct selection. Bucket counts and the gathering of the bucket are
+    done in parallel with OpenMP for arrays longer than 65536 elements,
+    unless called from inside a parallel region. val is not modified.
+    NaN values are ordered last.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate, 0 <= subset_size < total_size
+
+    @param[in]
+    sample_size magma_int_t
+                number of samples used to determine the splitters;
+                0 selects the default 1024.
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary CPU storage.
+                May be reallocated during execution.
+
+    @param[in,out]
+    tmp_size    size_t*
+                pointer to size of temporary storage in bytes.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magma_int_t sample_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue )
+{
+    return magma_zsampleselect_cpu_template( 1, total_size, subset_size,
+                sample_size, val, thrs, tmp_ptr, tmp_size );
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects an approximate threshold separating the subset_size
+    smallest magnitude elements from the rest.
+    CPU counterpart of magma_zsampleselect_approx.
+
+    A single bucketing pass of magma_zsampleselect_cpu is done, and the
+    bound of the bucket containing rank subset_size that is closer in rank
+    is returned. The error in rank is at most half the bucket size, about
+    total_size / 512 for the default sample size. Arrays not longer than
+    the sample are selected exactly.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate, 0 <= subset_size < total_size
+
+    @param[in]
+    sample_size magma_int_t
+                number of samples used to determine the splitters;
+                0 selects the default 1024.
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary CPU storage.
+                May be reallocated during execution.
+
+    @param[in,out]
+    tmp_size    size_t*
+                pointer to size of temporary storage in bytes.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magma_int_t sample_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue )
+{
+    return magma_zsampleselect_cpu_template( 0, total_size, subset_size,
+                sample_size, val, thrs, tmp_ptr, tmp_size );
+}
@@ -245,6 +245,20 @@ magma_zsolverinfo(
                 break;
         }
         
+        switch( precond_par->reorder ) {
+            case Magma_RCM:
+                printf("%%   Reordering used: reverse Cuthill-McKee.\n");
+                break;
+            case Magma_AMD:
+                printf("%%   Reordering used: approximate minimum degree.\n");
+                break;
+            case Magma_ND:
+                printf("%%   Reordering used: nested dissection.\n");
+                break;
+            default:
+                break;
+        }
+        
         printf("%%=================================================================================%%\n");
         switch( solver_par->solver ) {
             case Magma_CG:
@@ -608,6 +622,14 @@ magma_zsolverinfo_init(
     precond_par->U_dgraphindegree = NULL;
     precond_par->L_dgraphindegree_bak = NULL;
     precond_par->U_dgraphindegree_bak = NULL;
+    
+    precond_par->P.val = NULL;
+    precond_par->P.col = NULL;
+    precond_par->P.row = NULL;
+    precond_par->PT.val = NULL;
+    precond_par->PT.col = NULL;
+    precond_par->PT.row = NULL;
+    precond_par->Pwork.val = NULL;
 
 cleanup:
     if( info != 0 ){
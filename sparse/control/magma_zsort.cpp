@@ -12,7 +12,14 @@
 //  in this file, many routines are taken from
 //  the IO functions provided by MatrixMarket
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 #define SWAP(a, b)  { tmp = val[a]; val[a] = val[b]; val[b] = tmp; }
@@ -23,11 +30,479 @@
 #define UP 0
 #define DOWN 1
 
+// bits per digit and number of buckets of the radix sort
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+// arrays shorter than this are sorted by insertion sort
+#define SORT_INSERTION_SIZE 32
+
+// arrays shorter than this are sorted single-threaded
+#define SORT_PARALLEL_SIZE 65536
+
+
+// (|x|, position) key used by the merge sort. Ties in |x| are broken by the
+// original position, so all keys are distinct and the sort is stable.
+typedef struct magma_zsort_key
+{
+    double key;
+    magma_int_t idx;
+} magma_zsort_key;
+
+
+static inline bool
+magma_zsort_key_less( const magma_zsort_key& a, const magma_zsort_key& b )
+{
+    return a.key < b.key || (a.key == b.key && a.idx < b.idx);
+}
+
+
+// Returns t*n/p, the start of part t of n elements split into p parts,
+// without overflow of t*n.
+static inline magma_int_t
+magma_zsort_split( magma_int_t t, magma_int_t n, magma_int_t p )
+{
+    return magma_int_t( int64_t(t) * n / p );
+}
+
+
+// Checks length n of the arrays to sort: positions must fit in magma_index_t,
+// as they are carried in index arrays.
+static inline magma_int_t
+magma_zsort_check_size( magma_int_t n )
+{
+    if ( n < 0 ) {
+        return -1;
+    }
+    if ( int64_t(n) > int64_t( (std::numeric_limits<magma_index_t>::max)() ) ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    return 0;
+}
+
+
+// Returns number of threads to use for sorting n elements:
+// 1 for small arrays or if called from inside a parallel region.
+static magma_int_t
+magma_zsort_num_threads( magma_int_t n )
+{
+    magma_int_t num_threads = 1;
+#ifdef _OPENMP
+    if ( n >= SORT_PARALLEL_SIZE && ! omp_in_parallel() ) {
+        num_threads = omp_get_max_threads();
+    }
+#endif
+    return num_threads;
+}
+
+
+// Stable insertion sort of x by |x|, permuting col and row (if not NULL) alike.
+static void
+magma_zmsort_insertion(
+    magma_int_t n,
+    magmaDoubleComplex *x,
+    magma_index_t *col,
+    magma_index_t *row )
+{
+    for( magma_int_t i=1; i < n; i++ ){
+        magmaDoubleComplex xi = x[i];
+        double ai = MAGMA_Z_ABS( xi );
+        magma_index_t ci = (col != NULL ? col[i] : 0);
+        magma_index_t ri = (row != NULL ? row[i] : 0);
+        magma_int_t j = i-1;
+        while( j >= 0 && MAGMA_Z_ABS( x[j] ) > ai ){
+            x[j+1] = x[j];
+            if ( col != NULL ) col[j+1] = col[j];
+            if ( row != NULL ) row[j+1] = row[j];
+            j--;
+        }
+        x[j+1] = xi;
+        if ( col != NULL ) col[j+1] = ci;
+        if ( row != NULL ) row[j+1] = ri;
+    }
+}
+
+
+// Stable insertion sort of x, permuting y (if not NULL) alike.
+static void
+magma_zindexsort_insertion(
+    magma_int_t n,
+    magma_index_t *x,
+    magmaDoubleComplex *y )
+{
+    for( magma_int_t i=1; i < n; i++ ){
+        magma_index_t xi = x[i];
+        magmaDoubleComplex yi = (y != NULL ? y[i] : MAGMA_Z_ZERO);
+        magma_int_t j = i-1;
+        while( j >= 0 && x[j] > xi ){
+            x[j+1] = x[j];
+            if ( y != NULL ) y[j+1] = y[j];
+            j--;
+        }
+        x[j+1] = xi;
+        if ( y != NULL ) y[j+1] = yi;
+    }
+}
+
+
+// Returns how many of the first k elements of merge(A, B) come from A.
+static magma_int_t
+magma_zsort_corank(
+    magma_int_t k,
+    const magma_zsort_key *A, magma_int_t la,
+    const magma_zsort_key *B, magma_int_t lb )
+{
+    magma_int_t lo = max( 0, k - lb );
+    magma_int_t hi = min( k, la );
+    while( lo < hi ){
+        magma_int_t mid = (lo + hi) / 2;
+        if ( magma_zsort_key_less( A[mid], B[k - mid - 1] ) ) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
 /**
     Purpose
     -------
 
-    Sorts an array of values in increasing order.
+    Sorts an array of values in increasing order of their magnitude,
+    optionally permuting two index arrays alike.
+    The sort is stable. It computes |x| once, sorts (|x|, position) keys
+    in per-thread runs, and merges the runs in parallel, splitting each merge
+    among all threads by merge-path partitioning. NaN values are ordered last.
+
+    Arrays longer than SORT_PARALLEL_SIZE are sorted using OpenMP,
+    unless called from inside a parallel region.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the arrays. Positions are carried in magma_index_t,
+                so n larger than the largest magma_index_t is rejected with
+                MAGMA_ERR_NOT_SUPPORTED.
+
+    @param[in,out]
+    x           magmaDoubleComplex*
+                array to sort
+
+    @param[in,out]
+    col         magma_index_t*
+                array permuted as x, or NULL.
+
+    @param[in,out]
+    row         magma_index_t*
+                array permuted as x, or NULL.
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary CPU storage.
+                May be reallocated during execution.
+
+    @param[in,out]
+    tmp_size    size_t*
+                pointer to size of temporary storage in bytes.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmergesort(
+    magma_int_t n,
+    magmaDoubleComplex *x,
+    magma_index_t *col,
+    magma_index_t *row,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_zsort_key *src, *dst;
+    magmaDoubleComplex *xtmp;
+    magma_index_t *itmp;
+    magma_int_t num_threads, nruns;
+    std::vector< magma_int_t > bounds;
+
+    CHECK( magma_zsort_check_size( n ));
+    if ( n < SORT_INSERTION_SIZE ) {
+        magma_zmsort_insertion( n, x, col, row );
+        goto cleanup;
+    }
+
+    num_threads = magma_zsort_num_threads( n );
+    CHECK( magma_realloc_cpu_if_necessary( tmp_ptr, tmp_size,
+               size_t(n) * (2*sizeof(magma_zsort_key) + sizeof(magmaDoubleComplex)) ));
+    src  = (magma_zsort_key*) *tmp_ptr;
+    dst  = src + n;
+    xtmp = (magmaDoubleComplex*) (dst + n);
+
+    // initial runs: one per thread
+    nruns = num_threads;
+    bounds.resize( nruns+1 );
+    for( magma_int_t t=0; t <= nruns; t++ ){
+        bounds[t] = magma_zsort_split( t, n, nruns );
+    }
+
+    #pragma omp parallel for num_threads(num_threads)
+    for( magma_int_t t=0; t < nruns; t++ ){
+        for( magma_int_t i=bounds[t]; i < bounds[t+1]; i++ ){
+            double a = MAGMA_Z_ABS( x[i] );
+            src[i].key = (a != a ? (double) MAGMA_D_INF : a);
+            src[i].idx = i;
+        }
+        std::sort( src + bounds[t], src + bounds[t+1], magma_zsort_key_less );
+    }
+
+    // merge pairs of runs; each merge is split among num_threads parts
+    while( nruns > 1 ){
+        magma_int_t npairs = (nruns + 1) / 2;
+        #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+        for( int64_t w=0; w < int64_t(npairs)*num_threads; w++ ){
+            magma_int_t p = magma_int_t( w / num_threads );
+            magma_int_t q = magma_int_t( w % num_threads );
+            magma_int_t a0 = bounds[ 2*p ];
+            magma_int_t a1 = bounds[ min( 2*p+1, nruns ) ];
+            magma_int_t b1 = bounds[ min( 2*p+2, nruns ) ];
+            magma_int_t la = a1 - a0, lb = b1 - a1, len = b1 - a0;
+            magma_int_t k0 = magma_zsort_split( q,   len, num_threads );
+            magma_int_t k1 = magma_zsort_split( q+1, len, num_threads );
+            magma_int_t i  = magma_zsort_corank( k0, src+a0, la, src+a1, lb );
+            magma_int_t ie = magma_zsort_corank( k1, src+a0, la, src+a1, lb );
+            magma_int_t j  = k0 - i;
+            magma_int_t je = k1 - ie;
+            magma_int_t k  = a0 + k0;
+            while( i < ie && j < je ){
+                if ( magma_zsort_key_less( src[a1+j], src[a0+i] ) ) {
+                    dst[k++] = src[a1 + j++];
+                } else {
+                    dst[k++] = src[a0 + i++];
+                }
+            }
+            while( i < ie ) dst[k++] = src[a0 + i++];
+            while( j < je ) dst[k++] = src[a1 + j++];
+        }
+        for( magma_int_t p=0; p < npairs; p++ ){
+            bounds[p] = bounds[ 2*p ];
+        }
+        bounds[npairs] = n;
+        nruns = npairs;
+        std::swap( src, dst );
+    }
+
+    // apply permutation; dst is free and serves as index scratch
+    #pragma omp parallel for num_threads(num_threads)
+    for( magma_int_t i=0; i < n; i++ ){
+        xtmp[i] = x[ src[i].idx ];
+    }
+    #pragma omp parallel for num_threads(num_threads)
+    for( magma_int_t i=0; i < n; i++ ){
+        x[i] = xtmp[i];
+    }
+    itmp = (magma_index_t*) dst;
+    if ( col != NULL ) {
+        #pragma omp parallel for num_threads(num_threads)
+        for( magma_int_t i=0; i < n; i++ ){
+            itmp[i] = col[ src[i].idx ];
+        }
+        #pragma omp parallel for num_threads(num_threads)
+        for( magma_int_t i=0; i < n; i++ ){
+            col[i] = itmp[i];
+        }
+    }
+    if ( row != NULL ) {
+        #pragma omp parallel for num_threads(num_threads)
+        for( magma_int_t i=0; i < n; i++ ){
+            itmp[i] = row[ src[i].idx ];
+        }
+        #pragma omp parallel for num_threads(num_threads)
+        for( magma_int_t i=0; i < n; i++ ){
+            row[i] = itmp[i];
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Sorts an array of integers in increasing order,
+    optionally permuting an array of values alike.
+    Uses a stable LSD radix sort with 8-bit digits. Digits in which
+    all keys agree are skipped, so, e.g., column indices below 65536
+    need only two passes. Each pass builds per-thread histograms,
+    a prefix sum over (digit, thread), and scatters in parallel.
+
+    Arrays longer than SORT_PARALLEL_SIZE are sorted using OpenMP,
+    unless called from inside a parallel region.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the arrays. Positions are carried in magma_index_t,
+                so n larger than the largest magma_index_t is rejected with
+                MAGMA_ERR_NOT_SUPPORTED.
+
+    @param[in,out]
+    x           magma_index_t*
+                array to sort
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                array permuted as x, or NULL.
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary CPU storage.
+                May be reallocated during execution.
+
+    @param[in,out]
+    tmp_size    size_t*
+                pointer to size of temporary storage in bytes.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zindexsort_radix(
+    magma_int_t n,
+    magma_index_t *x,
+    magmaDoubleComplex *y,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    // flipping the sign bit maps signed keys to unsigned keys in the same order
+    const magma_uindex_t sign = magma_uindex_t(1) << (8*sizeof(magma_index_t) - 1);
+    const magma_int_t nbits = 8*sizeof(magma_index_t);
+
+    magma_index_t *src_x, *dst_x, *xtmp;
+    magmaDoubleComplex *src_y, *dst_y, *ytmp;
+    magma_int_t *hist;
+    magma_int_t num_threads;
+    magma_uindex_t diff = 0;
+
+    CHECK( magma_zsort_check_size( n ));
+    if ( n < SORT_INSERTION_SIZE ) {
+        magma_zindexsort_insertion( n, x, y );
+        goto cleanup;
+    }
+
+    num_threads = magma_zsort_num_threads( n );
+    CHECK( magma_realloc_cpu_if_necessary( tmp_ptr, tmp_size,
+               (y != NULL ? size_t(n)*sizeof(magmaDoubleComplex) : 0)
+               + size_t(num_threads)*RADIX_SIZE*sizeof(magma_int_t)
+               + size_t(n)*sizeof(magma_index_t) ));
+    ytmp = (y != NULL ? (magmaDoubleComplex*) *tmp_ptr : NULL);
+    hist = (magma_int_t*) (y != NULL ? (void*) (ytmp + n) : *tmp_ptr);
+    xtmp = (magma_index_t*) (hist + num_threads*RADIX_SIZE);
+
+    // bits in which keys differ; digits with no such bit need no pass
+    #pragma omp parallel for reduction(|:diff) num_threads(num_threads)
+    for( magma_int_t i=0; i < n; i++ ){
+        diff |= magma_uindex_t( x[i] ) ^ magma_uindex_t( x[0] );
+    }
+
+    src_x = x;     dst_x = xtmp;
+    src_y = y;     dst_y = ytmp;
+    for( magma_int_t shift=0; shift < nbits; shift += RADIX_BITS ){
+        if ( ((diff >> shift) & (RADIX_SIZE-1)) == 0 ) {
+            continue;
+        }
+        #pragma omp parallel num_threads(num_threads)
+        {
+            #ifdef _OPENMP
+            magma_int_t id = omp_get_thread_num();
+            magma_int_t nt = omp_get_num_threads();
+            #else
+            magma_int_t id = 0;
+            magma_int_t nt = 1;
+            #endif
+            magma_int_t lo = magma_zsort_split( id,   n, nt );
+            magma_int_t hi = magma_zsort_split( id+1, n, nt );
+            magma_int_t *h = hist + id*RADIX_SIZE;
+
+            for( magma_int_t d=0; d < RADIX_SIZE; d++ ){
+                h[d] = 0;
+            }
+            for( magma_int_t i=lo; i < hi; i++ ){
+                h[ ((magma_uindex_t( src_x[i] ) ^ sign) >> shift) & (RADIX_SIZE-1) ]++;
+            }
+            #pragma omp barrier
+            #pragma omp single
+            {
+                // exclusive prefix sum, digit-major, so equal digits keep thread order
+                magma_int_t sum = 0;
+                for( magma_int_t d=0; d < RADIX_SIZE; d++ ){
+                    for( magma_int_t t=0; t < nt; t++ ){
+                        magma_int_t cnt = hist[ t*RADIX_SIZE + d ];
+                        hist[ t*RADIX_SIZE + d ] = sum;
+                        sum += cnt;
+                    }
+                }
+            }
+            for( magma_int_t i=lo; i < hi; i++ ){
+                magma_int_t pos = h[ ((magma_uindex_t( src_x[i] ) ^ sign) >> shift) & (RADIX_SIZE-1) ]++;
+                dst_x[pos] = src_x[i];
+                if ( y != NULL ) {
+                    dst_y[pos] = src_y[i];
+                }
+            }
+        }
+        std::swap( src_x, dst_x );
+        std::swap( src_y, dst_y );
+    }
+
+    // odd number of passes: result is in workspace
+    if ( src_x != x ) {
+        #pragma omp parallel for num_threads(num_threads)
+        for( magma_int_t i=0; i < n; i++ ){
+            x[i] = src_x[i];
+            if ( y != NULL ) {
+                y[i] = src_y[i];
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Sorts an array of values in increasing order of their magnitude.
+    The sort is stable. Wrapper around magma_zmergesort that allocates
+    its own workspace; use magma_zmergesort directly to reuse workspace
+    across calls.
 
     Arguments
     ---------
@@ -61,33 +536,15 @@ magma_zsort(
 {
     magma_int_t info = 0;
 
-    magmaDoubleComplex temp;
-    magma_index_t pivot,j,i;
-
-    if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( MAGMA_Z_ABS(x[i]) <= MAGMA_Z_ABS(x[pivot]) && i<last )
-                i++;
-            while( MAGMA_Z_ABS(x[j]) > MAGMA_Z_ABS(x[pivot]) )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-            }
-        }
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
 
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
-        CHECK( magma_zsort( x, first, j-1, queue ));
-        CHECK( magma_zsort( x, j+1, last, queue ));
+    if( first < last ){
+        CHECK( magma_zmergesort( last-first+1, x+first, NULL, NULL,
+                                 &tmp_ptr, &tmp_size, queue ));
     }
 cleanup:
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
@@ -96,7 +553,10 @@ cleanup:
     Purpose
     -------
 
-    Sorts an array of values in increasing order.
+    Sorts an array of values in increasing order of their magnitude,
+    and permutes the index arrays col and row alike.
+    The sort is stable. Wrapper around magma_zmergesort that allocates
+    its own workspace.
 
     Arguments
     ---------
@@ -140,39 +600,15 @@ magma_zmsort(
 {
     magma_int_t info = 0;
 
-    magmaDoubleComplex temp;
-    magma_index_t pivot,j,i, tmpcol, tmprow;
-
-    if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( MAGMA_Z_ABS(x[i]) <= MAGMA_Z_ABS(x[pivot]) && i<last )
-                i++;
-            while( MAGMA_Z_ABS(x[j]) > MAGMA_Z_ABS(x[pivot]) )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-                tmpcol = col[i];
-                col[i] = col[j];
-                col[j] = tmpcol;
-                tmprow = row[i];
-                row[i] = row[j];
-                row[j] = tmprow;
-            }
-        }
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
 
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
-        CHECK( magma_zmsort( x, col, row, first, j-1, queue ));
-        CHECK( magma_zmsort( x, col, row, j+1, last, queue ));
+    if( first < last ){
+        CHECK( magma_zmergesort( last-first+1, x+first, col+first, row+first,
+                                 &tmp_ptr, &tmp_size, queue ));
     }
 cleanup:
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
@@ -182,6 +618,9 @@ cleanup:
     -------
 
     Sorts an array of integers in increasing order.
+    The sort is stable. Wrapper around magma_zindexsort_radix that allocates
+    its own workspace; use magma_zindexsort_radix directly to reuse workspace
+    across calls.
 
     Arguments
     ---------
@@ -215,32 +654,15 @@ magma_zindexsort(
 {
     magma_int_t info = 0;
 
-    magma_index_t pivot,j,temp,i;
-
-    if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( x[i]<=x[pivot] && i<last )
-                i++;
-            while( x[j]>x[pivot] )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-            }
-        }
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
 
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
-        CHECK( magma_zindexsort( x, first, j-1, queue ));
-        CHECK( magma_zindexsort( x, j+1, last, queue ));
+    if( first < last ){
+        CHECK( magma_zindexsort_radix( last-first+1, x+first, NULL,
+                                       &tmp_ptr, &tmp_size, queue ));
     }
 cleanup:
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
@@ -250,6 +672,8 @@ cleanup:
     -------
 
     Sorts an array of integers, updates a respective array of values.
+    The sort is stable. Wrapper around magma_zindexsort_radix that allocates
+    its own workspace.
 
     Arguments
     ---------
@@ -288,45 +712,19 @@ magma_zindexsortval(
 {
     magma_int_t info = 0;
 
-    magma_index_t pivot,j,temp,i;
-    magmaDoubleComplex tempval;
-
-    if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( x[i]<=x[pivot] && i<last )
-                i++;
-            while( x[j]>x[pivot] )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-                tempval = y[i];
-                y[i] = y[j];
-                y[j] = tempval;
-            }
-        }
-
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
 
-        tempval=y[pivot];
-        y[pivot]=y[j];
-        y[j]=tempval;
-        CHECK( magma_zindexsortval( x, y, first, j-1, queue ));
-        CHECK( magma_zindexsortval( x, y, j+1, last, queue ));
+    if( first < last ){
+        CHECK( magma_zindexsort_radix( last-first+1, x+first, y+first,
+                                       &tmp_ptr, &tmp_size, queue ));
     }
 cleanup:
+    magma_free_cpu( tmp_ptr );
     return info;
 }
 
 
-
 /**
     Purpose
     -------
@@ -37,6 +37,8 @@ static const char *usage_sparse =
 " --rtol x      Set a relative residual stopping criterion.\n"
 " --format      Possibility to choose a format for the sparse matrix:\n"
 "               CSR, ELL, SELLP, CUSPARSECSR, CSR5.\n"
+" --compute     Possibility to choose where the solver runs: DEV (default), or\n"
+"               CPU for CG, BICGSTAB, GMRES, IDR without preconditioner.\n"
 " --blocksize x Set a specific blocksize for SELL-P format.\n"
 " --alignment x Set a specific alignment for SELL-P format.\n"
 " --mscale      Possibility to scale the original matrix:\n"
@@ -53,6 +55,10 @@ static const char *usage_sparse =
 "                   --triolver k  Solver for triangular ILU factors: e.g. CUSOLVE, JACOBI, ISAI.\n"
 "                   --ppattern k  Pattern used for ISAI preconditioner.\n"
 "                   --psweeps x   Number of iterative ParILU sweeps.\n"
+"                   --pbsize k    Nonzeros per block for colored ParILU sweeps\n"
+"                                 on the CPU; 0 (default) for asynchronous sweeps.\n"
+"                   --reorder x   Reordering pre-pass for ILU and IC preconditioners:\n"
+"                                 NONE, RCM, AMD, ND (nested dissection).\n"
 " --trisolver   Possibility to choose a triangular solver for ILU preconditioning: \n"
 "               e.g. CUSOLVE, ISPTRSV, JACOBI, VBJACOBI, ISAI.\n"
 " --ppattern k  Possibility to choose a pattern for the trisolver: ISAI(k) or Block Jacobi.\n"
@@ -113,6 +119,7 @@ magma_zparse_opts(
     opts->output_format = Magma_CSR;
     opts->input_location = Magma_CPU;
     opts->output_location = Magma_CPU;
+    opts->compute_location = Magma_DEV;
     opts->scaling = Magma_NOSCALE;
     #if defined(PRECISION_z) | defined(PRECISION_d)
         opts->solver_par.atol = 1e-16;
@@ -141,6 +148,8 @@ magma_zparse_opts(
     opts->precond_par.sweeps = 5;
     opts->precond_par.maxiter = 1;
     opts->precond_par.pattern = 1;
+    opts->precond_par.bsize = 0;
+    opts->precond_par.reorder = Magma_NOREORDER;
     opts->solver_par.solver = Magma_CGMERGE;
     
     printf( usage_sparse_short, argv[0] );
@@ -421,8 +430,32 @@ magma_zparse_opts(
             opts->precond_par.pattern = atoi( argv[++i] );
         } else if ( strcmp("--psweeps", argv[i]) == 0 && i+1 < argc ) {
             opts->precond_par.sweeps = atoi( argv[++i] );
+        } else if ( strcmp("--pbsize", argv[i]) == 0 && i+1 < argc ) {
+            opts->precond_par.bsize = atoi( argv[++i] );
         } else if ( strcmp("--plevels", argv[i]) == 0 && i+1 < argc ) {
             opts->precond_par.levels = atoi( argv[++i] );
+        } else if ( strcmp("--reorder", argv[i]) == 0 && i+1 < argc ) {
+            i++;
+            if ( strcmp("NONE", argv[i]) == 0 ) {
+                opts->precond_par.reorder = Magma_NOREORDER;
+            } else if ( strcmp("RCM", argv[i]) == 0 ) {
+                opts->precond_par.reorder = Magma_RCM;
+            } else if ( strcmp("AMD", argv[i]) == 0 ) {
+                opts->precond_par.reorder = Magma_AMD;
+            } else if ( strcmp("ND", argv[i]) == 0 ) {
+                opts->precond_par.reorder = Magma_ND;
+            } else {
+                printf( "%%error: invalid reordering, use default (NONE).\n" );
+            }
+        } else if ( strcmp("--compute", argv[i]) == 0 && i+1 < argc ) {
+            i++;
+            if ( strcmp("CPU", argv[i]) == 0 ) {
+                opts->compute_location = Magma_CPU;
+            } else if ( strcmp("DEV", argv[i]) == 0 ) {
+                opts->compute_location = Magma_DEV;
+            } else {
+                printf( "%%error: invalid compute location, use default (DEV).\n" );
+            }
         } else if ( strcmp("--blocksize", argv[i]) == 0 && i+1 < argc ) {
             opts->blocksize = atoi( argv[++i] );
         } else if ( strcmp("--alignment", argv[i]) == 0 && i+1 < argc ) {
@@ -11,6 +11,8 @@
 #ifndef MAGMASPARSE_INTERNAL_H
 #define MAGMASPARSE_INTERNAL_H
 
+#include <stdint.h>
+
 #include "magma_internal.h"
 #include "magmasparse.h"
 
@@ -74,6 +76,95 @@ magma_int_t cusparse2magma_error( cusparseStatus_t status );
     } while(0)
 
 
+/**
+    Makes sure the CPU workspace *ptr of *size bytes holds at least
+    required_size bytes, reallocating it if necessary. The contents are not
+    preserved. Counterpart of realloc_if_necessary for device workspaces,
+    so CPU routines can reuse temporary storage across calls.
+
+    @ingroup magma_error_internal
+    ********************************************************************/
+static inline magma_int_t
+magma_realloc_cpu_if_necessary(
+    magma_ptr *ptr,
+    size_t *size,
+    size_t required_size )
+{
+    magma_int_t info = 0;
+    if ( *size < required_size ) {
+        magma_free_cpu( *ptr );
+        *ptr = NULL;
+        *size = 0;
+        info = magma_malloc_cpu( ptr, required_size );
+        if ( info == 0 ) {
+            *size = required_size;
+        }
+    }
+    return info;
+}
+
+
+/**
+    Header of the binary sparse matrix format (.mcsr) written by
+    magma_zwrite_csr_bin and read by magma_zread_csr_bin.
+    The header is followed by the row pointer, column indices, and values,
+    each starting at a multiple of MAGMA_MCSR_ALIGN bytes, so the arrays can
+    be used in place from a memory-mapped file. Dense matrices and vectors
+    (Magma_DENSE) have only values. Integers are in the byte order of the
+    writer; endian holds MAGMA_MCSR_ENDIAN so files of other byte order are
+    rejected.
+
+    @ingroup magma_error_internal
+    ********************************************************************/
+#define MAGMA_MCSR_MAGIC    "MAGMCSR"
+#define MAGMA_MCSR_VERSION  1
+#define MAGMA_MCSR_ENDIAN   0x01020304
+#define MAGMA_MCSR_ALIGN    64
+
+typedef struct magma_mcsr_header
+{
+    char    magic[8];       ///< MAGMA_MCSR_MAGIC
+    int32_t version;        ///< MAGMA_MCSR_VERSION
+    int32_t endian;         ///< MAGMA_MCSR_ENDIAN
+    int32_t index_size;     ///< sizeof(magma_index_t)
+    int32_t value_size;     ///< size of one value; with ncomponent gives the precision
+    int32_t ncomponent;     ///< 2 for complex, 1 for real values
+    int32_t storage_type;   ///< magma_storage_t: Magma_CSR, CSRL, CSRU, CSRD, or DENSE
+    int32_t sym;            ///< magma_symmetry_t
+    int32_t fill_mode;      ///< magma_uplo_t
+    int32_t major;          ///< magma_order_t, for Magma_DENSE
+    int32_t reserved1;
+    int64_t num_rows;
+    int64_t num_cols;
+    int64_t nnz;            ///< number of values
+    int64_t row_offset;     ///< byte offset of row pointer, 0 for Magma_DENSE
+    int64_t col_offset;     ///< byte offset of column indices, 0 for Magma_DENSE
+    int64_t val_offset;     ///< byte offset of values
+    int64_t file_size;      ///< total size in bytes
+    char    reserved2[24];  ///< pads header to 128 bytes
+} magma_mcsr_header;
+
+
+/**
+    Returns true if filename is a binary sparse matrix file (.mcsr),
+    judged by its magic number.
+
+    @ingroup magma_error_internal
+    ********************************************************************/
+static inline bool
+magma_mcsr_is_binary( const char *filename )
+{
+    char magic[ sizeof(MAGMA_MCSR_MAGIC) ] = { 0 };
+    FILE *fid = fopen( filename, "rb" );
+    if ( fid == NULL ) {
+        return false;
+    }
+    size_t len = fread( magic, 1, sizeof(magic), fid );
+    fclose( fid );
+    return len == sizeof(magic) && memcmp( magic, MAGMA_MCSR_MAGIC, sizeof(magic) ) == 0;
+}
+
+
 #ifdef __cplusplus
 } // extern C
 #endif
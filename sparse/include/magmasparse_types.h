@@ -154,6 +154,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: file mapping of magma_zread_csr_bin, else NULL
+        size_t mapping_size;                 // opt: size of the file mapping in bytes
     } magma_z_matrix;
 
     typedef struct magma_c_matrix
@@ -238,6 +240,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: file mapping of magma_cread_csr_bin, else NULL
+        size_t mapping_size;                 // opt: size of the file mapping in bytes
     } magma_c_matrix;
 
     typedef struct magma_d_matrix
@@ -322,6 +326,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: file mapping of magma_dread_csr_bin, else NULL
+        size_t mapping_size;                 // opt: size of the file mapping in bytes
     } magma_d_matrix;
 
     typedef struct magma_s_matrix
@@ -406,6 +412,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: file mapping of magma_sread_csr_bin, else NULL
+        size_t mapping_size;                 // opt: size of the file mapping in bytes
     } magma_s_matrix;
 
     // for backwards compatability, make these aliases.
@@ -633,11 +641,26 @@ typedef struct magma_s_vector
     #define csrsm2Info_t int
 #endif
     
+// Level schedule of a triangular solve on the CPU, from magma_ztrisolve_analysis.
+// Rows are stored in order of levels, with their off-diagonal entries.
+typedef struct magma_solve_levels_t
+{
+    magma_int_t num_rows{};
+    magma_int_t num_levels{};
+    magma_index_t *level_ptr{};  // level l has rows perm[ level_ptr[l] : level_ptr[l+1] ]
+    magma_index_t *perm{};       // rows in order of levels
+    magma_index_t *row{};        // entries of row perm[r] are row[r] : row[r+1]
+    magma_index_t *col{};
+    void *val{};                 // values, in the precision of the analysis
+    void *diag{};                // inverse diagonal in level order; NULL for unit diagonal
+} magma_solve_levels_t;
+
 #if CUDA_VERSION < 11031 || defined(MAGMA_HAVE_HIP)
 typedef struct magma_solve_info_t
 {
     csrsm2Info_t descr{};
     void *buffer{};
+    magma_solve_levels_t levels{};
 } magma_solve_info_t;
 //#define magma_ilu_info_t cusparseSolveAnalysisInfo_t
 #define magma_ilu_info_t csrsm2Info_t
@@ -646,6 +669,7 @@ typedef struct magma_solve_info_t
 {
     cusparseSpSMDescr_t descr{};
     void *buffer{};
+    magma_solve_levels_t levels{};
 } magma_solve_info_t;
 #define magma_ilu_info_t csrsm2Info_t
 #endif
@@ -704,6 +728,10 @@ typedef struct magma_solve_info_t
         magma_solve_info_t cuinfoUT;
 
         magma_bool_t transpose; // need the transpose for the solver?
+        magma_reorder_t reorder; // optional reordering pre-pass
+        magma_z_matrix P;        // permutation matrix of the reordering
+        magma_z_matrix PT;       // its transpose
+        magma_z_matrix Pwork;    // work vector for the permutation
 #if defined(MAGMA_HAVE_PASTIX)
         pastix_data_t *pastix_data;
         magma_int_t *iparm;
@@ -764,6 +792,10 @@ typedef struct magma_solve_info_t
         magma_solve_info_t cuinfoUT;
 
         magma_bool_t transpose; // need the transpose for the solver?
+        magma_reorder_t reorder; // optional reordering pre-pass
+        magma_c_matrix P;        // permutation matrix of the reordering
+        magma_c_matrix PT;       // its transpose
+        magma_c_matrix Pwork;    // work vector for the permutation
 #if defined(MAGMA_HAVE_PASTIX)
         pastix_data_t *pastix_data;
         magma_int_t *iparm;
@@ -824,6 +856,10 @@ typedef struct magma_solve_info_t
         magma_solve_info_t cuinfoUT;
 
         magma_bool_t transpose; // need the transpose for the solver?
+        magma_reorder_t reorder; // optional reordering pre-pass
+        magma_d_matrix P;        // permutation matrix of the reordering
+        magma_d_matrix PT;       // its transpose
+        magma_d_matrix Pwork;    // work vector for the permutation
 #if defined(MAGMA_HAVE_PASTIX)
         pastix_data_t *pastix_data;
         magma_int_t *iparm;
@@ -884,6 +920,10 @@ typedef struct magma_solve_info_t
         magma_solve_info_t cuinfoUT;
 
         magma_bool_t transpose; // need the transpose for the solver?
+        magma_reorder_t reorder; // optional reordering pre-pass
+        magma_s_matrix P;        // permutation matrix of the reordering
+        magma_s_matrix PT;       // its transpose
+        magma_s_matrix Pwork;    // work vector for the permutation
 #if defined(MAGMA_HAVE_PASTIX)
         pastix_data_t *pastix_data;
         magma_int_t *iparm;
@@ -368,6 +368,25 @@ magma_zindexsortval(
     magma_int_t last,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmergesort(
+    magma_int_t n,
+    magmaDoubleComplex *x,
+    magma_index_t *col,
+    magma_index_t *row,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zindexsort_radix(
+    magma_int_t n,
+    magma_index_t *x,
+    magmaDoubleComplex *y,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zorderstatistics(
     magmaDoubleComplex *val,
@@ -424,6 +443,28 @@ magma_zselectrandom(
     magma_int_t k,
     magma_queue_t queue );
 
+magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magma_int_t sample_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magma_int_t sample_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    size_t *tmp_size,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zdomainoverlap(
     magma_index_t num_rows,
@@ -441,6 +482,31 @@ magma_zsymbilu(
     magma_z_matrix *U,
     magma_queue_t queue );
 
+magma_int_t
+magma_zsymbolic_ilu(
+    magma_int_t levfill,
+    magma_int_t n,
+    const magma_index_t *ia,
+    const magma_index_t *ja,
+    magma_index_t *ial,
+    magma_index_t **jal,
+    magma_index_t *iau,
+    magma_index_t **jau,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsymbolic_ilu_seq(
+    const magma_int_t levfill,
+    const magma_int_t n,
+    magma_int_t *nzl,
+    magma_int_t *nzu,
+    const magma_index_t *ia,
+    const magma_index_t *ja,
+    magma_index_t *ial,
+    magma_index_t *jal,
+    magma_index_t *iau,
+    magma_index_t *jau );
+
 
 magma_int_t 
 magma_zwrite_csr_mtx( 
@@ -449,6 +515,23 @@ magma_zwrite_csr_mtx(
  const char *filename,
     magma_queue_t queue );
 
+magma_int_t
+magma_zwrite_csr_bin(
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zread_csr_bin(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zclose_csr_bin(
+    magma_z_matrix *A,
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zwrite_vector( 
     magma_z_matrix A,
@@ -529,6 +612,14 @@ magma_zmconvert(
     magma_storage_t new_format,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmconvert_values(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_storage_t old_format,
+    magma_storage_t new_format,
+    magma_queue_t queue );
+
 
 magma_int_t
 magma_zvinit(
@@ -1079,6 +1170,36 @@ magma_zparilu_sweep_sync(
     magma_z_matrix *U,
     magma_queue_t queue );
 
+magma_int_t
+magma_zparilu_sweep_res(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_z_matrix *U,
+    double *res,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zparilu_colors(
+    magma_z_matrix A,
+    magma_int_t bsize,
+    magma_index_t **block_row,
+    magma_index_t **block_order,
+    magma_index_t **color_ptr,
+    magma_int_t *ncolors,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zparilu_sweep_colored(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_z_matrix *U,
+    const magma_index_t *block_row,
+    const magma_index_t *block_order,
+    const magma_index_t *color_ptr,
+    magma_int_t ncolors,
+    double *res,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zparic_sweep(
     magma_z_matrix A,
@@ -1628,6 +1749,35 @@ magma_zmvarsizeblockstruct(
     magma_z_matrix *A,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmreorder(
+    magma_z_matrix A,
+    magma_reorder_t order,
+    magma_index_t **perm,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmpermute(
+    magma_z_matrix A,
+    magma_index_t *perm,
+    magma_z_matrix *B,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zvpermute(
+    magma_z_matrix x,
+    magma_index_t *perm,
+    magma_trans_t trans,
+    magma_z_matrix *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zprecondreorder(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
 
 
 /* ////////////////////////////////////////////////////////////////////////////
@@ -1650,6 +1800,12 @@ magma_zcg_res(
     magma_z_matrix *x, magma_z_solver_par *solver_par,
     magma_queue_t queue );
 
+magma_int_t
+magma_zcg_cpu(
+    magma_z_matrix A, magma_z_matrix b, 
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zcg_merge(
     magma_z_matrix A, magma_z_matrix b, 
@@ -1765,6 +1921,12 @@ magma_zbicgstab_merge(
     magma_z_matrix *x, magma_z_solver_par *solver_par,
     magma_queue_t queue );
 
+magma_int_t
+magma_zbicgstab_cpu(
+    magma_z_matrix A, magma_z_matrix b, 
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zbicgstab_merge2(
     magma_z_matrix A, magma_z_matrix b, 
@@ -1819,6 +1981,12 @@ magma_zfgmres(
     magma_z_preconditioner *precond_par,
     magma_queue_t queue );
 
+magma_int_t
+magma_zgmres_cpu(
+    magma_z_matrix A, magma_z_matrix b, 
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zbfgmres(
     magma_z_matrix A, magma_z_matrix b, 
@@ -1838,6 +2006,12 @@ magma_zidr_merge(
     magma_z_matrix *x, magma_z_solver_par *solver_par,
     magma_queue_t queue );
 
+magma_int_t
+magma_zidr_cpu(
+    magma_z_matrix A, magma_z_matrix b, 
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zidr_strms(
     magma_z_matrix A, magma_z_matrix b, 
@@ -2273,6 +2447,143 @@ magma_z_spmv(
     magma_z_matrix y,
     magma_queue_t queue );
 
+magma_int_t
+magma_zspmv_cpu(
+    magmaDoubleComplex alpha, 
+    magma_z_matrix A, 
+    magma_z_matrix x, 
+    magmaDoubleComplex beta, 
+    magma_z_matrix y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zspgemm_cpu(
+    magma_trans_t transA,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *C,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zspgemm_cpu_symbolic(
+    magma_trans_t transA,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *C,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zspgemm_cpu_numeric(
+    magma_trans_t transA,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *C,
+    magma_queue_t queue );
+
+magma_int_t
+magma_ztrisolve_analysis_cpu(
+    magma_z_matrix M,
+    magma_solve_info_t *solve_info,
+    bool upper_triangular,
+    bool unit_diagonal,
+    bool transpose,
+    magma_queue_t queue );
+
+magma_int_t
+magma_ztrisolve_cpu(
+    magma_z_matrix M,
+    magma_solve_info_t solve_info,
+    bool upper_triangular,
+    bool unit_diagonal,
+    bool transpose,
+    magma_z_matrix b,
+    magma_z_matrix x,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmdotc_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magmaDoubleComplex_const_ptr v,
+    magma_int_t ldv,
+    magmaDoubleComplex_const_ptr w,
+    magmaDoubleComplex *dots,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmaxpy_nrm2_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magmaDoubleComplex_const_ptr v,
+    magma_int_t ldv,
+    const magmaDoubleComplex *h,
+    magmaDoubleComplex_ptr w,
+    double *nrm,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_const_ptr p,
+    magmaDoubleComplex_const_ptr q,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex_ptr r,
+    double *rr,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcgmerge_p_cpu(
+    magma_int_t n,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_ptr p,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zbicgmerge_s_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_const_ptr v,
+    magmaDoubleComplex_ptr s,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zbicgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex omega,
+    magmaDoubleComplex_const_ptr p,
+    magmaDoubleComplex_const_ptr s,
+    magmaDoubleComplex_const_ptr t,
+    magmaDoubleComplex_const_ptr rr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex_ptr r,
+    magmaDoubleComplex *rho,
+    double *nrm2,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zbicgmerge_p_cpu(
+    magma_int_t n,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex omega,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_const_ptr v,
+    magmaDoubleComplex_ptr p,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zidrmerge_smooth_cpu(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr r,
+    magmaDoubleComplex_const_ptr x,
+    magmaDoubleComplex_ptr rs,
+    magmaDoubleComplex_ptr xs,
+    double *nrm,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zcustomspmv(
     magma_int_t m,
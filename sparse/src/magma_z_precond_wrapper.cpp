@@ -12,6 +12,17 @@
 #include "magmasparse_internal.h"
 
 
+// true if the preconditioner uses the reordering pre-pass
+static bool
+magma_zprecond_reordered(
+    magma_z_preconditioner *precond )
+{
+    return ( precond->reorder == Magma_RCM ||
+             precond->reorder == Magma_AMD ||
+             precond->reorder == Magma_ND );
+}
+
+
 /**
     Purpose
     -------
@@ -145,6 +156,9 @@ magma_z_precondsetup(
     //Chronometry
     real_Double_t tempo1, tempo2;
     
+    // the preconditioner is set up for A, or for P A P^T if reordered
+    magma_z_matrix PA={Magma_CSR};
+    
     tempo1 = magma_sync_wtime( queue );
     
     if( A.num_rows != A.num_cols ){
@@ -153,6 +167,24 @@ magma_z_precondsetup(
         precond->solver = Magma_NONE;
     } 
     
+    if ( magma_zprecond_reordered( precond ) ) {
+        if ( precond->solver == Magma_ILU    ||
+             precond->solver == Magma_PARILU ||
+             precond->solver == Magma_PARILUT ||
+             precond->solver == Magma_ICC    ||
+             precond->solver == Magma_PARIC  ||
+             precond->solver == Magma_PARICT ) {
+            info = magma_zprecondreorder( A, &PA, precond, queue );
+            if ( info != 0 ) {
+                return info;
+            }
+            A = PA;
+        } else {
+            printf("%% warning: reordering only for ILU and IC preconditioners.\n");
+            precond->reorder = Magma_NOREORDER;
+        }
+    }
+    
     if ( precond->solver == Magma_JACOBI ) {
         info = magma_zjacobisetup_diagscal( A, &(precond->d), queue );
     }
@@ -281,6 +313,8 @@ magma_z_precondsetup(
         }
     }
     
+    magma_zmfree( &PA, queue );
+    
     tempo2 = magma_sync_wtime( queue );
     precond->setuptime = tempo2-tempo1;
     
@@ -427,6 +461,12 @@ magma_z_applyprecond_left(
     zopts.solver_par.atol = 1e-16;
     zopts.solver_par.rtol = 1e-10;
     
+    // reordered preconditioner: the left part is applied to P b
+    if ( magma_zprecond_reordered( precond ) ) {
+        CHECK( magma_z_spmv( MAGMA_Z_ONE, precond->P, b, MAGMA_Z_ZERO, precond->Pwork, queue ));
+        b = precond->Pwork;
+    }
+    
     if( trans == MagmaNoTrans ) {
         if ( precond->solver == Magma_JACOBI ) {
             CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
@@ -586,6 +626,13 @@ magma_z_applyprecond_right(
         //Chronometry
     real_Double_t tempo1, tempo2;
     
+    // reordered preconditioner: the right part is applied into the work
+    // vector, and the result permuted back with P^T
+    magma_z_matrix *xout = x;
+    if ( magma_zprecond_reordered( precond ) ) {
+        x = &precond->Pwork;
+    }
+    
     tempo1 = magma_sync_wtime( queue );
     
     magma_zopts zopts;
@@ -697,6 +744,10 @@ magma_z_applyprecond_right(
         }
     }
     
+    if ( magma_zprecond_reordered( precond ) ) {
+        CHECK( magma_z_spmv( MAGMA_Z_ONE, precond->PT, *x, MAGMA_Z_ZERO, *xout, queue ));
+    }
+    
     tempo2 = magma_sync_wtime( queue );
     precond->runtime += tempo2-tempo1;
         
@@ -20,6 +20,10 @@
     system Ax = b. All linear algebra objects are expected to be on the device,
     the linear algebra objects are MAGMA-sparse specific structures 
     (dense matrix b, dense matrix x, sparse/dense matrix A).
+    If zopts->compute_location is Magma_CPU, or A is on the CPU, the solver
+    runs on the CPU; objects on the device are copied to the CPU, and the
+    solution back to x. This is supported for CG, BiCGSTAB, GMRES, and IDR,
+    without preconditioner, and a single right-hand side.
     The additional parameter zopts contains information about the solver
     and the preconditioner.
     * the type of solver
@@ -62,13 +66,56 @@ magma_z_solver(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_location_t location = zopts->compute_location;
+    magma_z_matrix hA={Magma_CSR}, hb={Magma_CSR}, hx={Magma_CSR};
     
     // make sure RHS is a dense matrix
     if ( b.storage_type != Magma_DENSE ) {
         printf( "error: sparse RHS not yet supported.\n" );
         return MAGMA_ERR_NOT_SUPPORTED;
     }
-    if( b.num_cols == 1 ){
+    if ( A.memory_location == Magma_CPU ) {
+        location = Magma_CPU;
+    }
+    if ( location == Magma_CPU ) {
+        if ( b.num_cols != 1 ) {
+            printf("error: only 1 RHS supported on the CPU.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        if ( A.memory_location == Magma_CPU ) {
+            hA = A;
+        } else {
+            CHECK( magma_zmtransfer( A, &hA, A.memory_location, Magma_CPU, queue ));
+        }
+        if ( b.memory_location == Magma_CPU ) {
+            hb = b;
+        } else {
+            CHECK( magma_zmtransfer( b, &hb, b.memory_location, Magma_CPU, queue ));
+        }
+        if ( x->memory_location == Magma_CPU ) {
+            hx = *x;
+        } else {
+            CHECK( magma_zmtransfer( *x, &hx, x->memory_location, Magma_CPU, queue ));
+        }
+        switch( zopts->solver_par.solver ) {
+            case  Magma_CG:
+            case  Magma_CGMERGE:
+                    CHECK( magma_zcg_cpu( hA, hb, &hx, &zopts->solver_par, queue )); break;
+            case  Magma_BICGSTAB:
+            case  Magma_BICGSTABMERGE:
+                    CHECK( magma_zbicgstab_cpu( hA, hb, &hx, &zopts->solver_par, queue )); break;
+            case  Magma_GMRES:
+                    CHECK( magma_zgmres_cpu( hA, hb, &hx, &zopts->solver_par, queue )); break;
+            case  Magma_IDR:
+            case  Magma_IDRMERGE:
+                    CHECK( magma_zidr_cpu( hA, hb, &hx, &zopts->solver_par, queue )); break;
+            default:
+                    printf("error: solver class not supported on the CPU.\n");
+                    info = MAGMA_ERR_NOT_SUPPORTED; break;
+        }
+    }
+    else if( b.num_cols == 1 ){
         switch( zopts->solver_par.solver ) {
             case  Magma_BICG:
                     CHECK( magma_zbicg( A, b, x, &zopts->solver_par, queue )); break;
@@ -161,5 +208,20 @@ magma_z_solver(
         }
     }
 cleanup:
+    if ( location == Magma_CPU ) {
+        // copy the solution back, and free the CPU copies
+        if ( x->memory_location != Magma_CPU ) {
+            if ( hx.val != NULL ) {
+                magma_zsetvector( x->num_rows*x->num_cols, hx.val, 1, x->dval, 1, queue );
+            }
+            magma_zmfree( &hx, queue );
+        }
+        if ( A.memory_location != Magma_CPU ) {
+            magma_zmfree( &hA, queue );
+        }
+        if ( b.memory_location != Magma_CPU ) {
+            magma_zmfree( &hb, queue );
+        }
+    }
     return info; 
 }
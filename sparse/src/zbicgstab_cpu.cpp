@@ -0,0 +1,194 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a general N-by-N matrix A.
+    This is a CPU implementation of the Biconjugate Gradient Stabilized
+    method. A, b, and x are on the CPU. The SpMV is the multithreaded
+    magma_zspmv_cpu; besides the two SpMVs, an iteration makes five passes
+    over the vectors, with the updates and dot products merged as in
+    magma_zbicgmerge_xr_cpu.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgesv
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zbicgstab_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_BICGSTAB;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+
+    // solver variables
+    magmaDoubleComplex alpha, beta, omega, rho, rho_new, rrv, nomb2, dots[2];
+    double nom0, nomb, res, nrm2;
+    // local variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE;
+    magma_int_t dofs = A.num_rows, ione = 1;
+    real_Double_t tempo1, tempo2;
+
+    // CPU workspace; s and t are the columns of st, so that
+    // s' t and t' t are computed in one pass
+    magma_z_matrix r={Magma_CSR}, rr={Magma_CSR}, p={Magma_CSR}, v={Magma_CSR};
+    magma_z_matrix st={Magma_CSR}, s, t;
+    CHECK( magma_zvinit( &r,  Magma_CPU, A.num_rows, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &rr, Magma_CPU, A.num_rows, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &p,  Magma_CPU, A.num_rows, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &v,  Magma_CPU, A.num_rows, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &st, Magma_CPU, A.num_rows, 2, c_zero, queue ));
+    s = st;
+    s.num_cols = 1;
+    s.nnz = dofs;
+    t = s;
+    t.val = st.val + dofs;
+
+    // solver setup
+    CHECK( magma_zresidualvec( A, b, *x, &r, &nom0, queue ));
+    blasf77_zcopy( &dofs, r.val, &ione, rr.val, &ione );                  // rr = r
+    blasf77_zcopy( &dofs, r.val, &ione, p.val,  &ione );                  // p = r
+    rho = MAGMA_Z_MAKE( nom0 * nom0, 0.0 );                               // rho = rr' r
+    solver_par->init_res = nom0;
+
+    CHECK( magma_zmdotc_cpu( dofs, 1, b.val, dofs, b.val, &nomb2, queue ));
+    nomb = sqrt( MAGMA_Z_REAL( nomb2 ));
+    if ( nomb == 0.0 ) {
+        nomb = 1.0;
+    }
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t) nom0;
+        solver_par->timing[0] = 0.0;
+    }
+    res = nom0;
+    if ( nom0/nomb <= solver_par->rtol || nom0 <= solver_par->atol ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    tempo1 = magma_wtime();
+
+    // start iteration
+    do
+    {
+        solver_par->numiter++;
+
+        CHECK( magma_z_spmv( c_one, A, p, c_zero, v, queue ));            // v = A p
+        solver_par->spmv_count++;
+        CHECK( magma_zmdotc_cpu( dofs, 1, rr.val, dofs, v.val, &rrv, queue ));
+        if ( MAGMA_Z_ABS( rrv ) <= 0.0 || magma_z_isnan_inf( rrv )) {
+            break;
+        }
+        alpha = rho / rrv;                                      // alpha = rho / rr' v
+        CHECK( magma_zbicgmerge_s_cpu( dofs, alpha, r.val, v.val, s.val, queue ));
+                                                                // s = r - alpha v
+        CHECK( magma_z_spmv( c_one, A, s, c_zero, t, queue ));            // t = A s
+        solver_par->spmv_count++;
+        CHECK( magma_zmdotc_cpu( dofs, 2, st.val, dofs, t.val, dots, queue ));
+                                                                // s' t, t' t
+        if ( MAGMA_Z_ABS( dots[1] ) > 0.0 ) {
+            omega = MAGMA_Z_CONJ( dots[0] ) / dots[1];          // omega = t' s / t' t
+        } else {
+            omega = c_zero;
+        }
+
+        // x = x + alpha p + omega s;  r = s - omega t;  rho_new = rr' r
+        CHECK( magma_zbicgmerge_xr_cpu( dofs, alpha, omega, p.val, s.val, t.val,
+                                        rr.val, x->val, r.val, &rho_new, &nrm2, queue ));
+        res = sqrt( nrm2 );
+
+        if ( solver_par->verbose > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+
+        if ( res/nomb <= solver_par->rtol || res <= solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+            break;
+        }
+        if ( MAGMA_Z_ABS( omega ) <= 0.0 || magma_z_isnan_inf( rho_new )) {
+            break;
+        }
+
+        beta = rho_new / rho * alpha / omega;
+        rho = rho_new;
+        CHECK( magma_zbicgmerge_p_cpu( dofs, beta, omega, r.val, v.val, p.val, queue ));
+                                                        // p = r + beta (p - omega v)
+    }
+    while ( solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    double residual;
+    CHECK( magma_zresidualvec( A, b, *x, &r, &residual, queue ));
+    solver_par->iter_res = res;
+    solver_par->final_res = residual;
+
+    // set solver conclusion
+    if ( info != MAGMA_SUCCESS ) {
+        if ( solver_par->init_res > solver_par->final_res ) {
+            info = MAGMA_SLOW_CONVERGENCE;
+        } else {
+            info = MAGMA_DIVERGENCE;
+        }
+    }
+
+cleanup:
+    magma_zmfree(&r, queue );
+    magma_zmfree(&rr, queue );
+    magma_zmfree(&p, queue );
+    magma_zmfree(&v, queue );
+    magma_zmfree(&st, queue );
+
+    solver_par->info = info;
+    return info;
+}   /* magma_zbicgstab_cpu */
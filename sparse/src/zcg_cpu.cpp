@@ -0,0 +1,167 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex Hermitian N-by-N positive definite matrix A.
+    This is a CPU implementation of the Conjugate Gradient method.
+    A, b, and x are on the CPU. The SpMV is the multithreaded
+    magma_zspmv_cpu; the vector updates and dot products are merged into
+    three passes over the vectors per iteration, see magma_zcgmerge_xr_cpu.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zposv
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zcg_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_CG;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+
+    // solver variables
+    magmaDoubleComplex alpha, beta, den, nomb2;
+    double nom0, nomb, res, rr, rr_old;
+    // local variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE;
+    magma_int_t dofs = A.num_rows, ione = 1;
+    real_Double_t tempo1, tempo2;
+
+    // CPU workspace
+    magma_z_matrix r={Magma_CSR}, p={Magma_CSR}, q={Magma_CSR};
+    CHECK( magma_zvinit( &r, Magma_CPU, A.num_rows, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &p, Magma_CPU, A.num_rows, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &q, Magma_CPU, A.num_rows, 1, c_zero, queue ));
+
+    // solver setup
+    CHECK( magma_zresidualvec( A, b, *x, &r, &nom0, queue ));
+    blasf77_zcopy( &dofs, r.val, &ione, p.val, &ione );                   // p = r
+    rr = nom0 * nom0;
+    solver_par->init_res = nom0;
+
+    CHECK( magma_zmdotc_cpu( dofs, 1, b.val, dofs, b.val, &nomb2, queue ));
+    nomb = sqrt( MAGMA_Z_REAL( nomb2 ));
+    if ( nomb == 0.0 ) {
+        nomb = 1.0;
+    }
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t) nom0;
+        solver_par->timing[0] = 0.0;
+    }
+    res = nom0;
+    if ( nom0/nomb <= solver_par->rtol || nom0 <= solver_par->atol ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    tempo1 = magma_wtime();
+
+    // start iteration
+    do
+    {
+        solver_par->numiter++;
+
+        CHECK( magma_z_spmv( c_one, A, p, c_zero, q, queue ));            // q = A p
+        solver_par->spmv_count++;
+        CHECK( magma_zmdotc_cpu( dofs, 1, p.val, dofs, q.val, &den, queue ));
+                                                                            // den = p' q
+        if ( MAGMA_Z_ABS( den ) <= 0.0 || magma_z_isnan_inf( den )) {
+            info = MAGMA_NONSPD;
+            break;
+        }
+        alpha = MAGMA_Z_MAKE( rr, 0.0 ) / den;
+
+        // x = x + alpha p;  r = r - alpha q;  rr = r' r
+        rr_old = rr;
+        CHECK( magma_zcgmerge_xr_cpu( dofs, alpha, p.val, q.val, x->val, r.val, &rr, queue ));
+        res = sqrt( rr );
+
+        if ( solver_par->verbose > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+
+        if ( res/nomb <= solver_par->rtol || res <= solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+            break;
+        }
+
+        beta = MAGMA_Z_MAKE( rr / rr_old, 0.0 );
+        CHECK( magma_zcgmerge_p_cpu( dofs, beta, r.val, p.val, queue ));   // p = r + beta p
+    }
+    while ( solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    double residual;
+    CHECK( magma_zresidualvec( A, b, *x, &r, &residual, queue ));
+    solver_par->iter_res = res;
+    solver_par->final_res = residual;
+
+    // set solver conclusion
+    if ( info != MAGMA_SUCCESS && info != MAGMA_NONSPD ) {
+        if ( solver_par->init_res > solver_par->final_res ) {
+            info = MAGMA_SLOW_CONVERGENCE;
+        } else {
+            info = MAGMA_DIVERGENCE;
+        }
+    }
+
+cleanup:
+    magma_zmfree(&r, queue );
+    magma_zmfree(&p, queue );
+    magma_zmfree(&q, queue );
+
+    solver_par->info = info;
+    return info;
+}   /* magma_zcg_cpu */
@@ -0,0 +1,283 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+// simulate 2-D arrays at the cost of some arithmetic
+#define V(i) (V.val+(i)*dofs)
+#define H(i,j) (H[(j)*m1+(i)])
+
+// reorthogonalize if Gram-Schmidt reduced the norm of the new vector
+// by more than this factor
+#define GMRES_CPU_REORTH 0.7
+
+
+static void
+GeneratePlaneRotation(magmaDoubleComplex dx, magmaDoubleComplex dy, magmaDoubleComplex *cs, magmaDoubleComplex *sn)
+{
+#if defined(PRECISION_s) | defined(PRECISION_d)
+    if (dy == MAGMA_Z_ZERO) {
+        *cs = MAGMA_Z_ONE;
+        *sn = MAGMA_Z_ZERO;
+    } else if (MAGMA_Z_ABS((dy)) > MAGMA_Z_ABS((dx))) {
+        magmaDoubleComplex temp = dx / dy;
+        *sn = MAGMA_Z_ONE / magma_zsqrt( ( MAGMA_Z_ONE + temp*temp));
+        *cs = temp * (*sn);
+    } else {
+        magmaDoubleComplex temp = dy / dx;
+        *cs = MAGMA_Z_ONE / magma_zsqrt( ( MAGMA_Z_ONE + temp*temp ));
+        *sn = temp * (*cs);
+    }
+#else
+    // same rotation as in magma_zfgmres
+    real_Double_t rho = sqrt(MAGMA_Z_REAL(MAGMA_Z_CONJ(dx)*dx + MAGMA_Z_CONJ(dy)*dy));
+    *cs = dx / rho;
+    *sn = dy / rho;
+#endif
+}
+
+static void ApplyPlaneRotation(magmaDoubleComplex *dx, magmaDoubleComplex *dy, magmaDoubleComplex cs, magmaDoubleComplex sn)
+{
+#if defined(PRECISION_s) | defined(PRECISION_d)
+    magmaDoubleComplex temp = (*dx);
+    *dx =  cs * (*dx) + sn * (*dy);
+    *dy = -sn * temp + cs * (*dy);
+#else
+    magmaDoubleComplex temp  =  MAGMA_Z_CONJ(cs) * (*dx) +  MAGMA_Z_CONJ(sn) * (*dy);
+    *dy = -(sn) * (*dx) + cs * (*dy);
+    *dx = temp;
+#endif
+}
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a general N-by-N matrix A.
+    This is a CPU implementation of the restarted GMRES, with restart
+    solver_par->restart. A, b, and x are on the CPU. The SpMV is the
+    multithreaded magma_zspmv_cpu. The Krylov basis is orthogonalized by
+    classical Gram-Schmidt, where the dot products with all basis vectors
+    (and the norm of the new vector) are computed in one pass,
+    see magma_zmdotc_cpu, and the update in another one, see
+    magma_zmaxpy_nrm2_cpu. If this reduces the norm of the new vector by
+    more than a factor 0.7, the step is repeated once.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgesv
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zgmres_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_GMRES;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+
+    // local variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE;
+    magma_int_t dofs = A.num_rows, ione = 1;
+    magma_int_t dim = max( 1, min( solver_par->restart, dofs ));
+    magma_int_t m1 = dim+1; // used inside H macro
+    magma_int_t i, j, k;
+    magmaDoubleComplex nomb2;
+    double nom, nomb, nrm, nrmw, betanom = 0.0;
+    real_Double_t tempo1, tempo2;
+
+    // CPU workspace; the basis vectors are the columns of V,
+    // vi and vi1 are views of columns i and i+1
+    magma_z_matrix V={Magma_CSR}, vi, vi1;
+    magmaDoubleComplex *H=NULL, *h=NULL, *s=NULL, *cs=NULL, *sn=NULL;
+
+    CHECK( magma_zvinit( &V, Magma_CPU, dofs, dim+1, c_zero, queue ));
+    CHECK( magma_zmalloc_cpu( &H, (dim+1)*dim ));
+    CHECK( magma_zmalloc_cpu( &h,  dim+2 ));
+    CHECK( magma_zmalloc_cpu( &s,  dim+1 ));
+    CHECK( magma_zmalloc_cpu( &cs, dim ));
+    CHECK( magma_zmalloc_cpu( &sn, dim ));
+    vi = V;
+    vi.num_cols = 1;
+    vi.nnz = dofs;
+    vi1 = vi;
+
+    // solver setup
+    vi.val = V(0);
+    CHECK( magma_zresidualvec( A, b, *x, &vi, &nom, queue ));            // V(0) = b - A x
+    solver_par->init_res = nom;
+    betanom = nom;
+
+    CHECK( magma_zmdotc_cpu( dofs, 1, b.val, dofs, b.val, &nomb2, queue ));
+    nomb = sqrt( MAGMA_Z_REAL( nomb2 ));
+    if ( nomb == 0.0 ) {
+        nomb = 1.0;
+    }
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t) nom;
+        solver_par->timing[0] = 0.0;
+    }
+    if ( nom/nomb <= solver_par->rtol || nom <= solver_par->atol ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    tempo1 = magma_wtime();
+    do
+    {
+        // V(0) = r / ||r||
+        if ( solver_par->numiter > 0 ) {
+            vi.val = V(0);
+            CHECK( magma_zresidualvec( A, b, *x, &vi, &nom, queue ));
+            solver_par->spmv_count++;
+        }
+        if ( magma_d_isnan_inf( nom ) ) {
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+        nrm = 1.0 / nom;
+        blasf77_zdscal( &dofs, &nrm, V(0), &ione );
+
+        for (i = 1; i < dim+1; i++)
+            s[i] = c_zero;
+        s[0] = MAGMA_Z_MAKE( nom, 0.0 );
+
+        i = -1;
+        do {
+            i++;
+            solver_par->numiter++;
+
+            // V(i+1) = A V(i)
+            vi.val  = V(i);
+            vi1.val = V(i+1);
+            CHECK( magma_z_spmv( c_one, A, vi, c_zero, vi1, queue ));
+            solver_par->spmv_count++;
+
+            // h = V(0:i)' V(i+1), and ||V(i+1)||^2 in h[i+1]
+            CHECK( magma_zmdotc_cpu( dofs, i+2, V(0), dofs, V(i+1), h, queue ));
+            nrmw = sqrt( MAGMA_Z_REAL( h[i+1] ));
+            // V(i+1) = V(i+1) - V(0:i) h
+            CHECK( magma_zmaxpy_nrm2_cpu( dofs, i+1, V(0), dofs, h, V(i+1), &nrm, queue ));
+            for (k = 0; k <= i; k++)
+                H(k,i) = h[k];
+
+            if ( nrm < GMRES_CPU_REORTH * nrmw ) {
+                CHECK( magma_zmdotc_cpu( dofs, i+1, V(0), dofs, V(i+1), h, queue ));
+                CHECK( magma_zmaxpy_nrm2_cpu( dofs, i+1, V(0), dofs, h, V(i+1), &nrm, queue ));
+                for (k = 0; k <= i; k++)
+                    H(k,i) += h[k];
+            }
+
+            // V(i+1) = V(i+1) / H(i+1,i); for nrm = 0, the Krylov space is invariant
+            H(i+1,i) = MAGMA_Z_MAKE( nrm, 0.0 );
+            if ( nrm > 0.0 ) {
+                nrmw = 1.0 / nrm;
+                blasf77_zdscal( &dofs, &nrmw, V(i+1), &ione );
+            }
+
+            for (k = 0; k < i; k++)
+                ApplyPlaneRotation(&H(k,i), &H(k+1,i), cs[k], sn[k]);
+
+            GeneratePlaneRotation(H(i,i), H(i+1,i), &cs[i], &sn[i]);
+            ApplyPlaneRotation(&H(i,i), &H(i+1,i), cs[i], sn[i]);
+            ApplyPlaneRotation(&s[i], &s[i+1], cs[i], sn[i]);
+
+            betanom = MAGMA_Z_ABS( s[i+1] );
+            if ( solver_par->verbose > 0 ) {
+                tempo2 = magma_wtime();
+                if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                    solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                            = (real_Double_t) betanom;
+                    solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                            = (real_Double_t) tempo2-tempo1;
+                }
+            }
+            if ( betanom/nomb <= solver_par->rtol || betanom <= solver_par->atol ) {
+                info = MAGMA_SUCCESS;
+                break;
+            }
+        }
+        while ( i+1 < dim && nrm > 0.0 && solver_par->numiter+1 <= solver_par->maxiter );
+
+        // solve upper triangular system in place
+        for (j = i; j >= 0; j--)
+        {
+            s[j] /= H(j,j);
+            for (k = j-1; k >= 0; k--)
+                s[k] -= H(k,j) * s[j];
+        }
+
+        // x = x + V(0:i) s, as x = x - V(0:i) (-s)
+        for (j = 0; j <= i; j++)
+            s[j] = -s[j];
+        CHECK( magma_zmaxpy_nrm2_cpu( dofs, i+1, V(0), dofs, s, x->val, &nrm, queue ));
+    }
+    while ( info != MAGMA_SUCCESS && solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    double residual;
+    vi.val = V(0);
+    CHECK( magma_zresidualvec( A, b, *x, &vi, &residual, queue ));
+    solver_par->iter_res = betanom;
+    solver_par->final_res = residual;
+
+    // set solver conclusion
+    if ( info != MAGMA_SUCCESS && info != MAGMA_DIVERGENCE ) {
+        if ( solver_par->init_res > solver_par->final_res ) {
+            info = MAGMA_SLOW_CONVERGENCE;
+        } else {
+            info = MAGMA_DIVERGENCE;
+        }
+    }
+
+cleanup:
+    magma_free_cpu( H );
+    magma_free_cpu( h );
+    magma_free_cpu( s );
+    magma_free_cpu( cs );
+    magma_free_cpu( sn );
+    magma_zmfree( &V, queue );
+
+    solver_par->info = info;
+    return info;
+} /* magma_zgmres_cpu */
@@ -0,0 +1,432 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+
+
+/*******************************************************************************
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a general complex N-by-N matrix A.
+    This is a CPU implementation of the Induced Dimension Reduction method,
+    with smoothing, following magma_zidr. A, b, and x are on the CPU.
+    The shadow space dimension s is taken from solver_par->restart, as in
+    magma_zidr. The SpMV is the multithreaded magma_zspmv_cpu.
+
+    The dot products with the shadow space P are computed in one pass for
+    all s columns, see magma_zmdotc_cpu; as M is lower triangular, this
+    gives both the coefficients for the bi-orthogonalization of G(:,k) and
+    the new column M(k:s,k). The updates of x and r, and the smoothing, are
+    merged into magma_zcgmerge_xr_cpu and magma_zidrmerge_smooth_cpu.
+    The operations on the s-dimensional systems use the CPU BLAS.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgesv
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zidr_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_IDR;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    solver_par->init_res = 0.0;
+    solver_par->final_res = 0.0;
+    solver_par->iter_res = 0.0;
+    solver_par->runtime = 0.0;
+
+    // constants
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_n_one = MAGMA_Z_NEG_ONE;
+
+    // internal user parameters
+    const double angle = 0.7;          // [0-1]
+
+    // local variables
+    magma_int_t iseed[4] = {0, 0, 0, 1};
+    magma_int_t dof, ione = 1;
+    magma_int_t s;
+    magma_int_t distr;
+    magma_int_t k, i, j, sk;
+    magma_int_t innerflag;
+    magma_int_t lwork, lapack_info;
+    double residual;
+    double nrm;
+    double nrmb;
+    double nrmr;
+    double nrmt;
+    double rho;
+    magmaDoubleComplex om;
+    magmaDoubleComplex tr;
+    magmaDoubleComplex mkk;
+    magmaDoubleComplex dots[2];
+    magmaDoubleComplex query;
+
+    // vectors and matrices; r and t are the columns of rt, so that
+    // r' r and t' r are computed in one pass
+    magma_z_matrix rt = {Magma_CSR}, r, t;
+    magma_z_matrix xs = {Magma_CSR}, rs = {Magma_CSR};
+    magma_z_matrix P = {Magma_CSR};
+    magma_z_matrix G = {Magma_CSR}, gk;
+    magma_z_matrix U = {Magma_CSR}, uk;
+    magma_z_matrix v = {Magma_CSR};
+    magmaDoubleComplex *M = NULL, *f = NULL, *c = NULL, *a = NULL, *beta = NULL;
+    magmaDoubleComplex *tau = NULL, *work = NULL;
+
+    // chronometry
+    real_Double_t tempo1, tempo2;
+
+    // initial s space, from the '--restart' option as in magma_zidr
+    s = 1;
+    if ( solver_par->restart != 50 ) {
+        if ( solver_par->restart > A.num_cols ) {
+            s = A.num_cols;
+        } else {
+            s = solver_par->restart;
+        }
+    }
+    solver_par->restart = s;
+
+    // set max iterations
+    solver_par->maxiter = min( 2 * A.num_cols, solver_par->maxiter );
+
+    // check if matrix A is square
+    if ( A.num_rows != A.num_cols ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    dof = A.num_rows;
+
+    // |b|
+    CHECK( magma_zmdotc_cpu( dof, 1, b.val, dof, b.val, dots, queue ));
+    nrmb = sqrt( MAGMA_Z_REAL( dots[0] ));
+    if ( nrmb == 0.0 ) {
+        for ( i = 0; i < dof; ++i ) {
+            x->val[i] = c_zero;
+        }
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    // r = b - A x
+    CHECK( magma_zvinit( &rt, Magma_CPU, dof, 2, c_zero, queue ));
+    r = rt;
+    r.num_cols = 1;
+    r.nnz = dof;
+    t = r;
+    t.val = rt.val + dof;
+    CHECK( magma_zresidualvec( A, b, *x, &r, &nrmr, queue ));
+
+    // |r|
+    solver_par->init_res = nrmr;
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t)nrmr;
+    }
+
+    // check if initial is guess good enough
+    if ( nrmr <= solver_par->atol ||
+        nrmr/nrmb <= solver_par->rtol ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    // P = randn(n, s)
+    CHECK( magma_zvinit( &P, Magma_CPU, dof, s, c_zero, queue ));
+    distr = 3;        // 1 = unif (0,1), 2 = unif (-1,1), 3 = normal (0,1)
+    sk = dof * s;
+    lapackf77_zlarnv( &distr, iseed, &sk, P.val );
+
+    // P = ortho(P)
+    if ( s > 1 ) {
+        // P = Q of the QR factorization of P
+        CHECK( magma_zmalloc_cpu( &tau, s ));
+        lwork = -1;
+        lapackf77_zgeqrf( &dof, &s, P.val, &dof, tau, &query, &lwork, &lapack_info );
+        sk = (magma_int_t) MAGMA_Z_REAL( query );
+        lapackf77_zungqr( &dof, &s, &s, P.val, &dof, tau, &query, &lwork, &lapack_info );
+        lwork = max( sk, (magma_int_t) MAGMA_Z_REAL( query ));
+        CHECK( magma_zmalloc_cpu( &work, lwork ));
+        lapackf77_zgeqrf( &dof, &s, P.val, &dof, tau, work, &lwork, &lapack_info );
+        lapackf77_zungqr( &dof, &s, &s, P.val, &dof, tau, work, &lwork, &lapack_info );
+    } else {
+        // P = P / |P|
+        CHECK( magma_zmdotc_cpu( dof, 1, P.val, dof, P.val, dots, queue ));
+        nrm = 1.0 / sqrt( MAGMA_Z_REAL( dots[0] ));
+        blasf77_zdscal( &dof, &nrm, P.val, &ione );
+    }
+
+    // smoothing solution and residual vectors
+    CHECK( magma_zvinit( &xs, Magma_CPU, dof, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &rs, Magma_CPU, dof, 1, c_zero, queue ));
+    blasf77_zcopy( &dof, x->val, &ione, xs.val, &ione );
+    blasf77_zcopy( &dof, r.val, &ione, rs.val, &ione );
+
+    // G(n,s) = 0, U(n,s) = 0, with views of column k
+    CHECK( magma_zvinit( &G, Magma_CPU, dof, s, c_zero, queue ));
+    CHECK( magma_zvinit( &U, Magma_CPU, dof, s, c_zero, queue ));
+    CHECK( magma_zvinit( &v, Magma_CPU, dof, 1, c_zero, queue ));
+    gk = v;
+    uk = v;
+
+    // M(s,s) = I, f, c, a, beta
+    CHECK( magma_zmalloc_cpu( &M, s*s ));
+    CHECK( magma_zmalloc_cpu( &f, s ));
+    CHECK( magma_zmalloc_cpu( &c, s ));
+    CHECK( magma_zmalloc_cpu( &a, s ));
+    CHECK( magma_zmalloc_cpu( &beta, s ));
+    lapackf77_zlaset( "F", &s, &s, &c_zero, &c_one, M, &s );
+
+    //--------------START TIME---------------
+    // chronometry
+    tempo1 = magma_wtime();
+    if ( solver_par->verbose > 0 ) {
+        solver_par->timing[0] = 0.0;
+    }
+
+    om = MAGMA_Z_ONE;
+    innerflag = 0;
+
+    // start iteration
+    do
+    {
+        solver_par->numiter++;
+
+        // new RHS for small systems
+        // f = P' r
+        CHECK( magma_zmdotc_cpu( dof, s, P.val, dof, r.val, f, queue ));
+
+        // shadow space loop
+        for ( k = 0; k < s; ++k ) {
+            sk = s - k;
+            gk.val = G.val + k*dof;
+            uk.val = U.val + k*dof;
+
+            // f(k:s) = M(k:s,k:s) c(k:s)
+            blasf77_zcopy( &sk, &f[k], &ione, &c[k], &ione );
+            blasf77_ztrsv( "L", "N", "N", &sk, &M[k*s+k], &s, &c[k], &ione );
+
+            // v = r - G(:,k:s) c(k:s)
+            blasf77_zcopy( &dof, r.val, &ione, v.val, &ione );
+            blasf77_zgemv( "N", &dof, &sk, &c_n_one, gk.val, &dof, &c[k], &ione, &c_one, v.val, &ione );
+
+            // U(:,k) = om * v + U(:,k:s) c(k:s)
+            blasf77_zgemv( "N", &dof, &sk, &c_one, uk.val, &dof, &c[k], &ione, &om, v.val, &ione );
+            blasf77_zcopy( &dof, v.val, &ione, uk.val, &ione );
+
+            // G(:,k) = A U(:,k)
+            CHECK( magma_z_spmv( c_one, A, uk, c_zero, gk, queue ));
+            solver_par->spmv_count++;
+
+            // a = P' G(:,k), before the bi-orthogonalization
+            CHECK( magma_zmdotc_cpu( dof, s, P.val, dof, gk.val, a, queue ));
+
+            // bi-orthogonalize the new basis vectors:
+            // solve M(0:k,0:k) a(0:k) = P(:,0:k)' G(:,k), then
+            // G(:,k) = G(:,k) - G(:,0:k) a(0:k)
+            // U(:,k) = U(:,k) - U(:,0:k) a(0:k)
+            // new column of M = P'G, first k-1 entries are zero
+            // M(k:s,k) = P(:,k:s)' G(:,k) = a(k:s) - M(k:s,0:k) a(0:k)
+            if ( k > 0 ) {
+                blasf77_ztrsv( "L", "N", "N", &k, M, &s, a, &ione );
+                blasf77_zgemv( "N", &dof, &k, &c_n_one, G.val, &dof, a, &ione, &c_one, gk.val, &ione );
+                blasf77_zgemv( "N", &dof, &k, &c_n_one, U.val, &dof, a, &ione, &c_one, uk.val, &ione );
+                blasf77_zgemv( "N", &sk, &k, &c_n_one, &M[k], &s, a, &ione, &c_one, &a[k], &ione );
+            }
+            blasf77_zcopy( &sk, &a[k], &ione, &M[k*s+k], &ione );
+
+            // check M(k,k) == 0
+            mkk = M[k*s+k];
+            if ( MAGMA_Z_EQUAL(mkk, MAGMA_Z_ZERO) ) {
+                innerflag = 1;
+                info = MAGMA_DIVERGENCE;
+                break;
+            }
+
+            // beta = f(k) / M(k,k)
+            beta[k] = f[k] / mkk;
+
+            // check for nan
+            if ( magma_z_isnan( beta[k] ) || magma_z_isinf( beta[k] )) {
+                innerflag = 1;
+                info = MAGMA_DIVERGENCE;
+                break;
+            }
+
+            // x = x + beta * U(:,k);  r = r - beta * G(:,k)
+            CHECK( magma_zcgmerge_xr_cpu( dof, beta[k], uk.val, gk.val, x->val, r.val, &nrm, queue ));
+
+            // smoothing operation
+            CHECK( magma_zidrmerge_smooth_cpu( dof, r.val, x->val, rs.val, xs.val, &nrmr, queue ));
+
+            // store current timing and residual
+            if ( solver_par->verbose > 0 ) {
+                tempo2 = magma_wtime();
+                if ( (solver_par->numiter) % solver_par->verbose == 0 ) {
+                    solver_par->res_vec[(solver_par->numiter) / solver_par->verbose]
+                            = (real_Double_t)nrmr;
+                    solver_par->timing[(solver_par->numiter) / solver_par->verbose]
+                            = (real_Double_t)tempo2 - tempo1;
+                }
+            }
+
+            // check convergence
+            if ( nrmr <= solver_par->atol ||
+                nrmr/nrmb <= solver_par->rtol ) {
+                innerflag = 2;
+                info = MAGMA_SUCCESS;
+                break;
+            }
+
+            // non-last s iteration
+            if ( (k + 1) < s ) {
+                // f(k+1:s) = f(k+1:s) - beta * M(k+1:s,k)
+                for ( j = k+1; j < s; ++j ) {
+                    f[j] -= beta[k] * M[k*s+j];
+                }
+            }
+        }
+
+        // check convergence or iteration limit or invalid result of inner loop
+        if ( innerflag > 0 ) {
+            break;
+        }
+
+        // t = A r
+        CHECK( magma_z_spmv( c_one, A, r, c_zero, t, queue ));
+        solver_par->spmv_count++;
+
+        // computation of a new omega
+//---------------------------------------
+        // r' r, t' r
+        CHECK( magma_zmdotc_cpu( dof, 2, rt.val, dof, r.val, dots, queue ));
+        nrm = sqrt( MAGMA_Z_REAL( dots[0] ));
+        tr = dots[1];
+
+        // |t|
+        CHECK( magma_zmdotc_cpu( dof, 1, t.val, dof, t.val, dots, queue ));
+        nrmt = sqrt( MAGMA_Z_REAL( dots[0] ));
+
+        // rho = abs(t' * r) / (|t| * |r|))
+        rho = MAGMA_D_ABS( MAGMA_Z_REAL(tr) / (nrmt * nrm) );
+
+        // om = (t' * r) / (|t| * |t|)
+        om = tr / (nrmt * nrmt);
+        if ( rho < angle ) {
+            om = (om * angle) / rho;
+        }
+//---------------------------------------
+        if ( MAGMA_Z_EQUAL(om, MAGMA_Z_ZERO) || magma_z_isnan_inf( om )) {
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+
+        // x = x + om * r;  r = r - om * t
+        CHECK( magma_zcgmerge_xr_cpu( dof, om, r.val, t.val, x->val, r.val, &nrm, queue ));
+
+        // smoothing operation
+        CHECK( magma_zidrmerge_smooth_cpu( dof, r.val, x->val, rs.val, xs.val, &nrmr, queue ));
+
+        // store current timing and residual
+        if ( solver_par->verbose > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter) % solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter) / solver_par->verbose]
+                        = (real_Double_t)nrmr;
+                solver_par->timing[(solver_par->numiter) / solver_par->verbose]
+                        = (real_Double_t)tempo2 - tempo1;
+            }
+        }
+
+        // check convergence
+        if ( nrmr <= solver_par->atol ||
+            nrmr/nrmb <= solver_par->rtol ) {
+            info = MAGMA_SUCCESS;
+            break;
+        }
+    }
+    while ( solver_par->numiter + 1 <= solver_par->maxiter );
+
+    // x = xs
+    blasf77_zcopy( &dof, xs.val, &ione, x->val, &ione );
+
+    // get last iteration timing
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t)tempo2 - tempo1;
+//--------------STOP TIME----------------
+
+    // get final stats
+    solver_par->iter_res = nrmr;
+    CHECK( magma_zresidualvec( A, b, *x, &r, &residual, queue ));
+    solver_par->final_res = residual;
+
+    // set solver conclusion
+    if ( info != MAGMA_SUCCESS && info != MAGMA_DIVERGENCE ) {
+        if ( solver_par->init_res > solver_par->final_res ) {
+            info = MAGMA_SLOW_CONVERGENCE;
+        } else {
+            info = MAGMA_DIVERGENCE;
+        }
+    }
+
+cleanup:
+    // free resources
+    magma_zmfree( &rt, queue );
+    magma_zmfree( &xs, queue );
+    magma_zmfree( &rs, queue );
+    magma_zmfree( &P, queue );
+    magma_zmfree( &G, queue );
+    magma_zmfree( &U, queue );
+    magma_zmfree( &v, queue );
+    magma_free_cpu( M );
+    magma_free_cpu( f );
+    magma_free_cpu( c );
+    magma_free_cpu( a );
+    magma_free_cpu( beta );
+    magma_free_cpu( tau );
+    magma_free_cpu( work );
+
+    solver_par->info = info;
+    return info;
+    /* magma_zidr_cpu */
+}
@@ -88,6 +88,8 @@ magma_zparict_cpu(
         L={Magma_CSR}, L_new={Magma_CSR}, L0={Magma_CSR};  
     magma_int_t num_rmL;
     double thrsL = 0.0;
+    size_t selecttmp_size = 0;
+    magma_ptr selecttmp_ptr = NULL;
 
     magma_int_t num_threads = 1, timing = 1; // 1 = print timing
     magma_int_t L0nnz;
@@ -161,8 +163,8 @@ magma_zparict_cpu(
         // pre-select: ignore the diagonal entries
         CHECK(magma_zparilut_preselect(0, &L_new, &oneL, queue));
         if (num_rmL>0) {
-            CHECK(magma_zparilut_set_thrs_randomselect(num_rmL, 
-                &oneL, 0, &thrsL, queue));
+            CHECK(magma_zsampleselect_cpu(oneL.nnz, num_rmL, 0, oneL.val,
+                &thrsL, &selecttmp_ptr, &selecttmp_size, queue));
         } else {
             thrsL = 0.0;
         }
@@ -229,6 +231,7 @@ cleanup:
     magma_zmfree(&L, queue);
     magma_zmfree(&LT, queue);
     magma_zmfree(&L_new, queue);
+    magma_free_cpu(selecttmp_ptr);
 #endif
     return info;
 }
@@ -27,7 +27,28 @@
     E. Chow and A. Patel: "Fine-grained Parallel Incomplete LU Factorization", 
     SIAM Journal on Scientific Computing, 37, C169-C193 (2015). 
     
-    This is the CPU implementation of the ParILU
+    This is the CPU implementation of the ParILU.
+
+    At most precond->sweeps asynchronous sweeps are done; they stop early
+    once the residual || A - L*U ||_F on the pattern of A, relative to
+    || A ||_F, is below precond->rtol. The residual and time of each sweep
+    are printed. On exit, precond->numiter is the number of sweeps done,
+    precond->init_res and precond->final_res are the relative residuals
+    measured in the first and last sweep, and precond->setuptime is the
+    setup time.
+
+    With precond->bsize > 0, the sweeps are colored (see
+    magma_zparilu_colors): the rows are split into cache-sized blocks of
+    about precond->bsize nonzeros, blocks sharing no column get the same
+    color, and the colors are swept in turn, the blocks of one color in
+    parallel. These sweeps are race-free, and the factors do not depend on
+    the number of threads. Smaller blocks give more parallelism but need
+    more sweeps; blocks of about nnz / (2 * number of threads) converge in
+    as many sweeps as the asynchronous ones. Matrices with small bandwidth,
+    e.g. after the RCM pre-pass of magma_zprecondreorder, need few colors.
+    Matrices that need more than 64 colors fall back to the asynchronous
+    sweeps. With precond->bsize = 0, the sweeps are asynchronous
+    (magma_zparilu_sweep_res).
 
     Arguments
     ---------
@@ -66,6 +87,13 @@ magma_zparilu_cpu(
 
     magma_z_matrix hAT={Magma_CSR}, hA={Magma_CSR}, hAL={Magma_CSR}, 
     hAU={Magma_CSR}, hAUT={Magma_CSR}, hAtmp={Magma_CSR}, hACOO={Magma_CSR};
+    magma_int_t timing = 1; // print residual and time per sweep
+    magma_index_t *block_row = NULL, *block_order = NULL, *color_ptr = NULL;
+    magma_int_t ncolors = 0;
+    real_Double_t start, t_setup, t_sweep, accum = 0.0;
+    double nrmA = 0.0, res = 0.0;
+
+    t_setup = magma_wtime();
 
     // copy original matrix as COO to device
     if (A.memory_location != Magma_CPU || A.storage_type != Magma_CSR) {
@@ -97,6 +125,14 @@ magma_zparilu_cpu(
     magma_zmatrix_tril(hAT, &hAU, queue);
     magma_zmfree(&hAT, queue);
     
+    // || A ||_F to scale the residual
+    for (magma_int_t k=0; k < hACOO.nnz; k++) {
+        nrmA += MAGMA_Z_REAL(hACOO.val[k]) * MAGMA_Z_REAL(hACOO.val[k])
+              + MAGMA_Z_IMAG(hACOO.val[k]) * MAGMA_Z_IMAG(hACOO.val[k]);
+    }
+    nrmA = sqrt( nrmA );
+    nrmA = ( nrmA > 0.0 ) ? nrmA : 1.0;
+    
     // This is the actual ParILU kernel. 
     // It can be called directly if
     // - the system matrix hACOO is available in COO format on the CPU 
@@ -104,8 +140,52 @@ magma_zparilu_cpu(
     // - hAU is the upper triangular in CSC on the CPU (U transpose in CSR)
     // The kernel is located in sparse/control/magma_zparilu_kernels.cpp
     //
+    if (precond->bsize > 0) {
+        info = magma_zparilu_colors(hACOO, precond->bsize,
+            &block_row, &block_order, &color_ptr, &ncolors, queue);
+        if (info == MAGMA_ERR_NOT_SUPPORTED) {
+            printf("%% warning: more than 64 colors, using asynchronous sweeps.\n");
+            ncolors = 0;
+            info = 0;
+        }
+        CHECK(info);
+    }
+    if (timing == 1) {
+        if (ncolors > 0) {
+            printf("%% colored sweeps: %lld colors\n", (long long) ncolors);
+        }
+        printf("parilu_%d = [\n%%sweep   residual    sweep      accum\n",
+            (int) omp_get_max_threads());
+    }
+    precond->numiter = 0;
     for (int i=0; i<precond->sweeps; i++) {
-        CHECK(magma_zparilu_sweep(hACOO, &hAL, &hAU, queue));
+        start = magma_wtime();
+        if (ncolors > 0) {
+            CHECK(magma_zparilu_sweep_colored(hACOO, &hAL, &hAU,
+                block_row, block_order, color_ptr, ncolors, &res, queue));
+        } else {
+            CHECK(magma_zparilu_sweep_res(hACOO, &hAL, &hAU, &res, queue));
+        }
+        t_sweep = magma_wtime() - start;
+        accum += t_sweep;
+        res = res / nrmA;
+        if (i == 0) {
+            precond->init_res = res;
+        }
+        precond->final_res = res;
+        precond->numiter = i+1;
+        if (timing == 1) {
+            printf("%5lld    %.4e   %.2e   %.2e\n",
+                (long long) i, res, t_sweep, accum);
+            fflush(stdout);
+        }
+        if (res < precond->rtol) {
+            break;
+        }
+    }
+    if (timing == 1) {
+        printf("];\n");
+        fflush(stdout);
     }
     CHECK(magma_z_cucsrtranspose(hAU, &hAUT, queue));
 
@@ -128,6 +208,8 @@ magma_zparilu_cpu(
             MAGMA_Z_ZERO, queue));
     }
 
+    precond->setuptime = magma_wtime() - t_setup;
+
 cleanup:
     magma_zmfree(&hAT, queue);
     magma_zmfree(&hA, queue);
@@ -136,6 +218,9 @@ cleanup:
     magma_zmfree(&hAUT, queue);
     magma_zmfree(&hAtmp, queue);
     magma_zmfree(&hACOO, queue);
+    magma_free_cpu(block_row);
+    magma_free_cpu(block_order);
+    magma_free_cpu(color_ptr);
 
 #endif
     return info;
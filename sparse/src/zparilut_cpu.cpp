@@ -91,6 +91,8 @@ magma_zparilut_cpu(
     magma_int_t num_rmL, num_rmU;
     double thrsL = 0.0;
     double thrsU = 0.0;
+    size_t selecttmp_size = 0;
+    magma_ptr selecttmp_ptr = NULL;
 
     magma_int_t num_threads = 1, timing = 1; // print timing
     magma_int_t L0nnz, U0nnz;
@@ -200,14 +202,14 @@ magma_zparilut_cpu(
         CHECK(magma_zparilut_preselect(0, &L_new, &oneL, queue));
         CHECK(magma_zparilut_preselect(0, &U_new, &oneU, queue));
         if (num_rmL>0) {
-            CHECK(magma_zparilut_set_thrs_randomselect_approx(num_rmL, 
-                &oneL, 0, &thrsL, queue));
+            CHECK(magma_zsampleselect_approx_cpu(oneL.nnz, num_rmL, 0, oneL.val,
+                &thrsL, &selecttmp_ptr, &selecttmp_size, queue));
         } else {
             thrsL = 0.0;
         }
         if (num_rmU>0) {
-            CHECK(magma_zparilut_set_thrs_randomselect_approx(num_rmU, 
-                &oneU, 0, &thrsU, queue));
+            CHECK(magma_zsampleselect_approx_cpu(oneU.nnz, num_rmU, 0, oneU.val,
+                &thrsU, &selecttmp_ptr, &selecttmp_size, queue));
         } else {
             thrsU = 0.0;
         }
@@ -281,6 +283,7 @@ cleanup:
     magma_zmfree(&U_new, queue);
     magma_zmfree(&hL, queue);
     magma_zmfree(&hU, queue);
+    magma_free_cpu(selecttmp_ptr);
 #endif
     return info;
 }
@@ -19,7 +19,8 @@
     -------
 
     Computes the residual r = b-Ax for a solution approximation x.
-    It returns both, the actual residual and the residual vector
+    It returns both, the actual residual and the residual vector.
+    For objects on the CPU, a single right-hand side is supported.
 
     Arguments
     ---------
@@ -62,9 +63,15 @@ magma_zresidualvec(
     // some useful variables
     magmaDoubleComplex zero = MAGMA_Z_ZERO, one = MAGMA_Z_ONE,
                                             mone = MAGMA_Z_NEG_ONE;
-    magma_int_t dofs = A.num_rows;
+    magma_int_t dofs = A.num_rows, ione = 1;
+    magmaDoubleComplex nrm2;
     
-    if ( A.num_rows == b.num_rows ) {
+    if ( A.memory_location == Magma_CPU && A.num_rows == b.num_rows ) {
+        blasf77_zcopy( &dofs, b.val, &ione, r->val, &ione );        // r = b
+        CHECK( magma_z_spmv( mone, A, x, one, *r, queue ));            // r = r - A x
+        CHECK( magma_zmdotc_cpu( dofs, 1, r->val, dofs, r->val, &nrm2, queue ));
+        *res = sqrt( MAGMA_Z_REAL( nrm2 ));                             // res = ||r||
+    } else if ( A.num_rows == b.num_rows ) {
         CHECK( magma_z_spmv( mone, A, x, zero, *r, queue ));      // r = A x
         magma_zaxpy( dofs, one, b.dval, 1, r->dval, 1, queue );          // r = r - b
         *res =  magma_dznrm2( dofs, r->dval, 1, queue );            // res = ||r||
@@ -387,6 +387,22 @@ if ( opts.bombard_merge ):
 # end
 
 
+# looping over solvers on the CPU, without preconditioner
+cpusolvers = []
+if ( opts.cg ):
+    cpusolvers += ['--compute CPU --solver CG']
+# end
+if ( opts.bicgstab ):
+    cpusolvers += ['--compute CPU --solver BICGSTAB']
+# end
+if ( opts.gmres ):
+    cpusolvers += ['--compute CPU --solver GMRES']
+# end
+if ( opts.idr ):
+    cpusolvers += ['--compute CPU --solver IDR']
+# end
+
+
 # looping over precsolvers
 precsolvers = []
 if ( opts.pcg ):
@@ -431,6 +447,9 @@ if ( opts.jacobi_prec ):
 # end
 if ( opts.ilu_exact_prec ):
     precs += ['--precond ILU ']
+    precs += ['--precond ILU --reorder RCM ']
+    precs += ['--precond ILU --reorder AMD ']
+    precs += ['--precond ILU --reorder ND ']
 # end
 if ( opts.ilut_prec ):
     precs += ['--precond PARILUT --prestart 1 --psweeps 5 --plevels 0 --prtol 0.05 --patol 0.2 ']
@@ -566,6 +585,41 @@ if ( opts.control):
             cmd = substitute( 'testing_zmconverter', 'z', precision )
             tests.append( [cmd, '', size, ''] )
 
+# ----------------------------------------------------------------------
+if ( opts.control):
+    for precision in opts.precisions:
+        for size in sizes:
+            # precision generation
+            cmd = substitute( 'testing_zmconvert_cpu', 'z', precision )
+            tests.append( [cmd, '', size, ''] )
+
+# ----------------------------------------------------------------------
+if ( opts.control):
+    for precision in opts.precisions:
+        for size in sizes:
+            # precision generation
+            cmd = substitute( 'testing_zmtranspose_cpu', 'z', precision )
+            tests.append( [cmd, '', size, ''] )
+        # above the threshold of the parallel transpose
+        cmd = substitute( 'testing_zmtranspose_cpu', 'z', precision )
+        tests.append( [cmd, '', 'LAPLACE2D 200', ''] )
+
+# ----------------------------------------------------------------------
+if ( opts.control):
+    for precision in opts.precisions:
+        for size in sizes:
+            # precision generation
+            cmd = substitute( 'testing_zmreorder', 'z', precision )
+            tests.append( [cmd, '', size, ''] )
+
+# ----------------------------------------------------------------------
+if ( opts.control):
+    for precision in opts.precisions:
+        for size in sizes:
+            # precision generation
+            cmd = substitute( 'testing_zsymbilu', 'z', precision )
+            tests.append( [cmd, '', size, ''] )
+
 # ----------------------------------------------------------------------
 if ( opts.control):
     for precision in opts.precisions:
@@ -594,6 +648,52 @@ if ( opts.sparse_blas):
                     tests.append( [cmd, alignment + ' ' + blocksize, size, ''] )
 
 
+# ----------------------------------------------------------------------
+if ( opts.sparse_blas):
+    for precision in opts.precisions:
+        for size in sizes:
+            for blocksize in blocksizes:
+                for alignment in alignments:
+                    # precision generation
+                    cmd = substitute( 'testing_zspmv_cpu', 'z', precision )
+                    tests.append( [cmd, alignment + ' ' + blocksize, size, ''] )
+
+
+# ----------------------------------------------------------------------
+if ( opts.sparse_blas):
+    for precision in opts.precisions:
+        for size in sizes:
+            # precision generation
+            cmd = substitute( 'testing_zspgemm_cpu', 'z', precision )
+            tests.append( [cmd, '', size, ''] )
+
+
+# ----------------------------------------------------------------------
+if ( opts.sparse_blas):
+    for precision in opts.precisions:
+        for size in sizes:
+            # precision generation
+            cmd = substitute( 'testing_ztrisolve_cpu', 'z', precision )
+            tests.append( [cmd, '', size, ''] )
+            tests.append( [cmd, '--nrhs 3', size, ''] )
+        # large levels, split among the threads
+        cmd = substitute( 'testing_ztrisolve_cpu', 'z', precision )
+        tests.append( [cmd, '--nrhs 3', 'LAPLACE3D 40', ''] )
+
+
+# ----------------------------------------------------------------------
+# ParILU sweeps on the CPU, compared to ILU(0); on the Laplace matrices,
+# where they converge in few sweeps
+if ( opts.sparse_blas):
+    for precision in opts.precisions:
+        for size in sizes:
+            if ( size.startswith( 'LAPLACE2D' )):
+                # precision generation
+                cmd = substitute( 'testing_zparilu_cpu', 'z', precision )
+                tests.append( [cmd, '--pbsize 64',   size, ''] )
+                tests.append( [cmd, '--pbsize 1024', size, ''] )
+
+
 # ----------------------------------------------------------------------
 if ( opts.sparse_blas):
     for precision in opts.precisions:
@@ -614,6 +714,15 @@ for solver in solvers:
             tests.append( [cmd, solver, size, ''] )
 
 
+# ----------------------------------------------------------------------
+for solver in cpusolvers:
+    for size in sizes:
+        for precision in opts.precisions:
+            # precision generation
+            cmd = substitute( 'testing_zsolver', 'z', precision )
+            tests.append( [cmd, solver, size, ''] )
+
+
 # ----------------------------------------------------------------------
 for solver in precsolvers:
     for precond in precs:
@@ -66,8 +66,41 @@ int main(  int argc, char** argv )
         // read from file
         TESTING_CHECK( magma_z_csr_mtx( &A2, filename, queue ));
 
-        // delete temporary matrix
+        // binary format: write, then map it back
+        const char *binname = "testmatrix.mcsr";
+        magma_z_matrix A6={Magma_CSR}, A7={Magma_CSR};
+        real_Double_t t_mtx, t_bin;
+        TESTING_CHECK( magma_zwrite_csr_bin( A, binname, queue ));
+        t_mtx = magma_wtime();
+        TESTING_CHECK( magma_z_csr_mtx( &A7, filename, queue ));
+        t_mtx = magma_wtime() - t_mtx;
+        t_bin = magma_wtime();
+        TESTING_CHECK( magma_zread_csr_bin( &A6, binname, queue ));
+        t_bin = magma_wtime() - t_bin;
+        printf("%% read time: mtx %.4f s, binary %.6f s\n", t_mtx, t_bin );
+
+        TESTING_CHECK( magma_zmdiff( A, A6, &res, queue ));
+        printf("%% ||A-B||_F = %8.2e\n", res);
+        if ( res < .000001 )
+            printf("%% tester binary IO:  ok\n");
+        else
+            printf("%% tester binary IO:  failed\n");
+        TESTING_CHECK( magma_zclose_csr_bin( &A6, queue ));
+        magma_zmfree( &A7, queue );
+
+        // magma_z_csr_mtx also reads binary files
+        TESTING_CHECK( magma_z_csr_mtx( &A6, binname, queue ));
+        TESTING_CHECK( magma_zmdiff( A, A6, &res, queue ));
+        printf("%% ||A-B||_F = %8.2e\n", res);
+        if ( res < .000001 )
+            printf("%% tester binary read into MAGMA matrix:  ok\n");
+        else
+            printf("%% tester binary read into MAGMA matrix:  failed\n");
+        magma_zmfree( &A6, queue );
+
+        // delete temporary matrices
         unlink( filename );
+        unlink( binname );
                 
         //visualize
         printf("A2:\n");
@@ -0,0 +1,206 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// memory footprint of a CPU matrix B in the given format, in bytes
+static double
+zmconvert_cpu_bytes( magma_z_matrix B, magma_storage_t format )
+{
+    double nval = B.nnz, ncol = B.nnz, nrow = B.num_rows+1, nidx = 0;
+
+    switch( format ) {
+        case Magma_COO:
+            nrow = B.nnz;
+            break;
+        case Magma_CSRCOO:
+            nidx = B.nnz;
+            break;
+        case Magma_ELLPACKT:
+        case Magma_ELL:
+        case Magma_ELLD:
+            nval = ncol = (double) B.max_nnz_row * B.num_rows;
+            nrow = 0;
+            break;
+        case Magma_ELLRT:
+            nval = ncol = (double) magma_roundup( B.max_nnz_row, B.alignment ) * B.num_rows;
+            nrow = B.num_rows;
+            break;
+        case Magma_SELLP:
+            nrow = B.numblocks+1;
+            break;
+        case Magma_DENSE:
+            nval = (double) B.num_rows * B.num_cols;
+            ncol = nrow = 0;
+            break;
+        case Magma_CSR5:
+            nidx = B.csr5_p+1 + B.csr5_num_offsets;
+            nidx += (double) (B.csr5_p+1)
+                  + (double) B.csr5_p * MAGMA_CSR5_OMEGA * B.csr5_num_packets;
+            nval += B.csr5_p;
+            break;
+        default:
+            break;
+    }
+    return nval*sizeof(magmaDoubleComplex) + (ncol+nrow+nidx)*sizeof(magma_index_t);
+}
+
+
+// true if the CSR matrices A and B are identical
+static bool
+zmconvert_cpu_equal( magma_z_matrix A, magma_z_matrix B )
+{
+    if ( A.num_rows != B.num_rows || A.nnz != B.nnz ) {
+        return false;
+    }
+    for( magma_int_t i=0; i <= A.num_rows; i++ ) {
+        if ( A.row[i] != B.row[i] )
+            return false;
+    }
+    for( magma_int_t j=0; j < A.nnz; j++ ) {
+        if ( A.col[j] != B.col[j] || ! MAGMA_Z_EQUAL( A.val[j], B.val[j] ))
+            return false;
+    }
+    return true;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Benchmark of the CPU format conversions in magma_zmconvert.
+      For every format, times the conversion from CSR, the conversion back,
+      and the values-only refresh with magma_zmconvert_values, and reports
+      the memory of the converted matrix, relative to CSR. Checks that the
+      round trip reproduces the matrix, before and after a refresh with
+      new values.
+      Usage: testing_zmconvert_cpu [ --blocksize b --alignment a ] matrices
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hA2={Magma_CSR}, hB={Magma_CSR}, hC={Magma_CSR};
+    magma_int_t blocksize = 32, alignment = 4;
+    real_Double_t start, end, totime, backtime, valtime;
+    int status = 0;
+
+    const int nformats = 10;
+    magma_storage_t formats[ nformats ] = {
+        Magma_CSR, Magma_CSRD, Magma_CSRCOO, Magma_ELLPACKT, Magma_ELL,
+        Magma_ELLD, Magma_ELLRT, Magma_SELLP, Magma_CSR5, Magma_DENSE };
+    const char* names[ nformats ] = {
+        "CSR", "CSRD", "CSRCOO", "ELLPACKT", "ELL",
+        "ELLD", "ELLRT", "SELLP", "CSR5", "DENSE" };
+    const int nrepeat = 10;
+
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--blocksize", argv[i]) == 0 && i+1 < argc ) {
+            blocksize = atoi( argv[++i] );
+        } else if ( strcmp("--alignment", argv[i]) == 0 && i+1 < argc ) {
+            alignment = atoi( argv[++i] );
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zmconvert_cpu"
+            " [ --blocksize %lld --alignment %lld (for SELLP, ELLRT) ] matrices\n\n",
+            (long long) blocksize, (long long) alignment );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+
+        // same pattern, new values, for the refresh
+        TESTING_CHECK( magma_zmconvert( hA, &hA2, Magma_CSR, Magma_CSR, queue ));
+        for( magma_int_t j=0; j < hA2.nnz; j++ ) {
+            hA2.val[j] = hA2.val[j] * MAGMA_Z_MAKE( 2.0, 0.0 ) + MAGMA_Z_ONE;
+        }
+        double csrbytes = zmconvert_cpu_bytes( hA, Magma_CSR );
+
+        printf( "%%   format   to (ms)   back (ms)   values (ms)   memory (MB)   vs. CSR   check\n" );
+        printf( "%%==============================================================================\n" );
+        for( int f=0; f < nformats; f++ ) {
+            if ( formats[f] == Magma_DENSE
+                 && (double) hA.num_rows * hA.num_cols > 1e8 / sizeof(magmaDoubleComplex) ) {
+                continue;
+            }
+
+            // CSR to format
+            start = magma_wtime();
+            for( int r=0; r < nrepeat; r++ ) {
+                hB.blocksize = blocksize;
+                hB.alignment = alignment;
+                TESTING_CHECK( magma_zmconvert( hA, &hB, Magma_CSR, formats[f], queue ));
+            }
+            end = magma_wtime();
+            totime = (end-start)/nrepeat;
+
+            // format to CSR
+            start = magma_wtime();
+            for( int r=0; r < nrepeat; r++ ) {
+                TESTING_CHECK( magma_zmconvert( hB, &hC, formats[f], Magma_CSR, queue ));
+            }
+            end = magma_wtime();
+            backtime = (end-start)/nrepeat;
+            bool okay = zmconvert_cpu_equal( hA, hC );
+
+            // values-only refresh, checked by converting back
+            start = magma_wtime();
+            for( int r=0; r < nrepeat; r++ ) {
+                TESTING_CHECK( magma_zmconvert_values( hA2, &hB, Magma_CSR, formats[f], queue ));
+            }
+            end = magma_wtime();
+            valtime = (end-start)/nrepeat;
+
+            TESTING_CHECK( magma_zmconvert( hB, &hC, formats[f], Magma_CSR, queue ));
+            okay = okay && zmconvert_cpu_equal( hA2, hC );
+            status += ! okay;
+
+            double bytes = zmconvert_cpu_bytes( hB, formats[f] );
+            printf( "%10s   %7.3f   %9.3f   %11.3f   %11.2f   %7.2f   %s\n",
+                    names[f], totime*1e3, backtime*1e3, valtime*1e3,
+                    bytes/1e6, bytes/csrbytes, (okay ? "ok" : "failed") );
+            fflush( stdout );
+
+            magma_zmfree( &hB, queue );
+            magma_zmfree( &hC, queue );
+        }
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hA2, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -0,0 +1,198 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// bandwidth of the CSR matrix A
+static magma_int_t
+zmreorder_bandwidth( magma_z_matrix A )
+{
+    magma_int_t bw = 0;
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            bw = max( bw, max( A.col[j] - i, i - A.col[j] ));
+        }
+    }
+    return bw;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Benchmark of the reorderings in magma_zmreorder.
+      For every ordering, reports the time to compute it, the bandwidth of
+      the reordered matrix P A P^T, the runtime of its SpMV on the CPU, and
+      the nonzeros of the ILU(k) pattern from magma_zsymbilu, relative to A.
+      Unless --parilut 0, also reports the nonzeros of the ParILUT factors
+      from magma_zparilut_cpu, and their ILU residual ||A - LU||_F.
+      Checks that solving with P A P^T and the permuted right-hand side
+      gives back the permuted vector.
+      Usage: testing_zmreorder [ --levels k --fill r --sweeps s --parilut 0|1 ]
+             matrices
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hB={Magma_CSR}, hC={Magma_CSR};
+    magma_z_matrix hL={Magma_CSR}, hU={Magma_CSR}, hLU={Magma_CSR};
+    magma_z_matrix x={Magma_CSR}, y={Magma_CSR}, Px={Magma_CSR}, Py={Magma_CSR}, z={Magma_CSR};
+    magma_z_solver_par solver_par;
+    magma_z_preconditioner precond;
+    magma_index_t *perm = NULL;
+    magma_int_t levels = 1, sweeps = 5, parilut = 1;
+    double fill = 2.0;
+    real_Double_t start, end, ordtime, spmvtime, ilures, nonlinres;
+    int status = 0;
+
+    const int norders = 4;
+    magma_reorder_t orders[ norders ] = {
+        Magma_NOREORDER, Magma_RCM, Magma_AMD, Magma_ND };
+    const char* names[ norders ] = { "NONE", "RCM", "AMD", "ND" };
+    const int nrepeat = 100;
+
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--levels", argv[i]) == 0 && i+1 < argc ) {
+            levels = atoi( argv[++i] );
+        } else if ( strcmp("--fill", argv[i]) == 0 && i+1 < argc ) {
+            fill = atof( argv[++i] );
+        } else if ( strcmp("--sweeps", argv[i]) == 0 && i+1 < argc ) {
+            sweeps = atoi( argv[++i] );
+        } else if ( strcmp("--parilut", argv[i]) == 0 && i+1 < argc ) {
+            parilut = atoi( argv[++i] );
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zmreorder"
+            " [ --levels %lld --fill %.1f --sweeps %lld --parilut %lld ] matrices\n\n",
+            (long long) levels, fill, (long long) sweeps, (long long) parilut );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+
+        TESTING_CHECK( magma_zvinit( &x, Magma_CPU, hA.num_rows, 1, MAGMA_Z_ZERO, queue ));
+        TESTING_CHECK( magma_zvinit( &y, Magma_CPU, hA.num_rows, 1, MAGMA_Z_ZERO, queue ));
+        TESTING_CHECK( magma_zvinit( &z, Magma_CPU, hA.num_rows, 1, MAGMA_Z_ZERO, queue ));
+        for( magma_int_t j=0; j < hA.num_rows; j++ ) {
+            x.val[j] = MAGMA_Z_MAKE( (double) (j % 7) + 1.0, 0.0 );
+        }
+        TESTING_CHECK( magma_z_spmv( MAGMA_Z_ONE, hA, x, MAGMA_Z_ZERO, y, queue ));
+
+        printf( "%%  order   time (ms)   bandwidth   SpMV (ms)   ILU(%lld) nnz   fill"
+                "   ParILUT nnz   ILU res.   check\n", (long long) levels );
+        printf( "%%=========================================================="
+                "=================================\n" );
+        for( int o=0; o < norders; o++ ) {
+            start = magma_wtime();
+            TESTING_CHECK( magma_zmreorder( hA, orders[o], &perm, queue ));
+            end = magma_wtime();
+            ordtime = end-start;
+            TESTING_CHECK( magma_zmpermute( hA, perm, &hB, queue ));
+
+            // (P A P^T) (P x) = P y
+            TESTING_CHECK( magma_zvpermute( x, perm, MagmaNoTrans, &Px, queue ));
+            TESTING_CHECK( magma_zvpermute( y, perm, MagmaNoTrans, &Py, queue ));
+            start = magma_wtime();
+            for( int r=0; r < nrepeat; r++ ) {
+                TESTING_CHECK( magma_z_spmv( MAGMA_Z_ONE, hB, Px, MAGMA_Z_ZERO, z, queue ));
+            }
+            end = magma_wtime();
+            spmvtime = (end-start)/nrepeat;
+            bool okay = true;
+            for( magma_int_t j=0; j < hA.num_rows; j++ ) {
+                okay = okay && MAGMA_Z_ABS( z.val[j] - Py.val[j] )
+                               <= 1e-6 * (1.0 + MAGMA_Z_ABS( Py.val[j] ));
+            }
+            status += ! okay;
+
+            // ILU(k) pattern
+            TESTING_CHECK( magma_zmtransfer( hB, &hC, Magma_CPU, Magma_CPU, queue ));
+            TESTING_CHECK( magma_zsymbilu( &hC, levels, &hL, &hU, queue ));
+            magma_int_t ilunnz = hC.nnz;
+            magma_zmfree( &hL, queue );
+            magma_zmfree( &hU, queue );
+
+            // ParILUT factors
+            magma_int_t lunnz = 0;
+            ilures = 0.0;
+            if ( parilut ) {
+                solver_par.maxiter = 0;
+                solver_par.verbose = 0;
+                solver_par.version = 0;
+                solver_par.restart = 0;
+                solver_par.solver = Magma_NONE;
+                TESTING_CHECK( magma_zsolverinfo_init( &solver_par, &precond, queue ));
+                precond.solver = Magma_PARILUT;
+                precond.trisolver = Magma_CUSOLVE;
+                precond.reorder = Magma_NOREORDER;
+                precond.levels = 0;
+                precond.sweeps = sweeps;
+                precond.atol = fill;
+                precond.rtol = 0.1;
+                TESTING_CHECK( magma_zparilut_cpu( hB, hB, &precond, queue ));
+                TESTING_CHECK( magma_zmtransfer( precond.L, &hL, Magma_DEV, Magma_CPU, queue ));
+                TESTING_CHECK( magma_zmtransfer( precond.U, &hU, Magma_DEV, Magma_CPU, queue ));
+                lunnz = hL.nnz + hU.nnz;
+                TESTING_CHECK( magma_zilures( hB, hL, hU, &hLU, &ilures, &nonlinres, queue ));
+                magma_zmfree( &hL, queue );
+                magma_zmfree( &hU, queue );
+                magma_zmfree( &hLU, queue );
+                magma_zprecondfree( &precond, queue );
+            }
+
+            printf( "%8s   %9.3f   %9lld   %9.4f   %11lld   %5.2f   %11lld   %8.2e   %s\n",
+                    names[o], ordtime*1e3, (long long) zmreorder_bandwidth( hB ),
+                    spmvtime*1e3, (long long) ilunnz, (double) ilunnz / hA.nnz,
+                    (long long) lunnz, ilures, (okay ? "ok" : "failed") );
+            fflush( stdout );
+
+            magma_free_cpu( perm );
+            perm = NULL;
+            magma_zmfree( &hB, queue );
+            magma_zmfree( &hC, queue );
+            magma_zmfree( &Px, queue );
+            magma_zmfree( &Py, queue );
+        }
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &x, queue );
+        magma_zmfree( &y, queue );
+        magma_zmfree( &z, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -0,0 +1,184 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "testings.h"
+
+
+#define NREPEAT 10
+#define MAX_THREADS 64
+
+
+// compares two CSR matrices entry by entry; returns number of mismatches
+static magma_int_t
+compare_csr( magma_z_matrix A, magma_z_matrix B, bool values )
+{
+    magma_int_t nerror = 0;
+    if ( A.num_rows != B.num_rows || A.num_cols != B.num_cols || A.nnz != B.nnz ) {
+        return 1;
+    }
+    for( magma_int_t i=0; i < A.num_rows+1; i++ ) {
+        nerror += (A.row[i] != B.row[i]);
+    }
+    for( magma_int_t j=0; j < A.nnz; j++ ) {
+        nerror += (A.col[j] != B.col[j]);
+        if ( values ) {
+            nerror += ! (MAGMA_Z_EQUAL( A.val[j], B.val[j] ));
+        }
+    }
+    return nerror;
+}
+
+
+// reference: sequential transpose of A with op( a ) applied to the values,
+// op 0: a, 1: conj( a ), 2: a (struct), 3: |a|. The entries (i, j, a) of A
+// are swapped to (j, i, a) and sorted stably by row, by counting sort.
+static void
+ref_ztranspose( magma_z_matrix A, int op, magma_z_matrix *R, magma_queue_t queue )
+{
+    R->storage_type = Magma_CSR;
+    R->memory_location = Magma_CPU;
+    R->num_rows = A.num_cols;
+    R->num_cols = A.num_rows;
+    R->nnz = A.nnz;
+    TESTING_CHECK( magma_index_malloc_cpu( &R->row, R->num_rows+1 ));
+    TESTING_CHECK( magma_index_malloc_cpu( &R->col, max( A.nnz, 1 )));
+    TESTING_CHECK( magma_zmalloc_cpu( &R->val, max( A.nnz, 1 )));
+    for( magma_int_t j=0; j <= R->num_rows; j++ ) {
+        R->row[j] = 0;
+    }
+    for( magma_int_t k=0; k < A.nnz; k++ ) {
+        R->row[ A.col[k]+1 ]++;
+    }
+    for( magma_int_t j=0; j < R->num_rows; j++ ) {
+        R->row[j+1] += R->row[j];
+    }
+    for( magma_int_t i=0; i < A.num_rows; i++ ) {
+        for( magma_int_t k=A.row[i]; k < A.row[i+1]; k++ ) {
+            magma_index_t p = R->row[ A.col[k] ]++;
+            magmaDoubleComplex a = A.val[k];
+            R->col[p] = i;
+            R->val[p] = (op == 1 ? MAGMA_Z_CONJ( a ) :
+                         op == 3 ? MAGMA_Z_MAKE( MAGMA_Z_ABS( a ), 0. ) : a);
+        }
+    }
+    for( magma_int_t j=R->num_rows; j > 0; j-- ) {
+        R->row[j] = R->row[j-1];
+    }
+    R->row[0] = 0;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- testing scaling of the CPU transpose (plain, conj, struct, abs)
+      for 1, 2, 4, ..., 64 threads. Results are compared entry by entry
+      against a sequential reference transpose; for struct, only the
+      pattern. Matrices with more than 16384 nonzeros in the lower triangle,
+      e.g., LAPLACE2D 200, use several threads.
+*/
+int main(  int argc, char** argv )
+{
+    magma_int_t info = 0;
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_zopts zopts;
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    real_Double_t t_op[4], t_ref = 0;
+    magma_z_matrix A={Magma_CSR}, Z={Magma_CSR}, ref[4], B={Magma_CSR};
+
+    int i=1;
+    TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
+
+    #ifdef _OPENMP
+    int max_threads = omp_get_max_threads();
+    #else
+    int max_threads = 1;
+    #endif
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &Z, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &Z,  argv[i], queue ));
+        }
+        // use the lower triangle, so the transpose differs from A
+        TESTING_CHECK( magma_zmconvert( Z, &A, Magma_CSR, Magma_CSRL, queue ));
+        magma_zmfree( &Z, queue );
+
+        printf("%% matrix info: %lld-by-%lld with %lld nonzeros\n",
+                (long long) A.num_rows, (long long) A.num_cols, (long long) A.nnz );
+        for( int op=0; op < 4; op++ ) {
+            ref_ztranspose( A, op, &ref[op], queue );
+        }
+
+        printf("%% threads   trans (s)    conj (s)  struct (s)     abs (s)   speedup   check\n");
+        printf("%%============================================================================\n");
+
+        for( int nthreads=1; nthreads <= MAX_THREADS; nthreads *= 2 ) {
+            #ifdef _OPENMP
+            omp_set_num_threads( nthreads );
+            #endif
+            magma_int_t nerror = 0;
+            for( int op=0; op < 4; op++ ) {
+                real_Double_t start = magma_wtime();
+                for( int r=0; r < NREPEAT; r++ ) {
+                    switch( op ) {
+                        case 0: TESTING_CHECK( magma_zmtranspose_cpu( A, &B, queue )); break;
+                        case 1: TESTING_CHECK( magma_zmtransposeconj_cpu( A, &B, queue )); break;
+                        case 2: TESTING_CHECK( magma_zmtransposestruct_cpu( A, &B, queue )); break;
+                        case 3: TESTING_CHECK( magma_zmtransposeabs_cpu( A, &B, queue )); break;
+                    }
+                }
+                t_op[op] = (magma_wtime() - start) / NREPEAT;
+                nerror += compare_csr( ref[op], B, op != 2 );
+                magma_zmfree( &B, queue );
+            }
+            if ( nthreads == 1 ) {
+                t_ref = t_op[0];
+            }
+            printf( " %7d  %10.4f  %10.4f  %10.4f  %10.4f  %8.2f   %s\n",
+                    nthreads, t_op[0], t_op[1], t_op[2], t_op[3], t_ref / t_op[0],
+                    (nerror == 0 ? "ok" : "failed") );
+            info += (nerror != 0);
+            fflush( stdout );
+        }
+        printf( "\n" );
+
+        for( int op=0; op < 4; op++ ) {
+            magma_zmfree( &ref[op], queue );
+        }
+        magma_zmfree( &A, queue );
+        i++;
+    }
+
+    #ifdef _OPENMP
+    omp_set_num_threads( max_threads );
+    #endif
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return info;
+}
@@ -0,0 +1,231 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// reference: sequential ILU(0) of A in CSR with sorted columns, in place
+// in LU; the strictly lower part is L (unit diagonal), the rest is U
+static void
+ref_zilu0( magma_z_matrix A, magma_z_matrix *LU, magma_queue_t queue )
+{
+    magma_index_t *diag = NULL, *pos = NULL;
+    magma_int_t n = A.num_rows;
+
+    TESTING_CHECK( magma_zmtransfer( A, LU, Magma_CPU, Magma_CPU, queue ));
+    TESTING_CHECK( magma_index_malloc_cpu( &diag, n ));
+    TESTING_CHECK( magma_index_malloc_cpu( &pos, n ));
+    for( magma_int_t i=0; i < n; i++ ){
+        pos[i] = -1;
+        diag[i] = -1;
+        for( magma_int_t p=LU->row[i]; p < LU->row[i+1]; p++ ){
+            if ( LU->col[p] == i ) {
+                diag[i] = p;
+            }
+        }
+    }
+    for( magma_int_t i=0; i < n; i++ ){
+        for( magma_int_t p=LU->row[i]; p < LU->row[i+1]; p++ ){
+            pos[ LU->col[p] ] = p;
+        }
+        for( magma_int_t p=LU->row[i]; p < LU->row[i+1] && LU->col[p] < i; p++ ){
+            magma_index_t k = LU->col[p];
+            LU->val[p] = LU->val[p] / LU->val[ diag[k] ];
+            for( magma_int_t q=diag[k]+1; q < LU->row[k+1]; q++ ){
+                if ( pos[ LU->col[q] ] >= 0 ) {
+                    LU->val[ pos[ LU->col[q] ] ] -= LU->val[p] * LU->val[q];
+                }
+            }
+        }
+        for( magma_int_t p=LU->row[i]; p < LU->row[i+1]; p++ ){
+            pos[ LU->col[p] ] = -1;
+        }
+    }
+    magma_free_cpu( diag );
+    magma_free_cpu( pos );
+}
+
+
+// returns entry (i,j) of R, which has sorted columns, or zero if not stored
+static magmaDoubleComplex
+zparilu_cpu_entry( magma_z_matrix R, magma_int_t i, magma_int_t j )
+{
+    magma_int_t lo = R.row[i], hi = R.row[i+1];
+    while ( lo < hi ) {
+        magma_int_t mid = (lo + hi) / 2;
+        if ( R.col[mid] < j ) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return (lo < R.row[i+1] && R.col[lo] == j ? R.val[lo] : MAGMA_Z_ZERO);
+}
+
+
+// relative difference sum |F - R| / sum |R| of the factors L (CSR, unit
+// diagonal) and U (U^T in CSR) to the reference factorization R
+static double
+zparilu_cpu_diff( magma_z_matrix L, magma_z_matrix U, magma_z_matrix R )
+{
+    double res = 0, nrm = 0;
+    for( magma_int_t i=0; i < L.num_rows; i++ ){
+        for( magma_int_t p=L.row[i]; p < L.row[i+1]; p++ ){
+            magma_index_t j = L.col[p];
+            magmaDoubleComplex r = (j == i ? MAGMA_Z_ONE : zparilu_cpu_entry( R, i, j ));
+            res += MAGMA_Z_ABS( L.val[p] - r );
+            nrm += MAGMA_Z_ABS( r );
+        }
+    }
+    for( magma_int_t j=0; j < U.num_rows; j++ ){
+        for( magma_int_t p=U.row[j]; p < U.row[j+1]; p++ ){
+            magmaDoubleComplex r = zparilu_cpu_entry( R, U.col[p], j );
+            res += MAGMA_Z_ABS( U.val[p] - r );
+            nrm += MAGMA_Z_ABS( r );
+        }
+    }
+    return (nrm > 0 ? res / nrm : res);
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing of the CPU ParILU sweeps of magma_zparilu_cpu.
+      For each matrix A, does asynchronous sweeps (magma_zparilu_sweep_res)
+      and colored sweeps with blocks of about pbsize nonzeros
+      (magma_zparilu_sweep_colored) until the residual converged, and
+      compares the factors to a sequential ILU(0).
+      Usage: testing_zparilu_cpu [ --pbsize k ] [ --psweeps k ] matrices
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hAT={Magma_CSR}, hACOO={Magma_CSR}, hR={Magma_CSR};
+    magma_z_matrix hAL={Magma_CSR}, hAU={Magma_CSR};
+    magma_index_t *block_row = NULL, *block_order = NULL, *color_ptr = NULL;
+    magma_int_t ncolors, nsweeps, bsize = 256, maxsweeps = 200;
+    real_Double_t start, sweeptime;
+    double nrmA, res, diff, eps = lapackf77_dlamch( "E" ), tol = 1000 * eps;
+    int status = 0;
+
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--pbsize", argv[i]) == 0 && i+1 < argc ) {
+            bsize = max( 1, atoi( argv[++i] ));
+        } else if ( strcmp("--psweeps", argv[i]) == 0 && i+1 < argc ) {
+            maxsweeps = max( 1, atoi( argv[++i] ));
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zparilu_cpu [ --pbsize %lld ] [ --psweeps %lld ] matrices\n\n",
+            (long long) bsize, (long long) maxsweeps );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+        printf( "%%  sweeps    bsize   colors   sweeps done   time (ms)     residual   error vs ILU(0)   check\n" );
+        printf( "%%==========================================================================================\n" );
+
+        ref_zilu0( hA, &hR, queue );
+        TESTING_CHECK( magma_zmconvert( hA, &hACOO, Magma_CSR, Magma_CSRCOO, queue ));
+        nrmA = 0;
+        for( magma_int_t k=0; k < hACOO.nnz; k++ ){
+            nrmA += MAGMA_Z_ABS( hACOO.val[k] ) * MAGMA_Z_ABS( hACOO.val[k] );
+        }
+        nrmA = (nrmA > 0 ? sqrt( nrmA ) : 1);
+
+        // c = 0: asynchronous sweeps; c = 1: colored sweeps
+        for( int c=0; c < 2; c++ ){
+            // initial guess as in magma_zparilu_cpu: L and U from A, unit diagonal of L
+            TESTING_CHECK( magma_zmatrix_tril( hA, &hAL, queue ));
+            for( magma_int_t k=0; k < hAL.num_rows; k++ ){
+                hAL.val[ hAL.row[k+1]-1 ] = MAGMA_Z_ONE;
+            }
+            TESTING_CHECK( magma_zmtranspose( hA, &hAT, queue ));
+            TESTING_CHECK( magma_zmatrix_tril( hAT, &hAU, queue ));
+            magma_zmfree( &hAT, queue );
+
+            ncolors = 0;
+            if ( c == 1 ) {
+                magma_int_t info = magma_zparilu_colors( hACOO, bsize,
+                    &block_row, &block_order, &color_ptr, &ncolors, queue );
+                if ( info == MAGMA_ERR_NOT_SUPPORTED ) {
+                    printf( "  colored  %7lld   more than 64 colors, skipped\n", (long long) bsize );
+                    magma_zmfree( &hAL, queue );
+                    magma_zmfree( &hAU, queue );
+                    continue;
+                }
+                TESTING_CHECK( info );
+            }
+
+            res = 1;
+            sweeptime = 0;
+            for( nsweeps = 0; nsweeps < maxsweeps && res >= 10 * eps; nsweeps++ ){
+                start = magma_wtime();
+                if ( c == 1 ) {
+                    TESTING_CHECK( magma_zparilu_sweep_colored( hACOO, &hAL, &hAU,
+                        block_row, block_order, color_ptr, ncolors, &res, queue ));
+                }
+                else {
+                    TESTING_CHECK( magma_zparilu_sweep_res( hACOO, &hAL, &hAU, &res, queue ));
+                }
+                sweeptime += magma_wtime() - start;
+                res = res / nrmA;
+            }
+
+            diff = zparilu_cpu_diff( hAL, hAU, hR );
+            status += ! (diff < tol);
+            printf( "  %-7s  %7lld   %6lld   %11lld   %9.3f   %10.2e   %15.2e   %s\n",
+                    (c == 1 ? "colored" : "async"), (long long) (c == 1 ? bsize : 0),
+                    (long long) ncolors, (long long) nsweeps, sweeptime*1e3,
+                    res, diff, (diff < tol ? "ok" : "failed") );
+
+            magma_zmfree( &hAL, queue );
+            magma_zmfree( &hAU, queue );
+            magma_free_cpu( block_row );
+            magma_free_cpu( block_order );
+            magma_free_cpu( color_ptr );
+            block_row = block_order = color_ptr = NULL;
+        }
+        fflush( stdout );
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hACOO, queue );
+        magma_zmfree( &hR, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -33,6 +33,7 @@ void makeRandomArray(magmaDoubleComplex* a, int size) {
 
 /* ////////////////////////////////////////////////////////////////////////////
    -- testing for the magma_zselect magma_zselectrandom magma_zselectsort functions
+      and the CPU sample-select magma_zsampleselect_cpu
 */
 int main(  int argc, char** argv )
 {
@@ -43,7 +44,11 @@ int main(  int argc, char** argv )
     magma_queue_t queue=NULL;
     magma_queue_create( 0, &queue );
     // using std::swap;
-    real_Double_t start, end, t_select, t_selectrandom, t_selectbitonic;
+    real_Double_t start, end, t_select, t_selectrandom, t_selectbitonic,
+        t_sampleselect, t_sampleselect_approx;
+    double thrs, thrs_approx;
+    magma_ptr tmp_ptr = NULL;
+    size_t tmp_size = 0;
     
     int size = atoi(argv[1]);
     int selectset = atoi(argv[2]);
@@ -89,6 +94,24 @@ int main(  int argc, char** argv )
         printf(" Inconsistent result.\n");
     }
     
+    // the sample-select leaves a unchanged
+    start = magma_sync_wtime( queue );
+    TESTING_CHECK( magma_zsampleselect_cpu( size, selectset, 0, a, &thrs,
+                                            &tmp_ptr, &tmp_size, queue ));
+    end = magma_sync_wtime( queue );
+    t_sampleselect = end-start;
+    printf("\n selected by sample-select: %.2f\n\n", thrs );
+    // the sample-select keys are MAGMA_Z_ABS, so thrs matches exactly
+    if (!(thrs == MAGMA_Z_ABS(selectRandomResult)) ){
+        printf(" Inconsistent result.\n");
+    }
+    start = magma_sync_wtime( queue );
+    TESTING_CHECK( magma_zsampleselect_approx_cpu( size, selectset, 0, a, &thrs_approx,
+                                                   &tmp_ptr, &tmp_size, queue ));
+    end = magma_sync_wtime( queue );
+    t_sampleselect_approx = end-start;
+    printf("\n selected by approximate sample-select: %.2f\n\n", thrs_approx );
+    
     makeRandomArray(a, size);
     start = magma_sync_wtime( queue );
     magma_int_t flag =0;
@@ -117,8 +140,11 @@ int main(  int argc, char** argv )
     printf(" Select time (ms): %.4f\n", double(t_select)*1000 );
     printf(" Randomized select time (ms): %.4f\n", double(t_selectrandom)*1000 );
     printf(" Bitonicsort time (ms): %.4f\n", double(t_selectbitonic)*1000 );
+    printf(" Sample-select time (ms): %.4f\n", double(t_sampleselect)*1000 );
+    printf(" Approximate sample-select time (ms): %.4f\n", double(t_sampleselect_approx)*1000 );
 
     // magma_free_cpu( &a );
+    magma_free_cpu( tmp_ptr );
     
     magma_queue_destroy( queue );
     magma_finalize();
@@ -80,14 +80,16 @@ int main(  int argc, char** argv )
         printf("%%============================================================================%%\n");
         printf("];\n");
 
-        TESTING_CHECK( magma_zmtransfer( B, &dB, Magma_CPU, Magma_DEV, queue ));
+        // with --compute CPU, the system stays on the CPU
+        magma_location_t location = ( zopts.compute_location == Magma_CPU ? Magma_CPU : Magma_DEV );
+        TESTING_CHECK( magma_zmtransfer( B, &dB, Magma_CPU, location, queue ));
 
         // vectors and initial guess
-        TESTING_CHECK( magma_zvinit_rand( &b, Magma_DEV, A.num_rows, 1, queue ));
+        TESTING_CHECK( magma_zvinit_rand( &b, location, A.num_rows, 1, queue ));
         //magma_zvinit( &x, Magma_DEV, A.num_cols, 1, one, queue );
         //magma_z_spmv( one, dB, x, zero, b, queue );                 //  b = A x
         //magma_zmfree(&x, queue );
-        TESTING_CHECK( magma_zvinit_rand( &x, Magma_DEV, A.num_cols, 1, queue ));
+        TESTING_CHECK( magma_zvinit_rand( &x, location, A.num_cols, 1, queue ));
         
         info = magma_z_solver( dB, b, &x, &zopts, queue );
         if( info != 0 ) {
@@ -0,0 +1,231 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// largest size for which the reference quicksort is run on sorted or
+// reversed input, where it degenerates to O(n^2) with recursion depth n
+#define REF_MAX_DEGENERATE 20000
+
+
+// reference: recursive quicksort formerly used by magma_zindexsort
+static void
+ref_indexsort( magma_index_t *x, magma_int_t first, magma_int_t last )
+{
+    magma_index_t temp, pivot, j, i;
+    if ( first < last ) {
+        pivot = first;
+        i = first;
+        j = last;
+        while ( i < j ) {
+            while ( x[i] <= x[pivot] && i < last )
+                i++;
+            while ( x[j] > x[pivot] )
+                j--;
+            if ( i < j ) {
+                temp = x[i]; x[i] = x[j]; x[j] = temp;
+            }
+        }
+        temp = x[pivot]; x[pivot] = x[j]; x[j] = temp;
+        ref_indexsort( x, first, j-1 );
+        ref_indexsort( x, j+1, last );
+    }
+}
+
+
+// reference: recursive quicksort formerly used by magma_zsort
+static void
+ref_sort( magmaDoubleComplex *x, magma_int_t first, magma_int_t last )
+{
+    magmaDoubleComplex temp;
+    magma_index_t pivot, j, i;
+    if ( first < last ) {
+        pivot = first;
+        i = first;
+        j = last;
+        while ( i < j ) {
+            while ( MAGMA_Z_ABS(x[i]) <= MAGMA_Z_ABS(x[pivot]) && i < last )
+                i++;
+            while ( MAGMA_Z_ABS(x[j]) > MAGMA_Z_ABS(x[pivot]) )
+                j--;
+            if ( i < j ) {
+                temp = x[i]; x[i] = x[j]; x[j] = temp;
+            }
+        }
+        temp = x[pivot]; x[pivot] = x[j]; x[j] = temp;
+        ref_sort( x, first, j-1 );
+        ref_sort( x, j+1, last );
+    }
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- testing performance of magma_zsort and magma_zindexsort against the
+      former quicksort, for random, sorted, and reversed input.
+      Also checks magma_zmsort and magma_zindexsortval, which carry index
+      and value arrays along, and that all sorts are stable: entries with
+      equal keys keep their original order, tracked through the permuted
+      arrays.
+      Usage: testing_zsort_perf [n ...]
+*/
+int main(  int argc, char** argv )
+{
+    magma_int_t info = 0;
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    const char* input_name[] = { "random", "sorted", "reversed" };
+    magma_int_t sizes[32], nsize = 0;
+    for( int i = 1; i < argc && nsize < 32; i++ ) {
+        sizes[nsize++] = atoi( argv[i] );
+    }
+    if ( nsize == 0 ) {
+        for( magma_int_t n = 10000; n <= 10000000; n *= 10 ) {
+            sizes[nsize++] = n;
+        }
+    }
+
+    magma_index_t *x=NULL, *xref=NULL, *x0=NULL, *col=NULL, *row=NULL;
+    magmaDoubleComplex *y=NULL, *yref=NULL, *y0=NULL;
+    real_Double_t t_new, t_ref, t_msort, t_val;
+
+    printf("%%   input          n   index new (s)   index ref (s)   value new (s)   value ref (s)   msort (s)   indexval (s)   check\n");
+    printf("%%========================================================================================================================\n");
+    for( magma_int_t isize = 0; isize < nsize; isize++ ) {
+        magma_int_t n = sizes[isize];
+        TESTING_CHECK( magma_index_malloc_cpu( &x,    n ));
+        TESTING_CHECK( magma_index_malloc_cpu( &xref, n ));
+        TESTING_CHECK( magma_index_malloc_cpu( &x0,   n ));
+        TESTING_CHECK( magma_index_malloc_cpu( &col,  n ));
+        TESTING_CHECK( magma_index_malloc_cpu( &row,  n ));
+        TESTING_CHECK( magma_zmalloc_cpu( &y,    n ));
+        TESTING_CHECK( magma_zmalloc_cpu( &yref, n ));
+        TESTING_CHECK( magma_zmalloc_cpu( &y0,   n ));
+
+        for( int input = 0; input < 3; input++ ) {
+            // keys repeat for random input, and values k and -k have equal
+            // magnitude, so there are ties to check stability
+            for( magma_int_t i = 0; i < n; i++ ) {
+                magma_int_t k = (input == 0 ? rand() % n
+                              : (input == 1 ? i : n - 1 - i));
+                x[i] = xref[i] = x0[i] = k;
+                y[i] = yref[i] = y0[i] = MAGMA_Z_MAKE( (i % 3 == 0 ? -k : k), 0.5 );
+            }
+            bool run_ref = (input == 0 || n <= REF_MAX_DEGENERATE);
+
+            // index sort
+            t_new = magma_wtime();
+            TESTING_CHECK( magma_zindexsort( x, 0, n-1, queue ));
+            t_new = magma_wtime() - t_new;
+            t_ref = 0;
+            if ( run_ref ) {
+                t_ref = magma_wtime();
+                ref_indexsort( xref, 0, n-1 );
+                t_ref = magma_wtime() - t_ref;
+            }
+            magma_int_t nerror = 0;
+            for( magma_int_t i = 0; i < n; i++ ) {
+                if ( (i > 0 && x[i-1] > x[i]) || (run_ref && x[i] != xref[i]) )
+                    nerror++;
+            }
+            printf( " %8s %10lld   %13.4f   ", input_name[input], (long long) n, t_new );
+            if ( run_ref )
+                printf( "%13.4f   ", t_ref );
+            else
+                printf( "%13s   ", "---" );
+
+            // value sort
+            t_new = magma_wtime();
+            TESTING_CHECK( magma_zsort( y, 0, n-1, queue ));
+            t_new = magma_wtime() - t_new;
+            if ( run_ref ) {
+                t_ref = magma_wtime();
+                ref_sort( yref, 0, n-1 );
+                t_ref = magma_wtime() - t_ref;
+            }
+            for( magma_int_t i = 1; i < n; i++ ) {
+                if ( MAGMA_Z_ABS( y[i-1] ) > MAGMA_Z_ABS( y[i] ))
+                    nerror++;
+            }
+            printf( "%13.4f   ", t_new );
+            if ( run_ref )
+                printf( "%13.4f   ", t_ref );
+            else
+                printf( "%13s   ", "---" );
+
+            // value sort carrying col and row: col holds the original
+            // position, so each entry must be y0[col[i]], and ties must have
+            // increasing col
+            for( magma_int_t i = 0; i < n; i++ ) {
+                y[i]   = y0[i];
+                col[i] = i;
+                row[i] = n - 1 - i;
+            }
+            t_msort = magma_wtime();
+            TESTING_CHECK( magma_zmsort( y, col, row, 0, n-1, queue ));
+            t_msort = magma_wtime() - t_msort;
+            for( magma_int_t i = 0; i < n; i++ ) {
+                if ( ! MAGMA_Z_EQUAL( y[i], y0[ col[i] ] ) || row[i] != n - 1 - col[i] )
+                    nerror++;
+                if ( i > 0 && ( MAGMA_Z_ABS( y[i-1] ) > MAGMA_Z_ABS( y[i] )
+                                || ( MAGMA_Z_ABS( y[i-1] ) == MAGMA_Z_ABS( y[i] )
+                                     && col[i-1] > col[i] )))
+                    nerror++;
+            }
+
+            // index sort carrying values: the real part of y holds the
+            // original position, and ties must have increasing positions
+            for( magma_int_t i = 0; i < n; i++ ) {
+                x[i] = x0[i];
+                y[i] = MAGMA_Z_MAKE( i, 0 );
+            }
+            t_val = magma_wtime();
+            TESTING_CHECK( magma_zindexsortval( x, y, 0, n-1, queue ));
+            t_val = magma_wtime() - t_val;
+            for( magma_int_t i = 0; i < n; i++ ) {
+                magma_int_t pos = magma_int_t( MAGMA_Z_REAL( y[i] ));
+                if ( x[i] != x0[pos] )
+                    nerror++;
+                if ( i > 0 && ( x[i-1] > x[i]
+                                || ( x[i-1] == x[i] && MAGMA_Z_REAL( y[i-1] ) > MAGMA_Z_REAL( y[i] ))))
+                    nerror++;
+            }
+            printf( "%9.4f   %12.4f   %s\n", t_msort, t_val, (nerror == 0 ? "ok" : "failed") );
+            info += (nerror != 0);
+            fflush( stdout );
+        }
+        magma_free_cpu( x );
+        magma_free_cpu( xref );
+        magma_free_cpu( x0 );
+        magma_free_cpu( col );
+        magma_free_cpu( row );
+        magma_free_cpu( y );
+        magma_free_cpu( yref );
+        magma_free_cpu( y0 );
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return info;
+}
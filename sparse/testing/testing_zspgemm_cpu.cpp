@@ -0,0 +1,262 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// reference: sequential product C = A*B with a dense accumulator,
+// columns sorted in each row
+static void
+ref_zspgemm( magma_z_matrix A, magma_z_matrix B, magma_z_matrix *C )
+{
+    magmaDoubleComplex *acc = NULL;
+    magma_index_t *mark = NULL;
+    magma_int_t nnz = 0;
+
+    C->storage_type = Magma_CSR;
+    C->memory_location = Magma_CPU;
+    C->ownership = MagmaTrue;
+    C->num_rows = A.num_rows;
+    C->num_cols = B.num_cols;
+    TESTING_CHECK( magma_zmalloc_cpu( &acc, B.num_cols ));
+    TESTING_CHECK( magma_index_malloc_cpu( &mark, B.num_cols ));
+    TESTING_CHECK( magma_index_malloc_cpu( &C->row, A.num_rows+1 ));
+    for( magma_int_t c=0; c < B.num_cols; c++ ){
+        mark[c] = -1;
+    }
+    // count, then fill
+    for( magma_int_t i=0; i < A.num_rows; i++ ){
+        C->row[i] = nnz;
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+            for( magma_int_t l=B.row[ A.col[j] ]; l < B.row[ A.col[j]+1 ]; l++ ){
+                if ( mark[ B.col[l] ] != i ) {
+                    mark[ B.col[l] ] = i;
+                    nnz++;
+                }
+            }
+        }
+    }
+    C->row[ A.num_rows ] = nnz;
+    C->nnz = nnz;
+    TESTING_CHECK( magma_index_malloc_cpu( &C->col, nnz ));
+    TESTING_CHECK( magma_zmalloc_cpu( &C->val, nnz ));
+    for( magma_int_t c=0; c < B.num_cols; c++ ){
+        mark[c] = -1;
+        acc[c] = MAGMA_Z_ZERO;
+    }
+    for( magma_int_t i=0; i < A.num_rows; i++ ){
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+            for( magma_int_t l=B.row[ A.col[j] ]; l < B.row[ A.col[j]+1 ]; l++ ){
+                mark[ B.col[l] ] = i;
+                acc[ B.col[l] ] += A.val[j] * B.val[l];
+            }
+        }
+        magma_int_t p = C->row[i];
+        for( magma_int_t c=0; c < B.num_cols && p < C->row[i+1]; c++ ){
+            if ( mark[c] == i ) {
+                C->col[p] = c;
+                C->val[p] = acc[c];
+                acc[c] = MAGMA_Z_ZERO;
+                p++;
+            }
+        }
+    }
+    magma_free_cpu( acc );
+    magma_free_cpu( mark );
+}
+
+
+// relative difference sum |C - R| / sum |R| on the pattern of C; R has
+// sorted columns. Entries of C missing in R count fully; if same is set,
+// the patterns must be equal.
+static double
+zspgemm_cpu_diff( magma_z_matrix C, magma_z_matrix R, bool same )
+{
+    double res = 0, nrm = 0;
+    if ( same && C.nnz != R.nnz ) {
+        return 1;
+    }
+    for( magma_int_t i=0; i < C.num_rows; i++ ){
+        if ( same && C.row[i+1] != R.row[i+1] ) {
+            return 1;
+        }
+        for( magma_int_t p=C.row[i]; p < C.row[i+1]; p++ ){
+            magma_int_t q = R.row[i];
+            while ( q < R.row[i+1] && R.col[q] < C.col[p] ) {
+                q++;
+            }
+            if ( q < R.row[i+1] && R.col[q] == C.col[p] ) {
+                res += MAGMA_Z_ABS( C.val[p] - R.val[q] );
+                nrm += MAGMA_Z_ABS( R.val[q] );
+            }
+            else if ( same ) {
+                return 1;
+            }
+            else {
+                res += MAGMA_Z_ABS( C.val[p] );
+            }
+        }
+    }
+    return (nrm > 0 ? res / nrm : res);
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing and benchmark of the CPU sparse matrix product magma_zspgemm_cpu.
+      For each matrix A, times
+        - A*A with a sequential dense-accumulator reference,
+        - A*A with magma_zspgemm_cpu, and its symbolic and numeric phases,
+          the numeric phase reusing the pattern,
+        - A^T*A with magma_zspgemm_cpu, checked against the reference on
+          the explicit transpose,
+        - A*A on the pattern of A, as for the ParILUT residual,
+        - the pattern-only union magma_zmatrix_cup( A, A^T ), for comparison.
+      Results are compared to the reference.
+      Usage: testing_zspgemm_cpu [ --niter k ] matrices
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hAt={Magma_CSR}, hC={Magma_CSR}, hR={Magma_CSR};
+    magma_z_matrix hM={Magma_CSR}, hU={Magma_CSR};
+    magma_int_t niter = 3;
+    real_Double_t start, reftime, cputime, symtime, numtime, atatime, masktime, cuptime;
+    double diff, tol = 100 * lapackf77_dlamch( "E" );
+    int status = 0;
+
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--niter", argv[i]) == 0 && i+1 < argc ) {
+            niter = max( 1, atoi( argv[++i] ));
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zspgemm_cpu [ --niter %lld ] matrices\n\n",
+            (long long) niter );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+        printf( "%%  product     nnz(C)   reference (ms)   spgemm (ms)   symbolic (ms)   numeric (ms)   speedup      error   check\n" );
+        printf( "%%=============================================================================================================\n" );
+
+        // A*A: reference, full product, and the two phases with pattern reuse
+        start = magma_sync_wtime( queue );
+        ref_zspgemm( hA, hA, &hR );
+        reftime = magma_sync_wtime( queue ) - start;
+
+        cputime = symtime = numtime = 1e30;
+        for( magma_int_t it=0; it < niter; it++ ){
+            magma_zmfree( &hC, queue );
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zspgemm_cpu( MagmaNoTrans, hA, hA, &hC, queue ));
+            cputime = min( cputime, magma_sync_wtime( queue ) - start );
+        }
+        diff = zspgemm_cpu_diff( hC, hR, true );
+        magma_zmfree( &hC, queue );
+        for( magma_int_t it=0; it < niter; it++ ){
+            magma_zmfree( &hC, queue );
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zspgemm_cpu_symbolic( MagmaNoTrans, hA, hA, &hC, queue ));
+            symtime = min( symtime, magma_sync_wtime( queue ) - start );
+        }
+        for( magma_int_t it=0; it < niter; it++ ){
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zspgemm_cpu_numeric( MagmaNoTrans, hA, hA, &hC, queue ));
+            numtime = min( numtime, magma_sync_wtime( queue ) - start );
+        }
+        diff = max( diff, zspgemm_cpu_diff( hC, hR, true ));
+        status += ! (diff < tol);
+        printf( "  A*A     %10lld   %14.3f   %11.3f   %13.3f   %12.3f   %7.2f   %8.2e   %s\n",
+                (long long) hC.nnz, reftime*1e3, cputime*1e3, symtime*1e3, numtime*1e3,
+                reftime / cputime, diff, (diff < tol ? "ok" : "failed") );
+
+        // A*A on the pattern of A: reference entries at the pattern of A
+        TESTING_CHECK( magma_zmtransfer( hA, &hM, Magma_CPU, Magma_CPU, queue ));
+        masktime = 1e30;
+        for( magma_int_t it=0; it < niter; it++ ){
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zspgemm_cpu_numeric( MagmaNoTrans, hA, hA, &hM, queue ));
+            masktime = min( masktime, magma_sync_wtime( queue ) - start );
+        }
+        diff = zspgemm_cpu_diff( hM, hR, false );
+        status += ! (diff < tol);
+        printf( "  A*A|A   %10lld   %14s   %11s   %13s   %12.3f   %7s   %8.2e   %s\n",
+                (long long) hM.nnz, "---", "---", "---", masktime*1e3, "---",
+                diff, (diff < tol ? "ok" : "failed") );
+        magma_zmfree( &hC, queue );
+        magma_zmfree( &hR, queue );
+        magma_zmfree( &hM, queue );
+
+        // A^T*A: reference on the explicit transpose
+        TESTING_CHECK( magma_zmtranspose_cpu( hA, &hAt, queue ));
+        start = magma_sync_wtime( queue );
+        ref_zspgemm( hAt, hA, &hR );
+        reftime = magma_sync_wtime( queue ) - start;
+        atatime = 1e30;
+        for( magma_int_t it=0; it < niter; it++ ){
+            magma_zmfree( &hC, queue );
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zspgemm_cpu( MagmaTrans, hA, hA, &hC, queue ));
+            atatime = min( atatime, magma_sync_wtime( queue ) - start );
+        }
+        diff = zspgemm_cpu_diff( hC, hR, true );
+        status += ! (diff < tol);
+        printf( "  A^T*A   %10lld   %14.3f   %11.3f   %13s   %12s   %7.2f   %8.2e   %s\n",
+                (long long) hC.nnz, reftime*1e3, atatime*1e3, "---", "---",
+                reftime / atatime, diff, (diff < tol ? "ok" : "failed") );
+
+        // pattern-only union of A and A^T
+        cuptime = 1e30;
+        for( magma_int_t it=0; it < niter; it++ ){
+            magma_zmfree( &hU, queue );
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zmatrix_cup( hA, hAt, &hU, queue ));
+            cuptime = min( cuptime, magma_sync_wtime( queue ) - start );
+        }
+        printf( "  A cup A^T %8lld   %14s   %11.3f   %13s   %12s   %7s   %8s   (pattern only)\n",
+                (long long) hU.nnz, "---", cuptime*1e3, "---", "---", "---", "---" );
+        fflush( stdout );
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hAt, queue );
+        magma_zmfree( &hC, queue );
+        magma_zmfree( &hR, queue );
+        magma_zmfree( &hU, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
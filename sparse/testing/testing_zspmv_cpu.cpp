@@ -0,0 +1,203 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// reference: sequential CSR product y = alpha*A*x + beta*y, for num_vecs
+// vectors with element (i,v) at x[ i*incx + v*ldx ]
+static void
+ref_zspmv_csr(
+    magmaDoubleComplex alpha, magma_z_matrix A, magma_int_t num_vecs,
+    const magmaDoubleComplex *x, magma_int_t incx, magma_int_t ldx,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y, magma_int_t incy, magma_int_t ldy )
+{
+    for( magma_int_t v=0; v < num_vecs; v++ ){
+        for( magma_int_t i=0; i < A.num_rows; i++ ){
+            magmaDoubleComplex sum = MAGMA_Z_ZERO;
+            for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ){
+                sum += A.val[j] * x[ A.col[j]*incx + v*ldx ];
+            }
+            y[ i*incy + v*ldy ] = alpha * sum + beta * y[ i*incy + v*ldy ];
+        }
+    }
+}
+
+
+// relative difference sum |y - yref| / sum |yref|
+static double
+zspmv_cpu_diff( magma_z_matrix y, const magmaDoubleComplex *yref )
+{
+    double res = 0, nrm = 0;
+    for( magma_int_t k=0; k < y.num_rows*y.num_cols; k++ ){
+        res += MAGMA_Z_ABS( y.val[k] - yref[k] );
+        nrm += MAGMA_Z_ABS( yref[k] );
+    }
+    return (nrm > 0 ? res / nrm : res);
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing and benchmark of the CPU sparse matrix-vector product,
+      magma_z_spmv on Magma_CPU objects, for CSR, ELL, SELL-P, and CSR5.
+      Also times the product with --nrhs vectors, in column-major and
+      row-major order. Results are compared to a sequential CSR product.
+      Usage: testing_zspmv_cpu [ --blocksize b --alignment a --nrhs k ] matrices
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hB={Magma_CSR};
+    magma_z_matrix hx={Magma_CSR}, hy={Magma_CSR};
+    magmaDoubleComplex *y0 = NULL, *yref = NULL;
+    magma_int_t blocksize = 32, alignment = 1, nrhs = 8;
+    real_Double_t start, end, reftime, cputime;
+    int status = 0;
+
+    magmaDoubleComplex c_one   = MAGMA_Z_MAKE(1.0, 0.0);
+    magmaDoubleComplex c_zero  = MAGMA_Z_MAKE(0.0, 0.0);
+    magmaDoubleComplex c_alpha = MAGMA_Z_MAKE(0.5, 0.0);
+    magmaDoubleComplex c_beta  = MAGMA_Z_MAKE(2.0, 0.0);
+
+    double accuracy = 1e-10;
+
+    #define PRECISION_z
+    #if defined(PRECISION_c)
+        accuracy = 1e-5;
+    #endif
+    #if defined(PRECISION_s)
+        accuracy = 1e-5;
+    #endif
+
+    const int nformats = 4;
+    magma_storage_t formats[ nformats ] = { Magma_CSR, Magma_ELL, Magma_SELLP, Magma_CSR5 };
+    const char* names[ nformats ] = { "CSR", "ELL", "SELLP", "CSR5" };
+    const int nrepeat = 100;
+
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--blocksize", argv[i]) == 0 && i+1 < argc ) {
+            blocksize = atoi( argv[++i] );
+        } else if ( strcmp("--alignment", argv[i]) == 0 && i+1 < argc ) {
+            alignment = atoi( argv[++i] );
+        } else if ( strcmp("--nrhs", argv[i]) == 0 && i+1 < argc ) {
+            nrhs = atoi( argv[++i] );
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zspmv_cpu"
+            " [ --blocksize %lld --alignment %lld (for SELLP) --nrhs %lld ] matrices\n\n",
+            (long long) blocksize, (long long) alignment, (long long) nrhs );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+        printf( "%% format  vectors  order   ref (GFLOP/s)   CPU (GFLOP/s)   speedup      error\n" );
+        printf( "%%==========================================================================\n" );
+
+        // single vector, then nrhs vectors in column-major and row-major order
+        for( int run = 0; run < 3; run++ ) {
+            magma_int_t nv = (run == 0 ? 1 : nrhs);
+            bool rowmajor = (run == 2);
+            if ( run > 0 && nrhs <= 1 ) {
+                break;
+            }
+            real_Double_t FLOPS = 2.0*hA.nnz*nv/1e9;
+            magma_int_t size_y = hA.num_rows*nv;
+            magma_int_t incx = (rowmajor ? nv : 1), ldx = (rowmajor ? 1 : hA.num_cols);
+            magma_int_t incy = (rowmajor ? nv : 1), ldy = (rowmajor ? 1 : hA.num_rows);
+
+            TESTING_CHECK( magma_zvinit_rand( &hx, Magma_CPU, hA.num_cols, nv, queue ));
+            TESTING_CHECK( magma_zvinit_rand( &hy, Magma_CPU, hA.num_rows, nv, queue ));
+            if ( rowmajor ) {
+                hx.major = MagmaRowMajor;
+                hy.major = MagmaRowMajor;
+            }
+            TESTING_CHECK( magma_zmalloc_cpu( &y0,   size_y ));
+            TESTING_CHECK( magma_zmalloc_cpu( &yref, size_y ));
+            memcpy( y0, hy.val, size_y*sizeof(magmaDoubleComplex) );
+
+            // sequential CSR reference
+            memcpy( yref, y0, size_y*sizeof(magmaDoubleComplex) );
+            start = magma_wtime();
+            for( int r=0; r < nrepeat; r++ ) {
+                ref_zspmv_csr( c_one, hA, nv, hx.val, incx, ldx, c_zero, yref, incy, ldy );
+            }
+            end = magma_wtime();
+            reftime = (end-start)/nrepeat;
+            memcpy( yref, y0, size_y*sizeof(magmaDoubleComplex) );
+            ref_zspmv_csr( c_alpha, hA, nv, hx.val, incx, ldx, c_beta, yref, incy, ldy );
+
+            for( int f=0; f < nformats; f++ ) {
+                hB.blocksize = blocksize;
+                hB.alignment = alignment;
+                TESTING_CHECK( magma_zmconvert( hA, &hB, Magma_CSR, formats[f], queue ));
+
+                start = magma_wtime();
+                for( int r=0; r < nrepeat; r++ ) {
+                    TESTING_CHECK( magma_z_spmv( c_one, hB, hx, c_zero, hy, queue ));
+                }
+                end = magma_wtime();
+                cputime = (end-start)/nrepeat;
+
+                // check y = alpha*A*x + beta*y
+                memcpy( hy.val, y0, size_y*sizeof(magmaDoubleComplex) );
+                TESTING_CHECK( magma_z_spmv( c_alpha, hB, hx, c_beta, hy, queue ));
+                double res = zspmv_cpu_diff( hy, yref );
+                bool okay = (res < accuracy);
+                status += ! okay;
+
+                printf( "%6s   %6lld   %5s   %13.2f   %13.2f   %7.2f   %8.2e   %s\n",
+                        names[f], (long long) nv, (rowmajor ? "row" : "col"),
+                        FLOPS/reftime, FLOPS/cputime, reftime/cputime, res,
+                        (okay ? "ok" : "failed") );
+                magma_zmfree( &hB, queue );
+            }
+
+            magma_zmfree( &hx, queue );
+            magma_zmfree( &hy, queue );
+            magma_free_cpu( y0 );
+            magma_free_cpu( yref );
+            fflush( stdout );
+        }
+
+        magma_zmfree( &hA, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -0,0 +1,128 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "testings.h"
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Benchmark of the symbolic ILU(k) factorization magma_zsymbolic_ilu.
+      For every level up to --levels, times the parallel factorization and
+      the sequential reference magma_zsymbolic_ilu_seq, and checks that
+      both give the same pattern of L and U. The reference gets the exact
+      fill of the parallel factorization as storage.
+      Usage: testing_zsymbilu [ --levels k ] matrices
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR};
+    magma_index_t *ial = NULL, *jal = NULL, *iau = NULL, *jau = NULL;
+    magma_index_t *ial2 = NULL, *jal2 = NULL, *iau2 = NULL, *jau2 = NULL;
+    magma_int_t levels = 3;
+    real_Double_t start, end, partime, seqtime;
+    int status = 0;
+
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--levels", argv[i]) == 0 && i+1 < argc ) {
+            levels = atoi( argv[++i] );
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zsymbilu [ --levels %lld ] matrices\n\n",
+            (long long) levels );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+        magma_int_t n = hA.num_rows;
+
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+
+        TESTING_CHECK( magma_index_malloc_cpu( &ial, n+1 ));
+        TESTING_CHECK( magma_index_malloc_cpu( &iau, n+1 ));
+        TESTING_CHECK( magma_index_malloc_cpu( &ial2, n+1 ));
+        TESTING_CHECK( magma_index_malloc_cpu( &iau2, n+1 ));
+
+        printf( "%%  levels   nnz(L)      nnz(U)      fill   parallel (ms)   sequential (ms)   check\n" );
+        printf( "%%=================================================================================\n" );
+        for( magma_int_t lev=0; lev <= levels; lev++ ) {
+            start = magma_wtime();
+            TESTING_CHECK( magma_zsymbolic_ilu( lev, n, hA.row, hA.col,
+                                                ial, &jal, iau, &jau, queue ));
+            end = magma_wtime();
+            partime = end-start;
+
+            magma_int_t nzl = ial[n], nzu = iau[n];
+            TESTING_CHECK( magma_index_malloc_cpu( &jal2, nzl ));
+            TESTING_CHECK( magma_index_malloc_cpu( &jau2, nzu ));
+            start = magma_wtime();
+            TESTING_CHECK( magma_zsymbolic_ilu_seq( lev, n, &nzl, &nzu, hA.row, hA.col,
+                                                    ial2, jal2, iau2, jau2 ));
+            end = magma_wtime();
+            seqtime = end-start;
+
+            bool okay = nzl == ial[n] && nzu == iau[n];
+            for( magma_int_t j=0; j <= n && okay; j++ ) {
+                okay = ial[j] == ial2[j] && iau[j] == iau2[j];
+            }
+            for( magma_int_t j=0; j < nzl && okay; j++ ) {
+                okay = jal[j] == jal2[j];
+            }
+            for( magma_int_t j=0; j < nzu && okay; j++ ) {
+                okay = jau[j] == jau2[j];
+            }
+            status += ! okay;
+
+            printf( "%8lld   %9lld   %9lld   %5.2f   %13.3f   %15.3f   %s\n",
+                    (long long) lev, (long long) ial[n], (long long) iau[n],
+                    (double) (ial[n] + iau[n]) / hA.nnz,
+                    partime*1e3, seqtime*1e3, (okay ? "ok" : "failed") );
+            fflush( stdout );
+
+            magma_free_cpu( jal );
+            magma_free_cpu( jau );
+            magma_free_cpu( jal2 );
+            magma_free_cpu( jau2 );
+            jal = jau = jal2 = jau2 = NULL;
+        }
+
+        magma_free_cpu( ial );
+        magma_free_cpu( iau );
+        magma_free_cpu( ial2 );
+        magma_free_cpu( iau2 );
+        magma_zmfree( &hA, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
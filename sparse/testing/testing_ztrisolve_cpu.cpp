@@ -0,0 +1,194 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// reference: sequential substitution with the lower (or upper) triangle
+// of A in CSR, rows in increasing (or decreasing) order
+static void
+ref_ztrisolve( magma_z_matrix A, bool lower, bool unit,
+               const magmaDoubleComplex *b, magmaDoubleComplex *x )
+{
+    magma_int_t n = A.num_rows;
+    for( magma_int_t t=0; t < n; t++ ){
+        magma_int_t i = (lower ? t : n-1-t);
+        magmaDoubleComplex s = b[i], d = MAGMA_Z_ZERO;
+        for( magma_int_t k=A.row[i]; k < A.row[i+1]; k++ ){
+            magma_index_t j = A.col[k];
+            if ( lower ? j < i : j > i ) {
+                s -= A.val[k] * x[j];
+            }
+            else if ( j == i ) {
+                d += A.val[k];
+            }
+        }
+        x[i] = (unit ? s : s / d);
+    }
+}
+
+
+// frees the level schedule of magma_ztrisolve_analysis_cpu
+static void
+ztrisolve_cpu_free( magma_solve_info_t *solve_info )
+{
+    magma_solve_levels_t *L = &solve_info->levels;
+    magma_free_cpu( L->level_ptr );
+    magma_free_cpu( L->perm );
+    magma_free_cpu( L->row );
+    magma_free_cpu( L->col );
+    magma_free_cpu( L->val );
+    magma_free_cpu( L->diag );
+    *L = magma_solve_levels_t();
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing and benchmark of the CPU triangular solve magma_ztrisolve_cpu,
+      the path of magma_ztrisolve for matrices on the CPU.
+      For each matrix A, solves with its lower and upper triangle, with unit
+      and non-unit diagonal, and with the transpose, comparing to a sequential
+      substitution (on the explicit transpose for the transposed solves),
+      and checks the in-place solve, with x the same as b.
+      Prints the number of levels of the schedule, and the times of the
+      analysis, the level-scheduled solve, and the reference.
+      LAPLACE3D n gives the 27-point stencil on an n^3 grid, whose large
+      levels are split among the threads.
+      Usage: testing_ztrisolve_cpu [ --niter k ] [ --nrhs k ] matrices
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hAt={Magma_CSR}, hb={Magma_CSR}, hx={Magma_CSR};
+    magmaDoubleComplex *xref = NULL;
+    magma_solve_info_t solve_info{};
+    magma_int_t niter = 3, nrhs = 1;
+    real_Double_t start, reftime, anatime, cputime;
+    double diff, diff_inplace, nrm, tol = 1000 * lapackf77_dlamch( "E" );
+    int status = 0;
+    magma_int_t ione = 1;
+
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--niter", argv[i]) == 0 && i+1 < argc ) {
+            niter = max( 1, atoi( argv[++i] ));
+        } else if ( strcmp("--nrhs", argv[i]) == 0 && i+1 < argc ) {
+            nrhs = max( 1, atoi( argv[++i] ));
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_ztrisolve_cpu [ --niter %lld ] [ --nrhs %lld ] matrices\n\n",
+            (long long) niter, (long long) nrhs );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else if ( strcmp("LAPLACE3D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_27stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+        printf( "%% triangle  diag    op   levels   analysis (ms)   reference (ms)   trisolve (ms)   speedup      error   in-place   check\n" );
+        printf( "%%=========================================================================================================================\n" );
+
+        TESTING_CHECK( magma_zmtranspose_cpu( hA, &hAt, queue ));
+        TESTING_CHECK( magma_zvinit_rand( &hb, Magma_CPU, hA.num_rows, nrhs, queue ));
+        TESTING_CHECK( magma_zvinit( &hx, Magma_CPU, hA.num_rows, nrhs, MAGMA_Z_ZERO, queue ));
+        TESTING_CHECK( magma_zmalloc_cpu( &xref, hA.num_rows*nrhs ));
+
+        for( int c=0; c < 8; c++ ){
+            bool upper = (c & 1), unit = (c & 2), transpose = (c & 4);
+
+            anatime = 1e30;
+            for( magma_int_t it=0; it < niter; it++ ){
+                start = magma_wtime();
+                TESTING_CHECK( magma_ztrisolve_analysis_cpu( hA, &solve_info, upper, unit, transpose, queue ));
+                anatime = min( anatime, magma_wtime() - start );
+            }
+
+            // the transposed solve on A is a solve with the other triangle of A^T
+            reftime = 1e30;
+            for( magma_int_t it=0; it < niter; it++ ){
+                start = magma_wtime();
+                for( magma_int_t v=0; v < nrhs; v++ ){
+                    ref_ztrisolve( (transpose ? hAt : hA), (upper == transpose), unit,
+                                   hb.val + v*hA.num_rows, xref + v*hA.num_rows );
+                }
+                reftime = min( reftime, magma_wtime() - start );
+            }
+
+            cputime = 1e30;
+            for( magma_int_t it=0; it < niter; it++ ){
+                start = magma_wtime();
+                TESTING_CHECK( magma_ztrisolve_cpu( hA, solve_info, upper, unit, transpose, hb, hx, queue ));
+                cputime = min( cputime, magma_wtime() - start );
+            }
+
+            diff = nrm = 0;
+            for( magma_int_t r=0; r < hA.num_rows*nrhs; r++ ){
+                diff += MAGMA_Z_ABS( hx.val[r] - xref[r] );
+                nrm  += MAGMA_Z_ABS( xref[r] );
+            }
+            diff = (nrm > 0 ? diff / nrm : diff);
+
+            // in-place solve, x = b
+            blasf77_zcopy( &hx.nnz, hb.val, &ione, hx.val, &ione );
+            TESTING_CHECK( magma_ztrisolve_cpu( hA, solve_info, upper, unit, transpose, hx, hx, queue ));
+            diff_inplace = 0;
+            for( magma_int_t r=0; r < hA.num_rows*nrhs; r++ ){
+                diff_inplace += MAGMA_Z_ABS( hx.val[r] - xref[r] );
+            }
+            diff_inplace = (nrm > 0 ? diff_inplace / nrm : diff_inplace);
+
+            bool okay = (diff < tol && diff_inplace < tol);
+            status += ! okay;
+            printf( "  %-7s  %-6s  %4s   %6lld   %13.3f   %14.3f   %13.3f   %7.2f   %8.2e   %8.2e   %s\n",
+                    (upper ? "upper" : "lower"), (unit ? "unit" : "nonunit"),
+                    (transpose ? "T" : "N"), (long long) solve_info.levels.num_levels,
+                    anatime*1e3, reftime*1e3, cputime*1e3, reftime / cputime,
+                    diff, diff_inplace, (okay ? "ok" : "failed") );
+            ztrisolve_cpu_free( &solve_info );
+        }
+        fflush( stdout );
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hAt, queue );
+        magma_zmfree( &hb, queue );
+        magma_zmfree( &hx, queue );
+        magma_free_cpu( xref );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
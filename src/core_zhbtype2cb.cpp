@@ -11,6 +11,7 @@
 
 */
 #include "magma_internal.h"
+#include "magma_simd.hpp"
 
 
 #define A(m,n)   (A + lda * (n) + ((m)-(n)))
@@ -128,6 +129,61 @@ magma_zhbtype2cb(magma_int_t n, magma_int_t nb,
     len = ed-st+1;
     lem = J2-J1+1;
 
+#ifdef MAGMA_SIMD
+    if ( lem <= 0 )
+        return;
+
+    /* With vector FMA, the right update from the top block, the elimination
+     * of the first column of the created bulge, and the left update are
+     * fused: after work = A(J1:J2,st:ed)*V, each column gets its right
+     * update and, while it is in cache, the left update by the new reflector. */
+    magmaDoubleComplex tau = *TAU(taupos), ctau2, *Aj;
+    magma_int_t upos, tau2pos;
+
+    memset( work, 0, lem*sizeof(magmaDoubleComplex) );
+    magma_simd_gemv( lem, len, A(J1, st), ldx, V(vpos), work );
+
+    /* Apply remaining right commming from the top block to col st */
+    magma_simd_axpy( lem, -tau * conj( *V(vpos) ), work, A(J1, st) );
+
+    if ( lem > 1 ) {
+        if ( wantz == 0 ) {
+            upos    = (sweep%2)*n + J1;
+            tau2pos = (sweep%2)*n + J1;
+        } else {
+            magma_bulge_findVTAUpos(n, nb, Vblksiz, sweep, J1, ldv, &upos, &tau2pos);
+            //findVTpos(n,nb,Vblksiz,sweep,J1, &upos, &tau2pos, &tpos, &blkid);
+        }
+
+        /* Remove the first column of the created bulge */
+        *V(upos)  = c_one;
+        
+        //magma_int_t lem2=lem-1;
+        //blasf77_zcopy( &lem2, A(ed+2, st), &ione, V(upos+1), &ione );
+        memcpy(V(upos+1), A(J1+1, st), (lem-1)*sizeof(magmaDoubleComplex));
+        memset(A(J1+1, st), 0, (lem-1)*sizeof(magmaDoubleComplex));
+
+        /* Eliminate the col at st */
+        lapackf77_zlarfg( &lem, A(J1, st), V(upos+1), &ione, TAU(tau2pos) );
+
+        /*
+         * Apply right, then left on A(J1:J2,st+1:ed)
+         * col st is the col that has been revomved;
+         */
+        ctau2 = conj( *TAU(tau2pos) );
+        for (magma_int_t j = 1; j < len; j++) {
+            Aj   = A(J1, st+j);
+            ctmp = magma_simd_axpy_dotc( lem, -tau * conj( *V(vpos+j) ), work, Aj, V(upos) );
+            magma_simd_axpy( lem, -ctau2 * ctmp, V(upos), Aj );
+        }
+    }
+    else {
+        /* Apply remaining right commming from the top block */
+        for (magma_int_t j = 1; j < len; j++) {
+            magma_simd_axpy( lem, -tau * conj( *V(vpos+j) ), work, A(J1, st+j) );
+        }
+    }
+#else
     if ( lem > 0 ) {
         /* Apply remaining right commming from the top block */
         lapackf77_zlarfx("R", &lem, &len, V(vpos), TAU(taupos), A(J1, st), &ldx, work);
@@ -162,6 +218,7 @@ magma_zhbtype2cb(magma_int_t n, magma_int_t nb,
         ctmp = MAGMA_Z_CONJ(*TAU(taupos));
         lapackf77_zlarfx("L", &lem, &len, V(vpos),  &ctmp, A(J1, st+1), &ldx, work);
     }
+#endif
 }
 
 #undef A
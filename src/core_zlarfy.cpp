@@ -11,6 +11,7 @@
 */
 #include "magma_internal.h"
 #include "magma_bulge.h"
+#include "magma_simd.hpp"
 
 /***************************************************************************//**
  *
@@ -61,6 +62,43 @@ magma_zlarfy(
     work (workspace) double complex array, dimension n
     */
 
+#ifdef MAGMA_SIMD
+    const magmaDoubleComplex c_half   =  MAGMA_Z_HALF;
+    const magmaDoubleComplex tau      = *TAU;
+    magmaDoubleComplex dtmp, vj, wj, *Aj;
+
+    /* With vector FMA, the zhemv, zdotc, zaxpy, zher2 sequence is fused into
+     * two passes over the lower triangle, each reading a column once.
+     * The tile is at most nb-by-nb, too small to amortize BLAS calls. */
+
+    /* X = AVtau, reading the lower triangle column by column */
+    memset( work, 0, n*sizeof(magmaDoubleComplex) );
+    for (magma_int_t j = 0; j < n; j++) {
+        Aj = A + j*lda;
+        vj = tau * V[j];
+        work[j] += MAGMA_Z_REAL( Aj[j] ) * vj;
+        work[j] += tau * magma_simd_hemv_col( n-j-1, vj, Aj+j+1, V+j+1, work+j+1 );
+    }
+
+    /* compute dtmp= X'*V */
+    dtmp = magma_simd_dotc( n, work, V );
+
+    /* compute 1/2 X'*V*t = 1/2*dtmp*tau  */
+    dtmp = -dtmp * c_half * tau;
+
+    /* compute W=X-1/2VX'Vt = X - dtmp*V */
+    magma_simd_axpy( n, dtmp, V, work );
+
+    /* performs the Hermitian rank 2 operation A := A - W*V' - V*W';
+     * the diagonal stays real */
+    for (magma_int_t j = 0; j < n; j++) {
+        Aj = A + j*lda;
+        vj = V[j];
+        wj = work[j];
+        Aj[j] = MAGMA_Z_MAKE( MAGMA_Z_REAL( Aj[j] ) - 2*MAGMA_Z_REAL( wj * conj( vj )), 0. );
+        magma_simd_axpy2( n-j-1, -conj( vj ), work+j+1, -conj( wj ), V+j+1, Aj+j+1 );
+    }
+#else
     const magma_int_t ione = 1;
     const magmaDoubleComplex c_zero   =  MAGMA_Z_ZERO;
     const magmaDoubleComplex c_neg_one=  MAGMA_Z_NEG_ONE;
@@ -86,4 +124,5 @@ magma_zlarfy(
 
     /* performs the symmetric rank 2 operation A := alpha*x*y' + alpha*y*x' + A */
     blasf77_zher2("L", &n, &c_neg_one, work, &ione, V, &ione, A, &lda);
+#endif
 }
@@ -16,6 +16,7 @@
 
 #include "magma_internal.h"
 #include "magma_timer.h"
+#include "trace.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,6 +24,9 @@ extern "C" {
 
 magma_int_t magma_get_dlaed3_k() { return 512; }
 
+// number of roots in a chunk of the dynamically scheduled secular equation
+magma_int_t magma_get_dlaed3_nroot() { return 32; }
+
 void magma_dvrange(
     magma_int_t k, double *d, magma_int_t *il, magma_int_t *iu, double vl, double vu)
 {
@@ -244,7 +248,7 @@ magma_dlaex3(
     magmaDouble_ptr dS  = dQ2  + n*lddq;
     magmaDouble_ptr dQ  = dS   + n*lddq;
 
-    magma_int_t i, iq2, j, n12, n2, n23, tmp, lq2;
+    magma_int_t i, iq2, j, n12, n2, n23, lq2;
     double temp;
     magma_int_t alleig, valeig, indeig;
 
@@ -319,34 +323,67 @@ magma_dlaex3(
     //magma_timer_t time = 0;
     //timer_start( time );
 
-    #pragma omp parallel private(i, j, tmp, temp)
+    // Roots are found in chunks of magma_get_dlaed3_nroot() columns, taken
+    // dynamically, as the number of dlaed4 iterations varies a lot between
+    // roots. Right after its roots are found, each chunk multiplies its
+    // columns into its own partial product of the updated W, while they are
+    // in cache, instead of a separate pass over Q after all roots are found.
+    // The partial products are reduced in chunk order, so the result does
+    // not depend on the number of threads.
+    // S holds the signs of W, the partial products, then one eigenvector
+    // per thread; hence at most N1 chunks and N1 threads.
+    magma_int_t nchunk  = min( n1, magma_ceildiv( k, magma_get_dlaed3_nroot() ));
+    magma_int_t nthread = min( n1, omp_get_max_threads() );
+
+    #pragma omp parallel num_threads(nthread) private(i, j, temp)
     {
-        magma_int_t tid     = omp_get_thread_num();
-        magma_int_t nthread = omp_get_num_threads();
-
-        magma_int_t ibegin = ( tid    * k) / nthread; // start index of local loop
-        magma_int_t iend   = ((tid+1) * k) / nthread; // end   index of local loop
-        magma_int_t ik     = iend - ibegin;           // number of local indices
+        magma_int_t tid = omp_get_thread_num();
+        magma_int_t c;
 
-        for (i = ibegin; i < iend; ++i)
+        #pragma omp for
+        for (i = 0; i < k; ++i) {
             dlamda[i] = lapackf77_dlamc3(&dlamda[i], &dlamda[i]) - dlamda[i];
+            s[i] = w[i];
+        }
+        // implicit barrier: all poles are modified before any root is found
+
+        #pragma omp for schedule(dynamic, 1)
+        for (c = 0; c < nchunk; ++c) {
+            magma_int_t jbegin = ( c    * k) / nchunk;
+            magma_int_t jend   = ((c+1) * k) / nchunk;
+            double *wc = s + (c+1)*k;
+            trace_cpu_start( 0, "laed4", NULL );
+
+            for (i = 0; i < k; ++i)
+                wc[i] = 1.;
+
+            for (j = jbegin; j < jend; ++j) {
+                magma_int_t tmpp = j+1;
+                magma_int_t iinfo = 0;
+                lapackf77_dlaed4(&k, &tmpp, dlamda, w, Q(0,j), &rho, &d[j], &iinfo);
+                // If the zero finder fails, the computation is terminated.
+                if (iinfo != 0) {
+                    #pragma omp critical (magma_dlaex3)
+                    *info = iinfo;
+                    break;
+                }
 
-        for (j = ibegin; j < iend; ++j) {
-            magma_int_t tmpp = j+1;
-            magma_int_t iinfo = 0;
-            lapackf77_dlaed4(&k, &tmpp, dlamda, w, Q(0,j), &rho, &d[j], &iinfo);
-            // If the zero finder fails, the computation is terminated.
-            if (iinfo != 0) {
-                #pragma omp critical (magma_dlaex3)
-                *info = iinfo;
-                break;
+                // W(I) = Q(I,I) * prod_{J != I} Q(I,J) / (DLAMDA(I) - DLAMDA(J))
+                if (k > 2) {
+                    for (i = 0; i < j; ++i)
+                        wc[i] *= *Q(i, j) / ( dlamda[i] - dlamda[j] );
+                    wc[j] *= *Q(j, j);
+                    for (i = j+1; i < k; ++i)
+                        wc[i] *= *Q(i, j) / ( dlamda[i] - dlamda[j] );
+                }
             }
+            trace_cpu_end( 0 );
         }
-
-        #pragma omp barrier
+        // implicit barrier: all roots are found
 
         if (*info == 0) {
-            #pragma omp single
+            // overlaps with the reduction of W below
+            #pragma omp single nowait
             {
                 // Prepare the INDXQ sorting permutation.
                 magma_int_t nk = n - k;
@@ -381,20 +418,19 @@ magma_dlaex3(
                 }
             }
             else if (k != 1) {
-                // Compute updated W.
-                blasf77_dcopy( &ik, &w[ibegin], &ione, &s[ibegin], &ione);
-
-                // Initialize W(I) = Q(I,I)
-                tmp = ldq + 1;
-                blasf77_dcopy( &ik, Q(ibegin,ibegin), &tmp, &w[ibegin], &ione);
-
-                for (j = 0; j < k; ++j) {
-                    magma_int_t i_tmp = min(j, iend);
-                    for (i = ibegin; i < i_tmp; ++i)
-                        w[i] = w[i] * ( *Q(i, j) / ( dlamda[i] - dlamda[j] ) );
-                    i_tmp = max(j+1, ibegin);
-                    for (i = i_tmp; i < iend; ++i)
-                        w[i] = w[i] * ( *Q(i, j) / ( dlamda[i] - dlamda[j] ) );
+                // Compute updated W, reducing the partial products.
+                // Split over the team actually running, which may be
+                // smaller than nthread.
+                magma_int_t nt     = omp_get_num_threads();
+                magma_int_t ibegin = ( tid    * k) / nt;      // start index of local loop
+                magma_int_t iend   = ((tid+1) * k) / nt;      // end   index of local loop
+                magma_int_t ik     = iend - ibegin;           // number of local indices
+
+                blasf77_dcopy( &ik, &s[k + ibegin], &ione, &w[ibegin], &ione);
+                for (c = 1; c < nchunk; ++c) {
+                    double *wc = s + (c+1)*k;
+                    for (i = ibegin; i < iend; ++i)
+                        w[i] *= wc[i];
                 }
 
                 for (i = ibegin; i < iend; ++i)
@@ -402,28 +438,18 @@ magma_dlaex3(
 
                 #pragma omp barrier
 
-                // reduce the number of threads used to have enough S workspace
-                nthread = min(n1, omp_get_num_threads());
-
-                if (tid < nthread) {
-                    ibegin = ( tid    * rk) / nthread + iil - 1;
-                    iend   = ((tid+1) * rk) / nthread + iil - 1;
-                    ik     = iend - ibegin;
-                }
-                else {
-                    ibegin = -1;
-                    iend   = -1;
-                    ik     = -1;
-                }
-
                 // Compute eigenvectors of the modified rank-1 modification.
-                for (j = ibegin; j < iend; ++j) {
+                // The partial products are no longer needed, so each thread
+                // uses S(tid+1) for its eigenvector.
+                double *sj = s + (tid+1)*k;
+                #pragma omp for
+                for (j = iil-1; j < iiu; ++j) {
                     for (i = 0; i < k; ++i)
-                        s[tid*k + i] = w[i] / *Q(i,j);
-                    temp = magma_cblas_dnrm2( k, s + tid*k, 1 );
+                        sj[i] = w[i] / *Q(i,j);
+                    temp = magma_cblas_dnrm2( k, sj, 1 );
                     for (i = 0; i < k; ++i) {
                         magma_int_t iii = indx[i] - 1;
-                        *Q(i,j) = s[tid*k + iii] / temp;
+                        *Q(i,j) = sj[iii] / temp;
                     }
                 }
             }
@@ -489,7 +515,7 @@ magma_dlaex3(
         blasf77_dcopy( &k, w, &ione, s, &ione);
 
         // Initialize W(I) = Q(I,I)
-        tmp = ldq + 1;
+        magma_int_t tmp = ldq + 1;
         blasf77_dcopy( &k, Q, &tmp, w, &ione);
 
         for (j = 0; j < k; ++j) {
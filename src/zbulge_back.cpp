@@ -12,7 +12,10 @@
        @precisions normal z -> s d c
 
  */
-#include "magma_internal.h"
+#include <atomic>
+#include <vector>
+
+#include "task_scheduler.hpp"  // includes magma_internal.h
 #include "magma_bulge.h"
 #include "magma_zbulge.h"
 
@@ -28,6 +31,14 @@ static void magma_ztile_bulge_applyQ(
     magmaDoubleComplex *TAU,
     magmaDoubleComplex *T, magma_int_t ldt);
 
+static void magma_zbulge_applyQ_submit(
+    magma_task_scheduler& sched, magma_int_t nworker,
+    magma_int_t ncol, magma_int_t n, magma_int_t nb, magma_int_t Vblksiz,
+    magmaDoubleComplex *E, magma_int_t lde,
+    magmaDoubleComplex *V, magma_int_t ldv,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    std::atomic<magma_int_t>* status);
+
 /******************************************************************************/
 typedef struct magma_zapplyQ_data_s {
     magma_int_t threads_num;
@@ -110,6 +121,95 @@ void magma_zapplyQ_id_data_init(
 }
 
 
+/******************************************************************************/
+// task applying V-blocks jfirst down to jlast of group bg to columns
+// E(:,0:ncol-1), for the dynamic schedule. A task that fails sets *status
+// to the error; later tasks then skip their work.
+class magma_zbulge_applyQ_task: public magma_task
+{
+public:
+    magma_zbulge_applyQ_task(
+        magma_int_t in_bg, magma_int_t in_jfirst, magma_int_t in_jlast,
+        magma_int_t in_ncol, magma_int_t in_n, magma_int_t in_nb, magma_int_t in_Vblksiz,
+        magmaDoubleComplex *in_E, magma_int_t in_lde,
+        magmaDoubleComplex *in_V, magma_int_t in_ldv,
+        magmaDoubleComplex *in_T, magma_int_t in_ldt,
+        std::atomic<magma_int_t>* in_status ):
+        bg     ( in_bg      ),
+        jfirst ( in_jfirst  ),
+        jlast  ( in_jlast   ),
+        ncol   ( in_ncol    ),
+        n      ( in_n       ),
+        nb     ( in_nb      ),
+        Vblksiz( in_Vblksiz ),
+        E      ( in_E       ),
+        lde    ( in_lde     ),
+        V      ( in_V       ),
+        ldv    ( in_ldv     ),
+        T      ( in_T       ),
+        ldt    ( in_ldt     ),
+        status ( in_status  )
+    {}
+
+    virtual void run();
+
+private:
+    magma_int_t bg, jfirst, jlast, ncol, n, nb, Vblksiz;
+    magmaDoubleComplex *E;
+    magma_int_t lde;
+    magmaDoubleComplex *V;
+    magma_int_t ldv;
+    magmaDoubleComplex *T;
+    magma_int_t ldt;
+    std::atomic<magma_int_t>* status;
+};
+
+
+/******************************************************************************/
+// task applying all V-blocks to a fixed set of columns, for the static schedule
+class magma_zbulge_applyQ_cols_task: public magma_task
+{
+public:
+    magma_zbulge_applyQ_cols_task(
+        magma_int_t in_core_id, magma_int_t in_n_loc,
+        magma_int_t in_n, magma_int_t in_nb, magma_int_t in_Vblksiz,
+        magmaDoubleComplex *in_E, magma_int_t in_lde,
+        magmaDoubleComplex *in_V, magma_int_t in_ldv,
+        magmaDoubleComplex *in_TAU,
+        magmaDoubleComplex *in_T, magma_int_t in_ldt ):
+        core_id( in_core_id ),
+        n_loc  ( in_n_loc   ),
+        n      ( in_n       ),
+        nb     ( in_nb      ),
+        Vblksiz( in_Vblksiz ),
+        E      ( in_E       ),
+        lde    ( in_lde     ),
+        V      ( in_V       ),
+        ldv    ( in_ldv     ),
+        TAU    ( in_TAU     ),
+        T      ( in_T       ),
+        ldt    ( in_ldt     )
+    {}
+
+    virtual void run()
+    {
+        magma_set_lapack_numthreads(1);
+        magma_ztile_bulge_applyQ( core_id, MagmaLeft, n_loc, n, nb, Vblksiz,
+                                  E, lde, V, ldv, TAU, T, ldt );
+    }
+
+private:
+    magma_int_t core_id, n_loc, n, nb, Vblksiz;
+    magmaDoubleComplex *E;
+    magma_int_t lde;
+    magmaDoubleComplex *V;
+    magma_int_t ldv;
+    magmaDoubleComplex *TAU;
+    magmaDoubleComplex *T;
+    magma_int_t ldt;
+};
+
+
 /******************************************************************************/
 extern "C" magma_int_t
 magma_zbulge_back(
@@ -123,7 +223,10 @@ magma_zbulge_back(
     magmaDoubleComplex *T, magma_int_t ldt,
     magma_int_t* info)
 {
-    magma_int_t threads = magma_get_parallel_numthreads();
+    magma_bulge_schedule_t schedule = magma_get_bulge_schedule();
+    magma_int_t threads = (schedule == MagmaBulgeDynamic
+                           ? magma_get_bulge_numthreads( n )
+                           : magma_get_parallel_numthreads());
     magma_int_t mklth   = magma_get_lapack_numthreads();
     magma_set_lapack_numthreads(1);
 
@@ -153,10 +256,13 @@ magma_zbulge_back(
     /* --------------------------------------------------
      *  apply V2 from left to the eigenvectors Z. dZ = (I-V2*T2*V2')*Z
      * -------------------------------------------------- */
+    // the static schedule keeps all of Z on the GPU; the dynamic schedule
+    // overlaps the GPU with CPU tasks on the last ne-n_gpu columns
     //$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
     //$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
     //$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
-    n_gpu=ne;
+    if (schedule == MagmaBulgeStatic)
+        n_gpu=ne;
     //$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
     //$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
     //$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
@@ -166,7 +272,27 @@ magma_zbulge_back(
      *  use GPU+CPU's
      *==========================*/
 
-    if (n_gpu < ne) {
+    if (n_gpu < ne && schedule == MagmaBulgeDynamic) {
+        // CPU tasks apply V2 to Z(:,N_GPU+1:NE) on threads-1 workers,
+        // while this thread applies V2 to Z(:,1:N_GPU) on the GPU
+        std::atomic<magma_int_t> status( 0 );
+        magma_task_scheduler sched;
+        sched.launch( threads-1 );
+        magma_zbulge_applyQ_submit( sched, threads-1, ne-n_gpu, n, nb, Vblksiz,
+                                    Z + n_gpu*ldz, ldz, V, ldv, T, ldt, &status );
+
+        if (n_gpu > 0) {
+            magma_zsetmatrix( n, n_gpu, Z, ldz, dZ, lddz, queue );
+            magma_zbulge_applyQ_v2(MagmaLeft, n_gpu, n, nb, Vblksiz, dZ, lddz, V, ldv, T, ldt, info);
+        }
+        sched.quit();
+        if (status != 0) {
+            *info = status;
+        }
+
+        magma_zsetmatrix( n, ne-n_gpu, Z + n_gpu*ldz, ldz, dZ + n_gpu*ldz, lddz, queue );
+
+    } else if (n_gpu < ne) {
         // define the size of Q to be done on CPU's and the size on GPU's
         // note that GPU use Q(1:N_GPU) and CPU use Q(N_GPU+1:N)
         #ifdef ENABLE_DEBUG
@@ -228,6 +354,134 @@ magma_zbulge_back(
 }
 
 
+/***************************************************************************//**
+    Purpose
+    -------
+    ZBULGE_BACK_CPU applies the Householder blocks V2, T2 of the bulge chasing
+    (magma_zhetrd_hb2st) from the left to the eigenvectors Z on the CPU only,
+    Z = Q2 * Z, as the CPU part of magma_zbulge_back does.
+
+    With the MagmaBulgeDynamic schedule (see magma_set_bulge_schedule), the
+    V-blocks are applied by tasks of a magma_task_scheduler on
+    magma_get_bulge_numthreads threads. A task applies a few consecutive
+    V-blocks of the same group to one column tile of Z, and waits only on the
+    earlier tasks that update the same rows of the same tile, so groups
+    proceed as a wavefront instead of each thread sweeping its columns alone.
+    With MagmaBulgeStatic, the columns of Z are split evenly over the
+    threads, as in magma_zbulge_back.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+            Unused, as in magma_zbulge_back.
+
+    @param[in]
+    n       INTEGER
+            The order of Q2. n >= 0.
+
+    @param[in]
+    nb      INTEGER
+            The bandwidth of the band matrix reduced by magma_zhetrd_hb2st.
+
+    @param[in]
+    ne      INTEGER
+            The number of columns of Z. ne >= 0.
+
+    @param[in]
+    Vblksiz INTEGER
+            The size of the V-blocks, from magma_zbulge_getlwstg2.
+
+    @param[in,out]
+    Z       COMPLEX_16 array, dimension (LDZ,NE)
+            On entry, the eigenvectors of the tridiagonal matrix.
+            On exit, Q2 * Z.
+
+    @param[in]
+    ldz     INTEGER
+            The leading dimension of Z. ldz >= max(1,n).
+
+    @param[in]
+    V       COMPLEX_16 array, the Householder vectors from magma_zhetrd_hb2st.
+
+    @param[in]
+    ldv     INTEGER
+            The leading dimension of V.
+
+    @param[in]
+    TAU     COMPLEX_16 array, the Householder scalars from magma_zhetrd_hb2st.
+
+    @param[in]
+    T       COMPLEX_16 array, the triangular factors from magma_zhetrd_hb2st.
+
+    @param[in]
+    ldt     INTEGER
+            The leading dimension of T.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+      -     = MAGMA_ERR_HOST_ALLOC: a task could not allocate its workspace
+
+    @ingroup magma_hetrd_hb2st
+*******************************************************************************/
+extern "C" magma_int_t
+magma_zbulge_back_cpu(
+    magma_uplo_t uplo,
+    magma_int_t n, magma_int_t nb,
+    magma_int_t ne, magma_int_t Vblksiz,
+    magmaDoubleComplex *Z, magma_int_t ldz,
+    magmaDoubleComplex *V, magma_int_t ldv,
+    magmaDoubleComplex *TAU,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    magma_int_t* info)
+{
+    *info = 0;
+    if (n < 0) {
+        *info = -2;
+    } else if (nb < 1) {
+        *info = -3;
+    } else if (ne < 0) {
+        *info = -4;
+    } else if (Vblksiz < 1) {
+        *info = -5;
+    } else if (ldz < max(1,n)) {
+        *info = -7;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+    if (n == 0 || ne == 0)
+        return *info;
+
+    magma_int_t threads = magma_get_bulge_numthreads( n );
+    magma_int_t mklth   = magma_get_lapack_numthreads();
+    magma_set_lapack_numthreads(1);
+
+    std::atomic<magma_int_t> status( 0 );
+    magma_task_scheduler sched;
+    sched.launch( threads );
+    if (magma_get_bulge_schedule() == MagmaBulgeDynamic) {
+        magma_zbulge_applyQ_submit( sched, threads, ne, n, nb, Vblksiz,
+                                    Z, ldz, V, ldv, T, ldt, &status );
+    } else {
+        magma_int_t n_loc = magma_ceildiv(ne, threads);
+        for (magma_int_t thread = 0; thread < threads && thread*n_loc < ne; thread++) {
+            sched.push_task( new magma_zbulge_applyQ_cols_task(
+                thread, min(n_loc, ne - thread*n_loc), n, nb, Vblksiz,
+                Z + thread*n_loc*ldz, ldz, V, ldv, TAU, T, ldt ));
+        }
+    }
+    sched.quit();
+    *info = status;
+
+    magma_set_lapack_numthreads(mklth);
+    return *info;
+}
+
+
 /******************************************************************************/
 static void *magma_zapplyQ_parallel_section(void *arg)
 {
@@ -487,6 +741,141 @@ static void magma_ztile_bulge_applyQ(
     magma_free_cpu(work2);
 }
 
+/******************************************************************************/
+// Rows fst:fst+vlen-1 touched by V-block j of group bg, with vnb reflectors,
+// and its position in V and T, for side = left (see magma_ztile_bulge_applyQ).
+// vlen = 0 if the block is empty.
+static void magma_zbulge_vblock(
+    magma_int_t n, magma_int_t nb, magma_int_t Vblksiz,
+    magma_int_t bg, magma_int_t j, magma_int_t ldv, magma_int_t ldt,
+    magma_int_t *fst, magma_int_t *vlen, magma_int_t *vnb,
+    magma_int_t *vpos, magma_int_t *tpos)
+{
+    magma_int_t nbGblk    = magma_ceildiv(n-1, Vblksiz);
+    magma_int_t firstcolj = (bg-1)*Vblksiz + 1;
+    magma_int_t rownbm    = magma_ceildiv((n-(firstcolj+1)),nb);
+    if (bg == nbGblk) rownbm = magma_ceildiv((n-(firstcolj)),nb);  // last blk has size=1 used for complex to handle A(N,N-1)
+
+    magma_int_t colst = (bg-1)*Vblksiz;
+    *vlen = 0;
+    *vnb  = 0;
+    *fst  = (rownbm -j)*nb + colst +1;
+    for (magma_int_t k=0; k < Vblksiz; k++) {
+        magma_int_t colj = colst + k;
+        magma_int_t st   = (rownbm -j)*nb + colj +1;
+        magma_int_t ed   = min(st+nb-1,n-1);
+        if (st > ed)
+            break;
+        if ((st == ed) && (colj != n-2))
+            break;
+        *vlen = ed - *fst + 1;
+        *vnb  = k+1;
+    }
+    if (*vnb == 0)
+        *vlen = 0;
+    magma_bulge_findVTpos(n, nb, Vblksiz, colst, *fst, ldv, ldt, vpos, tpos);
+}
+
+
+/******************************************************************************/
+// Applies V-blocks jfirst down to jlast of group bg to E(:,0:ncol-1).
+// Consecutive blocks of a group overlap in all but nb rows, so the rows of E
+// updated by one block are still in cache for the next.
+void magma_zbulge_applyQ_task::run()
+{
+    magma_int_t fst, vlen, vnb, vpos, tpos;
+    magmaDoubleComplex *work;
+
+    if (*status != 0)
+        return;
+
+    magma_set_lapack_numthreads(1);
+    if (MAGMA_SUCCESS != magma_zmalloc_cpu( &work, ncol*Vblksiz )) {
+        *status = MAGMA_ERR_HOST_ALLOC;
+        return;
+    }
+    for (magma_int_t j = jfirst; j >= jlast; j--) {
+        magma_zbulge_vblock( n, nb, Vblksiz, bg, j, ldv, ldt,
+                             &fst, &vlen, &vnb, &vpos, &tpos );
+        if (vlen > 0) {
+            lapackf77_zlarfb( "L", "N", "F", "C", &vlen, &ncol, &vnb,
+                              V(vpos), &ldv, T(tpos), &ldt, E(fst,0), &lde,
+                              work, &ncol );
+        }
+    }
+    magma_free_cpu( work );
+}
+
+
+/******************************************************************************/
+// Submits tasks applying Q2 from the left to E(:,0:ncol-1) to sched, in the
+// sequential order of magma_ztile_bulge_applyQ: groups bg from last to first,
+// and blocks j from last to first within a group.
+// The columns are split into tiles, about two per worker so every worker
+// finds work, but at least 64 wide so each V and T block read from memory
+// is applied to many columns. The blocks of a group are batched by grpsiz so
+// a task covers about 256 rows. A task depends, through one tag per
+// nb rows of its tile, only on the earlier tasks that update the same rows.
+// A task that cannot allocate its workspace sets *status to
+// MAGMA_ERR_HOST_ALLOC, which the caller checks after sched.quit().
+static void magma_zbulge_applyQ_submit(
+    magma_task_scheduler& sched, magma_int_t nworker,
+    magma_int_t ncol, magma_int_t n, magma_int_t nb, magma_int_t Vblksiz,
+    magmaDoubleComplex *E, magma_int_t lde,
+    magmaDoubleComplex *V, magma_int_t ldv,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    std::atomic<magma_int_t>* status)
+{
+    magma_int_t fst, vlen, vnb, vpos, tpos;
+
+    if (n <= 1 || ncol <= 0)
+        return;
+
+    magma_int_t nbGblk = magma_ceildiv(n-1, Vblksiz);
+    magma_int_t ntile  = max( 1, min( magma_ceildiv(ncol, 64), 2*nworker ));
+    magma_int_t wtile  = magma_ceildiv(ncol, ntile);
+    ntile              = magma_ceildiv(ncol, wtile);
+    magma_int_t grpsiz = max( 1, 256/nb );
+
+    std::vector< magma_dep > deps;
+    for (magma_int_t bg = nbGblk; bg > 0; bg--) {
+        magma_int_t firstcolj = (bg-1)*Vblksiz + 1;
+        magma_int_t rownbm    = magma_ceildiv((n-(firstcolj+1)),nb);
+        if (bg == nbGblk) rownbm = magma_ceildiv((n-(firstcolj)),nb);
+
+        for (magma_int_t jfirst = rownbm; jfirst > 0; jfirst -= grpsiz) {
+            magma_int_t jlast = max( 1, jfirst-grpsiz+1 );
+
+            // rows touched by the blocks of the task
+            magma_int_t row0 = n, row1 = 0;
+            for (magma_int_t j = jfirst; j >= jlast; j--) {
+                magma_zbulge_vblock( n, nb, Vblksiz, bg, j, ldv, ldt,
+                                     &fst, &vlen, &vnb, &vpos, &tpos );
+                if (vlen > 0) {
+                    row0 = min( row0, fst );
+                    row1 = max( row1, fst+vlen );
+                }
+            }
+            if (row0 >= row1)
+                continue;
+
+            for (magma_int_t t = 0; t < ntile; t++) {
+                magma_int_t col0 = t*wtile;
+                deps.clear();
+                for (magma_int_t r = row0/nb; r <= (row1-1)/nb; r++) {
+                    magma_dep dep = { E(r*nb, col0), MagmaAccessInOut };
+                    deps.push_back( dep );
+                }
+                sched.push_task( new magma_zbulge_applyQ_task(
+                                     bg, jfirst, jlast, min(wtile, ncol-col0),
+                                     n, nb, Vblksiz, E(0, col0), lde,
+                                     V, ldv, T, ldt, status ),
+                                 deps.size(), &deps[0] );
+            }
+        }
+    }
+}
+
 #undef E
 #undef V
 #undef TAU
@@ -433,6 +433,9 @@ magma_zheevdx_2stage(
     #endif
 
 
+    // profiling region; see $MAGMA_PROFILE in magma_timer.h
+    timer_region region( "zheevdx_2stage" );
+
     magma_timer_t time=0, time_total=0;
     timer_start( time_total );
     timer_start( time );
@@ -442,13 +445,16 @@ magma_zheevdx_2stage(
         *info = MAGMA_ERR_DEVICE_ALLOC;
         return *info;
     }
+    timer_region_start( "zhetrd_he2hb" );
     magma_zhetrd_he2hb(uplo, n, nb, A, lda, TAU1, Wstg1, lwstg1, dT1, info);
+    timer_region_stop();
 
     timer_stop( time );
     timer_printf( "  N= %10lld  nb= %5lld time zhetrd_he2hb= %6.2f\n", (long long) n, (long long) nb, time );
     timer_start( time );
 
     /* copy the input matrix into WORK(INDWRK) with band storage */
+    timer_region_start( "zhetrd_convert" );
     memset(A2, 0, n*lda2*sizeof(magmaDoubleComplex));
 
     for (magma_int_t j = 0; j < n-nb; j++) {
@@ -462,12 +468,15 @@ magma_zheevdx_2stage(
         blasf77_zcopy( &len, A(j+n-nb,j+n-nb), &ione, A2(0,j+n-nb), &ione );
         memset(A(j+n-nb,j+n-nb), 0, (nb-j)*sizeof(magmaDoubleComplex));
     }
+    timer_region_stop();
 
     timer_stop( time );
     timer_printf( "  N= %10lld  nb= %5lld time zhetrd_convert = %6.2f\n", (long long) n, (long long) nb, time );
     timer_start( time );
 
+    timer_region_start( "zhetrd_hb2st" );
     magma_zhetrd_hb2st(uplo, n, nb, Vblksiz, A2, lda2, W, E, V2, ldv, TAU2, wantz, T2, ldt);
+    timer_region_stop();
 
     timer_stop( time );
     timer_stop( time_total );
@@ -481,7 +490,9 @@ magma_zheevdx_2stage(
     if (! wantz) {
         timer_start( time );
 
+        timer_region_start( "dsterf" );
         lapackf77_dsterf(&n, W, E, info);
+        timer_region_stop();
         magma_dmove_eig(range, n, W, &il, &iu, vl, vu, m);
 
         timer_stop( time );
@@ -499,9 +510,11 @@ magma_zheevdx_2stage(
 
         timer_start( time );
 
+        timer_region_start( "zstedx" );
         magma_zstedx(range, n, vl, vu, il, iu, W, E,
                      Z, ldz, Wedc, lwedc,
                      iwork, liwork, dwedc, info);
+        timer_region_stop();
 
 
         timer_stop( time );
@@ -520,8 +533,15 @@ magma_zheevdx_2stage(
 
         timer_start( time );
 
+        timer_region_start( "zbulge_back" );
         magma_zbulge_back(uplo, n, nb, *m, Vblksiz, Z +ldz*(il-1), ldz, dZ, lddz,
                           V2, ldv, TAU2, T2, ldt, info);
+        timer_region_stop();
+        if (*info != 0) {
+            // TODO free dT1, etc. --- see goto cleanup in dlaex0_m.cpp, etc.
+            magma_free( dZ );
+            return *info;
+        }
 
         timer_stop( time );
         timer_printf( "  N= %10lld  nb= %5lld time zbulge_back = %6.2f\n", (long long) n, (long long) nb, time );
@@ -541,6 +561,7 @@ magma_zheevdx_2stage(
         magma_getdevice( &cdev );
         magma_queue_create( cdev, &queue );
 
+        timer_region_start( "zunmqr" );
         magma_zsetmatrix( n, n, A, lda, dA, ldda, queue );
 
         magma_zunmqr_2stage_gpu( MagmaLeft, MagmaNoTrans, n-nb, *m, n-nb, dA+nb, ldda,
@@ -550,6 +571,7 @@ magma_zheevdx_2stage(
 
         magma_queue_sync( queue );
         magma_queue_destroy( queue );
+        timer_region_stop();
 
         timer_stop( time );
         timer_printf( "  N= %10lld  nb= %5lld time zunmqr + copy = %6.2f\n", 
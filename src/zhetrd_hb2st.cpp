@@ -12,6 +12,9 @@
        @precisions normal z -> s d c
 
 */
+#include <atomic>
+#include <limits>
+
 #include "magma_internal.h"
 #include "magma_bulge.h"
 #include "magma_zbulge.h"
@@ -32,6 +35,16 @@ static void magma_ztile_bulge_parallel(
     magma_int_t grsiz, magma_int_t Vblksiz, magma_int_t wantz, 
     volatile magma_int_t *prog, pthread_barrier_t* myptbarrier);
 
+struct magma_zbulge_data_s;
+
+static void magma_ztile_bulge_parallel_dynamic(
+    magma_int_t my_core_id,
+    magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *V, magma_int_t ldv,
+    magmaDoubleComplex *TAU, magma_int_t n, magma_int_t nb,
+    magma_int_t Vblksiz, magma_int_t wantz,
+    struct magma_zbulge_data_s* data);
+
 static void magma_ztile_bulge_computeT_parallel(
     magma_int_t my_core_id, magma_int_t cores_num,
     magmaDoubleComplex *V, magma_int_t ldv, magmaDoubleComplex *TAU,
@@ -39,6 +52,31 @@ static void magma_ztile_bulge_computeT_parallel(
     magma_int_t n, magma_int_t nb, magma_int_t Vblksiz);
 
 
+/******************************************************************************/
+// Size of cache per core that the sweeps of one group should fit in,
+// see magma_zbulge_data_init.
+#define BULGE_CACHE_SIZE  (1024*1024)
+
+// Number of times a waiting thread polls before it goes to sleep.
+#define BULGE_SPIN_COUNT  64
+
+// Stride between progress counters, so each is in its own cache line.
+#define BULGE_STRIDE      (64/sizeof(std::atomic<magma_int_t>))
+
+// Progress posted for a group whose sweeps are all done;
+// satisfies every wait, like setting prog past the last task.
+#define BULGE_DONE        ((std::numeric_limits<magma_int_t>::max)())
+
+
+/******************************************************************************/
+// Per-thread mutex and condition on which a thread of the dynamic schedule
+// sleeps while waiting for the group before its own.
+typedef struct magma_bulge_sleeper_s {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+} magma_bulge_sleeper;
+
+
 /******************************************************************************/
 typedef struct magma_zbulge_data_s {
     magma_int_t threads_num;
@@ -57,6 +95,18 @@ typedef struct magma_zbulge_data_s {
     magma_int_t ldt;
     volatile magma_int_t *prog;
     pthread_barrier_t myptbarrier;
+
+    // dynamic schedule: sweeps are dealt out in ngroups groups of sweepgrp
+    // consecutive sweeps. group_prog[g*BULGE_STRIDE] is the last task (myid)
+    // finished by the last sweep of group g, group_waiter[g*BULGE_STRIDE]
+    // the thread sleeping until it advances, or -1.
+    magma_bulge_schedule_t schedule;
+    magma_int_t sweepgrp;
+    magma_int_t ngroups;
+    std::atomic<magma_int_t> next_group;
+    std::atomic<magma_int_t> *group_prog;
+    std::atomic<magma_int_t> *group_waiter;
+    magma_bulge_sleeper *sleeper;
 } magma_zbulge_data;
 
 
@@ -87,6 +137,35 @@ void magma_zbulge_data_init(
     zbulge_data_S->prog = prog;
 
     pthread_barrier_init(&(zbulge_data_S->myptbarrier), NULL, (unsigned) zbulge_data_S->threads_num);
+
+    /* For the dynamic schedule, group as many consecutive sweeps as fit in
+     * cache: at each step, the sweeps of a group work on neighboring tiles,
+     * covering about 3*nb/2 columns of the band per sweep. Keep at least
+     * two groups per thread along one sweep, so all threads find work. */
+    zbulge_data_S->schedule = magma_get_bulge_schedule();
+    magma_int_t sweepgrp = BULGE_CACHE_SIZE / (3*nb*nb*sizeof(magmaDoubleComplex));
+    sweepgrp = min( sweepgrp, nbtiles / (2*threads_num) );
+    sweepgrp = max( sweepgrp, 1 );
+    zbulge_data_S->sweepgrp = sweepgrp;
+    zbulge_data_S->ngroups  = magma_ceildiv( n-1, sweepgrp );
+    zbulge_data_S->next_group.store( 0 );
+    zbulge_data_S->group_prog   = NULL;
+    zbulge_data_S->group_waiter = NULL;
+    zbulge_data_S->sleeper      = NULL;
+    if ( zbulge_data_S->schedule == MagmaBulgeDynamic && n > 1 ) {
+        magma_int_t len = zbulge_data_S->ngroups * BULGE_STRIDE;
+        zbulge_data_S->group_prog   = new std::atomic<magma_int_t>[ len ];
+        zbulge_data_S->group_waiter = new std::atomic<magma_int_t>[ len ];
+        for (magma_int_t g = 0; g < len; g++) {
+            zbulge_data_S->group_prog[g].store( 0 );
+            zbulge_data_S->group_waiter[g].store( -1 );
+        }
+        zbulge_data_S->sleeper = new magma_bulge_sleeper[ threads_num ];
+        for (magma_int_t t = 0; t < threads_num; t++) {
+            pthread_mutex_init( &zbulge_data_S->sleeper[t].mutex, NULL );
+            pthread_cond_init(  &zbulge_data_S->sleeper[t].cond,  NULL );
+        }
+    }
 }
 
 
@@ -94,6 +173,16 @@ void magma_zbulge_data_init(
 void magma_zbulge_data_destroy(magma_zbulge_data *zbulge_data_S)
 {
     pthread_barrier_destroy(&(zbulge_data_S->myptbarrier));
+
+    if ( zbulge_data_S->sleeper != NULL ) {
+        for (magma_int_t t = 0; t < zbulge_data_S->threads_num; t++) {
+            pthread_mutex_destroy( &zbulge_data_S->sleeper[t].mutex );
+            pthread_cond_destroy(  &zbulge_data_S->sleeper[t].cond  );
+        }
+    }
+    delete[] zbulge_data_S->sleeper;
+    delete[] zbulge_data_S->group_prog;
+    delete[] zbulge_data_S->group_waiter;
 }
 
 
@@ -183,6 +272,12 @@ void magma_zbulge_id_data_init(magma_zbulge_id_data *id_data, magma_int_t id, ma
             The leading dimension of T.
             LDT > Vblksiz
 
+    The bulge chasing uses magma_get_bulge_numthreads threads.
+    With the default MagmaBulgeDynamic schedule (see magma_set_bulge_schedule),
+    threads take groups of consecutive sweeps on demand and sleep while
+    waiting for the preceding group; MagmaBulgeStatic assigns columns of the
+    band to threads and spins while waiting.
+
     @ingroup magma_hetrd_hb2st
 *******************************************************************************/
 extern "C" magma_int_t
@@ -196,7 +291,7 @@ magma_zhetrd_hb2st(
     real_Double_t timeblg=0.0;
     #endif
 
-    magma_int_t parallel_threads = magma_get_parallel_numthreads();
+    magma_int_t parallel_threads = magma_get_bulge_numthreads( n );
     magma_int_t mklth   = magma_get_lapack_numthreads();
     magma_int_t ompth   = magma_get_omp_numthreads();
 
@@ -403,7 +498,12 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
         timeB = magma_wtime();
     #endif
 
-    magma_ztile_bulge_parallel(my_core_id, allcores_num, A, lda, V, ldv, TAU, n, nb, nbtiles, grsiz, Vblksiz, wantz, prog, myptbarrier);
+    if (data -> schedule == MagmaBulgeDynamic) {
+        magma_ztile_bulge_parallel_dynamic(my_core_id, A, lda, V, ldv, TAU, n, nb, Vblksiz, wantz, data);
+    }
+    else {
+        magma_ztile_bulge_parallel(my_core_id, allcores_num, A, lda, V, ldv, TAU, n, nb, nbtiles, grsiz, Vblksiz, wantz, prog, myptbarrier);
+    }
     if (allcores_num > 1) pthread_barrier_wait(myptbarrier);
 
     #ifdef ENABLE_TIMER
@@ -670,6 +770,149 @@ static void magma_ztile_bulge_parallel(
 } // END FUNCTION
 
 
+/******************************************************************************/
+// Waits until the last sweep of group g has finished task myid >= val.
+// Polls briefly, then sleeps on the calling thread's condition;
+// magma_zbulge_group_post wakes it.
+static void magma_zbulge_group_wait(
+    magma_zbulge_data* data, magma_int_t my_core_id,
+    magma_int_t g, magma_int_t val)
+{
+    std::atomic<magma_int_t>& prog   = data->group_prog  [ g*BULGE_STRIDE ];
+    std::atomic<magma_int_t>& waiter = data->group_waiter[ g*BULGE_STRIDE ];
+
+    for (magma_int_t spin = 0; spin < BULGE_SPIN_COUNT; spin++) {
+        if (prog.load( std::memory_order_acquire ) >= val)
+            return;
+    }
+
+    // waiter is stored before prog is read again, and post stores prog
+    // before reading waiter (both sequentially consistent), so either this
+    // thread sees the new prog or post sees the waiter and signals it
+    // under the mutex.
+    magma_bulge_sleeper* me = &data->sleeper[ my_core_id ];
+    pthread_mutex_lock( &me->mutex );
+    waiter.store( my_core_id );
+    while (prog.load() < val) {
+        pthread_cond_wait( &me->cond, &me->mutex );
+    }
+    waiter.store( -1 );
+    pthread_mutex_unlock( &me->mutex );
+}
+
+
+/******************************************************************************/
+// Publishes progress val of group g and wakes the thread waiting on it.
+static void magma_zbulge_group_post(
+    magma_zbulge_data* data, magma_int_t g, magma_int_t val)
+{
+    data->group_prog[ g*BULGE_STRIDE ].store( val );
+    magma_int_t w = data->group_waiter[ g*BULGE_STRIDE ].load();
+    if (w >= 0) {
+        magma_bulge_sleeper* other = &data->sleeper[ w ];
+        pthread_mutex_lock( &other->mutex );
+        pthread_cond_signal( &other->cond );
+        pthread_mutex_unlock( &other->mutex );
+    }
+}
+
+
+/******************************************************************************/
+/* Dynamic bulge chasing schedule.
+ * Task myid of sweep sweepid depends on task myid-1 of the same sweep and on
+ * task myid+shift-1 of sweep sweepid-1, as in the static schedule.
+ * Each thread repeatedly takes the next group of sweepgrp consecutive sweeps
+ * and runs all of their tasks in the same order as the static schedule, so
+ * the dependencies within the group hold, and the sweeps of a group reuse
+ * the tiles of A and V left in cache by the sweep before.
+ * Only the first sweep of a group depends on another thread: it waits,
+ * sleeping if need be, for the last sweep of the previous group.
+ * */
+static void magma_ztile_bulge_parallel_dynamic(
+    magma_int_t my_core_id,
+    magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *V, magma_int_t ldv,
+    magmaDoubleComplex *TAU, magma_int_t n, magma_int_t nb,
+    magma_int_t Vblksiz, magma_int_t wantz,
+    magma_zbulge_data* data)
+{
+    magma_int_t sweepid, myid, stt, st, ed, stind, edind;
+    magma_int_t blklastind, colpt;
+    magma_int_t i, m, g, grst, gred;
+    magmaDoubleComplex *work;
+
+    if (n <= 1)
+        return;
+
+    // grsiz = 1, so a step covers shift tasks of a sweep, see the static schedule
+    const magma_int_t shift     = 3;
+    const magma_int_t stepercol = shift;
+    const magma_int_t sweepgrp  = data -> sweepgrp;
+    const magma_int_t ngroups   = data -> ngroups;
+
+    magma_zmalloc_cpu(&work, nb);
+
+    #if defined (ENABLE_DEBUG)
+    if (my_core_id == 0) {
+        printf("  Dynamic bulgechasing threads  %4lld   n %5lld      nb %5lld    sweeps per group %4lld  wantz %4lld\n",
+               (long long) data -> threads_num, (long long) n,
+               (long long) nb, (long long) sweepgrp, (long long) wantz );
+    }
+    #endif
+
+    while ( (g = data -> next_group.fetch_add( 1 )) < ngroups ) {
+        grst = g*sweepgrp + 1;
+        gred = min( grst + sweepgrp - 1, n-1 );
+        stt  = grst;
+        for (i = grst; i <= n-1; i++) {
+            ed = min(i,gred);
+            if (stt > ed) break;
+            for (m = 1; m <= stepercol; m++) {
+                st = stt;
+                for (sweepid = st; sweepid <= ed; sweepid++) {
+                    myid = (i-sweepid)*stepercol + m;
+                    if (myid%2 == 0) {
+                        colpt      = (myid/2)*nb+1+sweepid-1;
+                        stind      = colpt-nb+1;
+                        edind      = min(colpt,n);
+                        blklastind = colpt;
+                    } else {
+                        colpt      = ((myid+1)/2)*nb + 1 +sweepid -1;
+                        stind      = colpt-nb+1;
+                        edind      = min(colpt,n);
+                        if ( (stind >= edind-1) && (edind == n) )
+                            blklastind=n;
+                        else
+                            blklastind=0;
+                    }
+
+                    if (sweepid == grst && g > 0) {
+                        magma_zbulge_group_wait(data, my_core_id, g-1, myid+shift-1);
+                    }
+
+                    if (myid == 1) {
+                        magma_zhbtype1cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
+                    } else if (myid%2 == 0) {
+                        magma_zhbtype2cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
+                    } else {
+                        magma_zhbtype3cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
+                    }
+
+                    if (sweepid == gred) {
+                        magma_zbulge_group_post(data, g, (blklastind >= (n-1) ? BULGE_DONE : myid));
+                    }
+                    if (blklastind >= (n-1)) {
+                        stt++;
+                    }
+                } /* END for sweepid=st:ed */
+            } /* END for m=1:stepercol */
+        } /* END for i=grst:n-1 */
+    } /* END while groups */
+
+    magma_free_cpu(work);
+} // END FUNCTION
+
+
 /******************************************************************************/
 #define V(m)     &(V[(m)])
 #define TAU(m)   &(TAU[(m)])
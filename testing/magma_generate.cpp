@@ -15,6 +15,8 @@
 #include <vector>
 #include <limits>
 
+#include <stdint.h>
+
 #include "magma_v2.h"
 #include "magma_lapack.hpp"  // experimental C++ bindings
 #include "magma_operators.h"
@@ -98,6 +100,145 @@ inline bool contains( std::string const &str, std::string const &pattern )
 }
 
 
+/******************************************************************************/
+// Counter-based random numbers, Philox4x32-10; see Salmon, Moraes, Dror, Shaw,
+// Parallel random numbers: as easy as 1, 2, 3, SC 2011.
+// Entry k of stream s depends only on the key, s, and k, so entries are
+// generated in parallel and are the same for any number of threads.
+
+// streams for the random entries of one generated matrix
+enum class Stream : uint32_t {
+    matrix = 1,
+    sigma,
+    sign,
+    U,
+    V,
+    D,
+    next,     // next key, after the matrix is generated
+    padding,  // rows m, ..., lda-1 of the matrix
+};
+
+// Overwrites ctr with the 128 random bits for counter ctr.
+inline void philox4x32_10( const uint32_t key_[2], uint32_t ctr[4] )
+{
+    uint32_t key[2] = { key_[0], key_[1] };
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = uint64_t( 0xD2511F53 ) * ctr[0];
+        uint64_t p1 = uint64_t( 0xCD9E8D57 ) * ctr[2];
+        uint32_t c0 = uint32_t( p1 >> 32 ) ^ ctr[1] ^ key[0];
+        uint32_t c2 = uint32_t( p0 >> 32 ) ^ ctr[3] ^ key[1];
+        ctr[0] = c0;
+        ctr[1] = uint32_t( p1 );
+        ctr[2] = c2;
+        ctr[3] = uint32_t( p0 );
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+    }
+}
+
+// Random bits for entry k of stream.
+inline void philox_bits( const uint32_t key[2], Stream stream, uint64_t k,
+                         uint32_t ctr[4] )
+{
+    ctr[0] = uint32_t( k );
+    ctr[1] = uint32_t( k >> 32 );
+    ctr[2] = uint32_t( stream );
+    ctr[3] = 0;
+    philox4x32_10( key, ctr );
+}
+
+// Random number uniform on (0, 1), using the precision of real_t,
+// from 64 random bits.
+template< typename real_t >
+inline real_t philox_uniform( uint32_t hi, uint32_t lo )
+{
+    if (sizeof(real_t) == sizeof(float)) {
+        return ((hi >> 8) + real_t(0.5)) / real_t(16777216.);         // 2^24
+    }
+    else {
+        return ((hi >> 5) * real_t(67108864.) + (lo >> 6) + real_t(0.5))
+               / real_t(9007199254740992.);                            // 2^53
+    }
+}
+
+// The key is the LAPACK seed opts.iseed, each entry < 4096.
+inline void philox_key( magma_opts& opts, uint32_t key[2] )
+{
+    key[0] = uint32_t( opts.iseed[3] ) | (uint32_t( opts.iseed[2] ) << 12);
+    key[1] = uint32_t( opts.iseed[1] ) | (uint32_t( opts.iseed[0] ) << 12);
+}
+
+// Sets opts.iseed to a new key, so each matrix generated differs,
+// as with larnv. iseed[3] stays odd, as larnv requires.
+inline void philox_next_key( magma_opts& opts )
+{
+    uint32_t key[2], ctr[4];
+    philox_key( opts, key );
+    philox_bits( key, Stream::next, 0, ctr );
+    opts.iseed[0] = ctr[0] % 4096;
+    opts.iseed[1] = ctr[1] % 4096;
+    opts.iseed[2] = ctr[2] % 4096;
+    opts.iseed[3] = (ctr[3] % 2048)*2 + 1;
+}
+
+
+/******************************************************************************/
+// Fills m-by-n A with random entries, as larnv: idist is
+// 1 uniform on (0, 1), 2 uniform on (-1, 1), 3 normal with mean 0, std 1;
+// for complex, real and imaginary parts each. Entries are multiplied by scale.
+// Entry (i, j) is entry k = i + j*m of stream, independent of lda and of the
+// number of threads. Counter k gives the complex entry k, or the real
+// entries 2k and 2k+1.
+template< typename FloatT >
+void magma_generate_rand(
+    const uint32_t key[2], Stream stream, magma_int_t idist,
+    magma_int_t m, magma_int_t n,
+    FloatT* A, magma_int_t lda,
+    typename blas::traits<FloatT>::real_t scale )
+{
+    typedef typename blas::traits<FloatT>::real_t real_t;
+    const real_t twopi = 6.2831853071795864769;
+    const bool is_complex = (sizeof(FloatT) != sizeof(real_t));
+
+    #pragma omp parallel for schedule( static )
+    for (magma_int_t j = 0; j < n; ++j) {
+        uint32_t ctr[4];
+        uint64_t last = ~uint64_t( 0 );
+        real_t re = 0, im = 0;
+        for (magma_int_t i = 0; i < m; ++i) {
+            uint64_t k = uint64_t( i ) + uint64_t( j )*m;
+            uint64_t c = (is_complex ? k : k >> 1);
+            if (c != last) {
+                last = c;
+                philox_bits( key, stream, c, ctr );
+                real_t u1 = philox_uniform< real_t >( ctr[0], ctr[1] );
+                real_t u2 = philox_uniform< real_t >( ctr[2], ctr[3] );
+                if (idist == idist_randn) {
+                    // Box-Muller
+                    real_t r = sqrt( -2*log( u1 ) );
+                    re = scale * r * cos( twopi*u2 );
+                    im = scale * r * sin( twopi*u2 );
+                }
+                else if (idist == idist_rands) {
+                    re = scale * (2*u1 - 1);
+                    im = scale * (2*u2 - 1);
+                }
+                else {
+                    re = scale * u1;
+                    im = scale * u2;
+                }
+            }
+            if (is_complex) {
+                A[ i + j*lda ] = blas::traits<FloatT>::make( re, im );
+            }
+            else {
+                A[ i + j*lda ] = blas::traits<FloatT>::make( (k & 1 ? im : re), 0 );
+            }
+        }
+    }
+}
+
+
 /******************************************************************************/
 template< typename FloatT >
 void magma_generate_sigma(
@@ -116,6 +257,8 @@ void magma_generate_sigma(
     // locals
     magma_int_t minmn = min( A.m, A.n );
     assert( minmn == sigma.n );
+    uint32_t key[2];
+    philox_key( opts, key );
 
     switch (dist) {
         case Dist::arith:
@@ -172,7 +315,8 @@ void magma_generate_sigma(
 
         case Dist::logrand: {
             real_t range = log( 1/cond );
-            lapack::larnv( idist_rand, opts.iseed, sigma.n, sigma(0) );
+            magma_generate_rand( key, Stream::sigma, idist_rand, sigma.n, 1,
+                                 sigma(0), sigma.n, real_t(1) );
             for (magma_int_t i = 0; i < minmn; ++i) {
                 sigma[i] = exp( sigma[i] * range );
             }
@@ -188,7 +332,8 @@ void magma_generate_sigma(
         case Dist::rands:
         case Dist::rand: {
             magma_int_t idist = (magma_int_t) dist;
-            lapack::larnv( idist, opts.iseed, sigma.n, sigma(0) );
+            magma_generate_rand( key, Stream::sigma, idist, sigma.n, 1,
+                                 sigma(0), sigma.n, real_t(1) );
             break;
         }
 
@@ -205,8 +350,10 @@ void magma_generate_sigma(
 
     if (rand_sign) {
         // apply random signs
+        uint32_t ctr[4];
         for (magma_int_t i = 0; i < minmn; ++i) {
-            if (rand() > RAND_MAX/2) {
+            philox_bits( key, Stream::sign, i, ctr );
+            if (ctr[0] >> 31) {
                 sigma[i] = -sigma[i];
             }
         }
@@ -296,10 +443,11 @@ void magma_generate_svd(
     magma_int_t n = A.n;
     magma_int_t maxmn = max( m, n );
     magma_int_t minmn = min( m, n );
-    magma_int_t sizeU;
     magma_int_t info = 0;
     Matrix<FloatT> U( maxmn, minmn );
     Vector<FloatT> tau( minmn );
+    uint32_t key[2];
+    philox_key( opts, key );
 
     // query for workspace
     magma_int_t lwork = -1;
@@ -334,9 +482,10 @@ void magma_generate_svd(
 
     // random U, m-by-minmn
     // just make each random column into a Householder vector;
-    // no need to update subsequent columns (as in geqrf).
-    sizeU = U.size();
-    lapack::larnv( idist_randn, opts.iseed, sizeU, U(0,0) );
+    // no need to update subsequent columns (as in geqrf),
+    // so columns are independent.
+    magma_generate_rand( key, Stream::U, idist_randn, U.m, U.n, U(0,0), U.ld, real_t(1) );
+    #pragma omp parallel for schedule( dynamic, 16 )
     for (magma_int_t j = 0; j < minmn; ++j) {
         magma_int_t mj = m - j;
         lapack::larfg( mj, U(j,j), U(j+1,j), 1, tau(j) );
@@ -349,7 +498,8 @@ void magma_generate_svd(
     assert( info == 0 );
 
     // random V, n-by-minmn (stored column-wise in U)
-    lapack::larnv( idist_randn, opts.iseed, sizeU, U(0,0) );
+    magma_generate_rand( key, Stream::V, idist_randn, U.m, U.n, U(0,0), U.ld, real_t(1) );
+    #pragma omp parallel for schedule( dynamic, 16 )
     for (magma_int_t j = 0; j < minmn; ++j) {
         magma_int_t nj = n - j;
         lapack::larfg( nj, U(j,j), U(j+1,j), 1, tau(j) );
@@ -369,7 +519,7 @@ void magma_generate_svd(
         // A = A*D col scaling
         Vector<real_t> D( A.n );
         real_t range = log( condD );
-        lapack::larnv( idist_rand, opts.iseed, D.n, D(0) );
+        magma_generate_rand( key, Stream::D, idist_rand, D.n, 1, D(0), D.n, real_t(1) );
         for (magma_int_t i = 0; i < D.n; ++i) {
             D[i] = exp( D[i] * range );
         }
@@ -381,6 +531,7 @@ void magma_generate_svd(
             }
             printf( " ];\n" );
         }
+        #pragma omp parallel for schedule( static )
         for (magma_int_t j = 0; j < A.n; ++j) {
             for (magma_int_t i = 0; i < A.m; ++i) {
                 *A(i,j) = *A(i,j) * D[j];
@@ -408,10 +559,11 @@ void magma_generate_heev(
     // locals
     FloatT tmp;
     magma_int_t n = A.n;
-    magma_int_t sizeU;
     magma_int_t info = 0;
     Matrix<FloatT> U( n, n );
     Vector<FloatT> tau( n );
+    uint32_t key[2];
+    philox_key( opts, key );
 
     // query for workspace
     magma_int_t lwork = -1;
@@ -434,9 +586,10 @@ void magma_generate_heev(
 
     // random U, n-by-n
     // just make each random column into a Householder vector;
-    // no need to update subsequent columns (as in geqrf).
-    sizeU = U.size();
-    lapack::larnv( idist_randn, opts.iseed, sizeU, U(0,0) );
+    // no need to update subsequent columns (as in geqrf),
+    // so columns are independent.
+    magma_generate_rand( key, Stream::U, idist_randn, U.m, U.n, U(0,0), U.ld, real_t(1) );
+    #pragma omp parallel for schedule( dynamic, 16 )
     for (magma_int_t j = 0; j < n; ++j) {
         magma_int_t nj = n - j;
         lapack::larfg( nj, U(j,j), U(j+1,j), 1, tau(j) );
@@ -464,10 +617,11 @@ void magma_generate_heev(
         // A = D*A*D row & column scaling
         Vector<real_t> D( n );
         real_t range = log( condD );
-        lapack::larnv( idist_rand, opts.iseed, n, D(0) );
+        magma_generate_rand( key, Stream::D, idist_rand, n, 1, D(0), n, real_t(1) );
         for (magma_int_t i = 0; i < n; ++i) {
             D[i] = exp( D[i] * range );
         }
+        #pragma omp parallel for schedule( static )
         for (magma_int_t j = 0; j < n; ++j) {
             for (magma_int_t i = 0; i < n; ++i) {
                 *A(i,j) = *A(i,j) * D[i] * D[j];
@@ -513,7 +667,7 @@ void magma_generate_geevx(
     Arguments
     ---------
     @param[in]
-    opts    MAGMA options. Uses matrix, cond, condD; see further details.
+    opts    MAGMA options. Uses matrix, cond, condD, iseed; see further details.
 
     @param[out]
     A       Complex array, dimension (lda, n).
@@ -536,6 +690,17 @@ void magma_generate_geevx(
     described below. By default, cond = sqrt( 1/eps ) = 6.7e7 for double.
     condD is for specialized eigenvalue and SVD tests; by default, condD = 1.
 
+    The `--seed` command line option sets the random seed, opts.iseed.
+    Random entries come from a counter-based generator (Philox4x32-10) and are
+    generated in parallel. For the rand, rands, and randn types, the matrix
+    depends only on the seed, not on the number of OpenMP threads. The svd,
+    poev, and heev types also apply Householder reflectors with LAPACK unmqr,
+    and `_dominant` sums rows and columns with BLAS asum; threaded BLAS may
+    round these differently for different numbers of threads. Each call
+    updates opts.iseed, so successive matrices differ. Testers draw their
+    other random operands (e.g., right-hand sides) with larnv on opts.iseed,
+    so they also follow `--seed`.
+
     Examples:
 
         ./testing_zgemm --matrix rand_small
@@ -806,11 +971,14 @@ void magma_generate_matrix(
         case MatrixType::rands:
         case MatrixType::randn: {
             magma_int_t idist = (magma_int_t) type;
-            magma_int_t sizeA = A.ld * A.n;
-            lapack::larnv( idist, opts.iseed, sizeA, A(0,0) );
-            if (sigma_max != 1) {
-                FloatT scale = blas::traits<FloatT>::make( sigma_max, 0 );
-                blas::scal( sizeA, scale, A(0,0), 1 );
+            uint32_t key[2];
+            philox_key( opts, key );
+            magma_generate_rand( key, Stream::matrix, idist, A.m, A.n,
+                                 A(0,0), A.ld, sigma_max );
+            // fill the padding too, as larnv over lda-by-n did
+            if (A.ld > A.m) {
+                magma_generate_rand( key, Stream::padding, idist, A.ld - A.m, A.n,
+                                     A(A.m,0), A.ld, sigma_max );
             }
             break;
         }
@@ -842,7 +1010,8 @@ void magma_generate_matrix(
 
     if (contains( name, "_dominant" )) {
         // make diagonally dominant; strict unless diagonal has zeros
-        for (int i = 0; i < minmn; ++i) {
+        #pragma omp parallel for schedule( static )
+        for (magma_int_t i = 0; i < minmn; ++i) {
             real_t sum = max( blas::asum( A.m, A(0,i), 1    ),    // i-th col
                               blas::asum( A.n, A(i,0), A.ld ) );  // i-th row
             *A(i,i) = blas::traits<FloatT>::make( sum, 0 );
@@ -850,6 +1019,8 @@ void magma_generate_matrix(
         // reset sigma to unknown (nan)
         lapack::laset( "general", sigma.n, 1, nan, nan, sigma(0), sigma.n );
     }
+
+    philox_next_key( opts );
 }
 
 
@@ -14,6 +14,8 @@
 #include <assert.h>
 #include <errno.h>
 
+#include <algorithm>
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -111,6 +113,12 @@ const char *usage =
 "                   (Some testers take --ngpu -1 to run the multi-GPU code with 1 GPU.\n"
 "  --nsub x         Number of submatrices, default 1.\n"
 "  --niter x        Number of iterations to repeat each test, default 1.\n"
+"  --nwarmup x      With --json, number of leading iterations of each test left\n"
+"                   out of the statistics, default 0.\n"
+"  --json file      Append one JSON line per test to file (- for stdout), with\n"
+"                   median and percentile times over the iterations. Supported by\n"
+"                   the gemm, getrf, getrf_gpu, gesv, potrf, potrf_gpu, geqrf,\n"
+"                   geqrf_gpu, heevd, and bulge_back testers; see run_compare.py.\n"
 "  --nthread x      Number of CPU threads for some experimental codes, default 1.\n"
 "                   (For most testers, set $OMP_NUM_THREADS or $MKL_NUM_THREADS\n"
 "                    to control the number of CPU threads.)\n"
@@ -151,6 +159,10 @@ const char *usage =
 "                   or 'rand_dominant' if SPD required (e.g., for posv).\n"
 "  --cond   kA      where applicable, condition number for test matrix, default sqrt( 1/eps ); see magma_generate_matrix.\n"
 "  --condD  kD      where applicable, condition number for scaling test matrix, default 1; see magma_generate_matrix.\n"
+"  --seed   x       seed for test matrices from magma_generate, default 0. The rand,\n"
+"                   rands, and randn matrices depend only on the seed, not on the\n"
+"                   number of threads; svd, poev, heev, and _dominant also use\n"
+"                   threaded BLAS, which may round differently per thread count.\n"
 "\n"
 "                   * default values\n";
 
@@ -176,6 +188,7 @@ magma_opts::magma_opts( magma_opts_t flag )
     this->itype    = 1;
     this->version  = 1;
     this->verbose  = 0;
+    this->nwarmup  = 0;
 
     this->fraction_lo = 0.;
     this->fraction_up = 1.;
@@ -208,6 +221,11 @@ magma_opts::magma_opts( magma_opts_t flag )
     this->iseed[2]  = 0;
     this->iseed[3]  = 1;
 
+    this->record_file = NULL;
+    this->record_size[0] = -1;
+    this->record_size[1] = -1;
+    this->record_size[2] = -1;
+
     if ( flag == MagmaOptsBatched ) {
         // 32, 64, ..., 512
         this->default_nstart = 32;
@@ -407,6 +425,14 @@ void magma_opts::parse_opts( int argc, char** argv )
             magma_assert( this->niter > 0,
                           "error: --niter %s is invalid; ensure niter > 0.\n", argv[i] );
         }
+        else if ( strcmp("--nwarmup", argv[i]) == 0 && i+1 < argc ) {
+            this->nwarmup = atoi( argv[++i] );
+            magma_assert( this->nwarmup >= 0,
+                          "error: --nwarmup %s is invalid; ensure nwarmup >= 0.\n", argv[i] );
+        }
+        else if ( strcmp("--json", argv[i]) == 0 && i+1 < argc ) {
+            this->json = argv[++i];
+        }
         else if ( strcmp("--nthread", argv[i]) == 0 && i+1 < argc ) {
             this->nthread = atoi( argv[++i] );
             magma_assert( this->nthread > 0,
@@ -597,6 +623,17 @@ void magma_opts::parse_opts( int argc, char** argv )
             magma_assert( this->condD >= 1,
                           "error: --condD %s is invalid; ensure condD >= 1.\n", argv[i] );
         }
+        else if ( strcmp("--seed", argv[i]) == 0 && i+1 < argc) {
+            i += 1;
+            long long seed = atoll( argv[i] );
+            magma_assert( seed >= 0 && seed < (1LL << 47),
+                          "error: --seed %s is invalid; ensure 0 <= seed < 2^47.\n", argv[i] );
+            // LAPACK seed: 4 entries < 4096, iseed[3] odd
+            this->iseed[3] = (seed % 2048)*2 + 1;  seed /= 2048;
+            this->iseed[2] =  seed % 4096;         seed /= 4096;
+            this->iseed[1] =  seed % 4096;         seed /= 4096;
+            this->iseed[0] =  seed;
+        }
 
         // ----- usage
         else if ( strcmp("-h",     argv[i]) == 0 ||
@@ -706,9 +743,27 @@ void magma_opts::get_range(
 }
 
 
+// -----------------------------------------------------------------------------
+magma_opts::~magma_opts()
+{
+    record_flush();
+    if ( this->record_file != NULL && this->record_file != stdout ) {
+        fclose( this->record_file );
+    }
+    this->record_file = NULL;
+}
+
+
 // -----------------------------------------------------------------------------
 void magma_opts::cleanup()
 {
+    record_flush();
+    // the file is opened on the first record, so this tester never recorded
+    if ( ! this->json.empty() && this->record_file == NULL ) {
+        fprintf( stderr, "warning: --json ignored; this tester does not record results"
+                         " (see --json in --help for supported testers)\n" );
+    }
+
     this->queue = NULL;
     magma_queue_destroy( this->queues2[0] );
     magma_queue_destroy( this->queues2[1] );
@@ -721,6 +776,132 @@ void magma_opts::cleanup()
 }
 
 
+// -----------------------------------------------------------------------------
+// With --json, records one run of a routine, e.g.,
+//     opts.record( "zgetrf", M, N, 0, gflops, gpu_time, error, okay );
+// gflop is the Gflop count, not the rate. error < 0 means not checked.
+// impl distinguishes implementations of the same test, e.g., "lapack".
+// Runs of each routine and impl are collected while the size (m, n, k) stays
+// the same, as over --niter; after the first --nwarmup runs, their times give
+// the median and percentiles in one JSON line per routine and impl, written
+// when the size changes, or by cleanup.
+void magma_opts::record(
+    const char* routine, magma_int_t m, magma_int_t n, magma_int_t k,
+    double gflop, double time, double error, bool okay, const char* impl )
+{
+    if ( this->json.empty() ) {
+        return;
+    }
+
+    if ( m != this->record_size[0] || n != this->record_size[1]
+                                    || k != this->record_size[2] ) {
+        record_flush();
+        this->record_size[0] = m;
+        this->record_size[1] = n;
+        this->record_size[2] = k;
+    }
+
+    char key[ 1024 ];
+    snprintf( key, sizeof(key),
+              "\"routine\": \"%s\", \"precision\": \"%c\", \"impl\": \"%s\", "
+              "\"m\": %lld, \"n\": %lld, \"k\": %lld",
+              routine, routine[0], impl, (long long) m, (long long) n, (long long) k );
+    size_t i = 0;
+    while ( i < this->records.size() && this->records[i].key != key ) {
+        ++i;
+    }
+    if ( i == this->records.size() ) {
+        record_t rec;
+        rec.key   = key;
+        rec.runs  = 0;
+        rec.gflop = gflop;
+        rec.error = -1;
+        rec.okay  = true;
+        this->records.push_back( rec );
+    }
+
+    record_t& rec = this->records[i];
+    rec.runs += 1;
+    if ( rec.runs > this->nwarmup ) {
+        rec.times.push_back( time );
+    }
+    rec.error = max( rec.error, error );
+    rec.okay  = rec.okay && okay;
+}
+
+
+// -----------------------------------------------------------------------------
+// Writes a JSON number, or null if x is Inf or NaN, which JSON lacks.
+static void record_number( FILE* file, const char* name, double x, const char* format="%.6g" )
+{
+    fprintf( file, "\"%s\": ", name );
+    if ( std::isfinite( x ) )
+        fprintf( file, format, x );
+    else
+        fprintf( file, "null" );
+    fprintf( file, ", " );
+}
+
+
+// -----------------------------------------------------------------------------
+// Writes the JSON lines of the runs collected by record(), if any.
+void magma_opts::record_flush()
+{
+    if ( this->records.empty() ) {
+        return;
+    }
+
+    if ( this->record_file == NULL ) {
+        if ( this->json == "-" ) {
+            this->record_file = stdout;
+        }
+        else {
+            this->record_file = fopen( this->json.c_str(), "a" );
+            if ( this->record_file == NULL ) {
+                fprintf( stderr, "error: cannot open --json %s: %s\n",
+                         this->json.c_str(), strerror( errno ));
+                exit(1);
+            }
+        }
+    }
+
+    for( size_t i = 0; i < this->records.size(); ++i ) {
+        record_t& rec = this->records[i];
+        std::vector< double >& times = rec.times;
+        if ( times.empty() ) {
+            continue;  // only warmup runs
+        }
+
+        // nearest-rank percentiles; median averages the middle two
+        std::sort( times.begin(), times.end() );
+        size_t cnt = times.size();
+        double median = (times[ (cnt-1)/2 ] + times[ cnt/2 ]) / 2;
+        double p10 = times[ (size_t) ceil( 0.10*cnt ) - 1 ];
+        double p90 = times[ (size_t) ceil( 0.90*cnt ) - 1 ];
+
+        fprintf( this->record_file,
+                 "{%s, \"ngpu\": %lld, \"nthread\": %lld, \"version\": %lld, \"nb\": %lld, "
+                 "\"niter\": %lld, \"nwarmup\": %lld, ",
+                 rec.key.c_str(),
+                 (long long) this->ngpu, (long long) this->nthread,
+                 (long long) this->version, (long long) this->nb,
+                 (long long) cnt, (long long) (rec.runs - cnt) );
+        record_number( this->record_file, "time",       median );
+        record_number( this->record_file, "time_min",   times[0] );
+        record_number( this->record_file, "time_p10",   p10 );
+        record_number( this->record_file, "time_p90",   p90 );
+        record_number( this->record_file, "time_max",   times[ cnt-1 ] );
+        record_number( this->record_file, "gflops",     rec.gflop / median );
+        record_number( this->record_file, "gflops_max", rec.gflop / times[0] );
+        record_number( this->record_file, "error",
+                       (rec.error >= 0 ? rec.error : NAN), "%.3e" );
+        fprintf( this->record_file, "\"okay\": %s}\n", (rec.okay ? "true" : "false") );
+    }
+    fflush( this->record_file );
+    this->records.clear();
+}
+
+
 // ------------------------------------------------------------
 // Initialize PAPI events set to measure flops.
 // Note flops counters are inaccurate on Sandy Bridge, and don't exist on Haswell.
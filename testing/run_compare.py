@@ -0,0 +1,151 @@
+#!/usr/bin/env python
+#
+# MAGMA (version 2.0) --
+# Univ. of Tennessee, Knoxville
+# Univ. of California, Berkeley
+# Univ. of Colorado, Denver
+# @date
+
+## @file run_compare.py
+#
+# Usage:
+# First run tests with --json, once for the baseline and once for the change:
+#     ./run_tests.py [options] --niter 5 --nwarmup 1 --json base.json
+#     ./testing_xyz  [options] --niter 5 --nwarmup 1 --json new.json
+#
+# Then compare their results:
+#     ./run_compare.py base.json new.json
+#
+# Only testers that call magma_opts::record write JSON; currently the gemm,
+# getrf, getrf_gpu, gesv, potrf, potrf_gpu, geqrf, geqrf_gpu, heevd, and
+# bulge_back testers, in all precisions. Other testers ignore --json with a
+# warning, so a run_tests.py --json file has lines only for these.
+#
+# Each JSON line, written by magma_opts::record, has the median time of a
+# routine and implementation (magma, lapack, ...) at one size, over the
+# iterations after warmup, and its 10th and 90th percentiles.
+# Lines of the two files are matched by routine, implementation, m, n, k,
+# ngpu, nthread, version, and nb; if a file has several lines for the same
+# test, the last one is used.
+#
+# A test is slower if its new median time exceeds the baseline median by more
+# than the noise, which is the larger of --threshold (default 5%) and the
+# relative spread (p90 - p10) / median of either run. Likewise for faster.
+# A test that passed its accuracy check in the baseline but fails in the new
+# run is also reported.
+#
+# Prints slower, faster, and failed tests (all tests with --all), and exits
+# with status 1 if any test is slower or failed, for use in scripts.
+
+from __future__ import print_function
+
+import sys
+import json
+
+from optparse import OptionParser
+
+parser = OptionParser( usage='%prog [options] baseline.json new.json' )
+parser.add_option( '--threshold', action='store', type=float, default=0.05,
+	help='minimum relative change of median time to report, default 0.05' )
+parser.add_option( '--all',       action='store_true', default=False,
+	help='print all matched tests, not only changed ones' )
+
+(opts, args) = parser.parse_args()
+if (len( args ) != 2):
+	parser.error( 'requires baseline and new JSON files' )
+
+keys = ('routine', 'impl', 'm', 'n', 'k', 'ngpu', 'nthread', 'version', 'nb')
+
+
+# --------------------
+# Returns dict of records, keyed by test, and list of keys in file order.
+def load( filename ):
+	records = {}
+	order   = []
+	with open( filename ) as f:
+		for (lineno, line) in enumerate( f, 1 ):
+			line = line.strip()
+			if (not line):
+				continue
+			try:
+				rec = json.loads( line )
+			except ValueError as ex:
+				print( '%s:%d: skipping invalid line: %s' % (filename, lineno, ex), file=sys.stderr )
+				continue
+			key = tuple( [ rec.get( k ) for k in keys ] )
+			if (key not in records):
+				order.append( key )
+			records[ key ] = rec
+	return (records, order)
+# end
+
+
+# --------------------
+# Returns relative spread of times, (p90 - p10) / median.
+def spread( rec ):
+	try:
+		return (rec['time_p90'] - rec['time_p10']) / rec['time']
+	except (KeyError, TypeError, ZeroDivisionError):
+		return 0.
+# end
+
+
+# --------------------
+(base, base_order) = load( args[0] )
+(new,  new_order ) = load( args[1] )
+
+slower  = 0
+faster  = 0
+failed  = 0
+same    = 0
+skipped = 0
+
+print( '%-16s %-8s %6s %6s %6s   %11s %11s   %7s %6s   %s'
+       % ('routine', 'impl', 'm', 'n', 'k', 'base (sec)', 'new (sec)', 'ratio', 'noise', 'status') )
+print( '=' * 100 )
+for key in new_order:
+	if (key not in base):
+		continue
+	b = base[ key ]
+	c = new [ key ]
+	if (not b.get( 'time' ) or c.get( 'time' ) is None):
+		skipped += 1
+		continue
+
+	ratio = c['time'] / b['time']
+	noise = max( opts.threshold, spread( b ), spread( c ) )
+	status = []
+	if (ratio > 1 + noise):
+		status.append( 'slower' )
+		slower += 1
+	elif (ratio < 1 / (1 + noise)):
+		status.append( 'faster' )
+		faster += 1
+	if (b.get( 'okay', True ) and not c.get( 'okay', True )):
+		status.append( 'failed' )
+		failed += 1
+	if (not status):
+		same += 1
+		if (not opts.all):
+			continue
+
+	print( '%-16s %-8s %6d %6d %6d   %11.4g %11.4g   %7.3f %5.1f%%   %s'
+	       % (b['routine'], b['impl'], b['m'], b['n'], b['k'],
+	          b['time'], c['time'], ratio, 100*noise,
+	          ', '.join( status ) or 'ok') )
+# end
+
+only_base = len( [ key for key in base_order if key not in new  ] )
+only_new  = len( [ key for key in new_order  if key not in base ] )
+
+print()
+print( '%6d tests slower'    % (slower) )
+print( '%6d tests faster'    % (faster) )
+print( '%6d tests failed accuracy check, but passed in baseline' % (failed) )
+print( '%6d tests unchanged, within noise' % (same) )
+if (skipped):
+	print( '%6d tests without times' % (skipped) )
+if (only_base or only_new):
+	print( '%6d tests only in baseline, %d only in new run' % (only_base, only_new) )
+
+sys.exit( 1 if (slower or failed) else 0 )
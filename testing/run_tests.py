@@ -209,6 +209,20 @@
 # For multi-GPU codes, --ngpu specifies the number of GPUs, default 2. Most
 # testers accept --ngpu -1 to test the multi-GPU code on a single GPU.
 # (Using --ngpu 1 will usually invoke the single-GPU code.)
+#
+# Performance results
+# -------------------
+# The --json option has the testers that support it (listed in run_compare.py;
+# others print a warning) append one JSON line per routine and size to the
+# given file, with the median time and Gflop/s over --niter runs, after the
+# first --nwarmup runs. The run_compare.py script compares such a file to a
+# baseline one, reporting slowdowns beyond the noise.
+# For example:
+#
+#       ./run_tests.py --lu --niter 5 --nwarmup 1 --json base.json testing_dgetrf
+#       (change and re-make MAGMA)
+#       ./run_tests.py --lu --niter 5 --nwarmup 1 --json new.json  testing_dgetrf
+#       ./run_compare.py base.json new.json
 
 import os
 import re
@@ -228,6 +242,8 @@ parser.add_option(      '--tol',        action='store',      help='set tolerance
 parser.add_option(      '--dev',        action='store',      help='set GPU device to use')
 parser.add_option(      '--batch',      action='store',      help='batch count for batched tests', default='100')
 parser.add_option(      '--niter',      action='store',      help='number of iterations to repeat', default='1')
+parser.add_option(      '--nwarmup',    action='store',      help='number of leading iterations left out of --json statistics', default='0')
+parser.add_option(      '--json',       action='store',      help='append JSON lines of performance results to given file; compare with run_compare.py')
 parser.add_option(      '--ngpu',       action='store',      help='number of GPUs for multi-GPU tests; add --mgpu to run only multi-GPU tests', default='2')
 parser.add_option(      '--interactive',action='store_true', help='stop between tests')
 
@@ -714,6 +730,8 @@ aux = (
 	('testing_constants',              '-c',  '',   ''),
 	('testing_operators',              '-c',  '',   ''),
 	('testing_parse_opts',             '-c',  '',   ''),
+	('testing_profile',                '-c',  '',   ''),
+	('testing_task_scheduler', '--nthread 4 -c',  n,    ''),
 )
 if (opts.aux):
 	tests += aux
@@ -966,6 +984,16 @@ syev = (
 	('#testing_zheevdx_2stage', '--fraction 1.0 -U -JN -c',  n,    'upper not implemented'),
 	('#testing_zheevdx_2stage', '--fraction 1.0 -U -JV -c',  n,    'upper not implemented'),
 
+	# bulge chasing, static vs. dynamic schedule
+	('testing_zhetrd_hb2st',    '-JN -c',  n,    ''),
+	('testing_zhetrd_hb2st',    '-JV -c',  n,    ''),
+
+	# bulge chasing kernels; -n is the bandwidth nb
+	('testing_zhbtype_perf',    '',  '-n 1:8:1 -n 16:128:16 -n 33 -n 65',  ''),
+
+	# back-transformation with the bulge chasing blocks on the CPU, static vs. dynamic schedule
+	('testing_zbulge_back',     '-c',  n,    ''),
+
 	# same tester for multi-GPU version
 	# TODO test multi-GPU version with ngpu=1
 	# TODO test with --fraction < 1; checks don't seem to work.
@@ -1605,6 +1633,8 @@ subs = (
 	('ssy',           'dsy',            'csy',           'zsy'           ),
 	('sor',           'dor',            'cun',           'zun'           ),
 	('sy2sb',         'sy2sb',          'he2hb',         'he2hb'         ),
+	('sb2st',         'sb2st',          'hb2st',         'hb2st'         ),
+	('sbtype',        'sbtype',         'hbtype',        'hbtype'        ),
 	('',              'testing_ds',     '',              'testing_zc'    ),
 	('testing_s',     'testing_d',      'testing_c',     'testing_z'     ),
 	('lansy',         'lansy',          'lanhe',         'lanhe'         ),
@@ -1683,6 +1713,12 @@ if (opts.dev is not None):
 if (int(opts.niter) != 1):
 	global_options += ' --niter ' + opts.niter + ' '
 
+if (int(opts.nwarmup) != 0):
+	global_options += ' --nwarmup ' + opts.nwarmup + ' '
+
+if (opts.json):
+	global_options += ' --json ' + os.path.abspath( opts.json ) + ' '
+
 last_cmd = None
 
 for test in tests:
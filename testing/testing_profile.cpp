@@ -0,0 +1,162 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+// includes, C++ (before testings.h, which defines max, min macros)
+#include <string>
+#include <thread>
+
+// includes, project
+#include "testings.h"
+
+// tests the profiling regions, so include internal header
+#include "../control/magma_timer.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// check( flag ) keeps tally in gStatus of tests that fail
+magma_int_t gStatus;
+
+void check_( bool flag, const char* msg, int line )
+{
+    if ( ! flag ) {
+        gStatus += 1;
+        printf( "line %d: %s failed\n", line, msg );
+    }
+}
+
+#define check( flag ) check_( flag, #flag, __LINE__ )
+
+
+// ---------------------------------------------
+// names that must be escaped in JSON
+static const char* quote_name   = "say \"hi\"\\ok";
+static const char* newline_name = "line\nbreak";
+
+// runs n outer regions, each with the inner regions
+void run_regions( int n )
+{
+    for( int i = 0; i < n; ++i ) {
+        timer_region outer( "outer" );
+        {
+            timer_region inner( quote_name );
+            volatile double s = 0;
+            for( int j = 0; j < 1000; ++j ) {
+                s += 1. / (j + 1);
+            }
+        }
+        timer_region_start( newline_name );
+        timer_region_stop();
+    }
+}
+
+
+// ---------------------------------------------
+// Returns the contents of file fname.
+std::string read_file( const char* fname )
+{
+    std::string str;
+    FILE* file = fopen( fname, "r" );
+    if ( file != NULL ) {
+        char buf[ 4096 ];
+        size_t len;
+        while( (len = fread( buf, 1, sizeof(buf), file )) > 0 ) {
+            str.append( buf, len );
+        }
+        fclose( file );
+    }
+    return str;
+}
+
+
+// ---------------------------------------------
+// Returns the value of field key in the JSON line of str starting at pos,
+// or -1 if not found.
+double get_field( const std::string& str, size_t pos, const char* key )
+{
+    size_t end = str.find( '\n', pos );
+    size_t k = str.find( std::string( "\"" ) + key + "\": ", pos );
+    if ( pos == std::string::npos || k == std::string::npos || k > end ) {
+        return -1;
+    }
+    return atof( str.c_str() + k + strlen( key ) + 4 );
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing timer_region, timer_region_report
+*/
+int main( int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    gStatus = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    // the profile state reads $MAGMA_PROFILE on first use
+    char fname[ 64 ];
+    snprintf( fname, sizeof(fname), "testing_profile_%d.json", (int) getpid() );
+    setenv( "MAGMA_PROFILE", fname, 1 );
+    unsetenv( "MAGMA_PROFILE_EVENTS" );
+
+    int n = 100;
+    std::thread thread( run_regions, n );
+    run_regions( n );
+    thread.join();
+    timer_region_report();
+
+    std::string str = read_file( fname );
+    check( str.compare( 0, 12, "{\"regions\": " ) == 0 );
+    check( str.size() >= 3 && str.compare( str.size() - 3, 3, "]}\n" ) == 0 );
+
+    // outer, merged over both threads
+    size_t pos = str.find( "{\"path\": \"outer\"," );
+    check( pos != std::string::npos );
+    check( get_field( str, pos, "depth"   ) == 1 );
+    check( get_field( str, pos, "threads" ) == 2 );
+    check( get_field( str, pos, "count"   ) == 2*n );
+
+    // percentiles are within the range of the durations
+    double tmin = get_field( str, pos, "min" );
+    double tmax = get_field( str, pos, "max" );
+    double p50  = get_field( str, pos, "p50" );
+    double p99  = get_field( str, pos, "p99" );
+    check( 0 < tmin && tmin <= tmax );
+    // p50, p99 printed with 3 digits
+    check( tmin*(1 - 5e-3) <= p50 && p50 <= p99 && p99 <= tmax*(1 + 5e-3) );
+
+    // escaped names
+    pos = str.find( "{\"path\": \"outer/say \\\"hi\\\"\\\\ok\"," );
+    check( pos != std::string::npos );
+    check( get_field( str, pos, "depth" ) == 2 );
+    check( get_field( str, pos, "count" ) == 2*n );
+    pos = str.find( "{\"path\": \"outer/line\\u000abreak\"," );
+    check( pos != std::string::npos );
+    check( str.find( "line\nbreak" ) == std::string::npos );
+
+    // the report resets the regions
+    timer_region_report();
+    str = read_file( fname );
+    check( str == "{\"regions\": [\n]}\n" );
+
+    remove( fname );
+
+    printf( "%s\n", (gStatus == 0 ? "ok" : "failed") );
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return gStatus;
+}
@@ -0,0 +1,204 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, C++ (before testings.h, which defines max, min macros)
+#include <atomic>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+
+// includes, project
+#include "testings.h"
+
+// tests internal classes magma_thread_queue and magma_task_scheduler,
+// so include internal headers
+#include "../control/task_scheduler.hpp"
+
+
+// ---------------------------------------------
+// task doing nb iterations of dummy work, to measure scheduling overhead
+class spin_task: public magma_task
+{
+public:
+    spin_task( magma_int_t in_nb, double* in_x ):
+        nb( in_nb ),
+        x ( in_x  )
+    {}
+
+    virtual void run()
+    {
+        double s = 0;
+        for( magma_int_t i=0; i < nb; ++i ) {
+            s += 1. / (i + 1);
+        }
+        if ( x != NULL ) {
+            *x += s;
+        }
+    }
+
+private:
+    magma_int_t nb;
+    double* x;
+};
+
+
+// ---------------------------------------------
+// task in 2D wavefront: sets grid(i,j) = max( grid(i-1,j), grid(i,j-1) ) + 1.
+// Result is i + j + 1 only if dependencies are respected.
+class wavefront_task: public magma_task
+{
+public:
+    wavefront_task( magma_int_t in_i, magma_int_t in_j, magma_int_t in_ld, magma_int_t* in_grid ):
+        i   ( in_i    ),
+        j   ( in_j    ),
+        ld  ( in_ld   ),
+        grid( in_grid )
+    {}
+
+    virtual void run()
+    {
+        magma_int_t up   = (i > 0 ? grid[ (i-1) + j*ld ] : 0);
+        magma_int_t left = (j > 0 ? grid[ i + (j-1)*ld ] : 0);
+        grid[ i + j*ld ] = max( up, left ) + 1;
+    }
+
+private:
+    magma_int_t i, j, ld;
+    magma_int_t* grid;
+};
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing magma_task_scheduler
+   Measures throughput of independent tasks in magma_thread_queue and
+   magma_task_scheduler, and of a 2D wavefront with dependencies.
+   Use -n for number of tasks, --nthread for threads, --nb for work per task.
+*/
+int main( int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    real_Double_t   queue_time, sched_time, wave_time;
+    magma_int_t ntask, nt, nb;
+    int status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    nb = opts.nb;  // default 0, empty tasks
+
+    magma_int_t lapack_nthread = magma_get_lapack_numthreads();
+    magma_set_lapack_numthreads( 1 );
+
+    printf( "%% nthread %lld, work per task %lld\n", (long long) opts.nthread, (long long) nb );
+    printf( "%%   ntask   queue Mtask/s (sec)     scheduler Mtask/s (sec)   wavefront Mtask/s (sec)   check\n" );
+    printf( "%%================================================================================================\n" );
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            ntask = opts.nsize[itest];
+            nt = magma_int_t( sqrt( double( ntask )));
+            if ( nt < 1 ) {
+                nt = 1;
+            }
+
+            magma_int_t* grid;
+            TESTING_CHECK( magma_imalloc_cpu( &grid, nt*nt ));
+            memset( grid, 0, nt*nt*sizeof(magma_int_t) );
+
+            /* =====================================================================
+               Performs operation using magma_thread_queue
+               =================================================================== */
+            {
+                magma_thread_queue queue;
+                queue.launch( opts.nthread );
+                queue_time = magma_wtime();
+                for( magma_int_t i=0; i < ntask; ++i ) {
+                    queue.push_task( new spin_task( nb, NULL ));
+                }
+                queue.sync();
+                queue_time = magma_wtime() - queue_time;
+            }
+
+            /* =====================================================================
+               Performs operation using magma_task_scheduler
+               =================================================================== */
+            {
+                magma_task_scheduler sched;
+                sched.launch( opts.nthread );
+                sched_time = magma_wtime();
+                for( magma_int_t i=0; i < ntask; ++i ) {
+                    sched.push_task( new spin_task( nb, NULL ));
+                }
+                sched.sync();
+                sched_time = magma_wtime() - sched_time;
+
+                // nt x nt wavefront; each task depends on its up and left neighbors
+                wave_time = magma_wtime();
+                for( magma_int_t j=0; j < nt; ++j ) {
+                    for( magma_int_t i=0; i < nt; ++i ) {
+                        magma_dep deps[3];
+                        magma_int_t ndep = 0;
+                        deps[ndep].tag  = &grid[ i + j*nt ];
+                        deps[ndep].mode = MagmaAccessOut;
+                        ++ndep;
+                        if ( i > 0 ) {
+                            deps[ndep].tag  = &grid[ (i-1) + j*nt ];
+                            deps[ndep].mode = MagmaAccessIn;
+                            ++ndep;
+                        }
+                        if ( j > 0 ) {
+                            deps[ndep].tag  = &grid[ i + (j-1)*nt ];
+                            deps[ndep].mode = MagmaAccessIn;
+                            ++ndep;
+                        }
+                        sched.push_task( new wavefront_task( i, j, nt, grid ), ndep, deps );
+                    }
+                }
+                sched.sync();
+                wave_time = magma_wtime() - wave_time;
+            }
+
+            /* =====================================================================
+               Check the result
+               =================================================================== */
+            magma_int_t nerror = 0;
+            for( magma_int_t j=0; j < nt; ++j ) {
+                for( magma_int_t i=0; i < nt; ++i ) {
+                    nerror += (grid[ i + j*nt ] != i + j + 1);
+                }
+            }
+            bool okay = (nerror == 0);
+            status += ! okay;
+
+            printf( "%9lld   %9.3f (%9.4f)   %9.3f (%9.4f)   %9.3f (%9.4f)   %s\n",
+                    (long long) ntask,
+                    ntask / queue_time / 1e6, queue_time,
+                    ntask / sched_time / 1e6, sched_time,
+                    nt*nt / wave_time  / 1e6, wave_time,
+                    (okay ? "ok" : "failed") );
+
+            magma_free_cpu( grid );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    magma_set_lapack_numthreads( lapack_nthread );
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -0,0 +1,191 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "flops.h"
+#include "magma_v2.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+#include "magma_bulge.h"
+#include "magma_zbulge.h"
+#include "../control/magma_threadsetting.h"  // internal header
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zbulge_back_cpu, the CPU back-transformation of the eigenvectors
+      with the Householder blocks of the bulge chasing (applyQ step of
+      magma_zbulge_back). The blocks come from magma_zhetrd_hb2st on a random
+      band matrix. Times the static and dynamic schedules applying Q2 to the
+      N-by-N identity, as for all eigenvectors, and reports their Gflop/s,
+      counting N^2 multiply-adds per column. With --check, verifies
+      A Q2 = Q2 T, with T the tridiagonal matrix from d and e.
+      Threads are --nthread if > 1, else magma_get_parallel_numthreads.
+      Usage: testing_zbulge_back -n 1000:10000:1000 [--nthread t] [-c]
+*/
+int main( int argc, char** argv)
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magmaDoubleComplex *h_A, *h_R, *V, *TAU, *T, *Z[2], *A, *R;
+    magmaDoubleComplex c_one = MAGMA_Z_ONE, c_zero = MAGMA_Z_ZERO;
+    double *d, *e;
+    real_Double_t gflops, time[2];
+    magma_int_t N, nb, lda2, Vblksiz, ldv, ldt, blkcnt, sizTAU2, sizT2, sizV2, info;
+    magma_int_t ione = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    int status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+    magma_int_t threads = (opts.nthread > 1 ? opts.nthread : magma_get_parallel_numthreads());
+    magma_bulge_schedule_t schedule_save = magma_get_bulge_schedule();
+    magma_set_bulge_numthreads( threads );
+
+    printf("%% threads %lld\n", (long long) threads );
+    printf("%%   N    nb   Static Gflop/s (sec)   Dynamic Gflop/s (sec)   Speedup   |Q-Q_static|   |AQ-QT|/(|A| N)\n");
+    printf("%%========================================================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            N  = opts.nsize[itest];
+            nb = magma_get_zbulge_nb( N, threads );
+            magma_zbulge_getlwstg2( N, threads, 1,
+                                    &Vblksiz, &ldv, &ldt, &blkcnt,
+                                    &sizTAU2, &sizT2, &sizV2 );
+            magma_bulge_getlwstg1( N, nb, &lda2 );
+            // N^2 multiply-adds per column of Z, as a gemm with k = N
+            gflops = FLOPS_ZGEMM( N, N, N ) / 1e9;
+
+            TESTING_CHECK( magma_zmalloc_cpu( &h_A, lda2*N ));
+            TESTING_CHECK( magma_zmalloc_cpu( &h_R, lda2*N ));
+            TESTING_CHECK( magma_zmalloc_cpu( &V,   max( 1, sizV2   )));
+            TESTING_CHECK( magma_zmalloc_cpu( &TAU, max( 1, sizTAU2 )));
+            TESTING_CHECK( magma_zmalloc_cpu( &T,   max( 1, sizT2   )));
+            TESTING_CHECK( magma_dmalloc_cpu( &d, N ));
+            TESTING_CHECK( magma_dmalloc_cpu( &e, N ));
+            for( int s = 0; s < 2; ++s ) {
+                TESTING_CHECK( magma_zmalloc_cpu( &Z[s], N*N ));
+            }
+
+            /* Initialize the lower band, nb sub-diagonals, with real diagonal */
+            memset( h_A, 0, lda2*N*sizeof(magmaDoubleComplex) );
+            for( magma_int_t j = 0; j < N; ++j ) {
+                magma_int_t len = min( nb+1, N-j );
+                lapackf77_zlarnv( &ione, ISEED, &len, &h_A[j*lda2] );
+                h_A[j*lda2] = MAGMA_Z_MAKE( MAGMA_Z_REAL( h_A[j*lda2] ), 0. );
+            }
+            lapackf77_zlacpy( MagmaFullStr, &lda2, &N, h_A, &lda2, h_R, &lda2 );
+            magma_zhetrd_hb2st( MagmaLower, N, nb, Vblksiz, h_R, lda2, d, e,
+                                V, ldv, TAU, 1, T, ldt );
+
+            // ===================================================================
+            // Performs operation using the static, then the dynamic schedule
+            // ===================================================================
+            for( int s = 0; s < 2; ++s ) {
+                magma_set_bulge_schedule( s == 0 ? MagmaBulgeStatic : MagmaBulgeDynamic );
+                lapackf77_zlaset( MagmaFullStr, &N, &N, &c_zero, &c_one, Z[s], &N );
+                time[s] = magma_wtime();
+                magma_zbulge_back_cpu( MagmaLower, N, nb, N, Vblksiz, Z[s], N,
+                                       V, ldv, TAU, T, ldt, &info );
+                time[s] = magma_wtime() - time[s];
+                if (info != 0) {
+                    printf("magma_zbulge_back_cpu returned error %lld: %s.\n",
+                           (long long) info, magma_strerror( info ));
+                }
+            }
+
+            double diff = 0;
+            for( magma_int_t i = 0; i < N*N; ++i ) {
+                diff = max( diff, MAGMA_Z_ABS( Z[0][i] - Z[1][i] ));
+            }
+
+            printf("%5lld %5lld   %7.2f (%9.4f)     %7.2f (%9.4f)     %7.2f   %10.2e",
+                   (long long) N, (long long) nb,
+                   gflops / time[0], time[0], gflops / time[1], time[1],
+                   time[0] / time[1], diff );
+
+            if ( opts.check ) {
+                // =================================================================
+                // Check A Q2 = Q2 T, with A the full Hermitian band matrix
+                // =================================================================
+                TESTING_CHECK( magma_zmalloc_cpu( &A, N*N ));
+                TESTING_CHECK( magma_zmalloc_cpu( &R, N*N ));
+                lapackf77_zlaset( MagmaFullStr, &N, &N, &c_zero, &c_zero, A, &N );
+                double anorm = 0;
+                for( magma_int_t j = 0; j < N; ++j ) {
+                    for( magma_int_t i = 0; i <= nb && i+j < N; ++i ) {
+                        A[(i+j) + j*N] = h_A[i + j*lda2];
+                        A[j + (i+j)*N] = MAGMA_Z_CONJ( h_A[i + j*lda2] );
+                        anorm = max( anorm, MAGMA_Z_ABS( h_A[i + j*lda2] ));
+                    }
+                }
+                blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &N, &N, &N,
+                               &c_one, A, &N, Z[1], &N, &c_zero, R, &N );
+
+                double err = 0;
+                for( magma_int_t j = 0; j < N; ++j ) {
+                    for( magma_int_t i = 0; i < N; ++i ) {
+                        magmaDoubleComplex qt = Z[1][i + j*N] * d[j];
+                        if (j > 0)
+                            qt += Z[1][i + (j-1)*N] * e[j-1];
+                        if (j < N-1)
+                            qt += Z[1][i + (j+1)*N] * e[j];
+                        err = max( err, MAGMA_Z_ABS( R[i + j*N] - qt ));
+                    }
+                }
+                err /= (anorm * N);
+                bool okay = (diff < tol && err < tol);
+                status += ! okay;
+                printf("   %10.2e   %s\n", err, (okay ? "ok" : "failed"));
+
+                magma_free_cpu( A );
+                magma_free_cpu( R );
+            }
+            else {
+                printf("     ---\n");
+            }
+            opts.record( "zbulge_back", N, N, 0, gflops, time[0], -1, true, "static" );
+            opts.record( "zbulge_back", N, N, 0, gflops, time[1], diff, diff < tol, "dynamic" );
+
+            magma_free_cpu( h_A );
+            magma_free_cpu( h_R );
+            magma_free_cpu( V   );
+            magma_free_cpu( TAU );
+            magma_free_cpu( T   );
+            magma_free_cpu( d );
+            magma_free_cpu( e );
+            for( int s = 0; s < 2; ++s ) {
+                magma_free_cpu( Z[s] );
+            }
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    magma_set_bulge_numthreads( 0 );  // restore default
+    magma_set_bulge_schedule( schedule_save );
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -43,7 +43,6 @@ int main( int argc, char** argv)
     magma_int_t ldda, lddb, lddx;
     magma_int_t M, N, nrhs, qrsv_iters, info, size, min_mn, max_mn, nb;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
 
     printf("%% Epsilon(double): %8.6e\n"
            "%% Epsilon(single): %8.6e\n\n",
@@ -110,7 +109,7 @@ int main( int argc, char** argv)
             
             // make random RHS
             size = ldb*nrhs;
-            lapackf77_zlarnv( &ione, ISEED, &size, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &size, h_B );
             lapackf77_zlacpy( MagmaFullStr, &M, &nrhs, h_B, &ldb, h_R, &ldb );
             
             magma_zsetmatrix( M, N,    h_A, lda, d_A, ldda, opts.queue );
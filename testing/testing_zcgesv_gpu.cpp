@@ -38,7 +38,6 @@ int main(int argc, char **argv)
     magma_int_t ldda, lddb, lddx;
     magma_int_t N, nrhs, gesv_iter, info, size;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
 
     printf("%% Epsilon(double): %8.6e\n"
            "%% Epsilon(single): %8.6e\n\n",
@@ -93,7 +92,7 @@ int main(int argc, char **argv)
             /* Initialize matrices */
             magma_generate_matrix( opts, N, N, h_A, lda );
             size = ldb * nrhs;
-            lapackf77_zlarnv( &ione, ISEED, &size, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &size, h_B );
             lapackf77_zlacpy( MagmaFullStr, &N, &nrhs, h_B, &ldb, h_X, &ldx);
             
             magma_zsetmatrix( N, N,    h_A, lda, d_A, ldda, opts.queue );
@@ -36,7 +36,6 @@ int main(int argc, char **argv)
     magma_int_t lda, ldb, ldx;
     magma_int_t N, nrhs, posv_iter, info, size;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
     
     printf("%% Epsilon(double): %8.6e\n"
            "%% Epsilon(single): %8.6e\n\n",
@@ -78,7 +77,7 @@ int main(int argc, char **argv)
             magma_generate_matrix( opts, N, N, h_A, lda );
             
             size = ldb * nrhs;
-            lapackf77_zlarnv( &ione, ISEED, &size, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &size, h_B );
             
             magma_zsetmatrix( N, N,    h_A, lda, d_A, lda, opts.queue );
             magma_zsetmatrix( N, nrhs, h_B, ldb, d_B, ldb, opts.queue );
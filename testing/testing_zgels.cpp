@@ -38,7 +38,6 @@ int main( int argc, char** argv )
     magma_int_t M, N, size, nrhs, lda, ldb, min_mn, max_mn, nb, info;
     magma_int_t lhwork;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
 
     magma_opts opts;
     opts.parse_opts( argc, argv );
@@ -90,7 +89,7 @@ int main( int argc, char** argv )
             
             // make random RHS
             size = ldb*nrhs;
-            lapackf77_zlarnv( &ione, ISEED, &size, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &size, h_B );
             lapackf77_zlacpy( MagmaFullStr, &M, &nrhs, h_B, &ldb, h_R , &ldb );
             lapackf77_zlacpy( MagmaFullStr, &M, &nrhs, h_B, &ldb, h_B2, &ldb );
             
@@ -39,7 +39,6 @@ int main( int argc, char** argv )
     magma_int_t M, N, size, nrhs, lda, ldb, ldda, lddb, min_mn, max_mn, nb, info;
     magma_int_t lworkgpu, lhwork;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
 
     magma_opts opts;
     opts.parse_opts( argc, argv );
@@ -97,12 +96,12 @@ int main( int argc, char** argv )
             
             // make random RHS
             size = ldb*nrhs;
-            lapackf77_zlarnv( &ione, ISEED, &size, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &size, h_B );
             lapackf77_zlacpy( MagmaFullStr, &M, &nrhs, h_B, &ldb, h_R, &ldb );
             
             // make consistent RHS
             //size = N*nrhs;
-            //lapackf77_zlarnv( &ione, ISEED, &size, h_X );
+            //lapackf77_zlarnv( &ione, opts.iseed, &size, h_X );
             //blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &M, &nrhs, &N,
             //               &c_one,  h_A, &lda,
             //                        h_X, &ldb,
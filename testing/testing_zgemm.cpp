@@ -223,6 +223,8 @@ int main( int argc, char** argv)
                            cpu_perf,    1000.*cpu_time,
                            magma_error, dev_error,
                            (okay ? "ok" : "failed"));
+                    opts.record( "zgemm", M, N, K, gflops, magma_time, magma_error, magma_error < tol );
+                    opts.record( "zgemm", M, N, K, gflops, dev_time,   dev_error,   dev_error   < tol, "device" );
                 #else
                     bool okay = (dev_error < tol);
                     status += ! okay;
@@ -232,7 +234,9 @@ int main( int argc, char** argv)
                            cpu_perf,    1000.*cpu_time,
                            dev_error,
                            (okay ? "ok" : "failed"));
+                    opts.record( "zgemm", M, N, K, gflops, dev_time, dev_error, okay, "device" );
                 #endif
+                opts.record( "zgemm", M, N, K, gflops, cpu_time, -1, true, "lapack" );
             }
             else {
                 #if defined(MAGMA_HAVE_CUDA) || defined(MAGMA_HAVE_HIP)
@@ -250,10 +254,13 @@ int main( int argc, char** argv)
                            dev_perf,    1000.*dev_time,
                            magma_error,
                            (okay ? "ok" : "failed"));
+                    opts.record( "zgemm", M, N, K, gflops, magma_time, magma_error, okay );
+                    opts.record( "zgemm", M, N, K, gflops, dev_time, -1, true, "device" );
                 #else
                     printf("%5lld %5lld %5lld   %7.2f (%7.2f)     ---   (  ---  )       ---\n",
                            (long long) M, (long long) N, (long long) K,
                            dev_perf,    1000.*dev_time );
+                    opts.record( "zgemm", M, N, K, gflops, dev_time, -1, true, "device" );
                 #endif
             }
 
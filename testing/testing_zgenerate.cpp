@@ -9,7 +9,10 @@
 
        @author Mark Gates
 */
+#include <string.h>
+
 #include "testings.h"
+#include "../control/magma_threadsetting.h"  // internal header
 
 /******************************************************************************/
 int main( int argc, char** argv )
@@ -22,12 +25,20 @@ int main( int argc, char** argv )
     // locals
     real_Double_t time, time2;
     magma_int_t m, n, minmn, lda;
+    magma_int_t iseed[4];
+    int status = 0;
 
     magma_opts opts;
     opts.parse_opts( argc, argv );
 
     printf( "%% * cond and condD are not applicable to all matrix types.\n" );
-    printf( "%%     M     N       cond*      condD*   CPU time (sec)   time2 (sec)   Matrix\n" );
+    printf( "%% For rand, rands, randn, the matrix is regenerated with 1 thread and compared\n"
+            "%% bitwise (repro); other types go through threaded BLAS, which may round differently.\n" );
+    printf( "%%     M     N       cond*      condD*   CPU time (sec)   time2 (sec)   repro   Matrix\n" );
+    magma_int_t nthread = magma_get_omp_numthreads();
+    // only these types are generated without BLAS or LAPACK calls
+    bool repro = (opts.matrix.compare( 0, 4, "rand" ) == 0
+                  && opts.matrix.find( "_dominant" ) == std::string::npos);
     for( int itest = 0; itest < opts.ntest; ++itest ) {
         for( int iter = 0; iter < opts.niter; ++iter ) {
             double cond = opts.cond;
@@ -39,19 +50,36 @@ int main( int argc, char** argv )
             lda = m;
             minmn = min( m, n );
             Matrix<magmaDoubleComplex> A( m, n, lda );
+            Matrix<magmaDoubleComplex> B( m, n, lda );
             Vector<double> sigma( minmn );
 
             time2 = magma_wtime();
             magma_generate_matrix( opts, A, sigma );
             time2 = magma_wtime() - time2;
 
+            memcpy( iseed, opts.iseed, sizeof(iseed) );
             time = magma_wtime();
             magma_generate_matrix( opts, A.m, A.n, A(0,0), A.ld, sigma(0) );
             time = magma_wtime() - time;
 
-            printf( "%% %5lld %5lld   %9.2e   %9.2e   %9.4f     %9.4f        %s\n",
+            // same seed with 1 thread gives the same matrix
+            bool okay = true;
+            if (repro) {
+                memcpy( opts.iseed, iseed, sizeof(iseed) );
+                magma_set_omp_numthreads( 1 );
+                magma_generate_matrix( opts, B.m, B.n, B(0,0), B.ld, sigma(0) );
+                magma_set_omp_numthreads( nthread );
+                for (magma_int_t j = 0; j < n; ++j) {
+                    okay = okay && (memcmp( A(0,j), B(0,j), m*sizeof(magmaDoubleComplex) ) == 0);
+                }
+                status += ! okay;
+            }
+
+            printf( "%% %5lld %5lld   %9.2e   %9.2e   %9.4f     %9.4f      %-6s  %s\n",
                     (long long) m, (long long) n,
-                    cond, opts.condD, time, time2, opts.matrix.c_str() );
+                    cond, opts.condD, time, time2,
+                    (! repro ? "---" : okay ? "ok" : "failed"),
+                    opts.matrix.c_str() );
 
             if (opts.verbose) {
                 printf( "sigma = " ); magma_dprint( 1, minmn, sigma(0), 1 );
@@ -60,5 +88,7 @@ int main( int argc, char** argv )
         }
     }
 
+    opts.cleanup();
     TESTING_CHECK( magma_finalize() );
+    return status;
 }
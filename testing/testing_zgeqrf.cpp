@@ -167,6 +167,16 @@ int main( int argc, char** argv)
             else {
                 printf( "    ---\n" );
             }
+            if ( opts.lapack ) {
+                opts.record( "zgeqrf", M, N, 0, gflops, cpu_time, -1, true, "lapack" );
+            }
+            if ( opts.check ) {
+                opts.record( "zgeqrf", M, N, 0, gflops, gpu_time, max( error, error2 ),
+                             error < tol && error2 < tol );
+            }
+            else {
+                opts.record( "zgeqrf", M, N, 0, gflops, gpu_time );
+            }
             
             magma_free_cpu( tau    );
             magma_free_cpu( h_A    );
@@ -39,7 +39,6 @@ int main( int argc, char** argv)
     magmaDoubleComplex *h_A, *h_R, *tau, *h_work, tmp[1], unused[1];
     magmaDoubleComplex_ptr d_A, dT;
     magma_int_t M, N, n2, lda, ldda, lwork, info, min_mn, nb, size;
-    magma_int_t ISEED[4] = {0,0,0,1};
     
     magma_opts opts;
     opts.parse_opts( argc, argv );
@@ -198,7 +197,7 @@ int main( int argc, char** argv)
                 // initialize RHS, b = A*random
                 TESTING_CHECK( magma_zmalloc_cpu( &x, N ));
                 TESTING_CHECK( magma_zmalloc_cpu( &b, M ));
-                lapackf77_zlarnv( &ione, ISEED, &N, x );
+                lapackf77_zlarnv( &ione, opts.iseed, &N, x );
                 blasf77_zgemv( "Notrans", &M, &N, &c_one, h_A, &lda, x, &ione, &c_zero, b, &ione );
                 // copy to GPU
                 TESTING_CHECK( magma_zmalloc( &d_B, M ));
@@ -307,6 +306,19 @@ int main( int argc, char** argv)
             else {
                 printf( "    ---\n" );
             }
+            if ( opts.lapack ) {
+                opts.record( "zgeqrf_gpu", M, N, 0, gflops, cpu_time, -1, true, "lapack" );
+            }
+            if ( opts.check == 1 ) {
+                opts.record( "zgeqrf_gpu", M, N, 0, gflops, gpu_time, max( error, error2 ),
+                             error < tol && error2 < tol );
+            }
+            else if ( opts.check == 2 && M >= N ) {
+                opts.record( "zgeqrf_gpu", M, N, 0, gflops, gpu_time, error, error < tol );
+            }
+            else {
+                opts.record( "zgeqrf_gpu", M, N, 0, gflops, gpu_time );
+            }
             
             magma_free_cpu( tau    );
             magma_free_cpu( h_A    );
@@ -36,7 +36,6 @@ int main(int argc, char **argv)
     magma_int_t *ipiv;
     magma_int_t N, nrhs, lda, ldb, info, sizeB;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
     int status = 0;
     
     magma_opts opts;
@@ -73,7 +72,7 @@ int main(int argc, char **argv)
             //sizeA = lda*N;
             sizeB = ldb*nrhs;
             magma_generate_matrix( opts, N, N, h_A, lda );
-            lapackf77_zlarnv( &ione, ISEED, &sizeB, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &sizeB, h_B );
             
             // copy A to LU and B to X; save A and B for residual
             lapackf77_zlacpy( "F", &N, &N,    h_A, &lda, h_LU, &lda );
@@ -138,12 +137,14 @@ int main(int argc, char **argv)
                         (long long) N, (long long) nrhs, cpu_perf, cpu_time, gpu_perf, gpu_time,
                         error, (okay ? "ok" : "failed"),
                         lerror, (lokay ? "ok" : "failed"));
+                opts.record( "zgesv", N, N, nrhs, gflops, cpu_time, lerror, lokay, "lapack" );
             }
             else {
                 printf( "%5lld %5lld     ---   (  ---  )   %7.2f (%7.2f)   %8.2e   %s\n",
                         (long long) N, (long long) nrhs, gpu_perf, gpu_time,
                         error, (okay ? "ok" : "failed"));
             }
+            opts.record( "zgesv", N, N, nrhs, gflops, gpu_time, error, okay );
             
             magma_free_cpu( h_A  );
             magma_free_cpu( h_LU );
@@ -37,7 +37,6 @@ int main(int argc, char **argv)
     magma_int_t *ipiv;
     magma_int_t N, nrhs, lda, ldb, ldda, lddb, info, sizeB;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
     int status = 0;
     
     magma_opts opts;
@@ -71,7 +70,7 @@ int main(int argc, char **argv)
             //sizeA = lda*N;
             sizeB = ldb*nrhs;
             magma_generate_matrix( opts, N, N, h_A, lda );
-            lapackf77_zlarnv( &ione, ISEED, &sizeB, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &sizeB, h_B );
             
             magma_zsetmatrix( N, N,    h_A, lda, d_A, ldda, opts.queue );
             magma_zsetmatrix( N, nrhs, h_B, ldb, d_B, lddb, opts.queue );
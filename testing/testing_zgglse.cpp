@@ -39,7 +39,6 @@ int main( int argc, char** argv )
     magma_int_t M, N, size, P, lda, ldb, nb, info;
     magma_int_t lhwork;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
 
     magma_opts opts;
     opts.parse_opts( argc, argv );
@@ -95,13 +94,13 @@ int main( int argc, char** argv )
             
             // make random RHS
             size = ldb*N;
-            lapackf77_zlarnv( &ione, ISEED, &size, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &size, h_B );
             lapackf77_zlacpy( MagmaFullStr, &P, &N, h_B, &ldb, h_R , &ldb );
             lapackf77_zlacpy( MagmaFullStr, &P, &N, h_B, &ldb, h_B2, &ldb );
 
-            lapackf77_zlarnv( &ione, ISEED, &M, h_c );
-            lapackf77_zlarnv( &ione, ISEED, &P, h_d );
-            lapackf77_zlarnv( &ione, ISEED, &N, h_x );
+            lapackf77_zlarnv( &ione, opts.iseed, &M, h_c );
+            lapackf77_zlarnv( &ione, opts.iseed, &P, h_d );
+            lapackf77_zlarnv( &ione, opts.iseed, &N, h_x );
             lapackf77_zlacpy( MagmaFullStr, &M, &ione, h_c, &M, h_c2, &M );
             lapackf77_zlacpy( MagmaFullStr, &P, &ione, h_d, &P, h_d2, &P );
             lapackf77_zlacpy( MagmaFullStr, &N, &ione, h_x, &N, h_x2, &N );
@@ -0,0 +1,245 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+#include "magma_bulge.h"
+
+#define A(m,n)   (A + lda * (n) + ((m)-(n)))
+
+
+// reference: zhemv, zdotc, zaxpy, zher2 sequence formerly used by magma_zlarfy
+static void
+ref_zlarfy(
+    magma_int_t n,
+    magmaDoubleComplex *A, magma_int_t lda,
+    const magmaDoubleComplex *V, const magmaDoubleComplex *TAU,
+    magmaDoubleComplex *work)
+{
+    const magma_int_t ione = 1;
+    const magmaDoubleComplex c_zero    = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    const magmaDoubleComplex c_half    = MAGMA_Z_HALF;
+    magmaDoubleComplex dtmp;
+
+    blasf77_zhemv( "L", &n, TAU, A, &lda, V, &ione, &c_zero, work, &ione );
+    dtmp = magma_cblas_zdotc( n, work, ione, V, ione );
+    dtmp = -dtmp * c_half * (*TAU);
+    blasf77_zaxpy( &n, &dtmp, V, &ione, work, &ione );
+    blasf77_zher2( "L", &n, &c_neg_one, work, &ione, V, &ione, A, &lda );
+}
+
+
+// reference: former magma_zhbtype1cb for wantz = 0
+static void
+ref_zhbtype1cb(
+    magma_int_t n, magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *V, magmaDoubleComplex *TAU,
+    magma_int_t st, magma_int_t ed, magma_int_t sweep, magmaDoubleComplex *work)
+{
+    magma_int_t ione = 1;
+    magma_int_t vpos = (sweep%2)*n + st;
+    magma_int_t len  = ed-st+1;
+    V[vpos] = MAGMA_Z_ONE;
+    memcpy( &V[vpos+1], A(st+1, st-1), (len-1)*sizeof(magmaDoubleComplex) );
+    memset( A(st+1, st-1), 0, (len-1)*sizeof(magmaDoubleComplex) );
+    lapackf77_zlarfg( &len, A(st, st-1), &V[vpos+1], &ione, &TAU[vpos] );
+    ref_zlarfy( len, A(st,st), lda-1, &V[vpos], &TAU[vpos], work );
+}
+
+
+// reference: former magma_zhbtype2cb for wantz = 0
+static void
+ref_zhbtype2cb(
+    magma_int_t n, magma_int_t nb, magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *V, magmaDoubleComplex *TAU,
+    magma_int_t st, magma_int_t ed, magma_int_t sweep, magmaDoubleComplex *work)
+{
+    magma_int_t ione = 1;
+    magma_int_t vpos = (sweep%2)*n + st;
+    magma_int_t ldx  = lda-1;
+    magma_int_t J1   = ed+1;
+    magma_int_t J2   = min( ed+nb, n-1 );
+    magma_int_t len  = ed-st+1;
+    magma_int_t lem  = J2-J1+1;
+    magmaDoubleComplex ctmp;
+
+    if ( lem > 0 ) {
+        lapackf77_zlarfx( "R", &lem, &len, &V[vpos], &TAU[vpos], A(J1, st), &ldx, work );
+    }
+    if ( lem > 1 ) {
+        vpos = (sweep%2)*n + J1;
+        V[vpos] = MAGMA_Z_ONE;
+        memcpy( &V[vpos+1], A(J1+1, st), (lem-1)*sizeof(magmaDoubleComplex) );
+        memset( A(J1+1, st), 0, (lem-1)*sizeof(magmaDoubleComplex) );
+        lapackf77_zlarfg( &lem, A(J1, st), &V[vpos+1], &ione, &TAU[vpos] );
+        len  = len-1;
+        ctmp = MAGMA_Z_CONJ( TAU[vpos] );
+        lapackf77_zlarfx( "L", &lem, &len, &V[vpos], &ctmp, A(J1, st+1), &ldx, work );
+    }
+}
+
+
+// reference: former magma_zhbtype3cb for wantz = 0
+static void
+ref_zhbtype3cb(
+    magma_int_t n, magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *V, magmaDoubleComplex *TAU,
+    magma_int_t st, magma_int_t ed, magma_int_t sweep, magmaDoubleComplex *work)
+{
+    magma_int_t vpos = (sweep%2)*n + st;
+    magma_int_t len  = ed-st+1;
+    ref_zlarfy( len, A(st,st), lda-1, &V[vpos], &TAU[vpos], work );
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing performance of the bulge chasing kernels magma_zhbtype{1,2,3}cb
+      against the former LAPACK/BLAS based kernels, for the first three tasks
+      of a sweep. Here -n gives the bandwidth nb. The fused vector kernels
+      are compiled only with AVX2 and FMA, or AVX-512; otherwise the kernels
+      are the former ones and the speedup is about 1.
+      Usage: testing_zhbtype_perf -n 32:128:16 [--niter k]
+*/
+int main( int argc, char** argv)
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magmaDoubleComplex *h_A, *A, *V, *TAU, *work;
+    magmaDoubleComplex *Aref, *Vref, *TAUref;
+    real_Double_t t_new[3], t_ref[3], t;
+    magma_int_t nb, n, lda, sizeA, nrepeat;
+    magma_int_t ione = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    int status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+
+    printf("%%                    type1cb             type2cb             type3cb\n");
+    printf("%%  nb         ref (us)  new (us)  ref (us)  new (us)  ref (us)  new (us)   Speedup   Error\n");
+    printf("%%=======================================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            nb    = opts.nsize[itest];
+            n     = 3*nb + 1;
+            lda   = 2*nb;
+            sizeA = lda*n;
+            // about 1e8 flops per kernel, so timings are above timer resolution
+            nrepeat = max( 10, 100000000 / (8*nb*nb*nb + 1) );
+
+            TESTING_CHECK( magma_zmalloc_cpu( &h_A,    sizeA ));
+            TESTING_CHECK( magma_zmalloc_cpu( &A,      sizeA ));
+            TESTING_CHECK( magma_zmalloc_cpu( &Aref,   sizeA ));
+            TESTING_CHECK( magma_zmalloc_cpu( &V,      2*n ));
+            TESTING_CHECK( magma_zmalloc_cpu( &Vref,   2*n ));
+            TESTING_CHECK( magma_zmalloc_cpu( &TAU,    2*n ));
+            TESTING_CHECK( magma_zmalloc_cpu( &TAUref, 2*n ));
+            TESTING_CHECK( magma_zmalloc_cpu( &work,   nb ));
+
+            /* Initialize the lower band, nb sub-diagonals, with real diagonal */
+            memset( h_A, 0, sizeA*sizeof(magmaDoubleComplex) );
+            for( magma_int_t j = 0; j < n; ++j ) {
+                magma_int_t len = min( nb+1, n-j );
+                lapackf77_zlarnv( &ione, ISEED, &len, &h_A[j*lda] );
+                h_A[j*lda] = MAGMA_Z_MAKE( MAGMA_Z_REAL( h_A[j*lda] ), 0. );
+            }
+            memset( V,      0, 2*n*sizeof(magmaDoubleComplex) );
+            memset( Vref,   0, 2*n*sizeof(magmaDoubleComplex) );
+            memset( TAU,    0, 2*n*sizeof(magmaDoubleComplex) );
+            memset( TAUref, 0, 2*n*sizeof(magmaDoubleComplex) );
+
+            // ===================================================================
+            // Tasks 1, 2, 3 of sweep 0, as in magma_zhetrd_hb2st
+            // ===================================================================
+            for( int k = 0; k < 3; ++k ) {
+                t_new[k] = 0;
+                t_ref[k] = 0;
+            }
+            for( magma_int_t r = 0; r < nrepeat; ++r ) {
+                memcpy( Aref, h_A, sizeA*sizeof(magmaDoubleComplex) );
+                t = magma_wtime();
+                ref_zhbtype1cb( n, Aref, lda, Vref, TAUref, 1, nb, 0, work );
+                t_ref[0] += magma_wtime() - t;
+                t = magma_wtime();
+                ref_zhbtype2cb( n, nb, Aref, lda, Vref, TAUref, 1, nb, 0, work );
+                t_ref[1] += magma_wtime() - t;
+                t = magma_wtime();
+                ref_zhbtype3cb( n, Aref, lda, Vref, TAUref, nb+1, 2*nb, 0, work );
+                t_ref[2] += magma_wtime() - t;
+
+                memcpy( A, h_A, sizeA*sizeof(magmaDoubleComplex) );
+                t = magma_wtime();
+                magma_zhbtype1cb( n, nb, A, lda, V, 0, TAU, 1, nb, 0, 0, 0, work );
+                t_new[0] += magma_wtime() - t;
+                t = magma_wtime();
+                magma_zhbtype2cb( n, nb, A, lda, V, 0, TAU, 1, nb, 0, 0, 0, work );
+                t_new[1] += magma_wtime() - t;
+                t = magma_wtime();
+                magma_zhbtype3cb( n, nb, A, lda, V, 0, TAU, nb+1, 2*nb, 0, 0, 0, work );
+                t_new[2] += magma_wtime() - t;
+            }
+
+            // relative difference of the resulting band, reflectors, and tau
+            double err = 0, nrm = 0;
+            for( magma_int_t i = 0; i < sizeA; ++i ) {
+                err = max( err, fabs( A[i] - Aref[i] ));
+                nrm = max( nrm, fabs( Aref[i] ));
+            }
+            for( magma_int_t i = 0; i < 2*n; ++i ) {
+                err = max( err, fabs( V[i]   - Vref[i]   ));
+                err = max( err, fabs( TAU[i] - TAUref[i] ));
+            }
+            err /= (nrm * nb);
+            bool okay = (err < tol);
+            status += ! okay;
+
+            real_Double_t total_ref = t_ref[0] + t_ref[1] + t_ref[2];
+            real_Double_t total_new = t_new[0] + t_new[1] + t_new[2];
+            printf("%5lld       %8.2f  %8.2f  %8.2f  %8.2f  %8.2f  %8.2f   %7.2f   %8.2e   %s\n",
+                   (long long) nb,
+                   1e6*t_ref[0]/nrepeat, 1e6*t_new[0]/nrepeat,
+                   1e6*t_ref[1]/nrepeat, 1e6*t_new[1]/nrepeat,
+                   1e6*t_ref[2]/nrepeat, 1e6*t_new[2]/nrepeat,
+                   total_ref / total_new, err, (okay ? "ok" : "failed"));
+
+            magma_free_cpu( h_A    );
+            magma_free_cpu( A      );
+            magma_free_cpu( Aref   );
+            magma_free_cpu( V      );
+            magma_free_cpu( Vref   );
+            magma_free_cpu( TAU    );
+            magma_free_cpu( TAUref );
+            magma_free_cpu( work   );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
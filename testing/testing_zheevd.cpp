@@ -424,6 +424,14 @@ int main( int argc, char** argv)
             printf("   %s\n", (okay ? "ok" : "failed"));
             status += ! okay;
             
+            // no flop count, as it depends on the eigenvalue distribution
+            if ( opts.lapack ) {
+                opts.record( "zheevd", N, N, 0, 0, cpu_time, -1, true, "lapack" );
+            }
+            opts.record( "zheevd", N, N, 0, 0, gpu_time,
+                         (opts.check && opts.jobz != MagmaNoVec
+                             ? max( result[0], result[1] ) : -1), okay );
+            
             magma_free_cpu( h_A   );
             magma_free_cpu( w1    );
             magma_free_cpu( w2    );
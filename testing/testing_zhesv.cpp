@@ -92,11 +92,13 @@ int main( int argc, char** argv)
     magma_int_t     *ipiv;
     magma_int_t     N, n2, lda, ldb, sizeB, lwork, info;
     magma_int_t     ione = 1;
-    magma_int_t     ISEED[4] = {0,0,0,1};
     int status = 0;
 
     magma_opts opts;
     opts.parse_opts( argc, argv );
+
+    // copy opts.iseed, as get_residual regenerates A from it
+    magma_int_t ISEED[4] = { opts.iseed[0], opts.iseed[1], opts.iseed[2], opts.iseed[3] };
     
     double tol = opts.tolerance * lapackf77_dlamch("E");
 
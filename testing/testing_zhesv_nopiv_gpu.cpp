@@ -39,7 +39,6 @@ int main(int argc, char **argv)
     magma_int_t *ipiv;
     magma_int_t N, nrhs, lda, ldb, ldda, lddb, info, sizeB, lwork;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
     int status = 0;
     
     magma_opts opts;
@@ -73,7 +72,7 @@ int main(int argc, char **argv)
             //sizeA = lda*N;
             sizeB = ldb*nrhs;
             magma_generate_matrix( opts, N, N, h_A, lda );
-            lapackf77_zlarnv( &ione, ISEED, &sizeB, h_B );
+            lapackf77_zlarnv( &ione, opts.iseed, &sizeB, h_B );
             
             bool nopiv = true;
             if ( nopiv ) {
@@ -0,0 +1,170 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magma_lapack.h"
+#include "testings.h"
+
+#include "magma_bulge.h"
+#include "../control/magma_threadsetting.h"  // internal header
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zhetrd_hb2st, the bulge chasing of the 2-stage eigensolvers.
+      Times the static and dynamic schedules on the same random band matrix
+      and reports the speedup of the dynamic schedule. Both schedules do the
+      same operations in the same order per tile, so d and e must agree
+      exactly. With --check, eigenvalues are compared to LAPACK zhbtrd.
+      Threads are --nthread if > 1, else magma_get_parallel_numthreads.
+      Usage: testing_zhetrd_hb2st -n 4000:40000:4000 [--nthread t] [-JV] [-c]
+*/
+int main( int argc, char** argv)
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magmaDoubleComplex *h_A, *h_R, *V, *TAU, *T, *work, unused[1];
+    double *d[2], *e[2], *dref, *eref;
+    real_Double_t time[2];
+    magma_int_t N, nb, lda2, ldab, Vblksiz, ldv, ldt, blkcnt, sizTAU2, sizT2, sizV2, info;
+    magma_int_t ione = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    int status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+    magma_int_t wantz   = (opts.jobz == MagmaVec);
+    magma_int_t threads = (opts.nthread > 1 ? opts.nthread : magma_get_parallel_numthreads());
+    magma_bulge_schedule_t schedule_save = magma_get_bulge_schedule();
+    magma_set_bulge_numthreads( threads );
+
+    printf("%% jobz = %s, threads %lld\n", lapack_vec_const(opts.jobz), (long long) threads );
+    printf("%%   N    nb   Static (sec)   Dynamic (sec)   Speedup   |D-D_static|   |D-D_lapack|/(|D| N)\n");
+    printf("%%==========================================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            N  = opts.nsize[itest];
+            nb = magma_get_zbulge_nb( N, threads );
+            magma_zbulge_getlwstg2( N, threads, wantz,
+                                    &Vblksiz, &ldv, &ldt, &blkcnt,
+                                    &sizTAU2, &sizT2, &sizV2 );
+            magma_bulge_getlwstg1( N, nb, &lda2 );
+
+            TESTING_CHECK( magma_zmalloc_cpu( &h_A, lda2*N ));
+            TESTING_CHECK( magma_zmalloc_cpu( &h_R, lda2*N ));
+            TESTING_CHECK( magma_zmalloc_cpu( &V,   max( 1, sizV2   )));
+            TESTING_CHECK( magma_zmalloc_cpu( &TAU, max( 1, sizTAU2 )));
+            TESTING_CHECK( magma_zmalloc_cpu( &T,   max( 1, sizT2   )));
+            for( int s = 0; s < 2; ++s ) {
+                TESTING_CHECK( magma_dmalloc_cpu( &d[s], N ));
+                TESTING_CHECK( magma_dmalloc_cpu( &e[s], N ));
+            }
+
+            /* Initialize the lower band, nb sub-diagonals, with real diagonal */
+            memset( h_A, 0, lda2*N*sizeof(magmaDoubleComplex) );
+            for( magma_int_t j = 0; j < N; ++j ) {
+                magma_int_t len = min( nb+1, N-j );
+                lapackf77_zlarnv( &ione, ISEED, &len, &h_A[j*lda2] );
+                h_A[j*lda2] = MAGMA_Z_MAKE( MAGMA_Z_REAL( h_A[j*lda2] ), 0. );
+            }
+
+            // ===================================================================
+            // Performs operation using the static, then the dynamic schedule
+            // ===================================================================
+            for( int s = 0; s < 2; ++s ) {
+                magma_set_bulge_schedule( s == 0 ? MagmaBulgeStatic : MagmaBulgeDynamic );
+                lapackf77_zlacpy( MagmaFullStr, &lda2, &N, h_A, &lda2, h_R, &lda2 );
+                time[s] = magma_wtime();
+                magma_zhetrd_hb2st( MagmaLower, N, nb, Vblksiz, h_R, lda2, d[s], e[s],
+                                    V, ldv, TAU, wantz, T, ldt );
+                time[s] = magma_wtime() - time[s];
+            }
+
+            double diff = 0;
+            for( magma_int_t i = 0; i < N; ++i ) {
+                diff = max( diff, fabs( d[0][i] - d[1][i] ));
+            }
+            for( magma_int_t i = 0; i < N-1; ++i ) {
+                diff = max( diff, fabs( e[0][i] - e[1][i] ));
+            }
+
+            printf("%5lld %5lld   %10.4f      %10.4f     %7.2f   %10.2e",
+                   (long long) N, (long long) nb, time[0], time[1],
+                   time[0] / time[1], diff );
+
+            if ( opts.check ) {
+                // =================================================================
+                // Check the eigenvalues against LAPACK zhbtrd
+                // =================================================================
+                ldab = nb + 1;
+                TESTING_CHECK( magma_dmalloc_cpu( &dref, N ));
+                TESTING_CHECK( magma_dmalloc_cpu( &eref, N ));
+                TESTING_CHECK( magma_zmalloc_cpu( &work, N ));
+                lapackf77_zlacpy( MagmaFullStr, &ldab, &N, h_A, &lda2, h_R, &ldab );
+                lapackf77_zhbtrd( "N", MagmaLowerStr, &N, &nb, h_R, &ldab, dref, eref,
+                                  unused, &ione, work, &info );
+                if (info != 0) {
+                    printf("lapackf77_zhbtrd returned error %lld: %s.\n",
+                           (long long) info, magma_strerror( info ));
+                }
+                lapackf77_dsterf( &N, dref, eref, &info );
+                lapackf77_dsterf( &N, d[1], e[1], &info );
+
+                double err = 0, nrm = 0;
+                for( magma_int_t i = 0; i < N; ++i ) {
+                    err = max( err, fabs( d[1][i] - dref[i] ));
+                    nrm = max( nrm, fabs( dref[i] ));
+                }
+                err /= (nrm * N);
+                bool okay = (diff == 0 && err < tol);
+                status += ! okay;
+                printf("   %10.2e   %s\n", err, (okay ? "ok" : "failed"));
+
+                magma_free_cpu( dref );
+                magma_free_cpu( eref );
+                magma_free_cpu( work );
+            }
+            else {
+                printf("     ---\n");
+            }
+
+            magma_free_cpu( h_A );
+            magma_free_cpu( h_R );
+            magma_free_cpu( V   );
+            magma_free_cpu( TAU );
+            magma_free_cpu( T   );
+            for( int s = 0; s < 2; ++s ) {
+                magma_free_cpu( d[s] );
+                magma_free_cpu( e[s] );
+            }
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    magma_set_bulge_numthreads( 0 );  // restore default
+    magma_set_bulge_schedule( schedule_save );
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
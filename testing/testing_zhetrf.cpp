@@ -61,9 +61,9 @@ double get_residual(
 
     magma_int_t upper = (uplo == MagmaUpper);
 
-    // this seed should be DIFFERENT than used in init_matrix
-    // (else x is column of A, so residual can be exactly zero)
-    magma_int_t ISEED[4] = {0,0,0,1};
+    // copy opts.iseed, as init_matrix below regenerates A from it;
+    // larnv is a different generator, so x is not a column of A
+    magma_int_t ISEED[4] = { opts.iseed[0], opts.iseed[1], opts.iseed[2], opts.iseed[3] };
     magma_int_t info = 0;
     magma_int_t i;
     magmaDoubleComplex *x, *b;
@@ -147,9 +147,9 @@ double get_residual_gpu(
     const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
     const magma_int_t ione = 1;
 
-    // this seed should be DIFFERENT than used in init_matrix
-    // (else x is column of A, so residual can be exactly zero)
-    magma_int_t ISEED[4] = {0,0,0,1};
+    // copy opts.iseed, as init_matrix below regenerates A from it;
+    // larnv is a different generator, so x is not a column of A
+    magma_int_t ISEED[4] = { opts.iseed[0], opts.iseed[1], opts.iseed[2], opts.iseed[3] };
     magma_int_t info = 0;
     magmaDoubleComplex *x, *dx, *b;
 
@@ -232,7 +232,8 @@ double get_residual_aasen(
     }
 
     // solve
-    magma_int_t ISEED[4] = {0,0,0,1};
+    // copy opts.iseed, as init_matrix below regenerates A from it
+    magma_int_t ISEED[4] = { opts.iseed[0], opts.iseed[1], opts.iseed[2], opts.iseed[3] };
     magma_int_t info = 0;
     magmaDoubleComplex *x, *b;
 
@@ -22,7 +22,9 @@
 #define COMPLEX
 
 /* ////////////////////////////////////////////////////////////////////////////
-   -- Testing znan_inf
+   -- Testing znan_inf, and its variants znan_inf_cols, with per-column
+      counts and first location, znan_inf_amax, with the max abs of
+      the finite entries, and znan_inf_any, which stops at the first one
 */
 int main( int argc, char** argv)
 {
@@ -147,6 +149,7 @@ int main( int argc, char** argv)
             
             /* Initialize the matrix */
             lapackf77_zlarnv( &ione, ISEED, &size, hA );
+            magma_int_t c_any_clean = magma_znan_inf_any( uplo[iuplo], M, N, hA, lda );
             
             // up to 25% of matrix is NAN, and
             // up to 25% of matrix is INF.
@@ -212,6 +215,19 @@ int main( int argc, char** argv)
             magma_int_t c_cpu2 = magma_znan_inf    ( uplo[iuplo], M, N, hA, lda,  NULL, NULL );
             magma_int_t c_gpu2 = magma_znan_inf_gpu( uplo[iuplo], M, N, dA, ldda, NULL, NULL, opts.queue );
             
+            // per-column counts and first row, and max abs of finite entries
+            magma_int_t *col_nan, *col_inf, *col_first;
+            TESTING_CHECK( magma_imalloc_cpu( &col_nan,   N ));
+            TESTING_CHECK( magma_imalloc_cpu( &col_inf,   N ));
+            TESTING_CHECK( magma_imalloc_cpu( &col_first, N ));
+            magma_int_t c_cols = magma_znan_inf_cols( uplo[iuplo], M, N, hA, lda,
+                                                      col_nan, col_inf, col_first );
+            magma_int_t c_amax_nan=-1, c_amax_inf=-1;
+            double amax = -1;
+            magma_int_t c_amax = magma_znan_inf_amax( uplo[iuplo], M, N, hA, lda,
+                                                      &c_amax_nan, &c_amax_inf, &amax );
+            magma_int_t c_any = magma_znan_inf_any( uplo[iuplo], M, N, hA, lda );
+            
             /* =====================================================================
                Check the result
                =================================================================== */
@@ -223,7 +239,36 @@ int main( int argc, char** argv)
                      && ( c_cpu_nan == cnt_nan )
                      && ( c_cpu_inf == cnt_inf )
                      && ( c_gpu_nan == cnt_nan )
-                     && ( c_gpu_inf == cnt_inf );
+                     && ( c_gpu_inf == cnt_inf )
+                     && ( c_cols == c_cpu )
+                     && ( c_amax == c_cpu )
+                     && ( c_amax_nan == cnt_nan )
+                     && ( c_amax_inf == cnt_inf )
+                     && ( c_any_clean == 0 )
+                     && ( c_any == (c_cpu > 0 ? 1 : 0) );
+            
+            // check columns and amax against a scan of the triangle
+            double amax_ref = 0;
+            magma_int_t s_nan = 0, s_inf = 0;
+            for( j=0; j < N; ++j ) {
+                magma_int_t ibeg = (uplo[iuplo] == MagmaLower ? j : 0);
+                magma_int_t iend = (uplo[iuplo] == MagmaUpper ? min( j+1, M ) : M);
+                magma_int_t first = -1;
+                for( i=ibeg; i < iend; ++i ) {
+                    if ( magma_z_isnan_inf( *hA(i,j) ) ) {
+                        if ( first < 0 ) { first = i; }
+                    }
+                    else {
+                        amax_ref = max( amax_ref, MAGMA_Z_ABS( *hA(i,j) ));
+                    }
+                }
+                okay = okay && ( col_first[j] == first );
+                s_nan += col_nan[j];
+                s_inf += col_inf[j];
+            }
+            okay = okay && ( s_nan == cnt_nan )
+                        && ( s_inf == cnt_inf )
+                        && ( fabs( amax - amax_ref ) <= 4 * lapackf77_dlamch("E") * amax_ref );
             
             printf( "%4c %5lld %5lld   %10lld + %-10lld   %10lld + %-10lld   %10lld + %-10lld  %s\n",
                     lapacke_uplo_const( uplo[iuplo] ), (long long) M, (long long) N,
@@ -238,6 +283,9 @@ int main( int argc, char** argv)
             
             magma_free_cpu( ii );
             magma_free_cpu( jj );
+            magma_free_cpu( col_nan );
+            magma_free_cpu( col_inf );
+            magma_free_cpu( col_first );
         }
       }
       printf( "\n" );
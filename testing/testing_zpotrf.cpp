@@ -139,10 +139,13 @@ int main( int argc, char** argv)
                        (long long) N, cpu_perf, cpu_time, gpu_perf, gpu_time,
                        error, (error < tol ? "ok" : "failed") );
                 status += ! (error < tol);
+                opts.record( "zpotrf", N, N, 0, gflops, cpu_time, -1, true, "lapack" );
+                opts.record( "zpotrf", N, N, 0, gflops, gpu_time, error, error < tol );
             }
             else {
                 printf("%5lld     ---   (  ---  )   %7.2f (%7.2f)     ---  \n",
                        (long long) N, gpu_perf, gpu_time );
+                opts.record( "zpotrf", N, N, 0, gflops, gpu_time );
             }
             magma_free_cpu( h_A );
             magma_free_cpu( sigma );
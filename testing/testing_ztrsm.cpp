@@ -46,7 +46,6 @@ int main( int argc, char** argv)
     magma_int_t sizeB;
     magma_int_t lda, ldb, ldda, lddb;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
 
     magmaDoubleComplex *hA, *hB, *hBdev, *hBmagma, *hBlapack, *hX;
     magmaDoubleComplex_ptr dA, dB;
@@ -122,7 +121,7 @@ int main( int argc, char** argv)
             lapackf77_zpotrf( lapack_uplo_const(opts.uplo), &Ak, hA, &lda, &info );
             assert( info == 0 );
 
-            lapackf77_zlarnv( &ione, ISEED, &sizeB, hB );
+            lapackf77_zlarnv( &ione, opts.iseed, &sizeB, hB );
             lapackf77_zlacpy( MagmaFullStr, &M, &N, hB, &ldb, hBlapack, &lda );
             magma_zsetmatrix( Ak, Ak, hA, lda, dA(0,0), ldda, opts.queue );
 
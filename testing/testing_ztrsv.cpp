@@ -44,7 +44,6 @@ int main( int argc, char** argv)
     magma_int_t N, info;
     magma_int_t lda, ldda;
     magma_int_t ione     = 1;
-    magma_int_t ISEED[4] = {0,0,0,1};
 
     magmaDoubleComplex *hA, *hb, *hx, *hxcublas;
     magmaDoubleComplex_ptr dA, dx;
@@ -96,7 +95,7 @@ int main( int argc, char** argv)
             lapackf77_zpotrf( lapack_uplo_const(opts.uplo), &N, hA, &lda, &info );
             assert( info == 0 );
 
-            lapackf77_zlarnv( &ione, ISEED, &N, hb );
+            lapackf77_zlarnv( &ione, opts.iseed, &N, hb );
             blasf77_zcopy( &N, hb, &ione, hx, &ione );
 
             /* =====================================================================
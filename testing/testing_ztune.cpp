@@ -0,0 +1,272 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+#include "magma_zbulge.h"
+#include "../control/magma_threadsetting.h"  // internal header
+
+#define COMPLEX
+
+// routines timed by the tuner
+enum {
+    TuneGetrf,
+    TuneGeqrf,
+    TunePotrf,
+    TuneHeevdx
+};
+
+static const char* tune_routine_name[] = {
+    "zgetrf_gpu", "zgeqrf2_gpu", "zpotrf_gpu", "zheevdx_2stage"
+};
+
+// parameter in the tuning table, and its candidate values, 0 terminated
+struct tune_param_t {
+    const char* name;
+    int routine;
+    bool cpu;                   // keyed by the number of threads
+    magma_int_t candidates[ 16 ];
+};
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Returns the time of routine at size N, using the current tuning table,
+   as the min over --niter runs, after a run for warmup with --warmup.
+   Returns -1 if the routine fails.
+*/
+static double tune_time(
+    magma_opts& opts, int routine, magma_int_t N, magma_int_t threads,
+    const magmaDoubleComplex* h_A, magma_int_t lda )
+{
+    magmaDoubleComplex *h_R, *h_work, *tau;
+    magmaDoubleComplex_ptr d_A;
+    double *w, *rwork;
+    magma_int_t *ipiv, *iwork;
+    magma_int_t ldda, lwork, lrwork, liwork, Nfound, info = 0;
+    double time, best = -1;
+
+    ldda = magma_roundup( N, opts.align );
+    magma_int_t wantz = (opts.jobz == MagmaVec);
+    #ifdef COMPLEX
+    magma_zheevdx_getworksize( N, threads, wantz, &lwork, &lrwork, &liwork );
+    #else
+    magma_zheevdx_getworksize( N, threads, wantz, &lwork, &liwork );
+    lrwork = 1;
+    #endif
+
+    TESTING_CHECK( magma_zmalloc( &d_A, ldda*N ));
+    TESTING_CHECK( magma_imalloc_cpu( &ipiv, N ));
+    TESTING_CHECK( magma_zmalloc_cpu( &tau, N ));
+    if ( routine == TuneHeevdx ) {
+        TESTING_CHECK( magma_zmalloc_pinned( &h_R, lda*N ));
+        TESTING_CHECK( magma_zmalloc_pinned( &h_work, lwork ));
+        TESTING_CHECK( magma_dmalloc_cpu( &rwork, lrwork ));
+        TESTING_CHECK( magma_dmalloc_cpu( &w, N ));
+        TESTING_CHECK( magma_imalloc_cpu( &iwork, liwork ));
+    }
+
+    int nrun = opts.niter + (opts.warmup ? 1 : 0);
+    for( int run = 0; run < nrun && info == 0; ++run ) {
+        if ( routine == TuneHeevdx ) {
+            lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+        }
+        else {
+            magma_zsetmatrix( N, N, h_A, lda, d_A, ldda, opts.queue );
+        }
+
+        time = magma_wtime();
+        switch ( routine ) {
+            case TuneGetrf:
+                magma_zgetrf_gpu( N, N, d_A, ldda, ipiv, &info );
+                break;
+            case TuneGeqrf:
+                magma_zgeqrf2_gpu( N, N, d_A, ldda, tau, &info );
+                break;
+            case TunePotrf:
+                magma_zpotrf_gpu( MagmaLower, N, d_A, ldda, &info );
+                break;
+            case TuneHeevdx:
+                magma_zheevdx_2stage( opts.jobz, MagmaRangeAll, MagmaLower, N,
+                                      h_R, lda, 0, 0, 0, 0, &Nfound, w,
+                                      h_work, lwork,
+                                      #ifdef COMPLEX
+                                      rwork, lrwork,
+                                      #endif
+                                      iwork, liwork, &info );
+                break;
+        }
+        time = magma_wtime() - time;
+        if (info != 0) {
+            printf("magma_%s returned error %lld: %s.\n",
+                   tune_routine_name[ routine ], (long long) info, magma_strerror( info ));
+        }
+        else if ( run >= nrun - opts.niter ) {
+            best = (best < 0 ? time : min( best, time ));
+        }
+    }
+
+    magma_free( d_A );
+    magma_free_cpu( ipiv );
+    magma_free_cpu( tau );
+    if ( routine == TuneHeevdx ) {
+        magma_free_pinned( h_R );
+        magma_free_pinned( h_work );
+        magma_free_cpu( rwork );
+        magma_free_cpu( w );
+        magma_free_cpu( iwork );
+    }
+    return best;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Autotuner for the tuning table of magma_tune_get.
+      For each size N, tries the candidate values of each parameter,
+      timing the routine that uses it, and keeps the fastest in the table.
+      Parameters of the same routine are tuned in turn, each with the best
+      values of the ones before, e.g., Vblksiz with the best bulge nb.
+      Bulge chasing parameters are tuned for magma_get_parallel_numthreads
+      threads, or --nthread if > 1; the others are for any number of threads.
+      The table, with the entries it had before, is written to $MAGMA_TUNE,
+      else magma_tune.txt. Rerun magma_init with $MAGMA_TUNE set to use it.
+      --version selects one routine: 1 getrf, 2 geqrf, 3 potrf, 4 heevdx_2stage
+      (-JV for eigenvectors); by default all are tuned.
+      Usage: testing_ztune -n 1000:10000:1000 [--niter 3] [--version v] [-JV]
+*/
+int main( int argc, char** argv)
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magmaDoubleComplex *h_A;
+    magma_int_t N, lda;
+    magma_int_t ione = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    int status = 0;
+
+    magma_opts opts;
+    opts.version = 0;
+    opts.parse_opts( argc, argv );
+
+    magma_int_t threads = (opts.nthread > 1 ? opts.nthread : magma_get_parallel_numthreads());
+    magma_set_omp_numthreads( threads );
+    magma_set_lapack_numthreads( threads );
+
+    const char* filename = getenv( "MAGMA_TUNE" );
+    if ( filename == NULL || filename[0] == '\0' ) {
+        filename = "magma_tune.txt";
+    }
+
+    tune_param_t params[] = {
+        { "zgetrf_nb",        TuneGetrf,  false, { 32, 64, 128, 192, 256, 384, 512, 768, 1024 }},
+        { "zgeqrf_nb",        TuneGeqrf,  false, { 32, 64, 96, 128, 192, 256, 384, 512 }},
+        { "zpotrf_nb",        TunePotrf,  false, { 64, 128, 192, 256, 384, 512, 768, 1024 }},
+        { "zbulge_nb",        TuneHeevdx, true,  { 32, 48, 64, 96, 128, 160, 192 }},
+        { "zbulge_vblksiz",   TuneHeevdx, true,  { 16, 24, 32, 48, 64, 96, 128 }},
+        { "bulge_numthreads", TuneHeevdx, true,  { 0 }},
+    };
+    int nparam = sizeof(params) / sizeof(params[0]);
+
+    // thread counts: powers of 2 up to threads, and threads
+    int nt = 0;
+    for( magma_int_t t = 1; t < threads && nt < 15; t *= 2 ) {
+        params[ nparam-1 ].candidates[ nt++ ] = t;
+    }
+    params[ nparam-1 ].candidates[ nt ] = threads;
+
+    printf( "%% threads %lld, table %s, jobz %s\n",
+            (long long) threads, filename, lapack_vec_const( opts.jobz ));
+    printf( "%%   N   parameter          value: time (sec) ...                                   best   speedup\n" );
+    printf( "%%=================================================================================================\n" );
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        N   = opts.nsize[itest];
+        lda = N;
+        TESTING_CHECK( magma_zmalloc_cpu( &h_A, lda*N ));
+
+        for( int p = 0; p < nparam; ++p ) {
+            const tune_param_t& param = params[p];
+            if ( opts.version != 0 && opts.version != param.routine + 1 ) {
+                continue;
+            }
+
+            // matrix for the routine
+            magma_int_t n2 = lda*N;
+            lapackf77_zlarnv( &ione, ISEED, &n2, h_A );
+            if ( param.routine == TunePotrf ) {
+                magma_zmake_hpd( N, h_A, lda );
+            }
+            else if ( param.routine == TuneHeevdx ) {
+                magma_zmake_hermitian( N, h_A, lda );
+            }
+
+            magma_int_t nthread = (param.cpu ? threads : 0);
+            printf( "%5lld   %-16s", (long long) N, param.name );
+
+            // time with the current value: tuned before, or built-in default
+            double time0 = tune_time( opts, param.routine, N, threads, h_A, lda );
+            double best_time = -1;
+            magma_int_t best = -1;
+            // Vblksiz is clamped to the bulge nb, so larger values repeat it
+            magma_int_t max_value = N;
+            if ( strcmp( param.name, "zbulge_vblksiz" ) == 0 ) {
+                max_value = magma_get_zbulge_nb( N, threads );
+            }
+            for( int c = 0; c < 16 && param.candidates[c] > 0; ++c ) {
+                magma_int_t value = param.candidates[c];
+                if ( value > max_value && c > 0 ) {
+                    break;
+                }
+                magma_tune_set( param.name, N, nthread, value );
+                double time = tune_time( opts, param.routine, N, threads, h_A, lda );
+                printf( "  %lld: %.4f", (long long) value, time );
+                if ( time > 0 && (best_time < 0 || time < best_time) ) {
+                    best_time = time;
+                    best = value;
+                }
+            }
+            if ( best > 0 ) {
+                magma_tune_set( param.name, N, nthread, best );
+                printf( "   %5lld   %7.2f\n", (long long) best,
+                        (time0 > 0 ? time0 / best_time : 0) );
+            }
+            else {
+                printf( "   failed\n" );
+                status += 1;
+            }
+            fflush( stdout );
+        }
+        magma_free_cpu( h_A );
+    }
+
+    magma_int_t info = magma_tune_save( filename );
+    if ( info != 0 ) {
+        printf( "magma_tune_save returned error %lld: %s.\n",
+                (long long) info, magma_strerror( info ));
+        status += 1;
+    }
+    else {
+        printf( "%% wrote %s\n", filename );
+    }
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
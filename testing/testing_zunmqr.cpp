@@ -35,7 +35,6 @@ int main( int argc, char** argv )
     magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
     magma_int_t ione = 1;
     magma_int_t mm, m, n, k, size, info;
-    magma_int_t ISEED[4] = {0,0,0,1};
     magma_int_t nb, ldc, lda, lwork, lwork_max;
     magmaDoubleComplex *C, *R, *A, *W, *tau;
     int status = 0;
@@ -98,7 +97,7 @@ int main( int argc, char** argv )
             
             // C is full, m x n
             size = ldc*n;
-            lapackf77_zlarnv( &ione, ISEED, &size, C );
+            lapackf77_zlarnv( &ione, opts.iseed, &size, C );
             lapackf77_zlacpy( "Full", &m, &n, C, &ldc, R, &ldc );
             
             // A is mm x k
@@ -168,6 +168,7 @@ class magma_opts
 public:
     // constructor
     magma_opts( magma_opts_t flag=MagmaOptsDefault );
+    ~magma_opts();
     
     // parse command line
     void parse_opts( int argc, char** argv );
@@ -184,6 +185,11 @@ public:
     // deallocate queues, etc.
     void cleanup();
     
+    // with --json, records one run of routine; see magma_util.cpp
+    void record( const char* routine, magma_int_t m, magma_int_t n, magma_int_t k,
+                 double gflop, double time, double error=-1, bool okay=true,
+                 const char* impl="magma" );
+    
     // matrix size
     magma_int_t ntest;
     magma_int_t msize[ MAX_NTEST ];
@@ -222,6 +228,10 @@ public:
     
     double      tolerance;
     
+    // structured output
+    std::string json;       // file to append JSON lines to; "-" for stdout
+    magma_int_t nwarmup;    // leading iterations of each test left out of statistics
+    
     // boolean arguments
     bool magma;
     bool lapack;
@@ -258,6 +268,22 @@ public:
     #elif defined(MAGMA_HAVE_HIP)
     hipblasHandle_t handle;
     #endif
+
+private:
+    void record_flush();
+
+    // runs of one routine and impl at the current size, for record()
+    struct record_t {
+        std::string key;
+        std::vector< double > times;
+        magma_int_t runs;
+        double      gflop;
+        double      error;
+        bool        okay;
+    };
+    FILE*       record_file;
+    std::vector< record_t > records;
+    magma_int_t record_size[3];
 };
 
 extern const char* g_platform_str;
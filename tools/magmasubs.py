@@ -759,6 +759,7 @@ subs = {
     ('lapack_diag',    'lapack_siag',    'lapack_diag',    'lapack_siag'     ),
     ('lapack_direct',  'lapack_sirect',  'lapack_direct',  'lapack_sirect'   ),
     ('magma_copy',     'magma_sopy',     'magma_copy',     'magma_sopy'      ),
+    ('magma_dep',      'magma_sep',      'magma_dep',      'magma_sep'       ),
     
   ], # end normal
 